@@ -51,6 +51,10 @@ public:
                        double scale = 1.0);
   CollisionEnvAllValid(const CollisionEnv& other, const WorldPtr& world);
 
+  // keep the CompactCollisionResult overloads of CollisionEnv visible
+  using CollisionEnv::checkRobotCollision;
+  using CollisionEnv::checkSelfCollision;
+
   void checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
                            const moveit::core::RobotState& state) const override;
   void checkRobotCollision(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state,
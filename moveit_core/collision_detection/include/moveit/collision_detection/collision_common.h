@@ -38,10 +38,13 @@
 
 #include <boost/array.hpp>
 #include <boost/function.hpp>
+#include <cstdint>
+#include <functional>
 #include <vector>
 #include <string>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <Eigen/Core>
 #include <moveit/robot_model/robot_model.h>
 
@@ -180,6 +183,100 @@ struct CollisionResult
   std::set<CostSource> cost_sources;
 };
 
+/** \brief Compact definition of a contact point, referring to the bodies by the index of their name in the name table
+ * of a CompactCollisionResult */
+struct CompactContact
+{
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  /** \brief contact position */
+  Eigen::Vector3d pos;
+
+  /** \brief normal unit vector at contact */
+  Eigen::Vector3d normal;
+
+  /** \brief depth (penetration between bodies) */
+  double depth;
+
+  /** \brief The name index of the first body involved in the contact */
+  std::uint32_t body_id_1;
+
+  /** \brief The name index of the second body involved in the contact */
+  std::uint32_t body_id_2;
+
+  /** \brief The type of the first body involved in the contact */
+  BodyType body_type_1;
+
+  /** \brief The type of the second body involved in the contact */
+  BodyType body_type_2;
+
+  /** \brief The distance percentage between casted poses until collision (see Contact) */
+  double percent_interpolation;
+};
+
+/** \brief Representation of a collision checking result that can be reused without allocating memory.
+ *
+ *  Contacts are stored in a flat vector and refer to the bodies through an interned name table. clear() keeps the
+ *  capacity of the contact vector as well as the name table, so repeated queries for the same bodies do not allocate.
+ */
+class CompactCollisionResult
+{
+public:
+  CompactCollisionResult() : collision(false), distance(std::numeric_limits<double>::max()), contact_count(0)
+  {
+  }
+
+  /** \brief Clear a previously stored result, keeping the allocated memory */
+  void clear()
+  {
+    collision = false;
+    distance = std::numeric_limits<double>::max();
+    contact_count = 0;
+    contacts.clear();
+    cost_sources.clear();
+  }
+
+  /** \brief Get the index of \e name in the name table, adding it if necessary */
+  std::uint32_t getNameId(const std::string& name);
+
+  /** \brief Get the name with index \e id */
+  const std::string& getName(std::uint32_t id) const
+  {
+    return names_[id];
+  }
+
+  /** \brief Get the number of stored contacts between the bodies with name index \e id1 and \e id2 */
+  std::size_t getContactCount(std::uint32_t id1, std::uint32_t id2) const;
+
+  /** \brief Store \e contact */
+  void addContact(const Contact& contact);
+
+  /** \brief Convert the compact contact \e compact into \e contact */
+  void getContact(const CompactContact& compact, Contact& contact) const;
+
+  /** \brief Convert this result into a CollisionResult */
+  void getCollisionResult(CollisionResult& res) const;
+
+  /** \brief True if collision was found, false otherwise */
+  bool collision;
+
+  /** \brief Closest distance between two bodies */
+  double distance;
+
+  /** \brief Number of contacts returned */
+  std::size_t contact_count;
+
+  /** \brief The contacts in the order they were found */
+  std::vector<CompactContact> contacts;
+
+  /** \brief These are the individual cost sources when costs are computed */
+  std::set<CostSource> cost_sources;
+
+private:
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, std::uint32_t> name_ids_;
+};
+
 /** \brief Representation of a collision checking request */
 struct CollisionRequest
 {
@@ -226,6 +323,62 @@ struct CollisionRequest
   bool verbose;
 };
 
+/** \brief Representation of a request to check a batch of robot states for collisions */
+struct BatchCollisionRequest
+{
+  BatchCollisionRequest() : stop_at_first_collision(true), num_threads(0), min_states_per_thread(8)
+  {
+  }
+
+  /** \brief If true, the check terminates once the first (lowest-index) colliding state is known. Otherwise the
+   *   indices of all colliding states are reported. */
+  bool stop_at_first_collision;
+
+  /** \brief Maximum number of threads used for the check. If 0, the number of hardware threads is used. The threads
+   *   are taken from the global moveit::core::WorkerPool, which also caps their number. */
+  unsigned int num_threads;
+
+  /** \brief A thread is only used for every this many states, so small batches are checked on the calling thread */
+  unsigned int min_states_per_thread;
+};
+
+/** \brief Representation of the result of a batched collision check */
+struct BatchCollisionResult
+{
+  BatchCollisionResult() : collision(false)
+  {
+  }
+
+  /** \brief Clear a previously stored result */
+  void clear()
+  {
+    collision = false;
+    colliding_indices.clear();
+  }
+
+  /** \brief True if any of the states is in collision */
+  bool collision;
+
+  /** \brief Sorted indices of the colliding states. Contains only the first one if \e stop_at_first_collision was set
+   *   in the request. */
+  std::vector<std::size_t> colliding_indices;
+};
+
+/** \brief Evaluate \e is_colliding for the indices 0 ... \e count - 1 on up to \e req.num_threads threads and collect
+ *   the colliding ones in \e res.
+ *
+ *   The workers run on the persistent threads of the global moveit::core::WorkerPool, so thread_local caches of the
+ *   collision checkers are kept from one batch to the next.
+ *
+ *   \e is_colliding is called concurrently and receives the index of the state as well as the index of the calling
+ *   worker (< the number of workers), which can be used to address per-thread scratch data. Indices are handed out in
+ *   increasing order, so stopping at the first collision still reports the lowest colliding index. */
+void checkCollisionBatch(const BatchCollisionRequest& req, BatchCollisionResult& res, std::size_t count,
+                         const std::function<bool(std::size_t index, std::size_t worker)>& is_colliding);
+
+/** \brief The number of workers checkCollisionBatch() uses for \e count states */
+std::size_t getBatchWorkerCount(const BatchCollisionRequest& req, std::size_t count);
+
 namespace DistanceRequestTypes
 {
 enum DistanceRequestType
@@ -110,6 +110,55 @@ public:
   virtual void checkCollision(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state,
                               const AllowedCollisionMatrix& acm) const;
 
+  /** \brief Check whether the robot model is in collision with itself or the world at a particular state, storing
+   *  the contacts in a compact result that can be reused without allocating memory.
+   *  Allowed collisions specified by the allowed collision matrix are taken into account.
+   *  @param req A CollisionRequest object that encapsulates the collision request
+   *  @param res A CompactCollisionResult object that encapsulates the collision result
+   *  @param state The kinematic state for which checks are being made
+   *  @param acm The allowed collision matrix. */
+  void checkCollision(const CollisionRequest& req, CompactCollisionResult& res, const moveit::core::RobotState& state,
+                      const AllowedCollisionMatrix& acm) const;
+
+  /** \brief Check for self collision, storing the contacts in a compact result. Any collision between any pair of
+   *  links is checked for, unless it is allowed by \e acm. The default implementation converts the result of the
+   *  regular checkSelfCollision(), so only backends that override it avoid allocating memory per contact.
+   *  @param req A CollisionRequest object that encapsulates the collision request
+   *  @param res A CompactCollisionResult object that encapsulates the collision result
+   *  @param state The kinematic state for which checks are being made
+   *  @param acm The allowed collision matrix. */
+  virtual void checkSelfCollision(const CollisionRequest& req, CompactCollisionResult& res,
+                                  const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm) const;
+
+  /** \brief Check whether the robot model is in collision with the world, storing the contacts in a compact result.
+   *  The default implementation converts the result of the regular checkRobotCollision().
+   *  @param req A CollisionRequest object that encapsulates the collision request
+   *  @param res A CompactCollisionResult object that encapsulates the collision result
+   *  @param state The kinematic state for which checks are being made
+   *  @param acm The allowed collision matrix. */
+  virtual void checkRobotCollision(const CollisionRequest& req, CompactCollisionResult& res,
+                                   const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm) const;
+
+  /** \brief Check a batch of robot states for collisions, as checkCollision() does for a single state.
+   *  The states are distributed over multiple threads, each of them reusing its own CollisionResult.
+   *  @param req A CollisionRequest object that is used for each of the states
+   *  @param batch_req A BatchCollisionRequest object that specifies the threading and when to stop
+   *  @param res A BatchCollisionResult object that receives the indices of the colliding states
+   *  @param states The states to check. Their collision body transforms have to be up to date. */
+  void checkCollisionBatch(const CollisionRequest& req, const BatchCollisionRequest& batch_req,
+                           BatchCollisionResult& res, const std::vector<const moveit::core::RobotState*>& states) const;
+
+  /** \brief Check a batch of robot states for collisions, as checkCollision() does for a single state.
+   *  Allowed collisions specified by the allowed collision matrix are taken into account.
+   *  @param req A CollisionRequest object that is used for each of the states
+   *  @param batch_req A BatchCollisionRequest object that specifies the threading and when to stop
+   *  @param res A BatchCollisionResult object that receives the indices of the colliding states
+   *  @param states The states to check. Their collision body transforms have to be up to date.
+   *  @param acm The allowed collision matrix. */
+  void checkCollisionBatch(const CollisionRequest& req, const BatchCollisionRequest& batch_req,
+                           BatchCollisionResult& res, const std::vector<const moveit::core::RobotState*>& states,
+                           const AllowedCollisionMatrix& acm) const;
+
   /** \brief Check whether the robot model is in collision with the world. Any collisions between a robot link
    *  and the world are considered. Self collisions are not checked.
    *  @param req A CollisionRequest object that encapsulates the collision request
@@ -40,10 +40,15 @@
 #include <moveit/macros/class_forward.h>
 #include <moveit_msgs/AllowedCollisionMatrix.h>
 #include <boost/function.hpp>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
 
 namespace collision_detection
 {
@@ -71,7 +76,8 @@ enum Type
  * CONDITIONAL) */
 using DecideContactFn = boost::function<bool(collision_detection::Contact&)>;
 
-MOVEIT_CLASS_FORWARD(AllowedCollisionMatrix);  // Defines AllowedCollisionMatrixPtr, ConstPtr, WeakPtr... etc
+MOVEIT_CLASS_FORWARD(AllowedCollisionMatrix);          // Defines AllowedCollisionMatrixPtr, ConstPtr, WeakPtr... etc
+MOVEIT_CLASS_FORWARD(CompiledAllowedCollisionMatrix);  // Defines CompiledAllowedCollisionMatrixPtr, ConstPtr, ...
 
 /** @class AllowedCollisionMatrix
  *  @brief Definition of a structure for the allowed collision matrix. All elements in the collision world are referred
@@ -269,11 +275,141 @@ public:
   /** @brief Print the allowed collision matrix */
   void print(std::ostream& out) const;
 
+  /** @brief Get an index-based snapshot of the allowed collision matrix, which answers queries without string
+   * lookups.
+   *  The snapshot is computed on first use and shared until the matrix is modified. */
+  CompiledAllowedCollisionMatrixConstPtr getCompiled() const;
+
 private:
+  friend class CompiledAllowedCollisionMatrix;
+
+  /** @brief Mark the compiled entries of \e name as stale after a modification. The next getCompiled() patches
+   * only their rows and columns of the last snapshot */
+  void invalidateCompiled(const std::string& name);
+
+  /** @brief Mark the compiled entries of the pair as stale after a modification */
+  void invalidateCompiled(const std::string& name1, const std::string& name2);
+
+  /** @brief Drop the compiled snapshot after a modification of the whole matrix */
+  void invalidateCompiled();
+
   std::map<std::string, std::map<std::string, AllowedCollision::Type> > entries_;
   std::map<std::string, std::map<std::string, DecideContactFn> > allowed_contacts_;
 
   std::map<std::string, AllowedCollision::Type> default_entries_;
   std::map<std::string, DecideContactFn> default_allowed_contacts_;
+
+  mutable CompiledAllowedCollisionMatrixConstPtr compiled_;
+
+  /** @brief The last snapshot and the names modified since, for patching it when compiled_ is stale */
+  CompiledAllowedCollisionMatrixConstPtr compiled_base_;
+  std::set<std::string> stale_names_;
+};
+
+/** @class CompiledAllowedCollisionMatrix
+ *  @brief Immutable snapshot of an AllowedCollisionMatrix for the collision checking hot path.
+ *   All names known to the matrix are mapped to consecutive indices and the results of getEntry() and
+ *   getAllowedCollision() are precomputed for all pairs of them in dense tables. Contact predicates are kept in side
+ *   tables. Names that are unknown to the matrix are represented by the index -1 and are handled exactly as by the
+ *   AllowedCollisionMatrix. */
+class CompiledAllowedCollisionMatrix
+{
+public:
+  /** @brief Compile a snapshot of \e acm */
+  explicit CompiledAllowedCollisionMatrix(const AllowedCollisionMatrix& acm);
+
+  /** @brief Compile a snapshot of \e acm by copying \e base and recomputing only the rows and columns of
+   * \e names, which need to include all names \e acm was modified for since \e base was compiled. The indices of
+   * \e base are kept and new names are appended. */
+  CompiledAllowedCollisionMatrix(const CompiledAllowedCollisionMatrix& base, const AllowedCollisionMatrix& acm,
+                                 const std::set<std::string>& names);
+
+  /** @brief Get the index of \e name, or -1 if the name is not known to the matrix */
+  int getIndex(const std::string& name) const;
+
+  /** @brief Get the number of names known to the matrix */
+  std::size_t getSize() const
+  {
+    return names_.size();
+  }
+
+  /** @brief Get a number that identifies this snapshot among all snapshots created by this process */
+  std::uint32_t getSerial() const
+  {
+    return serial_;
+  }
+
+  /** @brief Equivalent of AllowedCollisionMatrix::getEntry() for the elements with index \e index1 and \e index2 */
+  bool getEntry(int index1, int index2, AllowedCollision::Type& allowed_collision_type) const;
+
+  /** @brief Equivalent of AllowedCollisionMatrix::getEntry() for the elements with index \e index1 and \e index2 */
+  bool getEntry(int index1, int index2, DecideContactFn& fn) const;
+
+  /** @brief Equivalent of AllowedCollisionMatrix::getAllowedCollision() for the elements with index \e index1 and
+   * \e index2 */
+  bool getAllowedCollision(int index1, int index2, AllowedCollision::Type& allowed_collision) const;
+
+  /** @brief Equivalent of AllowedCollisionMatrix::getAllowedCollision() for the elements with index \e index1 and
+   * \e index2 */
+  bool getAllowedCollision(int index1, int index2, DecideContactFn& fn) const;
+
+  /** @class IndexCache
+   *  @brief Remembers the index of a name in the most recently used snapshot, so collision objects can look up their
+   * index without hashing their name on every query. It can be used from multiple threads concurrently. */
+  class IndexCache
+  {
+  public:
+    IndexCache() : packed_(0)
+    {
+    }
+
+    /** @brief Copies start with an empty cache */
+    IndexCache(const IndexCache& /*other*/) : packed_(0)
+    {
+    }
+
+    IndexCache& operator=(const IndexCache& /*other*/)
+    {
+      packed_ = 0;
+      return *this;
+    }
+
+    /** @brief Get the index of \e name in \e compiled. The name has to be the same for all calls on this cache. */
+    int getIndex(const CompiledAllowedCollisionMatrix& compiled, const std::string& name) const;
+
+  private:
+    /** @brief The serial of the snapshot in the upper and the index + 1 in the lower 32 bits */
+    mutable std::atomic<std::uint64_t> packed_;
+  };
+
+private:
+  static constexpr std::uint8_t NOT_FOUND = 0xff;
+
+  /** @brief Compute the default entry of the element with index \e index */
+  void compileDefault(const AllowedCollisionMatrix& acm, std::size_t index);
+
+  /** @brief Compute the entries of the pair of elements with index \e index1 and \e index2 */
+  void compilePair(const AllowedCollisionMatrix& acm, std::size_t index1, std::size_t index2);
+
+  std::size_t pairIndex(int index1, int index2) const
+  {
+    return static_cast<std::size_t>(index1) * names_.size() + static_cast<std::size_t>(index2);
+  }
+
+  std::uint32_t serial_;
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, int> indices_;
+
+  /** @brief Results of getEntry() and getAllowedCollision() for all pairs, or NOT_FOUND */
+  std::vector<std::uint8_t> entries_;
+  std::vector<std::uint8_t> allowed_;
+
+  /** @brief Default entries of all elements, or NOT_FOUND */
+  std::vector<std::uint8_t> default_entries_;
+
+  /** @brief Contact predicates, keyed by pair index or by element index for the defaults */
+  std::unordered_map<std::size_t, DecideContactFn> entry_fns_;
+  std::unordered_map<std::size_t, DecideContactFn> allowed_fns_;
+  std::unordered_map<int, DecideContactFn> default_fns_;
 };
 }  // namespace collision_detection
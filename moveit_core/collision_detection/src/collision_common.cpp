@@ -33,6 +33,10 @@
  *********************************************************************/
 
 #include <moveit/collision_detection/collision_common.h>
+#include <moveit/utils/worker_pool.h>
+
+#include <algorithm>
+#include <atomic>
 
 static const char LOGNAME[] = "collision_common";
 constexpr size_t LOG_THROTTLE_PERIOD = 5;
@@ -58,4 +62,120 @@ void CollisionResult::print() const
   }
 }
 
+std::uint32_t CompactCollisionResult::getNameId(const std::string& name)
+{
+  auto it = name_ids_.find(name);
+  if (it != name_ids_.end())
+    return it->second;
+  const std::uint32_t id = names_.size();
+  names_.push_back(name);
+  name_ids_.emplace(name, id);
+  return id;
+}
+
+std::size_t CompactCollisionResult::getContactCount(std::uint32_t id1, std::uint32_t id2) const
+{
+  std::size_t count = 0;
+  for (const CompactContact& contact : contacts)
+    if ((contact.body_id_1 == id1 && contact.body_id_2 == id2) ||
+        (contact.body_id_1 == id2 && contact.body_id_2 == id1))
+      ++count;
+  return count;
+}
+
+void CompactCollisionResult::addContact(const Contact& contact)
+{
+  contacts.emplace_back();
+  CompactContact& compact = contacts.back();
+  compact.pos = contact.pos;
+  compact.normal = contact.normal;
+  compact.depth = contact.depth;
+  compact.body_id_1 = getNameId(contact.body_name_1);
+  compact.body_id_2 = getNameId(contact.body_name_2);
+  compact.body_type_1 = contact.body_type_1;
+  compact.body_type_2 = contact.body_type_2;
+  compact.percent_interpolation = contact.percent_interpolation;
+}
+
+void CompactCollisionResult::getContact(const CompactContact& compact, Contact& contact) const
+{
+  contact.pos = compact.pos;
+  contact.normal = compact.normal;
+  contact.depth = compact.depth;
+  contact.body_name_1 = getName(compact.body_id_1);
+  contact.body_name_2 = getName(compact.body_id_2);
+  contact.body_type_1 = compact.body_type_1;
+  contact.body_type_2 = compact.body_type_2;
+  contact.percent_interpolation = compact.percent_interpolation;
+}
+
+void CompactCollisionResult::getCollisionResult(CollisionResult& res) const
+{
+  res.clear();
+  res.collision = collision;
+  res.distance = distance;
+  res.contact_count = contact_count;
+  res.cost_sources = cost_sources;
+  Contact contact;
+  for (const CompactContact& compact : contacts)
+  {
+    getContact(compact, contact);
+    const std::pair<std::string, std::string>& pc =
+        contact.body_name_1 < contact.body_name_2 ? std::make_pair(contact.body_name_1, contact.body_name_2) :
+                                                    std::make_pair(contact.body_name_2, contact.body_name_1);
+    res.contacts[pc].push_back(contact);
+  }
+}
+
+std::size_t getBatchWorkerCount(const BatchCollisionRequest& req, std::size_t count)
+{
+  const std::size_t max_workers = moveit::core::WorkerPool::getGlobal().getMaxWorkerCount();
+  std::size_t num_threads = req.num_threads ? std::min<std::size_t>(req.num_threads, max_workers) : max_workers;
+  if (req.min_states_per_thread > 1)
+    num_threads = std::min(num_threads, count / req.min_states_per_thread);
+  return std::max<std::size_t>(1, std::min(num_threads, count));
+}
+
+void checkCollisionBatch(const BatchCollisionRequest& req, BatchCollisionResult& res, std::size_t count,
+                         const std::function<bool(std::size_t index, std::size_t worker)>& is_colliding)
+{
+  res.clear();
+  const std::size_t num_workers = getBatchWorkerCount(req, count);
+  std::atomic<std::size_t> next_index(0);
+  // lowest colliding index found so far; states beyond it need not be checked when stopping at the first collision
+  std::atomic<std::size_t> first_collision(count);
+  std::vector<std::vector<std::size_t>> colliding(num_workers);
+
+  auto work = [&](std::size_t worker) {
+    for (std::size_t i = next_index++; i < count; i = next_index++)
+    {
+      if (req.stop_at_first_collision && i > first_collision)
+        break;
+      if (!is_colliding(i, worker))
+        continue;
+      colliding[worker].push_back(i);
+      std::size_t current = first_collision;
+      while (i < current && !first_collision.compare_exchange_weak(current, i))
+        ;
+    }
+  };
+
+  if (num_workers == 1)
+    work(0);
+  else
+    moveit::core::WorkerPool::getGlobal().run(num_workers, work);
+
+  if (first_collision == count)
+    return;
+  res.collision = true;
+  if (req.stop_at_first_collision)
+    res.colliding_indices.push_back(first_collision);
+  else
+  {
+    for (const std::vector<std::size_t>& indices : colliding)
+      res.colliding_indices.insert(res.colliding_indices.end(), indices.begin(), indices.end());
+    std::sort(res.colliding_indices.begin(), res.colliding_indices.end());
+  }
+}
+
 }  // namespace collision_detection
@@ -304,4 +304,69 @@ void CollisionEnv::checkCollision(const CollisionRequest& req, CollisionResult&
     checkRobotCollision(req, res, state, acm);
 }
 
+void CollisionEnv::checkCollision(const CollisionRequest& req, CompactCollisionResult& res,
+                                  const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm) const
+{
+  checkSelfCollision(req, res, state, acm);
+  if (!res.collision || (req.contacts && res.contact_count < req.max_contacts))
+    checkRobotCollision(req, res, state, acm);
+}
+
+/** \brief Replace the content of \e compact by \e res */
+static void assignCompactResult(const CollisionResult& res, CompactCollisionResult& compact)
+{
+  compact.clear();
+  compact.collision = res.collision;
+  compact.distance = res.distance;
+  compact.contact_count = res.contact_count;
+  compact.cost_sources = res.cost_sources;
+  for (const auto& pair_contacts : res.contacts)
+    for (const Contact& contact : pair_contacts.second)
+      compact.addContact(contact);
+}
+
+void CollisionEnv::checkSelfCollision(const CollisionRequest& req, CompactCollisionResult& res,
+                                      const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm) const
+{
+  // continue from the contacts found so far, so the limits of the request apply to the whole result
+  CollisionResult full;
+  res.getCollisionResult(full);
+  checkSelfCollision(req, full, state, acm);
+  assignCompactResult(full, res);
+}
+
+void CollisionEnv::checkRobotCollision(const CollisionRequest& req, CompactCollisionResult& res,
+                                       const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm) const
+{
+  CollisionResult full;
+  res.getCollisionResult(full);
+  checkRobotCollision(req, full, state, acm);
+  assignCompactResult(full, res);
+}
+
+void CollisionEnv::checkCollisionBatch(const CollisionRequest& req, const BatchCollisionRequest& batch_req,
+                                       BatchCollisionResult& res,
+                                       const std::vector<const moveit::core::RobotState*>& states) const
+{
+  std::vector<CollisionResult> results(getBatchWorkerCount(batch_req, states.size()));
+  collision_detection::checkCollisionBatch(batch_req, res, states.size(), [&](std::size_t i, std::size_t worker) {
+    results[worker].clear();
+    checkCollision(req, results[worker], *states[i]);
+    return results[worker].collision;
+  });
+}
+
+void CollisionEnv::checkCollisionBatch(const CollisionRequest& req, const BatchCollisionRequest& batch_req,
+                                       BatchCollisionResult& res,
+                                       const std::vector<const moveit::core::RobotState*>& states,
+                                       const AllowedCollisionMatrix& acm) const
+{
+  std::vector<CollisionResult> results(getBatchWorkerCount(batch_req, states.size()));
+  collision_detection::checkCollisionBatch(batch_req, res, states.size(), [&](std::size_t i, std::size_t worker) {
+    results[worker].clear();
+    checkCollision(req, results[worker], *states[i], acm);
+    return results[worker].collision;
+  });
+}
+
 }  // end of namespace collision_detection
@@ -36,6 +36,7 @@
 
 #include <moveit/collision_detection/collision_matrix.h>
 #include <boost/bind.hpp>
+#include <algorithm>
 #include <iomanip>
 
 namespace collision_detection
@@ -114,6 +115,7 @@ bool AllowedCollisionMatrix::hasEntry(const std::string& name1, const std::strin
 
 void AllowedCollisionMatrix::setEntry(const std::string& name1, const std::string& name2, bool allowed)
 {
+  invalidateCompiled(name1, name2);
   const AllowedCollision::Type v = allowed ? AllowedCollision::ALWAYS : AllowedCollision::NEVER;
   entries_[name1][name2] = entries_[name2][name1] = v;
 
@@ -136,12 +138,14 @@ void AllowedCollisionMatrix::setEntry(const std::string& name1, const std::strin
 
 void AllowedCollisionMatrix::setEntry(const std::string& name1, const std::string& name2, const DecideContactFn& fn)
 {
+  invalidateCompiled(name1, name2);
   entries_[name1][name2] = entries_[name2][name1] = AllowedCollision::CONDITIONAL;
   allowed_contacts_[name1][name2] = allowed_contacts_[name2][name1] = fn;
 }
 
 void AllowedCollisionMatrix::removeEntry(const std::string& name)
 {
+  invalidateCompiled(name);
   entries_.erase(name);
   allowed_contacts_.erase(name);
   for (auto& entry : entries_)
@@ -152,6 +156,7 @@ void AllowedCollisionMatrix::removeEntry(const std::string& name)
 
 void AllowedCollisionMatrix::removeEntry(const std::string& name1, const std::string& name2)
 {
+  invalidateCompiled(name1, name2);
   auto jt = entries_.find(name1);
   if (jt != entries_.end())
   {
@@ -210,6 +215,7 @@ void AllowedCollisionMatrix::setEntry(const std::string& name, bool allowed)
 
 void AllowedCollisionMatrix::setEntry(bool allowed)
 {
+  invalidateCompiled();
   const AllowedCollision::Type v = allowed ? AllowedCollision::ALWAYS : AllowedCollision::NEVER;
   for (auto& entry : entries_)
     for (auto& it2 : entry.second)
@@ -218,6 +224,7 @@ void AllowedCollisionMatrix::setEntry(bool allowed)
 
 void AllowedCollisionMatrix::setDefaultEntry(const std::string& name, bool allowed)
 {
+  invalidateCompiled(name);
   const AllowedCollision::Type v = allowed ? AllowedCollision::ALWAYS : AllowedCollision::NEVER;
   default_entries_[name] = v;
   default_allowed_contacts_.erase(name);
@@ -225,6 +232,7 @@ void AllowedCollisionMatrix::setDefaultEntry(const std::string& name, bool allow
 
 void AllowedCollisionMatrix::setDefaultEntry(const std::string& name, const DecideContactFn& fn)
 {
+  invalidateCompiled(name);
   default_entries_[name] = AllowedCollision::CONDITIONAL;
   default_allowed_contacts_[name] = fn;
 }
@@ -307,6 +315,7 @@ bool AllowedCollisionMatrix::getAllowedCollision(const std::string& name1, const
 
 void AllowedCollisionMatrix::clear()
 {
+  invalidateCompiled();
   entries_.clear();
   allowed_contacts_.clear();
   default_entries_.clear();
@@ -409,4 +418,261 @@ void AllowedCollisionMatrix::print(std::ostream& out) const
   }
 }
 
+void AllowedCollisionMatrix::invalidateCompiled(const std::string& name)
+{
+  // the current snapshot becomes the base to patch, unless it is stale already
+  CompiledAllowedCollisionMatrixConstPtr compiled = std::atomic_load(&compiled_);
+  if (compiled)
+  {
+    compiled_base_ = compiled;
+    stale_names_.clear();
+    std::atomic_store(&compiled_, CompiledAllowedCollisionMatrixConstPtr());
+  }
+  if (compiled_base_)
+    stale_names_.insert(name);
+}
+
+void AllowedCollisionMatrix::invalidateCompiled(const std::string& name1, const std::string& name2)
+{
+  invalidateCompiled(name1);
+  invalidateCompiled(name2);
+}
+
+void AllowedCollisionMatrix::invalidateCompiled()
+{
+  std::atomic_store(&compiled_, CompiledAllowedCollisionMatrixConstPtr());
+  compiled_base_.reset();
+  stale_names_.clear();
+}
+
+CompiledAllowedCollisionMatrixConstPtr AllowedCollisionMatrix::getCompiled() const
+{
+  // concurrent callers may compile the same snapshot twice, which is harmless
+  CompiledAllowedCollisionMatrixConstPtr compiled = std::atomic_load(&compiled_);
+  if (!compiled)
+  {
+    // patching costs a row and a column per stale name, so only few stale names are worth it
+    if (compiled_base_ && 2 * stale_names_.size() < compiled_base_->getSize())
+      compiled = std::make_shared<const CompiledAllowedCollisionMatrix>(*compiled_base_, *this, stale_names_);
+    else
+      compiled = std::make_shared<const CompiledAllowedCollisionMatrix>(*this);
+    std::atomic_store(&compiled_, compiled);
+  }
+  return compiled;
+}
+
+constexpr std::uint8_t CompiledAllowedCollisionMatrix::NOT_FOUND;
+
+static std::atomic<std::uint32_t> COMPILED_ACM_SERIAL(0);
+
+static std::uint32_t nextCompiledSerial()
+{
+  // serial 0 marks an empty IndexCache
+  std::uint32_t serial = ++COMPILED_ACM_SERIAL;
+  if (serial == 0)
+    serial = ++COMPILED_ACM_SERIAL;
+  return serial;
+}
+
+CompiledAllowedCollisionMatrix::CompiledAllowedCollisionMatrix(const AllowedCollisionMatrix& acm)
+  : serial_(nextCompiledSerial())
+{
+  acm.getAllEntryNames(names_);
+  for (const auto& default_entry : acm.default_entries_)
+    names_.push_back(default_entry.first);
+  for (const auto& default_contact : acm.default_allowed_contacts_)
+    names_.push_back(default_contact.first);
+  std::sort(names_.begin(), names_.end());
+  names_.erase(std::unique(names_.begin(), names_.end()), names_.end());
+
+  const std::size_t n = names_.size();
+  indices_.reserve(n);
+  default_entries_.assign(n, NOT_FOUND);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    indices_[names_[i]] = static_cast<int>(i);
+    compileDefault(acm, i);
+  }
+
+  entries_.assign(n * n, NOT_FOUND);
+  allowed_.assign(n * n, NOT_FOUND);
+  for (std::size_t i = 0; i < n; ++i)
+    for (std::size_t j = 0; j < n; ++j)
+      compilePair(acm, i, j);
+}
+
+CompiledAllowedCollisionMatrix::CompiledAllowedCollisionMatrix(const CompiledAllowedCollisionMatrix& base,
+                                                               const AllowedCollisionMatrix& acm,
+                                                               const std::set<std::string>& names)
+  : serial_(nextCompiledSerial())
+  , names_(base.names_)
+  , indices_(base.indices_)
+  , default_entries_(base.default_entries_)
+  , default_fns_(base.default_fns_)
+{
+  // names that were removed from acm keep their index, their recomputed entries match those of unknown names
+  std::vector<std::size_t> stale;
+  stale.reserve(names.size());
+  for (const std::string& name : names)
+  {
+    auto it = indices_.find(name);
+    if (it == indices_.end())
+    {
+      it = indices_.emplace(name, static_cast<int>(names_.size())).first;
+      names_.push_back(name);
+    }
+    stale.push_back(it->second);
+  }
+
+  const std::size_t n = names_.size();
+  const std::size_t base_n = base.names_.size();
+  default_entries_.resize(n, NOT_FOUND);
+  if (n == base_n)
+  {
+    entries_ = base.entries_;
+    allowed_ = base.allowed_;
+    entry_fns_ = base.entry_fns_;
+    allowed_fns_ = base.allowed_fns_;
+  }
+  else
+  {
+    // the pair indices change with the size, so the tables are laid out anew
+    entries_.assign(n * n, NOT_FOUND);
+    allowed_.assign(n * n, NOT_FOUND);
+    for (std::size_t i = 0; i < base_n; ++i)
+    {
+      std::copy_n(base.entries_.begin() + i * base_n, base_n, entries_.begin() + i * n);
+      std::copy_n(base.allowed_.begin() + i * base_n, base_n, allowed_.begin() + i * n);
+    }
+    for (const auto& entry_fn : base.entry_fns_)
+      entry_fns_[entry_fn.first / base_n * n + entry_fn.first % base_n] = entry_fn.second;
+    for (const auto& allowed_fn : base.allowed_fns_)
+      allowed_fns_[allowed_fn.first / base_n * n + allowed_fn.first % base_n] = allowed_fn.second;
+  }
+
+  for (std::size_t i : stale)
+  {
+    compileDefault(acm, i);
+    for (std::size_t j = 0; j < n; ++j)
+    {
+      compilePair(acm, i, j);
+      compilePair(acm, j, i);
+    }
+  }
+}
+
+void CompiledAllowedCollisionMatrix::compileDefault(const AllowedCollisionMatrix& acm, std::size_t index)
+{
+  AllowedCollision::Type type;
+  default_entries_[index] = acm.getDefaultEntry(names_[index], type) ? type : NOT_FOUND;
+  DecideContactFn fn;
+  if (acm.getDefaultEntry(names_[index], fn))
+    default_fns_[static_cast<int>(index)] = fn;
+  else
+    default_fns_.erase(static_cast<int>(index));
+}
+
+void CompiledAllowedCollisionMatrix::compilePair(const AllowedCollisionMatrix& acm, std::size_t index1,
+                                                 std::size_t index2)
+{
+  const std::string& name1 = names_[index1];
+  const std::string& name2 = names_[index2];
+  const std::size_t k = index1 * names_.size() + index2;
+  AllowedCollision::Type type;
+  entries_[k] = acm.getEntry(name1, name2, type) ? type : NOT_FOUND;
+  allowed_[k] = acm.getAllowedCollision(name1, name2, type) ? type : NOT_FOUND;
+  DecideContactFn fn;
+  if (acm.getEntry(name1, name2, fn))
+    entry_fns_[k] = fn;
+  else
+    entry_fns_.erase(k);
+  if (acm.getAllowedCollision(name1, name2, fn))
+    allowed_fns_[k] = fn;
+  else
+    allowed_fns_.erase(k);
+}
+
+int CompiledAllowedCollisionMatrix::getIndex(const std::string& name) const
+{
+  auto it = indices_.find(name);
+  return it == indices_.end() ? -1 : it->second;
+}
+
+bool CompiledAllowedCollisionMatrix::getEntry(int index1, int index2,
+                                              AllowedCollision::Type& allowed_collision_type) const
+{
+  if (index1 < 0 || index2 < 0)
+    return false;
+  const std::uint8_t type = entries_[pairIndex(index1, index2)];
+  if (type == NOT_FOUND)
+    return false;
+  allowed_collision_type = static_cast<AllowedCollision::Type>(type);
+  return true;
+}
+
+bool CompiledAllowedCollisionMatrix::getEntry(int index1, int index2, DecideContactFn& fn) const
+{
+  if (index1 < 0 || index2 < 0)
+    return false;
+  auto it = entry_fns_.find(pairIndex(index1, index2));
+  if (it == entry_fns_.end())
+    return false;
+  fn = it->second;
+  return true;
+}
+
+bool CompiledAllowedCollisionMatrix::getAllowedCollision(int index1, int index2,
+                                                         AllowedCollision::Type& allowed_collision) const
+{
+  if (index1 >= 0 && index2 >= 0)
+  {
+    const std::uint8_t type = allowed_[pairIndex(index1, index2)];
+    if (type == NOT_FOUND)
+      return false;
+    allowed_collision = static_cast<AllowedCollision::Type>(type);
+    return true;
+  }
+
+  // an unknown element has no entries, so only the default of the other one can apply
+  const int known = index1 >= 0 ? index1 : index2;
+  if (known < 0 || default_entries_[known] == NOT_FOUND)
+    return false;
+  allowed_collision = static_cast<AllowedCollision::Type>(default_entries_[known]);
+  return true;
+}
+
+bool CompiledAllowedCollisionMatrix::getAllowedCollision(int index1, int index2, DecideContactFn& fn) const
+{
+  if (index1 >= 0 && index2 >= 0)
+  {
+    auto it = allowed_fns_.find(pairIndex(index1, index2));
+    if (it == allowed_fns_.end())
+      return false;
+    fn = it->second;
+    return true;
+  }
+
+  const int known = index1 >= 0 ? index1 : index2;
+  if (known < 0)
+    return false;
+  auto it = default_fns_.find(known);
+  if (it == default_fns_.end())
+    return false;
+  fn = it->second;
+  return true;
+}
+
+int CompiledAllowedCollisionMatrix::IndexCache::getIndex(const CompiledAllowedCollisionMatrix& compiled,
+                                                         const std::string& name) const
+{
+  const std::uint64_t packed = packed_.load(std::memory_order_relaxed);
+  if (static_cast<std::uint32_t>(packed >> 32) == compiled.getSerial())
+    return static_cast<int>(static_cast<std::uint32_t>(packed)) - 1;
+
+  const int index = compiled.getIndex(name);
+  packed_.store(static_cast<std::uint64_t>(compiled.getSerial()) << 32 | static_cast<std::uint32_t>(index + 1),
+                std::memory_order_relaxed);
+  return index;
+}
+
 }  // end of namespace collision_detection
@@ -0,0 +1,159 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/collision_detection/collision_matrix.h>
+
+using namespace collision_detection;
+
+static bool allowNothing(Contact& /*contact*/)
+{
+  return false;
+}
+
+/** \brief Compare all queries of the compiled matrix to the ones of the matrix it was compiled from */
+static void expectEqualQueries(const AllowedCollisionMatrix& acm, const std::vector<std::string>& names)
+{
+  CompiledAllowedCollisionMatrixConstPtr compiled = acm.getCompiled();
+  for (const std::string& name1 : names)
+    for (const std::string& name2 : names)
+    {
+      const int index1 = compiled->getIndex(name1);
+      const int index2 = compiled->getIndex(name2);
+      AllowedCollision::Type type, compiled_type;
+      DecideContactFn fn, compiled_fn;
+
+      bool found = acm.getEntry(name1, name2, type);
+      EXPECT_EQ(compiled->getEntry(index1, index2, compiled_type), found) << name1 << ", " << name2;
+      if (found)
+        EXPECT_EQ(compiled_type, type) << name1 << ", " << name2;
+
+      found = acm.getAllowedCollision(name1, name2, type);
+      EXPECT_EQ(compiled->getAllowedCollision(index1, index2, compiled_type), found) << name1 << ", " << name2;
+      if (found)
+        EXPECT_EQ(compiled_type, type) << name1 << ", " << name2;
+
+      EXPECT_EQ(compiled->getEntry(index1, index2, compiled_fn), acm.getEntry(name1, name2, fn));
+      EXPECT_EQ(compiled->getAllowedCollision(index1, index2, compiled_fn), acm.getAllowedCollision(name1, name2, fn));
+    }
+}
+
+TEST(CompiledAllowedCollisionMatrix, MatchesAllowedCollisionMatrix)
+{
+  AllowedCollisionMatrix acm(std::vector<std::string>{ "link1", "link2", "link3", "link4" }, false);
+  acm.setEntry("link1", "link2", true);
+  acm.setEntry("link2", "link3", DecideContactFn(&allowNothing));
+  acm.setDefaultEntry("object", true);
+  acm.setDefaultEntry("link4", DecideContactFn(&allowNothing));
+
+  // "unknown" is not part of the matrix at all
+  const std::vector<std::string> names{ "link1", "link2", "link3", "link4", "object", "unknown" };
+  expectEqualQueries(acm, names);
+
+  CompiledAllowedCollisionMatrixConstPtr compiled = acm.getCompiled();
+  EXPECT_EQ(compiled->getSize(), 5u);
+  EXPECT_EQ(compiled->getIndex("unknown"), -1);
+  EXPECT_EQ(acm.getCompiled(), compiled);
+
+  // modifications invalidate the snapshot
+  acm.setDefaultEntry("link1", false);
+  acm.removeEntry("link3");
+  EXPECT_NE(acm.getCompiled(), compiled);
+  expectEqualQueries(acm, names);
+}
+
+TEST(CompiledAllowedCollisionMatrix, IndexCache)
+{
+  AllowedCollisionMatrix acm(std::vector<std::string>{ "link1", "link2" }, false);
+  CompiledAllowedCollisionMatrix::IndexCache cache;
+  const int index = cache.getIndex(*acm.getCompiled(), "link2");
+  EXPECT_EQ(index, acm.getCompiled()->getIndex("link2"));
+  EXPECT_EQ(cache.getIndex(*acm.getCompiled(), "link2"), index);
+
+  // a new snapshot with a different layout has to be noticed. Adding a name patches the snapshot and keeps the
+  // indices, modifying the whole matrix compiles it anew in sorted order
+  acm.setEntry("link0", "link1", true);
+  EXPECT_EQ(cache.getIndex(*acm.getCompiled(), "link2"), acm.getCompiled()->getIndex("link2"));
+  acm.setEntry(false);
+  EXPECT_EQ(cache.getIndex(*acm.getCompiled(), "link2"), acm.getCompiled()->getIndex("link2"));
+  EXPECT_NE(acm.getCompiled()->getIndex("link2"), index);
+
+  CompiledAllowedCollisionMatrix::IndexCache unknown;
+  EXPECT_EQ(unknown.getIndex(*acm.getCompiled(), "unknown"), -1);
+  EXPECT_EQ(unknown.getIndex(*acm.getCompiled(), "unknown"), -1);
+}
+
+TEST(CompiledAllowedCollisionMatrix, IncrementalUpdates)
+{
+  std::vector<std::string> names;
+  for (int i = 0; i < 12; ++i)
+    names.push_back("link" + std::to_string(i));
+  AllowedCollisionMatrix acm(names, false);
+  names.push_back("object");
+  names.push_back("unknown");
+  CompiledAllowedCollisionMatrixConstPtr compiled = acm.getCompiled();
+
+  // each modification of a single entry patches the previous snapshot, which stays unchanged for its holders
+  acm.setEntry("link1", "link2", true);
+  CompiledAllowedCollisionMatrixConstPtr patched = acm.getCompiled();
+  EXPECT_NE(patched, compiled);
+  AllowedCollision::Type type;
+  ASSERT_TRUE(compiled->getEntry(compiled->getIndex("link1"), compiled->getIndex("link2"), type));
+  EXPECT_EQ(type, AllowedCollision::NEVER);
+  expectEqualQueries(acm, names);
+
+  acm.setEntry("link3", "object", DecideContactFn(&allowNothing));
+  expectEqualQueries(acm, names);
+  acm.setDefaultEntry("link4", true);
+  acm.setDefaultEntry("object", DecideContactFn(&allowNothing));
+  expectEqualQueries(acm, names);
+  acm.removeEntry("link1", "link2");
+  acm.removeEntry("link5");
+  expectEqualQueries(acm, names);
+  acm.setEntry("link5", "link6", true);
+  expectEqualQueries(acm, names);
+  EXPECT_EQ(acm.getCompiled()->getIndex("link1"), compiled->getIndex("link1"));
+
+  // copies patch their own snapshots
+  AllowedCollisionMatrix copy(acm);
+  copy.setEntry("link0", "link1", true);
+  expectEqualQueries(copy, names);
+  expectEqualQueries(acm, names);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -41,6 +41,7 @@
 #include <moveit/collision_detection_bullet/bullet_integration/basic_types.h>
 #include <moveit/collision_detection_bullet/bullet_integration/contact_checker_common.h>
 #include <moveit/collision_detection/collision_common.h>
+#include <moveit/collision_detection/collision_matrix.h>
 #include <moveit/macros/declare_ptr.h>
 #include <moveit/macros/class_forward.h>
 
@@ -172,6 +173,9 @@ public:
   /** \brief The robot links the collision objects is allowed to touch */
   std::set<std::string> m_touch_links;
 
+  /** \brief Caches the index of the object in the most recently used compiled allowed collision matrix */
+  collision_detection::CompiledAllowedCollisionMatrix::IndexCache m_acm_index;
+
   /** @brief Get the collision object name */
   const std::string& getName() const
   {
@@ -265,6 +269,26 @@ protected:
   std::vector<std::shared_ptr<void>> m_data;
 };
 
+/** \brief Allowed = true. Equivalent of acmCheck() for the compiled allowed collision matrix, which avoids looking up
+ *  the objects by name. */
+inline bool acmCheck(const CollisionObjectWrapper* cow0, const CollisionObjectWrapper* cow1,
+                     const collision_detection::CompiledAllowedCollisionMatrix* acm)
+{
+  collision_detection::AllowedCollision::Type allowed_type;
+
+  if (acm != nullptr && acm->getEntry(cow0->m_acm_index.getIndex(*acm, cow0->getName()),
+                                      cow1->m_acm_index.getIndex(*acm, cow1->getName()), allowed_type))
+  {
+    ROS_DEBUG_STREAM_NAMED("collision_detection.bullet", "Entry in ACM found for " << cow0->getName() << " and "
+                                                                                   << cow1->getName());
+    return allowed_type != collision_detection::AllowedCollision::Type::NEVER;
+  }
+
+  ROS_DEBUG_STREAM_NAMED("collision_detection.bullet",
+                         "No entry in ACM, collision check between " << cow0->getName() << " and " << cow1->getName());
+  return false;
+}
+
 /** @brief Casted collision shape used for checking if an object is collision free between two discrete poses
  *
  *  The cast is not explicitely computed but implicitely represented through the single shape and the transformation
@@ -568,6 +592,9 @@ struct BroadphaseContactResultCallback
   double contact_distance_;
   const collision_detection::AllowedCollisionMatrix* acm_{ nullptr };
 
+  /** \brief Index-based snapshot of \e acm_, used for the pairwise queries */
+  collision_detection::CompiledAllowedCollisionMatrixConstPtr compiled_acm_;
+
   /** \brief Indicates if the callback is used for only self-collision checking */
   bool self_;
 
@@ -578,6 +605,8 @@ struct BroadphaseContactResultCallback
                                   const collision_detection::AllowedCollisionMatrix* acm, bool self, bool cast = false)
     : collisions_(collisions), contact_distance_(contact_distance), acm_(acm), self_(self), cast_(cast)
   {
+    if (acm_)
+      compiled_acm_ = acm_->getCompiled();
   }
 
   ~BroadphaseContactResultCallback() = default;
@@ -589,12 +618,12 @@ struct BroadphaseContactResultCallback
   {
     if (cast_)
     {
-      return !collisions_.done && !isOnlyKinematic(cow0, cow1) && !acmCheck(cow0->getName(), cow1->getName(), acm_);
+      return !collisions_.done && !isOnlyKinematic(cow0, cow1) && !acmCheck(cow0, cow1, compiled_acm_.get());
     }
     else
     {
       return !collisions_.done && (self_ ? isOnlyKinematic(cow0, cow1) : !isOnlyKinematic(cow0, cow1)) &&
-             !acmCheck(cow0->getName(), cow1->getName(), acm_);
+             !acmCheck(cow0, cow1, compiled_acm_.get());
     }
   }
 
@@ -39,6 +39,7 @@
 #include <moveit/collision_detection/collision_env.h>
 #include <moveit/collision_detection_bullet/bullet_integration/bullet_discrete_bvh_manager.h>
 #include <moveit/collision_detection_bullet/bullet_integration/bullet_cast_bvh_manager.h>
+#include <memory>
 #include <mutex>
 
 namespace collision_detection
@@ -60,6 +61,10 @@ public:
 
   CollisionEnvBullet(CollisionEnvBullet&) = delete;
 
+  // keep the CompactCollisionResult overloads of CollisionEnv visible
+  using CollisionEnv::checkRobotCollision;
+  using CollisionEnv::checkSelfCollision;
+
   void checkSelfCollision(const CollisionRequest& req, CollisionResult& res,
                           const moveit::core::RobotState& state) const override;
 
@@ -113,19 +118,20 @@ protected:
   /** \brief Construts a bullet collision object out of a robot link */
   void addLinkAsCollisionObject(const urdf::LinkSharedPtr& link);
 
-  /** \brief Handles self collision checks */
+  /** \brief Holds the collision objects of the robot links and the world.
+   *
+   *  Checks do not use this manager directly, but per-thread clones of it which share its collision shapes (see
+   *  ScopedManagers). Changes to it have to be followed by a call to invalidateManagers(). */
   collision_detection_bullet::BulletDiscreteBVHManagerPtr manager_{
     new collision_detection_bullet::BulletDiscreteBVHManager()
   };
 
-  /** \brief Handles continuous robot world collision checks */
-  collision_detection_bullet::BulletCastBVHManagerPtr manager_CCD_{
-    new collision_detection_bullet::BulletCastBVHManager()
-  };
-
-  // Lock manager_ and manager_CCD_, for thread-safe collision tests
+  /** \brief Lock manager_ while it is modified or cloned, so threads can clone it while the world changes */
   mutable std::mutex collision_env_mutex_;
 
+  /** \brief Invalidate the per-thread clones of the managers of all threads. */
+  void invalidateManagers();
+
   /** \brief Adds a world object to the collision managers */
   void addToManager(const World::Object* obj);
 
@@ -140,9 +146,20 @@ protected:
   std::vector<std::string> active_;
 
 private:
+  struct ManagerCacheEntry;
+  class ScopedManagers;
+
+  /** \brief Fill \e entry with new clones of manager_ for discrete and continuous checks. */
+  void cloneManagers(ManagerCacheEntry& entry) const;
+
   /** \brief Callback function executed for each change to the world environment */
   void notifyObjectChange(const ObjectConstPtr& obj, World::Action action);
 
   World::ObserverHandle observer_handle_;
+
+  /** \brief Identifies the current contents of manager_. Per-thread clones only hold a weak reference to it, so
+   *   replacing it makes them outdated and they are discarded once this environment is destroyed. Accessed atomically,
+   *   as it is read by checks without locking. */
+  std::shared_ptr<const int> managers_token_{ std::make_shared<const int>(0) };
 };
 }  // namespace collision_detection
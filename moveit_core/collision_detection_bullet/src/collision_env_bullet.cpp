@@ -41,6 +41,8 @@
 #include <boost/bind.hpp>
 #include <bullet/btBulletCollisionCommon.h>
 
+#include <map>
+
 namespace collision_detection
 {
 const std::string CollisionDetectorAllocatorBullet::NAME("Bullet");
@@ -93,6 +95,104 @@ CollisionEnvBullet::~CollisionEnvBullet()
   getWorld()->removeObserver(observer_handle_);
 }
 
+/** \brief This thread's clones of the collision managers of a single CollisionEnvBullet. */
+struct CollisionEnvBullet::ManagerCacheEntry
+{
+  /** \brief Refers to \e managers_token_ of the environment the clones were made from. */
+  std::weak_ptr<const int> token_;
+
+  /** \brief Handles self collision and discrete robot world collision checks */
+  collision_detection_bullet::BulletDiscreteBVHManagerPtr manager_;
+
+  /** \brief Handles continuous robot world collision checks */
+  collision_detection_bullet::BulletCastBVHManagerPtr manager_CCD_;
+
+  /** \brief Set while a check uses this entry, which guards against reentrant checks from within callbacks. */
+  bool in_use_ = false;
+};
+
+void CollisionEnvBullet::cloneManagers(ManagerCacheEntry& entry) const
+{
+  std::lock_guard<std::mutex> guard(collision_env_mutex_);
+  entry.token_ = managers_token_;
+  entry.manager_ = manager_->clone();
+
+  // the cast manager converts the clones of the robot links into cast objects, but shares the world objects' shapes
+  entry.manager_CCD_.reset(new collision_detection_bullet::BulletCastBVHManager());
+  for (const std::pair<const std::string, collision_detection_bullet::CollisionObjectWrapperPtr>& cow :
+       manager_->getCollisionObjects())
+    entry.manager_CCD_->addCollisionObject(cow.second->clone());
+}
+
+void CollisionEnvBullet::invalidateManagers()
+{
+  std::atomic_store(&managers_token_, std::make_shared<const int>(0));
+}
+
+/** \brief Provides this thread's clones of the collision managers for the duration of a single check.
+ *
+ *  The clones are only made again after the world or the robot's geometry changed. Checks therefore run in parallel
+ *  without locking, except for the first check of each thread after such a change. */
+class CollisionEnvBullet::ScopedManagers
+{
+public:
+  ScopedManagers(const CollisionEnvBullet& env)
+  {
+    // every this many newly cloned entries, entries of destroyed environments are removed
+    static const unsigned int MAX_CLEAN_COUNT = 100;
+
+    // each thread gets its own instance, so no locking is needed
+    static thread_local std::map<const CollisionEnvBullet*, ManagerCacheEntry> cache;
+    static thread_local unsigned int clean_count = 0;
+
+    entry_ = &cache[&env];
+    if (entry_->in_use_)
+    {
+      env.cloneManagers(fallback_);
+      entry_ = &fallback_;
+      return;
+    }
+
+    const std::shared_ptr<const int> token = std::atomic_load(&env.managers_token_);
+    if (entry_->token_.owner_before(token) || token.owner_before(entry_->token_))
+    {
+      env.cloneManagers(*entry_);
+      if (++clean_count > MAX_CLEAN_COUNT)
+      {
+        clean_count = 0;
+        for (auto it = cache.begin(); it != cache.end();)
+          if (it->second.token_.expired() && !it->second.in_use_)
+            it = cache.erase(it);
+          else
+            ++it;
+      }
+    }
+    entry_->in_use_ = true;
+  }
+
+  ~ScopedManagers()
+  {
+    entry_->in_use_ = false;
+  }
+
+  ScopedManagers(const ScopedManagers&) = delete;
+  ScopedManagers& operator=(const ScopedManagers&) = delete;
+
+  const collision_detection_bullet::BulletDiscreteBVHManagerPtr& discrete() const
+  {
+    return entry_->manager_;
+  }
+
+  const collision_detection_bullet::BulletCastBVHManagerPtr& cast() const
+  {
+    return entry_->manager_CCD_;
+  }
+
+private:
+  ManagerCacheEntry* entry_;
+  ManagerCacheEntry fallback_;
+};
+
 void CollisionEnvBullet::checkSelfCollision(const CollisionRequest& req, CollisionResult& res,
                                             const moveit::core::RobotState& state) const
 {
@@ -110,34 +210,35 @@ void CollisionEnvBullet::checkSelfCollisionHelper(const CollisionRequest& req, C
                                                   const moveit::core::RobotState& state,
                                                   const AllowedCollisionMatrix* acm) const
 {
-  std::lock_guard<std::mutex> guard(collision_env_mutex_);
+  ScopedManagers managers(*this);
+  const collision_detection_bullet::BulletDiscreteBVHManagerPtr& manager = managers.discrete();
 
   std::vector<collision_detection_bullet::CollisionObjectWrapperPtr> cows;
   addAttachedOjects(state, cows);
 
   if (req.distance)
   {
-    manager_->setContactDistanceThreshold(MAX_DISTANCE_MARGIN);
+    manager->setContactDistanceThreshold(MAX_DISTANCE_MARGIN);
   }
 
   for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : cows)
   {
-    manager_->addCollisionObject(cow);
-    manager_->setCollisionObjectsTransform(
+    manager->addCollisionObject(cow);
+    manager->setCollisionObjectsTransform(
         cow->getName(), state.getAttachedBody(cow->getName())->getGlobalCollisionBodyTransforms()[0]);
   }
 
   // updating link positions with the current robot state
   for (const std::string& link : active_)
   {
-    manager_->setCollisionObjectsTransform(link, state.getCollisionBodyTransform(link, 0));
+    manager->setCollisionObjectsTransform(link, state.getCollisionBodyTransform(link, 0));
   }
 
-  manager_->contactTest(res, req, acm, true);
+  manager->contactTest(res, req, acm, true);
 
   for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : cows)
   {
-    manager_->removeCollisionObject(cow->getName());
+    manager->removeCollisionObject(cow->getName());
   }
 }
 
@@ -173,29 +274,30 @@ void CollisionEnvBullet::checkRobotCollisionHelper(const CollisionRequest& req,
                                                    const moveit::core::RobotState& state,
                                                    const AllowedCollisionMatrix* acm) const
 {
-  std::lock_guard<std::mutex> guard(collision_env_mutex_);
+  ScopedManagers managers(*this);
+  const collision_detection_bullet::BulletDiscreteBVHManagerPtr& manager = managers.discrete();
 
   if (req.distance)
   {
-    manager_->setContactDistanceThreshold(MAX_DISTANCE_MARGIN);
+    manager->setContactDistanceThreshold(MAX_DISTANCE_MARGIN);
   }
 
   std::vector<collision_detection_bullet::CollisionObjectWrapperPtr> attached_cows;
   addAttachedOjects(state, attached_cows);
-  updateTransformsFromState(state, manager_);
+  updateTransformsFromState(state, manager);
 
   for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : attached_cows)
   {
-    manager_->addCollisionObject(cow);
-    manager_->setCollisionObjectsTransform(
+    manager->addCollisionObject(cow);
+    manager->setCollisionObjectsTransform(
         cow->getName(), state.getAttachedBody(cow->getName())->getGlobalCollisionBodyTransforms()[0]);
   }
 
-  manager_->contactTest(res, req, acm, false);
+  manager->contactTest(res, req, acm, false);
 
   for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : attached_cows)
   {
-    manager_->removeCollisionObject(cow->getName());
+    manager->removeCollisionObject(cow->getName());
   }
 }
 
@@ -204,30 +306,31 @@ void CollisionEnvBullet::checkRobotCollisionHelperCCD(const CollisionRequest& re
                                                       const moveit::core::RobotState& state2,
                                                       const AllowedCollisionMatrix* acm) const
 {
-  std::lock_guard<std::mutex> guard(collision_env_mutex_);
+  ScopedManagers managers(*this);
+  const collision_detection_bullet::BulletCastBVHManagerPtr& manager_CCD = managers.cast();
 
   std::vector<collision_detection_bullet::CollisionObjectWrapperPtr> attached_cows;
   addAttachedOjects(state1, attached_cows);
 
   for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : attached_cows)
   {
-    manager_CCD_->addCollisionObject(cow);
-    manager_CCD_->setCastCollisionObjectsTransform(
+    manager_CCD->addCollisionObject(cow);
+    manager_CCD->setCastCollisionObjectsTransform(
         cow->getName(), state1.getAttachedBody(cow->getName())->getGlobalCollisionBodyTransforms()[0],
         state2.getAttachedBody(cow->getName())->getGlobalCollisionBodyTransforms()[0]);
   }
 
   for (const std::string& link : active_)
   {
-    manager_CCD_->setCastCollisionObjectsTransform(link, state1.getCollisionBodyTransform(link, 0),
-                                                   state2.getCollisionBodyTransform(link, 0));
+    manager_CCD->setCastCollisionObjectsTransform(link, state1.getCollisionBodyTransform(link, 0),
+                                                  state2.getCollisionBodyTransform(link, 0));
   }
 
-  manager_CCD_->contactTest(res, req, acm, false);
+  manager_CCD->contactTest(res, req, acm, false);
 
   for (const collision_detection_bullet::CollisionObjectWrapperPtr& cow : attached_cows)
   {
-    manager_CCD_->removeCollisionObject(cow->getName());
+    manager_CCD->removeCollisionObject(cow->getName());
   }
 }
 
@@ -260,7 +363,6 @@ void CollisionEnvBullet::addToManager(const World::Object* obj)
       false));
 
   manager_->addCollisionObject(cow);
-  manager_CCD_->addCollisionObject(cow->clone());
 }
 
 void CollisionEnvBullet::updateManagedObject(const std::string& id)
@@ -271,7 +373,6 @@ void CollisionEnvBullet::updateManagedObject(const std::string& id)
     if (manager_->hasCollisionObject(id))
     {
       manager_->removeCollisionObject(id);
-      manager_CCD_->removeCollisionObject(id);
       addToManager(it->second.get());
     }
     else
@@ -284,7 +385,6 @@ void CollisionEnvBullet::updateManagedObject(const std::string& id)
     if (manager_->hasCollisionObject(id))
     {
       manager_->removeCollisionObject(id);
-      manager_CCD_->removeCollisionObject(id);
     }
   }
 }
@@ -312,12 +412,12 @@ void CollisionEnvBullet::notifyObjectChange(const ObjectConstPtr& obj, World::Ac
   if (action == World::DESTROY)
   {
     manager_->removeCollisionObject(obj->id_);
-    manager_CCD_->removeCollisionObject(obj->id_);
   }
   else
   {
     updateManagedObject(obj->id_);
   }
+  invalidateManagers();
 }
 
 void CollisionEnvBullet::addAttachedOjects(const moveit::core::RobotState& state,
@@ -350,6 +450,7 @@ void CollisionEnvBullet::addAttachedOjects(const moveit::core::RobotState& state
 
 void CollisionEnvBullet::updatedPaddingOrScaling(const std::vector<std::string>& links)
 {
+  std::lock_guard<std::mutex> guard(collision_env_mutex_);
   for (const std::string& link : links)
   {
     if (robot_model_->getURDF()->links_.find(link) != robot_model_->getURDF()->links_.end())
@@ -361,6 +462,7 @@ void CollisionEnvBullet::updatedPaddingOrScaling(const std::vector<std::string>&
       ROS_ERROR_NAMED("collision_detection.bullet", "Updating padding or scaling for unknown link: '%s'", link.c_str());
     }
   }
+  invalidateManagers();
 }
 
 void CollisionEnvBullet::updateTransformsFromState(
@@ -418,7 +520,6 @@ void CollisionEnvBullet::addLinkAsCollisionObject(const urdf::LinkSharedPtr& lin
     if (manager_->hasCollisionObject(link->name))
     {
       manager_->removeCollisionObject(link->name);
-      manager_CCD_->removeCollisionObject(link->name);
     }
 
     try
@@ -426,7 +527,6 @@ void CollisionEnvBullet::addLinkAsCollisionObject(const urdf::LinkSharedPtr& lin
       collision_detection_bullet::CollisionObjectWrapperPtr cow(new collision_detection_bullet::CollisionObjectWrapper(
           link->name, collision_detection::BodyType::ROBOT_LINK, shapes, shape_poses, collision_object_types, true));
       manager_->addCollisionObject(cow);
-      manager_CCD_->addCollisionObject(cow->clone());
       active_.push_back(cow->getName());
     }
     catch (std::exception&)
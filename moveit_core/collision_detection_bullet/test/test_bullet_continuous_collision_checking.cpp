@@ -51,6 +51,9 @@
 #include <urdf_parser/urdf_parser.h>
 #include <geometric_shapes/shape_operations.h>
 
+#include <atomic>
+#include <thread>
+
 namespace cb = collision_detection_bullet;
 
 /** \brief Brings the panda robot in user defined home position */
@@ -315,6 +318,95 @@ TEST_F(BulletCollisionDetectionTester, ContinuousCollisionWorld)
   res.clear();
 }
 
+/** \brief Discrete and continuous checks from several threads have to give the same results as a single thread. */
+TEST_F(BulletCollisionDetectionTester, ParallelChecks)
+{
+  moveit::core::RobotState state1(robot_model_);
+  moveit::core::RobotState state2(robot_model_);
+  setToHome(state1);
+  setToHome(state2);
+  double joint_2{ 0.05 };
+  double joint_4{ -1.6 };
+  state2.setJointPositions("panda_joint2", &joint_2);
+  state2.setJointPositions("panda_joint4", &joint_4);
+  state2.update();
+
+  shapes::ShapeConstPtr shape_ptr(new shapes::Box(0.1, 0.1, 0.1));
+  Eigen::Isometry3d pos{ Eigen::Isometry3d::Identity() };
+  pos.translation().x() = 0.43;
+  pos.translation().z() = 0.55;
+  cenv_->getWorld()->addToObject("box", shape_ptr, pos);
+
+  collision_detection::CollisionRequest req;
+  std::atomic<unsigned int> failures(0);
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < 4; ++i)
+    threads.emplace_back([&]() {
+      for (unsigned int j = 0; j < 50; ++j)
+      {
+        collision_detection::CollisionResult res;
+        cenv_->checkRobotCollision(req, res, state1, *acm_);
+        if (res.collision)
+          ++failures;
+        res.clear();
+        cenv_->checkSelfCollision(req, res, state1, *acm_);
+        if (res.collision)
+          ++failures;
+        res.clear();
+        cenv_->checkRobotCollision(req, res, state1, state2, *acm_);
+        if (!res.collision)
+          ++failures;
+      }
+    });
+  for (std::thread& thread : threads)
+    thread.join();
+  EXPECT_EQ(failures, 0u);
+
+  // the threads' copies of the world have to be updated after the world changes
+  cenv_->getWorld()->removeObject("box");
+  collision_detection::CollisionResult res;
+  cenv_->checkRobotCollision(req, res, state1, state2, *acm_);
+  EXPECT_FALSE(res.collision);
+}
+
+/** \brief The CompactCollisionResult overloads of CollisionEnv have to be callable on CollisionEnvBullet directly. */
+TEST_F(BulletCollisionDetectionTester, CompactCollisionResult)
+{
+  const collision_detection::CollisionEnvBullet& env =
+      static_cast<const collision_detection::CollisionEnvBullet&>(*cenv_);
+
+  shapes::ShapeConstPtr shape_ptr(new shapes::Box(0.3, 0.3, 0.3));
+  Eigen::Isometry3d pos{ Eigen::Isometry3d::Identity() };
+  pos.translation().x() = 0.43;
+  pos.translation().z() = 0.55;
+  cenv_->getWorld()->addToObject("box", shape_ptr, pos);
+
+  moveit::core::RobotState state(robot_model_);
+  setToHome(state);
+  state.update();
+
+  collision_detection::CollisionRequest req;
+  req.contacts = true;
+  req.max_contacts = 10;
+  collision_detection::CollisionResult res;
+  collision_detection::CompactCollisionResult compact_res;
+  collision_detection::CollisionResult converted;
+
+  env.checkRobotCollision(req, res, state, *acm_);
+  env.checkRobotCollision(req, compact_res, state, *acm_);
+  compact_res.getCollisionResult(converted);
+  ASSERT_TRUE(res.collision);
+  EXPECT_EQ(converted.collision, res.collision);
+  EXPECT_EQ(converted.contact_count, res.contact_count);
+
+  res.clear();
+  compact_res.clear();
+  env.checkSelfCollision(req, res, state, *acm_);
+  env.checkSelfCollision(req, compact_res, state, *acm_);
+  EXPECT_FALSE(res.collision);
+  EXPECT_FALSE(compact_res.collision);
+}
+
 TEST(ContinuousCollisionUnit, BulletCastBVHCollisionBoxBoxUnit)
 {
   collision_detection::CollisionResult result;
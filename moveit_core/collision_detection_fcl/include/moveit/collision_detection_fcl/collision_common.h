@@ -45,13 +45,16 @@
 #if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
 #include <fcl/broadphase/broadphase_collision_manager.h>
 #include <fcl/narrowphase/collision.h>
+#include <fcl/narrowphase/continuous_collision.h>
 #include <fcl/narrowphase/distance.h>
 #else
 #include <fcl/broadphase/broadphase.h>
 #include <fcl/collision.h>
+#include <fcl/continuous_collision.h>
 #include <fcl/distance.h>
 #endif
 
+#include <limits>
 #include <memory>
 #include <set>
 
@@ -118,6 +121,12 @@ struct CollisionGeometryData
     return type == other.type && ptr.raw == other.ptr.raw;
   }
 
+  /** \brief Returns the index of the body in \e acm, remembering it for subsequent queries. */
+  int getACMIndex(const CompiledAllowedCollisionMatrix& acm) const
+  {
+    return acm_index.getIndex(acm, getID());
+  }
+
   /** \brief Indicates the body type of the object. */
   BodyType type;
 
@@ -135,18 +144,24 @@ struct CollisionGeometryData
     const World::Object* obj;
     const void* raw;
   } ptr;
+
+  /** \brief Caches the index of the body in the most recently used compiled collision matrix. */
+  CompiledAllowedCollisionMatrix::IndexCache acm_index;
 };
 
 /** \brief Data structure which is passed to the collision callback function of the collision manager. */
 struct CollisionData
 {
-  CollisionData() : req_(nullptr), active_components_only_(nullptr), res_(nullptr), acm_(nullptr), done_(false)
+  CollisionData()
+    : req_(nullptr), active_components_only_(nullptr), res_(nullptr), compact_res_(nullptr), acm_(nullptr), done_(false)
   {
   }
 
   CollisionData(const CollisionRequest* req, CollisionResult* res, const AllowedCollisionMatrix* acm)
-    : req_(req), active_components_only_(nullptr), res_(res), acm_(acm), done_(false)
+    : req_(req), active_components_only_(nullptr), res_(res), compact_res_(nullptr), acm_(acm), done_(false)
   {
+    if (acm_)
+      compiled_acm_ = acm_->getCompiled();
   }
 
   ~CollisionData()
@@ -156,6 +171,15 @@ struct CollisionData
   /** \brief Compute \e active_components_only_ based on the joint group specified in \e req_ */
   void enableGroup(const moveit::core::RobotModelConstPtr& robot_model);
 
+  /** \brief Get the number of contacts stored for the pair of bodies \e cd1 and \e cd2 */
+  std::size_t getContactCount(const CollisionGeometryData& cd1, const CollisionGeometryData& cd2) const;
+
+  /** \brief Store a contact in \e compact_res_, if set, or in \e res_ otherwise */
+  void addContact(const Contact& c);
+
+  /** \brief Store an FCL contact in \e compact_res_, if set, or in \e res_ otherwise */
+  void addContact(const fcl::Contactd& fc);
+
   /** \brief The collision request passed by the user */
   const CollisionRequest* req_;
 
@@ -168,9 +192,15 @@ struct CollisionData
   /** \brief The user-specified response location. */
   CollisionResult* res_;
 
+  /** \brief If set, contacts are stored here instead of in \e res_, which still receives all other results. */
+  CompactCollisionResult* compact_res_;
+
   /** \brief The user-specified collision matrix (may be NULL). */
   const AllowedCollisionMatrix* acm_;
 
+  /** \brief Index-based snapshot of \e acm_, used for the pairwise queries (NULL if \e acm_ is NULL). */
+  CompiledAllowedCollisionMatrixConstPtr compiled_acm_;
+
   /** \brief Flag indicating whether collision checking is complete. */
   bool done_;
 };
@@ -178,8 +208,11 @@ struct CollisionData
 /** \brief Data structure which is passed to the distance callback function of the collision manager. */
 struct DistanceData
 {
-  DistanceData(const DistanceRequest* req, DistanceResult* res) : req(req), res(res), done(false)
+  DistanceData(const DistanceRequest* req, DistanceResult* res)
+    : req(req), res(res), pair_distance(std::numeric_limits<double>::quiet_NaN()), done(false)
   {
+    if (req->acm)
+      compiled_acm = req->acm->getCompiled();
   }
   ~DistanceData()
   {
@@ -191,10 +224,40 @@ struct DistanceData
   /** \brief Distance query results information. */
   DistanceResult* res;
 
+  /** \brief Index-based snapshot of the request's collision matrix (NULL if the request has none). */
+  CompiledAllowedCollisionMatrixConstPtr compiled_acm;
+
+  /** \brief Set by distanceCallback() to a lower bound of the distance of the pair it computed a distance for. It is
+   *   left unchanged for pairs that are skipped before a distance is computed. */
+  double pair_distance;
+
   /** \brief Indicates if distance query is finished. */
   bool done;
 };
 
+/** \brief Data structure which is passed to the continuous collision callback function of the collision manager.
+ *
+ *  The manager is queried with an object enclosing the volume swept by a single robot collision object. */
+struct ContinuousCollisionData
+{
+  ContinuousCollisionData(CollisionData* collision_data)
+    : collision_data_(collision_data), object_(nullptr), swept_volume_(nullptr)
+  {
+  }
+
+  /** \brief Request, result and filtering information, as used for discrete collision checks. */
+  CollisionData* collision_data_;
+
+  /** \brief The robot collision object, posed at the start of the motion. */
+  const fcl::CollisionObjectd* object_;
+
+  /** \brief The transform of \e object_ at the end of the motion. */
+  fcl::Transform3d end_transform_;
+
+  /** \brief The object the broadphase manager is queried with. */
+  const fcl::CollisionObjectd* swept_volume_;
+};
+
 MOVEIT_STRUCT_FORWARD(FCLGeometry);
 
 /** \brief Bundles the \e CollisionGeometryData and FCL collision geometry representation into a single class. */
@@ -277,6 +340,18 @@ struct FCLManager
  *   \return True terminates the collision check, false continues it to the next pair of objects */
 bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data);
 
+/** \brief Callback function used by the FCLManager for each pair of a swept volume of a robot collision object and
+ *   a world object to check for collisions during the motion of the robot object.
+ *
+ *   The robot object is linearly interpolated between its start and end transform. If the pair collides, the contact
+ *   at the time of contact is reported and its \e percent_interpolation is set accordingly.
+ *
+ *   \param o1 First FCL collision object
+ *   \param o2 Second FCL collision object
+ *   \data Pointer to the ContinuousCollisionData
+ *   \return True terminates the collision check, false continues it to the next pair of objects */
+bool continuousCollisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data);
+
 /** \brief Callback function used by the FCLManager used for each pair of collision objects to
  *   calculate collisions and distances.
  *
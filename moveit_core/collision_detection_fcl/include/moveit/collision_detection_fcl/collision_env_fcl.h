@@ -45,7 +45,9 @@
 #include <fcl/broadphase/broadphase.h>
 #endif
 
+#include <limits>
 #include <memory>
+#include <unordered_map>
 
 namespace collision_detection
 {
@@ -76,6 +78,12 @@ public:
   void checkRobotCollision(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state,
                            const AllowedCollisionMatrix& acm) const override;
 
+  void checkSelfCollision(const CollisionRequest& req, CompactCollisionResult& res,
+                          const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm) const override;
+
+  void checkRobotCollision(const CollisionRequest& req, CompactCollisionResult& res,
+                           const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm) const override;
+
   void checkRobotCollision(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state1,
                            const moveit::core::RobotState& state2, const AllowedCollisionMatrix& acm) const override;
 
@@ -90,6 +98,117 @@ public:
 
   void setWorld(const WorldPtr& world) override;
 
+  /** \brief Enable or disable the per-thread cache of the robot's FCL collision objects.
+   *
+   *   If enabled (the default), each thread keeps its own copy of the robot's FCL collision objects and of the
+   *   self-collision broadphase manager. Subsequent checks only update the transforms of these objects from the given
+   *   RobotState instead of allocating them and building a new broadphase structure on every call. */
+  void setRobotObjectCaching(bool enable)
+  {
+    cache_robot_objects_ = enable;
+  }
+
+  /** \brief Check whether the per-thread cache of the robot's FCL collision objects is enabled. */
+  bool getRobotObjectCaching() const
+  {
+    return cache_robot_objects_;
+  }
+
+  /** \brief Enable or disable incremental self-collision checking (disabled by default).
+   *
+   *   If enabled, the narrowphase result of each pair of links is kept in the per-thread robot object cache and only
+   *   pairs that involve a link which moved since the previous check are re-tested. This speeds up repeated checks in
+   *   which only some joints change, e.g. when planning for one arm of a multi-arm robot. It applies to requests that
+   *   do not ask for contacts or costs and requires robot object caching. */
+  void setIncrementalSelfCollision(bool enable)
+  {
+    incremental_self_collision_ = enable;
+  }
+
+  /** \brief Check whether incremental self-collision checking is enabled. */
+  bool getIncrementalSelfCollision() const
+  {
+    return incremental_self_collision_;
+  }
+
+  /** \brief Stateful distance queries for a sequence of similar robot states, e.g. one per control cycle.
+   *
+   *   The session remembers a lower bound of the distance of each pair of collision objects it evaluated, together
+   *   with the poses the objects had. Before a pair is evaluated again, this bound is reduced by how far the objects
+   *   can have moved since. If the result still is not below the request's distance threshold (or, for
+   *   DistanceRequestType::GLOBAL, the smallest distance found so far), the narrowphase is skipped. Global queries
+   *   start with the pair that was closest in the previous query, so this bound is tight early on.
+   *
+   *   Results are the same as those of CollisionEnvFCL::distanceSelf() and CollisionEnvFCL::distanceRobot(), which
+   *   also provide the reused broadphase structures. A session is meant to be used by a single thread and must not
+   *   outlive its environment. */
+  class DistanceSession
+  {
+  public:
+    DistanceSession(const CollisionEnvFCL& env);
+
+    /** \brief Compute the distances between the robot's links in \e state, see CollisionEnvFCL::distanceSelf(). */
+    void distanceSelf(const DistanceRequest& req, DistanceResult& res, const moveit::core::RobotState& state);
+
+    /** \brief Compute the distances between the robot in \e state and the world, see
+     *   CollisionEnvFCL::distanceRobot(). */
+    void distanceRobot(const DistanceRequest& req, DistanceResult& res, const moveit::core::RobotState& state);
+
+    /** \brief Forget all remembered pairs, so the next query is evaluated from scratch. */
+    void clear();
+
+    /** \brief The number of pairs whose narrowphase was skipped in the latest query. */
+    std::size_t getPrunedPairCount() const
+    {
+      return pruned_pairs_;
+    }
+
+  private:
+    /** \brief Pair of collision geometries, ordered by address. */
+    using PairKey = std::pair<const fcl::CollisionGeometryd*, const fcl::CollisionGeometryd*>;
+
+    struct PairKeyHash
+    {
+      std::size_t operator()(const PairKey& key) const
+      {
+        return std::hash<const void*>()(key.first) ^ (std::hash<const void*>()(key.second) << 1);
+      }
+    };
+
+    /** \brief What is remembered about a pair of collision geometries. */
+    struct PairEntry
+    {
+      /** \brief Detect geometries that were destroyed, whose addresses may be reused. */
+      std::weak_ptr<const fcl::CollisionGeometryd> geometries_[2];
+
+      /** \brief The poses of the geometries when \e distance_ was computed. */
+      Eigen::Isometry3d poses_[2];
+
+      /** \brief Lower bound of the distance of the geometries at \e poses_, NaN if unknown. */
+      double distance_ = std::numeric_limits<double>::quiet_NaN();
+
+      /** \brief The query the pair was last evaluated in. */
+      std::size_t query_ = 0;
+    };
+
+    struct QueryData;
+
+    /** \brief Distance callback that skips pairs whose remembered distance bound exceeds the current threshold. */
+    static bool coherentCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data, double& min_dist);
+
+    /** \brief Remove the entries of destroyed geometries every so many queries. */
+    void cleanPairs();
+
+    const CollisionEnvFCL& env_;
+    std::unordered_map<PairKey, PairEntry, PairKeyHash> pairs_;
+
+    /** \brief The geometries of the closest pair in the latest global query. */
+    PairKey closest_;
+
+    std::size_t query_;
+    std::size_t pruned_pairs_;
+  };
+
 protected:
   /** \brief Updates the FCL collision geometry and objects saved in the CollisionRobotFCL members to reflect a new
    *   padding or scaling of the robot links.
@@ -100,13 +219,26 @@ protected:
    *   \param links The names of the links which have been updated in the robot model */
   void updatedPaddingOrScaling(const std::vector<std::string>& links) override;
 
-  /** \brief Bundles the different checkSelfCollision functions into a single function */
+  /** \brief Bundles the different checkSelfCollision functions into a single function. If \e compact_res is given, the
+   *   contacts are stored there instead of in \e res. */
   void checkSelfCollisionHelper(const CollisionRequest& req, CollisionResult& res,
-                                const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm) const;
+                                const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm,
+                                CompactCollisionResult* compact_res = nullptr) const;
 
-  /** \brief Bundles the different checkRobotCollision functions into a single function */
+  /** \brief Bundles the different checkRobotCollision functions into a single function. If \e compact_res is given,
+   *   the contacts are stored there instead of in \e res. */
   void checkRobotCollisionHelper(const CollisionRequest& req, CollisionResult& res,
-                                 const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm) const;
+                                 const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm,
+                                 CompactCollisionResult* compact_res = nullptr) const;
+
+  /** \brief Bundles the continuous checkRobotCollision functions into a single function.
+   *
+   *   Each robot collision object is linearly interpolated from its pose in \e state1 to its pose in \e state2 and
+   *   checked against the world. Contacts report the fraction of the motion at which they occur in
+   *   \e percent_interpolation. Self-collisions are not checked. */
+  void checkRobotCollisionHelperCCD(const CollisionRequest& req, CollisionResult& res,
+                                    const moveit::core::RobotState& state1, const moveit::core::RobotState& state2,
+                                    const AllowedCollisionMatrix* acm) const;
 
   /** \brief Construct an FCL collision object from MoveIt's World::Object. */
   void constructFCLObjectWorld(const World::Object* obj, FCLObject& fcl_obj) const;
@@ -126,6 +258,12 @@ protected:
    *   \param fcl_obj The newly filled object */
   void constructFCLObjectRobot(const moveit::core::RobotState& state, FCLObject& fcl_obj) const;
 
+  /** \brief Appends the FCL collision objects of all bodies attached to the robot in \e state to \e fcl_obj.
+   *
+   *   \param state The current robot state
+   *   \param fcl_obj The object the attached bodies' collision objects are added to */
+  void constructFCLObjectAttachedBodies(const moveit::core::RobotState& state, FCLObject& fcl_obj) const;
+
   /** \brief Prepares for the collision check through constructing an FCL collision object out of the current robot
    *   state and specifying a broadphase collision manager of FCL where the constructed object is registered to. */
   void allocSelfCollisionBroadPhase(const moveit::core::RobotState& state, FCLManager& manager) const;
@@ -151,9 +289,28 @@ protected:
   std::map<std::string, FCLObject> fcl_objs_;
 
 private:
+  struct RobotCacheEntry;
+  class ScopedRobotObjects;
+
+  /** \brief Get this thread's cached FCL representation of the robot, or nullptr if it cannot be used. */
+  RobotCacheEntry* acquireRobotCacheEntry() const;
+
+  /** \brief Invalidate the cached FCL robot representations of all threads. */
+  void invalidateRobotCache();
+
   /** \brief Callback function executed for each change to the world environment */
   void notifyObjectChange(const ObjectConstPtr& obj, World::Action action);
 
   World::ObserverHandle observer_handle_;
+
+  /** \brief Flag indicating whether the per-thread robot object cache is used. */
+  bool cache_robot_objects_;
+
+  /** \brief Flag indicating whether self-collision checks reuse the results of pairs of links that did not move. */
+  bool incremental_self_collision_;
+
+  /** \brief Identifies the current robot geometry. Thread-local cache entries only hold a weak reference to it, so
+   *   resetting it invalidates them and they are discarded once this environment is destroyed. */
+  std::shared_ptr<const int> robot_cache_token_;
 };
 }  // namespace collision_detection
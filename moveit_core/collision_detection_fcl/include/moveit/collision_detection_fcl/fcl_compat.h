@@ -64,6 +64,10 @@ class DistanceRequest;
 using DistanceRequestd = fcl::DistanceRequest;
 class DistanceResult;
 using DistanceResultd = fcl::DistanceResult;
+struct ContinuousCollisionRequest;
+using ContinuousCollisionRequestd = fcl::ContinuousCollisionRequest;
+struct ContinuousCollisionResult;
+using ContinuousCollisionResultd = fcl::ContinuousCollisionResult;
 class Plane;
 using Planed = fcl::Plane;
 class Sphere;
@@ -85,10 +85,13 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
   // use the collision matrix (if any) to avoid certain collision checks
   DecideContactFn dcf;
   bool always_allow_collision = false;
-  if (cdata->acm_)
+  if (cdata->compiled_acm_)
   {
+    const CompiledAllowedCollisionMatrix& acm = *cdata->compiled_acm_;
+    const int index1 = cd1->getACMIndex(acm);
+    const int index2 = cd2->getACMIndex(acm);
     AllowedCollision::Type type;
-    bool found = cdata->acm_->getAllowedCollision(cd1->getID(), cd2->getID(), type);
+    bool found = acm.getAllowedCollision(index1, index2, type);
     if (found)
     {
       // if we have an entry in the collision matrix, we read it
@@ -104,7 +107,7 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
       }
       else if (type == AllowedCollision::CONDITIONAL)
       {
-        cdata->acm_->getAllowedCollision(cd1->getID(), cd2->getID(), dcf);
+        acm.getAllowedCollision(index1, index2, dcf);
         if (cdata->req_->verbose)
           ROS_DEBUG_NAMED("collision_detection.fcl", "Collision between '%s' and '%s' is conditionally allowed",
                           cd1->getID().c_str(), cd2->getID().c_str());
@@ -157,17 +160,7 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
   if (cdata->req_->contacts)
     if (cdata->res_->contact_count < cdata->req_->max_contacts)
     {
-      std::size_t have;
-      if (cd1->getID() < cd2->getID())
-      {
-        std::pair<std::string, std::string> cp(cd1->getID(), cd2->getID());
-        have = cdata->res_->contacts.find(cp) != cdata->res_->contacts.end() ? cdata->res_->contacts[cp].size() : 0;
-      }
-      else
-      {
-        std::pair<std::string, std::string> cp(cd2->getID(), cd1->getID());
-        have = cdata->res_->contacts.find(cp) != cdata->res_->contacts.end() ? cdata->res_->contacts[cp].size() : 0;
-      }
+      std::size_t have = cdata->getContactCount(*cd1, *cd2);
       if (have < cdata->req_->max_contacts_per_pair)
         want_contact_count =
             std::min(cdata->req_->max_contacts_per_pair - have, cdata->req_->max_contacts - cdata->res_->contact_count);
@@ -192,9 +185,6 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
                        "These contacts will be evaluated to check if they are accepted or not",
                        num_contacts, cd1->getID().c_str(), cd2->getID().c_str());
       Contact c;
-      const std::pair<std::string, std::string>& pc = cd1->getID() < cd2->getID() ?
-                                                          std::make_pair(cd1->getID(), cd2->getID()) :
-                                                          std::make_pair(cd2->getID(), cd1->getID());
       for (int i = 0; i < num_contacts; ++i)
       {
         fcl2contact(col_result.getContact(i), c);
@@ -205,8 +195,7 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
           if (want_contact_count > 0)
           {
             --want_contact_count;
-            cdata->res_->contacts[pc].push_back(c);
-            cdata->res_->contact_count++;
+            cdata->addContact(c);
             if (cdata->req_->verbose)
               ROS_INFO_NAMED("collision_detection.fcl",
                              "Found unacceptable contact between '%s' and '%s'. Contact was stored.",
@@ -274,17 +263,9 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
                          num_contacts_initial, cd1->getID().c_str(), cd1->getTypeString().c_str(), cd2->getID().c_str(),
                          cd2->getTypeString().c_str(), num_contacts);
 
-        const std::pair<std::string, std::string>& pc = cd1->getID() < cd2->getID() ?
-                                                            std::make_pair(cd1->getID(), cd2->getID()) :
-                                                            std::make_pair(cd2->getID(), cd1->getID());
         cdata->res_->collision = true;
         for (int i = 0; i < num_contacts; ++i)
-        {
-          Contact c;
-          fcl2contact(col_result.getContact(i), c);
-          cdata->res_->contacts[pc].push_back(c);
-          cdata->res_->contact_count++;
-        }
+          cdata->addContact(col_result.getContact(i));
       }
 
       if (enable_cost)
@@ -363,6 +344,151 @@ bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, voi
   return cdata->done_;
 }
 
+/** \brief FCL's conservative advancement does not support all geometry types. For the others, the motion is sampled
+ *  instead. */
+static bool supportsConservativeAdvancement(const fcl::CollisionObjectd* o)
+{
+  switch (o->collisionGeometry()->getNodeType())
+  {
+    case fcl::GEOM_OCTREE:
+    case fcl::GEOM_PLANE:
+    case fcl::GEOM_HALFSPACE:
+      return false;
+    default:
+      return true;
+  }
+}
+
+bool continuousCollisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data)
+{
+  ContinuousCollisionData* ccdata = reinterpret_cast<ContinuousCollisionData*>(data);
+  CollisionData* cdata = ccdata->collision_data_;
+  if (cdata->done_)
+    return true;
+
+  // the manager reports the swept volume and the world object in arbitrary order
+  const fcl::CollisionObjectd* robot_obj = ccdata->object_;
+  const fcl::CollisionObjectd* world_obj = o1 == ccdata->swept_volume_ ? o2 : o1;
+  const CollisionGeometryData* cd1 =
+      static_cast<const CollisionGeometryData*>(robot_obj->collisionGeometry()->getUserData());
+  const CollisionGeometryData* cd2 =
+      static_cast<const CollisionGeometryData*>(world_obj->collisionGeometry()->getUserData());
+
+  // If active components are specified, the robot object has to be one of them
+  if (cdata->active_components_only_)
+  {
+    const moveit::core::LinkModel* l1 =
+        cd1->type == BodyTypes::ROBOT_LINK ? cd1->ptr.link : cd1->ptr.ab->getAttachedLink();
+    if (cdata->active_components_only_->find(l1) == cdata->active_components_only_->end())
+      return false;
+  }
+
+  // use the collision matrix (if any) to avoid certain collision checks
+  DecideContactFn dcf;
+  if (cdata->compiled_acm_)
+  {
+    const CompiledAllowedCollisionMatrix& acm = *cdata->compiled_acm_;
+    const int index1 = cd1->getACMIndex(acm);
+    const int index2 = cd2->getACMIndex(acm);
+    AllowedCollision::Type type;
+    if (acm.getAllowedCollision(index1, index2, type))
+    {
+      if (type == AllowedCollision::ALWAYS)
+      {
+        if (cdata->req_->verbose)
+          ROS_DEBUG_NAMED("collision_detection.fcl",
+                          "Collision between '%s' (type '%s') and '%s' (type '%s') is always allowed. "
+                          "No contacts are computed.",
+                          cd1->getID().c_str(), cd1->getTypeString().c_str(), cd2->getID().c_str(),
+                          cd2->getTypeString().c_str());
+        return false;
+      }
+      else if (type == AllowedCollision::CONDITIONAL)
+        acm.getAllowedCollision(index1, index2, dcf);
+    }
+  }
+
+  if (cdata->req_->verbose)
+    ROS_DEBUG_NAMED("collision_detection.fcl", "Actually checking continuous collisions between %s and %s",
+                    cd1->getID().c_str(), cd2->getID().c_str());
+
+  fcl::ContinuousCollisionRequestd ccd_req;
+  ccd_req.ccd_motion_type = fcl::CCDM_LINEAR;
+  if (supportsConservativeAdvancement(robot_obj) && supportsConservativeAdvancement(world_obj))
+  {
+    ccd_req.ccd_solver_type = fcl::CCDC_CONSERVATIVE_ADVANCEMENT;
+    ccd_req.num_max_iterations = 100;
+  }
+  else
+  {
+    ccd_req.ccd_solver_type = fcl::CCDC_NAIVE;
+    ccd_req.num_max_iterations = 20;
+  }
+  fcl::ContinuousCollisionResultd ccd_res;
+  fcl::continuousCollide(robot_obj, ccdata->end_transform_, world_obj, world_obj->getTransform(), ccd_req, ccd_res);
+  if (!ccd_res.is_collide)
+    return false;
+
+  // compute the contact at the time of contact; as conservative advancement stops right before the objects
+  // touch, fall back to the nearest points if the discrete check does not find any
+  Contact c;
+  fcl::CollisionResultd col_result;
+  if (fcl::collide(robot_obj->collisionGeometry().get(), ccd_res.contact_tf1, world_obj->collisionGeometry().get(),
+                   ccd_res.contact_tf2, fcl::CollisionRequestd(1, true), col_result) > 0)
+    fcl2contact(col_result.getContact(0), c);
+  else
+  {
+    fcl::DistanceResultd dist_result;
+    fcl::distance(robot_obj->collisionGeometry().get(), ccd_res.contact_tf1, world_obj->collisionGeometry().get(),
+                  ccd_res.contact_tf2, fcl::DistanceRequestd(true), dist_result);
+#if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
+    c.nearest_points[0] = dist_result.nearest_points[0];
+    c.nearest_points[1] = dist_result.nearest_points[1];
+#else
+    c.nearest_points[0] = Eigen::Vector3d(dist_result.nearest_points[0].data.vs);
+    c.nearest_points[1] = Eigen::Vector3d(dist_result.nearest_points[1].data.vs);
+#endif
+    c.pos = 0.5 * (c.nearest_points[0] + c.nearest_points[1]);
+    c.normal = (c.nearest_points[1] - c.nearest_points[0]).normalized();
+    c.depth = 0.0;
+    c.body_name_1 = cd1->getID();
+    c.body_type_1 = cd1->type;
+    c.body_name_2 = cd2->getID();
+    c.body_type_2 = cd2->type;
+  }
+  c.percent_interpolation = ccd_res.time_of_contact;
+
+  // if the contact is allowed, there is no collision
+  if (dcf && dcf(c))
+  {
+    if (cdata->req_->verbose)
+      ROS_DEBUG_NAMED("collision_detection.fcl", "Contact between '%s' and '%s' at %f of the motion is allowed",
+                      cd1->getID().c_str(), cd2->getID().c_str(), c.percent_interpolation);
+    return false;
+  }
+
+  cdata->res_->collision = true;
+  if (cdata->req_->verbose)
+    ROS_INFO_NAMED("collision_detection.fcl",
+                   "Found a contact between '%s' (type '%s') and '%s' (type '%s') at %f of the motion, "
+                   "which constitutes a collision.",
+                   cd1->getID().c_str(), cd1->getTypeString().c_str(), cd2->getID().c_str(),
+                   cd2->getTypeString().c_str(), c.percent_interpolation);
+
+  // store the contact, if it is needed
+  if (cdata->req_->contacts && cdata->res_->contact_count < cdata->req_->max_contacts &&
+      cdata->getContactCount(*cd1, *cd2) < cdata->req_->max_contacts_per_pair)
+    cdata->addContact(c);
+
+  if (!cdata->req_->contacts || cdata->res_->contact_count >= cdata->req_->max_contacts)
+    cdata->done_ = true;
+
+  if (!cdata->done_ && cdata->req_->is_done)
+    cdata->done_ = cdata->req_->is_done(*cdata->res_);
+
+  return cdata->done_;
+}
+
 /** \brief Cache for an arbitrary type of shape. It is assigned during the execution of \e createCollisionGeometry().
  *
  *  Only a single cache per thread and object type is created as it is a quasi-singleton instance. */
@@ -440,11 +566,12 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
 
   // use the collision matrix (if any) to avoid certain distance checks
   bool always_allow_collision = false;
-  if (cdata->req->acm)
+  if (cdata->compiled_acm)
   {
     AllowedCollision::Type type;
 
-    bool found = cdata->req->acm->getAllowedCollision(cd1->getID(), cd2->getID(), type);
+    bool found = cdata->compiled_acm->getAllowedCollision(cd1->getACMIndex(*cdata->compiled_acm),
+                                                          cd2->getACMIndex(*cdata->compiled_acm), type);
     if (found)
     {
       // if we have an entry in the collision matrix, we read it
@@ -532,6 +659,8 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
     return false;
   }
   double d = fcl::distance(o1, o2, fcl::DistanceRequestd(cdata->req->enable_nearest_points), fcl_result);
+  // when no pair of features is closer than the threshold, d is the threshold, which still bounds the distance
+  cdata->pair_distance = d;
 
   // Check if either object is already in the map. If not add it or if present
   // check to see if the new distance is closer. If closer remove the existing
@@ -583,6 +712,7 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
 
         const fcl::Contactd& contact = coll_res.getContact(max_index);
         dist_result.distance = -contact.penetration_depth;
+        cdata->pair_distance = dist_result.distance;
 #if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
         dist_result.nearest_points[0] = contact.pos;
         dist_result.nearest_points[1] = contact.pos;
@@ -928,6 +1058,53 @@ void cleanCollisionGeometryCache()
   }
 }
 
+std::size_t CollisionData::getContactCount(const CollisionGeometryData& cd1, const CollisionGeometryData& cd2) const
+{
+  if (compact_res_)
+    return compact_res_->getContactCount(compact_res_->getNameId(cd1.getID()), compact_res_->getNameId(cd2.getID()));
+
+  auto it = cd1.getID() < cd2.getID() ? res_->contacts.find(std::make_pair(cd1.getID(), cd2.getID())) :
+                                        res_->contacts.find(std::make_pair(cd2.getID(), cd1.getID()));
+  return it == res_->contacts.end() ? 0 : it->second.size();
+}
+
+void CollisionData::addContact(const Contact& c)
+{
+  if (compact_res_)
+    compact_res_->addContact(c);
+  else if (c.body_name_1 < c.body_name_2)
+    res_->contacts[std::make_pair(c.body_name_1, c.body_name_2)].push_back(c);
+  else
+    res_->contacts[std::make_pair(c.body_name_2, c.body_name_1)].push_back(c);
+  res_->contact_count++;
+}
+
+void CollisionData::addContact(const fcl::Contactd& fc)
+{
+  if (!compact_res_)
+  {
+    Contact c;
+    fcl2contact(fc, c);
+    addContact(c);
+    return;
+  }
+
+  // fill the compact contact directly, so no body names are copied
+  const CollisionGeometryData* cgd1 = static_cast<const CollisionGeometryData*>(fc.o1->getUserData());
+  const CollisionGeometryData* cgd2 = static_cast<const CollisionGeometryData*>(fc.o2->getUserData());
+  compact_res_->contacts.emplace_back();
+  CompactContact& c = compact_res_->contacts.back();
+  c.pos = Eigen::Vector3d(fc.pos[0], fc.pos[1], fc.pos[2]);
+  c.normal = Eigen::Vector3d(fc.normal[0], fc.normal[1], fc.normal[2]);
+  c.depth = fc.penetration_depth;
+  c.body_id_1 = compact_res_->getNameId(cgd1->getID());
+  c.body_type_1 = cgd1->type;
+  c.body_id_2 = compact_res_->getNameId(cgd2->getID());
+  c.body_type_2 = cgd2->type;
+  c.percent_interpolation = 0.0;
+  res_->contact_count++;
+}
+
 void CollisionData::enableGroup(const moveit::core::RobotModelConstPtr& robot_model)
 {
   if (robot_model->hasJointModelGroup(req_->group_name))
@@ -39,11 +39,19 @@
 #include <moveit/collision_detection_fcl/collision_common.h>
 
 #include <moveit/collision_detection_fcl/fcl_compat.h>
+#include <eigen_stl_containers/eigen_stl_containers.h>
 
 #if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
 #include <fcl/broadphase/broadphase_dynamic_AABB_tree.h>
+#include <fcl/geometry/shape/box.h>
+#else
+#include <fcl/shape/geometric_shapes.h>
 #endif
 
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
 namespace collision_detection
 {
 const std::string CollisionDetectorAllocatorFCL::NAME("FCL");
@@ -51,6 +59,9 @@ constexpr char LOGNAME[] = "collision_detection.fcl";
 
 CollisionEnvFCL::CollisionEnvFCL(const moveit::core::RobotModelConstPtr& model, double padding, double scale)
   : CollisionEnv(model, padding, scale)
+  , cache_robot_objects_(true)
+  , incremental_self_collision_(false)
+  , robot_cache_token_(std::make_shared<const int>(0))
 {
   const std::vector<const moveit::core::LinkModel*>& links = robot_model_->getLinkModelsWithCollisionGeometry();
   std::size_t index;
@@ -89,6 +100,9 @@ CollisionEnvFCL::CollisionEnvFCL(const moveit::core::RobotModelConstPtr& model,
 CollisionEnvFCL::CollisionEnvFCL(const moveit::core::RobotModelConstPtr& model, const WorldPtr& world, double padding,
                                  double scale)
   : CollisionEnv(model, world, padding, scale)
+  , cache_robot_objects_(true)
+  , incremental_self_collision_(false)
+  , robot_cache_token_(std::make_shared<const int>(0))
 {
   const std::vector<const moveit::core::LinkModel*>& links = robot_model_->getLinkModelsWithCollisionGeometry();
   std::size_t index;
@@ -129,7 +143,11 @@ CollisionEnvFCL::~CollisionEnvFCL()
   getWorld()->removeObserver(observer_handle_);
 }
 
-CollisionEnvFCL::CollisionEnvFCL(const CollisionEnvFCL& other, const WorldPtr& world) : CollisionEnv(other, world)
+CollisionEnvFCL::CollisionEnvFCL(const CollisionEnvFCL& other, const WorldPtr& world)
+  : CollisionEnv(other, world)
+  , cache_robot_objects_(other.cache_robot_objects_)
+  , incremental_self_collision_(other.incremental_self_collision_)
+  , robot_cache_token_(std::make_shared<const int>(0))
 {
   robot_geoms_ = other.robot_geoms_;
   robot_fcl_objs_ = other.robot_fcl_objs_;
@@ -190,7 +208,15 @@ void CollisionEnvFCL::constructFCLObjectRobot(const moveit::core::RobotState& st
       fcl_obj.collision_objects_.push_back(FCLCollisionObjectPtr(coll_obj));
     }
 
-  // TODO: Implement a method for caching fcl::CollisionObject's for moveit::core::AttachedBody's
+  constructFCLObjectAttachedBodies(state, fcl_obj);
+}
+
+void CollisionEnvFCL::constructFCLObjectAttachedBodies(const moveit::core::RobotState& state, FCLObject& fcl_obj) const
+{
+  fcl::Transform3d fcl_tf;
+
+  // Objects constructed here are not cached. With the per-thread robot object cache enabled, the attached bodies'
+  // objects are reused across checks instead (see ScopedRobotObjects).
   std::vector<const moveit::core::AttachedBody*> ab;
   state.getAttachedBodies(ab);
   for (auto& body : ab)
@@ -221,6 +247,342 @@ void CollisionEnvFCL::allocSelfCollisionBroadPhase(const moveit::core::RobotStat
   // manager.manager_->update();
 }
 
+/** \brief This thread's copy of the robot's FCL collision objects for a single CollisionEnvFCL. */
+struct CollisionEnvFCL::RobotCacheEntry
+{
+  /** \brief Refers to \e robot_cache_token_ of the environment the entry was built for. */
+  std::weak_ptr<const int> token_;
+
+  /** \brief The collision objects of the robot links, followed by those of the attached bodies during a check.
+   *   Only the link objects stay registered to the broadphase manager between checks. */
+  FCLManager manager_;
+
+  /** \brief Index into \e robot_geoms_ for each of the link collision objects. */
+  std::vector<std::size_t> geom_indices_;
+
+  /** \brief FCL representation of a single attached body. */
+  struct AttachedBodyObjects
+  {
+    /** \brief The shapes the objects were created from. Holding them also prevents AttachedBody::setPadding() and
+     *   AttachedBody::setScale() from modifying them in place. */
+    std::vector<shapes::ShapeConstPtr> shapes_;
+
+    /** \brief Geometry for each shape, nullptr if the shape is not supported by FCL. */
+    std::vector<FCLGeometryConstPtr> geometries_;
+
+    /** \brief Collision object for each shape, nullptr if the shape is not supported by FCL. These objects stay
+     *   registered to the broadphase manager as long as they are cached. */
+    std::vector<FCLCollisionObjectPtr> objects_;
+
+    /** \brief Whether the body was attached in the state of the latest check. */
+    bool used_ = false;
+  };
+
+  /** \brief The cached attached bodies, identified by name. */
+  std::map<std::string, AttachedBodyObjects> attached_bodies_;
+
+  /** \brief Buffer for the attached bodies of the checked state. */
+  std::vector<const moveit::core::AttachedBody*> attached_body_buffer_;
+
+  /** \brief Set while a check uses this entry, which guards against reentrant checks from within callbacks. */
+  bool in_use_ = false;
+
+  /** \brief The poses of the link collision objects in the latest check. */
+  EigenSTL::vector_Isometry3d link_poses_;
+
+  /** \brief Index of each link collision object in \e link_poses_. */
+  std::unordered_map<const fcl::CollisionObjectd*, std::size_t> link_indices_;
+
+  /** \brief Narrowphase results of incremental self-collision checks for the pairs of link collision objects.
+   *   Entries for pairs that involve a link that moved since are reset to PAIR_UNKNOWN. Empty if unused. */
+  std::vector<std::uint8_t> pair_states_;
+
+  /** \brief The serial of the compiled ACM and the group the entries of \e pair_states_ were computed with. */
+  std::uint32_t pair_acm_serial_ = 0;
+  std::string pair_group_name_;
+
+  enum PairState : std::uint8_t
+  {
+    PAIR_UNKNOWN,
+    PAIR_FREE,
+    PAIR_COLLIDING
+  };
+
+  /** \brief Reset the cached pair results that involve the link collision object with index \e i. */
+  void invalidatePairs(std::size_t i)
+  {
+    const std::size_t n = link_poses_.size();
+    for (std::size_t j = 0; j < n; ++j)
+      pair_states_[i * n + j] = pair_states_[j * n + i] = PAIR_UNKNOWN;
+  }
+};
+
+CollisionEnvFCL::RobotCacheEntry* CollisionEnvFCL::acquireRobotCacheEntry() const
+{
+  if (!cache_robot_objects_)
+    return nullptr;
+
+  // every this many newly built entries, entries of destroyed environments are removed
+  static const unsigned int MAX_CLEAN_COUNT = 100;
+
+  /* As for the shape cache in collision_common.cpp, each thread gets its own instance, so no locking is needed.
+   * Entries are keyed by environment, but only valid as long as the token they were built with is the environment's
+   * current one. This also detects a new environment allocated at the address of a destroyed one. */
+  static thread_local std::map<const CollisionEnvFCL*, RobotCacheEntry> cache;
+  static thread_local unsigned int clean_count = 0;
+
+  RobotCacheEntry& entry = cache[this];
+  if (entry.in_use_)
+    return nullptr;
+
+  if (entry.token_.owner_before(robot_cache_token_) || robot_cache_token_.owner_before(entry.token_))
+  {
+    entry.token_ = robot_cache_token_;
+    entry.geom_indices_.clear();
+    entry.attached_bodies_.clear();
+    entry.manager_.object_.clear();
+    entry.manager_.manager_ = std::make_shared<fcl::DynamicAABBTreeCollisionManagerd>();
+    for (std::size_t i = 0; i < robot_geoms_.size(); ++i)
+      if (robot_geoms_[i] && robot_geoms_[i]->collision_geometry_)
+      {
+        // copy the prototype object, so the local AABB of the geometry is not recomputed
+        entry.manager_.object_.collision_objects_.push_back(
+            std::make_shared<fcl::CollisionObjectd>(*robot_fcl_objs_[i]));
+        entry.geom_indices_.push_back(i);
+      }
+    entry.manager_.object_.registerTo(entry.manager_.manager_.get());
+
+    // NaN poses make sure all objects are posed in the first check
+    entry.link_poses_.assign(entry.geom_indices_.size(),
+                             Eigen::Isometry3d(Eigen::Matrix4d::Constant(std::numeric_limits<double>::quiet_NaN())));
+    entry.link_indices_.clear();
+    for (std::size_t i = 0; i < entry.geom_indices_.size(); ++i)
+      entry.link_indices_[entry.manager_.object_.collision_objects_[i].get()] = i;
+    entry.pair_states_.clear();
+
+    if (++clean_count > MAX_CLEAN_COUNT)
+    {
+      clean_count = 0;
+      for (auto it = cache.begin(); it != cache.end();)
+        if (it->second.token_.expired() && !it->second.in_use_)
+          it = cache.erase(it);
+        else
+          ++it;
+    }
+  }
+  return &entry;
+}
+
+void CollisionEnvFCL::invalidateRobotCache()
+{
+  robot_cache_token_ = std::make_shared<const int>(0);
+}
+
+/** \brief Provides the FCL representation of the robot at a given state for the duration of a single check.
+ *
+ *  The thread's cached robot objects are re-posed if available. Otherwise, new objects (and, for self-collision
+ *  checks, a new broadphase manager) are constructed as before. */
+class CollisionEnvFCL::ScopedRobotObjects
+{
+public:
+  ScopedRobotObjects(const CollisionEnvFCL& env, const moveit::core::RobotState& state, bool self_collision)
+    : entry_(env.acquireRobotCacheEntry()), self_collision_(self_collision)
+  {
+    if (!entry_)
+    {
+      if (self_collision_)
+        env.allocSelfCollisionBroadPhase(state, fallback_);
+      else
+        env.constructFCLObjectRobot(state, fallback_.object_);
+      manager_ = &fallback_;
+      return;
+    }
+
+    entry_->in_use_ = true;
+    manager_ = &entry_->manager_;
+
+    // only re-pose the objects of links that moved since the previous check
+    std::vector<FCLCollisionObjectPtr>& objs = manager_->object_.collision_objects_;
+    fcl::Transform3d fcl_tf;
+    for (std::size_t i = 0; i < entry_->geom_indices_.size(); ++i)
+    {
+      const CollisionGeometryData& cgd = *env.robot_geoms_[entry_->geom_indices_[i]]->collision_geometry_data_;
+      const Eigen::Isometry3d& pose = state.getCollisionBodyTransform(cgd.ptr.link, cgd.shape_index);
+      if (pose.matrix() == entry_->link_poses_[i].matrix())
+        continue;
+      entry_->link_poses_[i] = pose;
+      transform2fcl(pose, fcl_tf);
+      objs[i]->setTransform(fcl_tf);
+      objs[i]->computeAABB();
+      if (!entry_->pair_states_.empty())
+        entry_->invalidatePairs(i);
+    }
+
+    addAttachedBodies(state);
+    if (self_collision_)
+      manager_->manager_->update();
+  }
+
+  ~ScopedRobotObjects()
+  {
+    if (!entry_)
+      return;
+
+    // drop the attached bodies' objects from the list, but keep the capacity of the vector
+    manager_->object_.collision_objects_.resize(entry_->geom_indices_.size());
+    entry_->in_use_ = false;
+  }
+
+  ScopedRobotObjects(const ScopedRobotObjects&) = delete;
+  ScopedRobotObjects& operator=(const ScopedRobotObjects&) = delete;
+
+  /** \brief The robot's collision objects. For self-collision checks, they are registered to the broadphase
+   *   manager. */
+  FCLManager& get()
+  {
+    return *manager_;
+  }
+
+  /** \brief Check the robot for self-collisions, reusing the cached narrowphase results of pairs of links that did
+   *   not move since they were computed. Returns false if this is not possible for the given request, in which case
+   *   nothing is checked. */
+  bool collideSelfIncremental(CollisionData& cd)
+  {
+    // the cached pair results are only meaningful if a check stops at the first collision without details
+    if (!entry_ || !self_collision_ || cd.req_->contacts || cd.req_->cost || cd.res_->collision || cd.compact_res_)
+      return false;
+
+    const std::uint32_t acm_serial = cd.compiled_acm_ ? cd.compiled_acm_->getSerial() : 0;
+    const std::size_t n = entry_->link_poses_.size();
+    if (entry_->pair_states_.empty() || acm_serial != entry_->pair_acm_serial_ ||
+        cd.req_->group_name != entry_->pair_group_name_)
+    {
+      entry_->pair_states_.assign(n * n, RobotCacheEntry::PAIR_UNKNOWN);
+      entry_->pair_acm_serial_ = acm_serial;
+      entry_->pair_group_name_ = cd.req_->group_name;
+    }
+
+    IncrementalData data{ &cd, entry_ };
+    manager_->manager_->collide(&data, &incrementalCallback);
+    return true;
+  }
+
+private:
+  using AttachedBodyObjects = RobotCacheEntry::AttachedBodyObjects;
+
+  struct IncrementalData
+  {
+    CollisionData* cd_;
+    RobotCacheEntry* entry_;
+  };
+
+  /** \brief Collision callback that answers pairs of links from the cached results and stores new results. Pairs
+   *   that involve attached bodies are always checked. */
+  static bool incrementalCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data)
+  {
+    IncrementalData* idata = static_cast<IncrementalData*>(data);
+    CollisionData* cd = idata->cd_;
+    RobotCacheEntry* entry = idata->entry_;
+    auto it1 = entry->link_indices_.find(o1);
+    auto it2 = entry->link_indices_.find(o2);
+    if (it1 == entry->link_indices_.end() || it2 == entry->link_indices_.end())
+      return collisionCallback(o1, o2, cd);
+
+    const std::size_t n = entry->link_poses_.size();
+    std::uint8_t& pair_state = entry->pair_states_[std::min(it1->second, it2->second) * n +
+                                                   std::max(it1->second, it2->second)];
+    if (pair_state == RobotCacheEntry::PAIR_FREE)
+      return false;
+    if (pair_state == RobotCacheEntry::PAIR_COLLIDING)
+    {
+      cd->res_->collision = true;
+      cd->done_ = true;
+      return true;
+    }
+
+    // no collision was found before this pair, so the result tells whether this pair collides
+    bool done = collisionCallback(o1, o2, cd);
+    pair_state = cd->res_->collision ? RobotCacheEntry::PAIR_COLLIDING : RobotCacheEntry::PAIR_FREE;
+    return done;
+  }
+
+  /** \brief Append the collision objects of the bodies attached in \e state, reusing cached ones where possible. */
+  void addAttachedBodies(const moveit::core::RobotState& state)
+  {
+    for (auto& cached : entry_->attached_bodies_)
+      cached.second.used_ = false;
+
+    std::vector<FCLCollisionObjectPtr>& objs = manager_->object_.collision_objects_;
+    fcl::Transform3d fcl_tf;
+    state.getAttachedBodies(entry_->attached_body_buffer_);
+    for (const moveit::core::AttachedBody* ab : entry_->attached_body_buffer_)
+    {
+      auto it = entry_->attached_bodies_.find(ab->getName());
+      if (it == entry_->attached_bodies_.end())
+        it = entry_->attached_bodies_.insert(std::make_pair(ab->getName(), AttachedBodyObjects())).first;
+      AttachedBodyObjects& cached = it->second;
+      if (cached.shapes_ != ab->getShapes())
+        constructAttachedBody(ab, cached);
+      cached.used_ = true;
+
+      const EigenSTL::vector_Isometry3d& ab_t = ab->getGlobalCollisionBodyTransforms();
+      for (std::size_t k = 0; k < cached.objects_.size(); ++k)
+        if (cached.objects_[k])
+        {
+          // the objects may have been created for a copy of this body (e.g. in another RobotState), so the geometry
+          // data has to refer to this instance for the touch links and attached link used by the callbacks
+          cached.geometries_[k]->collision_geometry_data_->ptr.ab = ab;
+          transform2fcl(ab_t[k], fcl_tf);
+          cached.objects_[k]->setTransform(fcl_tf);
+          cached.objects_[k]->computeAABB();
+          objs.push_back(cached.objects_[k]);
+        }
+    }
+
+    // bodies that are not attached anymore are removed from the cache
+    for (auto it = entry_->attached_bodies_.begin(); it != entry_->attached_bodies_.end();)
+      if (!it->second.used_)
+      {
+        unregisterAttachedBody(it->second);
+        it = entry_->attached_bodies_.erase(it);
+      }
+      else
+        ++it;
+  }
+
+  /** \brief (Re-)create the FCL geometry and collision objects of an attached body. */
+  void constructAttachedBody(const moveit::core::AttachedBody* ab, AttachedBodyObjects& cached)
+  {
+    unregisterAttachedBody(cached);
+    cached.shapes_ = ab->getShapes();
+    cached.geometries_.assign(cached.shapes_.size(), FCLGeometryConstPtr());
+    cached.objects_.assign(cached.shapes_.size(), FCLCollisionObjectPtr());
+    for (std::size_t k = 0; k < cached.shapes_.size(); ++k)
+    {
+      FCLGeometryConstPtr g = createCollisionGeometry(cached.shapes_[k], ab, k);
+      if (g && g->collision_geometry_)
+      {
+        cached.geometries_[k] = g;
+        cached.objects_[k] = std::make_shared<fcl::CollisionObjectd>(g->collision_geometry_);
+        manager_->manager_->registerObject(cached.objects_[k].get());
+      }
+    }
+  }
+
+  /** \brief Remove the collision objects of a cached attached body from the broadphase manager. */
+  void unregisterAttachedBody(const AttachedBodyObjects& cached)
+  {
+    for (const FCLCollisionObjectPtr& obj : cached.objects_)
+      if (obj)
+        manager_->manager_->unregisterObject(obj.get());
+  }
+
+  RobotCacheEntry* entry_;
+  bool self_collision_;
+  FCLManager fallback_;
+  FCLManager* manager_;
+};
+
 void CollisionEnvFCL::checkSelfCollision(const CollisionRequest& req, CollisionResult& res,
                                          const moveit::core::RobotState& state) const
 {
@@ -233,15 +595,46 @@ void CollisionEnvFCL::checkSelfCollision(const CollisionRequest& req, CollisionR
   checkSelfCollisionHelper(req, res, state, &acm);
 }
 
+/** \brief Move the summary of \e compact into \e res, which is updated by the collision callbacks while they store the
+ *  contacts in \e compact */
+static void beginCompactCheck(CompactCollisionResult& compact, CollisionResult& res)
+{
+  res.collision = compact.collision;
+  res.distance = compact.distance;
+  res.contact_count = compact.contact_count;
+  res.cost_sources.swap(compact.cost_sources);
+}
+
+/** \brief Move the summary in \e res back into \e compact */
+static void endCompactCheck(CollisionResult& res, CompactCollisionResult& compact)
+{
+  compact.collision = res.collision;
+  compact.distance = res.distance;
+  compact.contact_count = res.contact_count;
+  compact.cost_sources.swap(res.cost_sources);
+}
+
+void CollisionEnvFCL::checkSelfCollision(const CollisionRequest& req, CompactCollisionResult& res,
+                                         const moveit::core::RobotState& state, const AllowedCollisionMatrix& acm) const
+{
+  CollisionResult summary;
+  beginCompactCheck(res, summary);
+  checkSelfCollisionHelper(req, summary, state, &acm, &res);
+  endCompactCheck(summary, res);
+}
+
 void CollisionEnvFCL::checkSelfCollisionHelper(const CollisionRequest& req, CollisionResult& res,
-                                               const moveit::core::RobotState& state,
-                                               const AllowedCollisionMatrix* acm) const
+                                               const moveit::core::RobotState& state, const AllowedCollisionMatrix* acm,
+                                               CompactCollisionResult* compact_res) const
 {
-  FCLManager manager;
-  allocSelfCollisionBroadPhase(state, manager);
   CollisionData cd(&req, &res, acm);
+  cd.compact_res_ = compact_res;
   cd.enableGroup(getRobotModel());
-  manager.manager_->collide(&cd, &collisionCallback);
+  {
+    ScopedRobotObjects robot(*this, state, true);
+    if (!incremental_self_collision_ || !robot.collideSelfIncremental(cd))
+      robot.get().manager_->collide(&cd, &collisionCallback);
+  }
   if (req.distance)
   {
     DistanceRequest dreq;
@@ -272,7 +665,7 @@ void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& req, Collision
                                           const moveit::core::RobotState& state1,
                                           const moveit::core::RobotState& state2) const
 {
-  ROS_ERROR_NAMED(LOGNAME, "Continuous collision not implemented");
+  checkRobotCollisionHelperCCD(req, res, state1, state2, nullptr);
 }
 
 void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
@@ -280,20 +673,125 @@ void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& req, Collision
                                           const moveit::core::RobotState& state2,
                                           const AllowedCollisionMatrix& acm) const
 {
-  ROS_ERROR_NAMED(LOGNAME, "Not implemented");
+  checkRobotCollisionHelperCCD(req, res, state1, state2, &acm);
 }
 
-void CollisionEnvFCL::checkRobotCollisionHelper(const CollisionRequest& req, CollisionResult& res,
-                                                const moveit::core::RobotState& state,
-                                                const AllowedCollisionMatrix* acm) const
+/** \brief Get the pose of the robot body a collision geometry belongs to in \e state.
+ *
+ *  Returns false if the body is an attached body that is not attached in \e state. */
+static bool getCollisionBodyTransform(const moveit::core::RobotState& state, const CollisionGeometryData& cgd,
+                                      Eigen::Isometry3d& pose)
 {
-  FCLObject fcl_obj;
-  constructFCLObjectRobot(state, fcl_obj);
+  if (cgd.type == BodyTypes::ROBOT_LINK)
+  {
+    pose = state.getCollisionBodyTransform(cgd.ptr.link, cgd.shape_index);
+    return true;
+  }
+
+  const moveit::core::AttachedBody* ab = state.getAttachedBody(cgd.getID());
+  if (!ab || static_cast<std::size_t>(cgd.shape_index) >= ab->getGlobalCollisionBodyTransforms().size())
+    return false;
+  pose = ab->getGlobalCollisionBodyTransforms()[cgd.shape_index];
+  return true;
+}
+
+static Eigen::Vector3d toEigen(const fcl::Vector3d& v)
+{
+  return Eigen::Vector3d(v[0], v[1], v[2]);
+}
+
+/** \brief Resize and place \e box so that it encloses all poses of \e obj when it is linearly interpolated from its
+ *   current transform to \e end. */
+static void computeSweptVolume(const fcl::CollisionObjectd& obj, const Eigen::Isometry3d& start,
+                               const Eigen::Isometry3d& end, fcl::Boxd& box, fcl::CollisionObjectd& swept)
+{
+  const fcl::CollisionGeometryd& geom = *obj.collisionGeometry();
+  const Eigen::Vector3d local_center = toEigen(geom.aabb_center);
+  const double radius = geom.aabb_radius;
+
+  // the start pose is bounded by the object's AABB, the end pose by the geometry's bounding sphere
+  const Eigen::Vector3d end_center = end * local_center;
+  Eigen::Vector3d min_corner = toEigen(obj.getAABB().min_).array().min(end_center.array() - radius).matrix();
+  Eigen::Vector3d max_corner = toEigen(obj.getAABB().max_).array().max(end_center.array() + radius).matrix();
 
+  // points off the rotation center leave the straight line between their start and end position while rotating
+  const double angle = Eigen::AngleAxisd(start.linear().transpose() * end.linear()).angle();
+  const double deviation = std::min(angle, 2.0) * (local_center.norm() + radius);
+  min_corner.array() -= deviation;
+  max_corner.array() += deviation;
+
+  const Eigen::Vector3d side = max_corner - min_corner;
+  box.side = fcl::Vector3d(side.x(), side.y(), side.z());
+  box.computeLocalAABB();
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation() = 0.5 * (min_corner + max_corner);
+  swept.setTransform(transform2fcl(pose));
+  swept.computeAABB();
+}
+
+void CollisionEnvFCL::checkRobotCollisionHelperCCD(const CollisionRequest& req, CollisionResult& res,
+                                                   const moveit::core::RobotState& state1,
+                                                   const moveit::core::RobotState& state2,
+                                                   const AllowedCollisionMatrix* acm) const
+{
   CollisionData cd(&req, &res, acm);
   cd.enableGroup(getRobotModel());
+  ContinuousCollisionData ccd(&cd);
+
+  auto box = std::make_shared<fcl::Boxd>(1.0, 1.0, 1.0);
+  fcl::CollisionObjectd swept(box);
+  ccd.swept_volume_ = &swept;
+
+  ScopedRobotObjects robot(*this, state1, false);
+  const FCLObject& fcl_obj = robot.get().object_;
+  Eigen::Isometry3d start, end;
   for (std::size_t i = 0; !cd.done_ && i < fcl_obj.collision_objects_.size(); ++i)
-    manager_->collide(fcl_obj.collision_objects_[i].get(), &cd, &collisionCallback);
+  {
+    const fcl::CollisionObjectd* obj = fcl_obj.collision_objects_[i].get();
+    const CollisionGeometryData& cgd =
+        *static_cast<const CollisionGeometryData*>(obj->collisionGeometry()->getUserData());
+    getCollisionBodyTransform(state1, cgd, start);
+    if (!getCollisionBodyTransform(state2, cgd, end))
+    {
+      ROS_WARN_NAMED(LOGNAME, "Body '%s' is not attached at the end of the motion. Assuming it does not move.",
+                     cgd.getID().c_str());
+      end = start;
+    }
+
+    ccd.object_ = obj;
+    transform2fcl(end, ccd.end_transform_);
+    computeSweptVolume(*obj, start, end, *box, swept);
+    manager_->collide(&swept, &ccd, &continuousCollisionCallback);
+  }
+
+  if (req.distance)
+    ROS_WARN_NAMED(LOGNAME, "Distance computation is not supported for continuous collision checks");
+}
+
+void CollisionEnvFCL::checkRobotCollision(const CollisionRequest& req, CompactCollisionResult& res,
+                                          const moveit::core::RobotState& state,
+                                          const AllowedCollisionMatrix& acm) const
+{
+  CollisionResult summary;
+  beginCompactCheck(res, summary);
+  checkRobotCollisionHelper(req, summary, state, &acm, &res);
+  endCompactCheck(summary, res);
+}
+
+void CollisionEnvFCL::checkRobotCollisionHelper(const CollisionRequest& req, CollisionResult& res,
+                                                const moveit::core::RobotState& state,
+                                                const AllowedCollisionMatrix* acm,
+                                                CompactCollisionResult* compact_res) const
+{
+  CollisionData cd(&req, &res, acm);
+  cd.compact_res_ = compact_res;
+  cd.enableGroup(getRobotModel());
+  {
+    ScopedRobotObjects robot(*this, state, false);
+    const FCLObject& fcl_obj = robot.get().object_;
+    for (std::size_t i = 0; !cd.done_ && i < fcl_obj.collision_objects_.size(); ++i)
+      manager_->collide(fcl_obj.collision_objects_[i].get(), &cd, &collisionCallback);
+  }
 
   if (req.distance)
   {
@@ -311,24 +809,182 @@ void CollisionEnvFCL::checkRobotCollisionHelper(const CollisionRequest& req, Col
 void CollisionEnvFCL::distanceSelf(const DistanceRequest& req, DistanceResult& res,
                                    const moveit::core::RobotState& state) const
 {
-  FCLManager manager;
-  allocSelfCollisionBroadPhase(state, manager);
+  ScopedRobotObjects robot(*this, state, true);
   DistanceData drd(&req, &res);
 
-  manager.manager_->distance(&drd, &distanceCallback);
+  robot.get().manager_->distance(&drd, &distanceCallback);
 }
 
 void CollisionEnvFCL::distanceRobot(const DistanceRequest& req, DistanceResult& res,
                                     const moveit::core::RobotState& state) const
 {
-  FCLObject fcl_obj;
-  constructFCLObjectRobot(state, fcl_obj);
+  ScopedRobotObjects robot(*this, state, false);
+  const FCLObject& fcl_obj = robot.get().object_;
 
   DistanceData drd(&req, &res);
   for (std::size_t i = 0; !drd.done && i < fcl_obj.collision_objects_.size(); ++i)
     manager_->distance(fcl_obj.collision_objects_[i].get(), &drd, &distanceCallback);
 }
 
+/** \brief Get the transform of an FCL collision object as an Eigen isometry. */
+static Eigen::Isometry3d getObjectPose(const fcl::CollisionObjectd& obj)
+{
+#if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
+  return obj.getTransform();
+#else
+  const fcl::Quaternion3f& q = obj.getQuatRotation();
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.linear() = Eigen::Quaterniond(q.getW(), q.getX(), q.getY(), q.getZ()).toRotationMatrix();
+  pose.translation() = toEigen(obj.getTranslation());
+  return pose;
+#endif
+}
+
+/** \brief Upper bound of the distance any point of \e geom moves when its pose changes from \e from to \e to. */
+static double getMotionBound(const fcl::CollisionGeometryd& geom, const Eigen::Isometry3d& from,
+                             const Eigen::Isometry3d& to)
+{
+  // the points of the geometry are within aabb_radius of its center, which rotate by at most the rotation angle
+  const Eigen::Vector3d center = toEigen(geom.aabb_center);
+  const double angle = Eigen::AngleAxisd(from.linear().transpose() * to.linear()).angle();
+  return (to * center - from * center).norm() + std::min(angle, 2.0) * geom.aabb_radius;
+}
+
+struct CollisionEnvFCL::DistanceSession::QueryData
+{
+  DistanceSession* session_;
+  DistanceData* distance_data_;
+};
+
+CollisionEnvFCL::DistanceSession::DistanceSession(const CollisionEnvFCL& env)
+  : env_(env), closest_(nullptr, nullptr), query_(0), pruned_pairs_(0)
+{
+}
+
+void CollisionEnvFCL::DistanceSession::distanceSelf(const DistanceRequest& req, DistanceResult& res,
+                                                    const moveit::core::RobotState& state)
+{
+  cleanPairs();
+  ScopedRobotObjects robot(env_, state, true);
+  DistanceData drd(&req, &res);
+  QueryData data{ this, &drd };
+
+  // evaluate the previously closest pair first, so its distance bounds the global query right away
+  if (req.type == DistanceRequestType::GLOBAL && closest_.first)
+  {
+    fcl::CollisionObjectd* objs[2] = { nullptr, nullptr };
+    for (const FCLCollisionObjectPtr& obj : robot.get().object_.collision_objects_)
+    {
+      if (obj->collisionGeometry().get() == closest_.first)
+        objs[0] = obj.get();
+      else if (obj->collisionGeometry().get() == closest_.second)
+        objs[1] = obj.get();
+    }
+    double min_dist = std::numeric_limits<double>::max();
+    if (objs[0] && objs[1])
+      coherentCallback(objs[0], objs[1], &data, min_dist);
+  }
+
+  if (!drd.done)
+    robot.get().manager_->distance(&data, &coherentCallback);
+}
+
+void CollisionEnvFCL::DistanceSession::distanceRobot(const DistanceRequest& req, DistanceResult& res,
+                                                     const moveit::core::RobotState& state)
+{
+  cleanPairs();
+  ScopedRobotObjects robot(env_, state, false);
+  const std::vector<FCLCollisionObjectPtr>& objs = robot.get().object_.collision_objects_;
+  DistanceData drd(&req, &res);
+  QueryData data{ this, &drd };
+
+  // query the robot object of the previously closest pair first, so its distance bounds the global query right away
+  std::size_t first = objs.size();
+  if (req.type == DistanceRequestType::GLOBAL && closest_.first)
+    for (std::size_t i = 0; i < objs.size() && first == objs.size(); ++i)
+      if (objs[i]->collisionGeometry().get() == closest_.first ||
+          objs[i]->collisionGeometry().get() == closest_.second)
+        first = i;
+  if (first < objs.size())
+    env_.manager_->distance(objs[first].get(), &data, &coherentCallback);
+
+  for (std::size_t i = 0; !drd.done && i < objs.size(); ++i)
+    if (i != first)
+      env_.manager_->distance(objs[i].get(), &data, &coherentCallback);
+}
+
+void CollisionEnvFCL::DistanceSession::clear()
+{
+  pairs_.clear();
+  closest_ = PairKey(nullptr, nullptr);
+}
+
+void CollisionEnvFCL::DistanceSession::cleanPairs()
+{
+  // every this many queries, entries of destroyed geometries are removed
+  static const std::size_t CLEAN_INTERVAL = 100;
+
+  ++query_;
+  pruned_pairs_ = 0;
+  if (query_ % CLEAN_INTERVAL != 0)
+    return;
+  for (auto it = pairs_.begin(); it != pairs_.end();)
+    if (it->second.geometries_[0].expired() || it->second.geometries_[1].expired())
+      it = pairs_.erase(it);
+    else
+      ++it;
+}
+
+bool CollisionEnvFCL::DistanceSession::coherentCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2,
+                                                        void* data, double& min_dist)
+{
+  QueryData* qdata = static_cast<QueryData*>(data);
+  DistanceSession* session = qdata->session_;
+  DistanceData* drd = qdata->distance_data_;
+
+  // the entry stores the geometries ordered by address, independent of the order the broadphase reports them in
+  fcl::CollisionObjectd* objs[2] = { o1, o2 };
+  if (o2->collisionGeometry().get() < o1->collisionGeometry().get())
+    std::swap(objs[0], objs[1]);
+  const PairKey key(objs[0]->collisionGeometry().get(), objs[1]->collisionGeometry().get());
+  PairEntry& entry = session->pairs_[key];
+
+  // the pair was already evaluated for the previously closest pair in this query
+  if (entry.query_ == session->query_)
+    return drd->done;
+  entry.query_ = session->query_;
+
+  const Eigen::Isometry3d poses[2] = { getObjectPose(*objs[0]), getObjectPose(*objs[1]) };
+  if (!std::isnan(entry.distance_) && !entry.geometries_[0].expired() && !entry.geometries_[1].expired())
+  {
+    double threshold = drd->req->distance_threshold;
+    if (drd->req->type == DistanceRequestType::GLOBAL)
+      threshold = std::min(threshold, drd->res->minimum_distance.distance);
+    const double lower_bound = entry.distance_ - getMotionBound(*key.first, entry.poses_[0], poses[0]) -
+                               getMotionBound(*key.second, entry.poses_[1], poses[1]);
+    if (lower_bound >= threshold)
+    {
+      ++session->pruned_pairs_;
+      return drd->done;
+    }
+  }
+
+  const double min_distance = drd->res->minimum_distance.distance;
+  drd->pair_distance = std::numeric_limits<double>::quiet_NaN();
+  bool done = distanceCallback(o1, o2, drd, min_dist);
+  if (!std::isnan(drd->pair_distance))
+  {
+    entry.geometries_[0] = objs[0]->collisionGeometry();
+    entry.geometries_[1] = objs[1]->collisionGeometry();
+    entry.poses_[0] = poses[0];
+    entry.poses_[1] = poses[1];
+    entry.distance_ = drd->pair_distance;
+  }
+  if (drd->req->type == DistanceRequestType::GLOBAL && drd->res->minimum_distance.distance < min_distance)
+    session->closest_ = key;
+  return done;
+}
+
 void CollisionEnvFCL::updateFCLObject(const std::string& id)
 {
   // remove FCL objects that correspond to this object
@@ -409,6 +1065,7 @@ void CollisionEnvFCL::notifyObjectChange(const ObjectConstPtr& obj, World::Actio
 
 void CollisionEnvFCL::updatedPaddingOrScaling(const std::vector<std::string>& links)
 {
+  invalidateRobotCache();
   std::size_t index;
   for (const auto& link : links)
   {
@@ -0,0 +1,180 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Benchmark of collision checks with and without the per-thread robot object cache and incremental self-collision
+ * checking of CollisionEnvFCL */
+
+#include <moveit/collision_detection_fcl/collision_env_fcl.h>
+#include <moveit/robot_state/robot_state.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+// Count all heap allocations of this process, so the benchmark can report allocations per check
+static std::atomic<std::size_t> ALLOCATION_COUNT(0);
+
+void* operator new(std::size_t size)
+{
+  ++ALLOCATION_COUNT;
+  if (void* ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept
+{
+  std::free(ptr);
+}
+
+// Helper class to measure time and allocations within a scoped block and output the result
+class ScopedCounter
+{
+  const char* const msg_;
+  const std::size_t checks_;
+  const std::size_t allocations_;
+  const std::chrono::time_point<std::chrono::steady_clock> start_;
+
+public:
+  ScopedCounter(const char* msg, std::size_t checks)
+    : msg_(msg), checks_(checks), allocations_(ALLOCATION_COUNT), start_(std::chrono::steady_clock::now())
+  {
+  }
+
+  ~ScopedCounter()
+  {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+    std::cerr << msg_ << elapsed.count() * 1000. << "ms, "
+              << static_cast<double>(ALLOCATION_COUNT - allocations_) / checks_ << " allocations per check"
+              << std::endl;
+  }
+};
+
+class CollisionEnvFCLBenchmark : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    robot_model_ = moveit::core::loadTestingRobotModel("pr2");
+    ASSERT_TRUE(static_cast<bool>(robot_model_));
+
+    // precompute the states, so their allocations are not counted
+    states_.reserve(NUM_STATES);
+    for (std::size_t i = 0; i < NUM_STATES; ++i)
+    {
+      states_.emplace_back(robot_model_);
+      states_.back().setToRandomPositions();
+      states_.back().update();
+    }
+  }
+
+  void run(collision_detection::CollisionEnvFCL& env, bool self, const char* msg)
+  {
+    collision_detection::CollisionRequest req;
+    collision_detection::CollisionResult res;
+
+    // warm up the thread-local caches
+    env.checkSelfCollision(req, res, states_[0]);
+    env.checkRobotCollision(req, res, states_[0]);
+
+    ScopedCounter c(msg, NUM_STATES);
+    for (const moveit::core::RobotState& state : states_)
+    {
+      res.clear();
+      if (self)
+        env.checkSelfCollision(req, res, state);
+      else
+        env.checkRobotCollision(req, res, state);
+    }
+  }
+
+  static const std::size_t NUM_STATES = 10000;
+  moveit::core::RobotModelPtr robot_model_;
+  std::vector<moveit::core::RobotState> states_;
+};
+
+TEST_F(CollisionEnvFCLBenchmark, selfCollision)
+{
+  collision_detection::CollisionEnvFCL env(robot_model_);
+  env.setRobotObjectCaching(false);
+  run(env, true, "Self-collision checks without robot object cache: ");
+  env.setRobotObjectCaching(true);
+  run(env, true, "Self-collision checks with robot object cache: ");
+}
+
+TEST_F(CollisionEnvFCLBenchmark, robotCollision)
+{
+  collision_detection::CollisionEnvFCL env(robot_model_);
+  shapes::ShapeConstPtr box(new shapes::Box(0.2, 0.2, 0.2));
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation().x() = 0.8;
+  env.getWorld()->addToObject("box", box, pose);
+
+  env.setRobotObjectCaching(false);
+  run(env, false, "Robot-world checks without robot object cache: ");
+  env.setRobotObjectCaching(true);
+  run(env, false, "Robot-world checks with robot object cache: ");
+}
+
+TEST_F(CollisionEnvFCLBenchmark, incrementalSelfCollision)
+{
+  // only the right arm moves, as when planning for a single arm
+  const moveit::core::JointModelGroup* group = robot_model_->getJointModelGroup("right_arm");
+  ASSERT_TRUE(group);
+  for (std::size_t i = 1; i < NUM_STATES; ++i)
+  {
+    states_[i] = states_[0];
+    states_[i].setToRandomPositions(group);
+    states_[i].update();
+  }
+
+  collision_detection::CollisionEnvFCL env(robot_model_);
+  run(env, true, "Single-arm self-collision checks: ");
+  env.setIncrementalSelfCollision(true);
+  run(env, true, "Incremental single-arm self-collision checks: ");
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -222,6 +222,285 @@ TEST_F(CollisionDetectionEnvTest, PaddingTest)
   ASSERT_FALSE(res.collision);
 }
 
+/** \brief The per-thread robot object cache has to report the same collisions as freshly constructed objects. */
+TEST_F(CollisionDetectionEnvTest, RobotObjectCaching)
+{
+  std::shared_ptr<collision_detection::CollisionEnvFCL> uncached_env(
+      new collision_detection::CollisionEnvFCL(robot_model_));
+  uncached_env->setRobotObjectCaching(false);
+  ASSERT_TRUE(std::static_pointer_cast<collision_detection::CollisionEnvFCL>(c_env_)->getRobotObjectCaching());
+
+  shapes::ShapeConstPtr shape_ptr(new shapes::Box(0.1, 0.1, 0.1));
+  Eigen::Isometry3d pos{ Eigen::Isometry3d::Identity() };
+  pos.translation().x() = 0.43;
+  pos.translation().z() = 0.55;
+  c_env_->getWorld()->addToObject("box", shape_ptr, pos);
+  uncached_env->getWorld()->addToObject("box", shape_ptr, pos);
+
+  // attach a sphere to the hand, so the attached bodies are part of the checks as well
+  std::vector<shapes::ShapeConstPtr> shapes{ shapes::ShapeConstPtr(new shapes::Sphere(0.05)) };
+  EigenSTL::vector_Isometry3d poses{ Eigen::Isometry3d::Identity() };
+  robot_state_->attachBody("sphere", shapes, poses, std::set<std::string>(), "panda_hand");
+
+  collision_detection::CollisionRequest req;
+  for (std::size_t i = 0; i < 100; ++i)
+  {
+    robot_state_->setToRandomPositions();
+    robot_state_->update();
+
+    collision_detection::CollisionResult res, uncached_res;
+    c_env_->checkSelfCollision(req, res, *robot_state_, *acm_);
+    uncached_env->checkSelfCollision(req, uncached_res, *robot_state_, *acm_);
+    EXPECT_EQ(res.collision, uncached_res.collision);
+
+    res.clear();
+    uncached_res.clear();
+    c_env_->checkRobotCollision(req, res, *robot_state_, *acm_);
+    uncached_env->checkRobotCollision(req, uncached_res, *robot_state_, *acm_);
+    EXPECT_EQ(res.collision, uncached_res.collision);
+
+    EXPECT_NEAR(c_env_->distanceSelf(*robot_state_, *acm_), uncached_env->distanceSelf(*robot_state_, *acm_), 1e-6);
+    EXPECT_NEAR(c_env_->distanceRobot(*robot_state_, *acm_), uncached_env->distanceRobot(*robot_state_, *acm_), 1e-6);
+  }
+}
+
+/** \brief Cached attached body objects have to follow changes of the attached bodies. */
+TEST_F(CollisionDetectionEnvTest, AttachedBodyCaching)
+{
+  // box right in front of the robot hand
+  shapes::ShapeConstPtr box(new shapes::Box(0.1, 0.1, 0.1));
+  Eigen::Isometry3d pos{ Eigen::Isometry3d::Identity() };
+  pos.translation().x() = 0.43;
+  pos.translation().z() = 0.55;
+  c_env_->getWorld()->addToObject("box", box, pos);
+
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+  EigenSTL::vector_Isometry3d poses{ Eigen::Isometry3d::Identity() };
+
+  // a small object in the hand does not reach the box
+  std::vector<shapes::ShapeConstPtr> small{ shapes::ShapeConstPtr(new shapes::Sphere(0.01)) };
+  robot_state_->attachBody("object", small, poses, std::set<std::string>(), "panda_hand");
+  c_env_->checkRobotCollision(req, res, *robot_state_, *acm_);
+  ASSERT_FALSE(res.collision);
+  res.clear();
+
+  // replacing it by a large one with the same name has to be noticed
+  std::vector<shapes::ShapeConstPtr> large{ shapes::ShapeConstPtr(new shapes::Sphere(0.2)) };
+  robot_state_->clearAttachedBody("object");
+  robot_state_->attachBody("object", large, poses, std::set<std::string>(), "panda_hand");
+  c_env_->checkRobotCollision(req, res, *robot_state_, *acm_);
+  ASSERT_TRUE(res.collision);
+  res.clear();
+
+  // the cached objects must also be valid for copies of the state
+  moveit::core::RobotState copy(*robot_state_);
+  c_env_->checkRobotCollision(req, res, copy, *acm_);
+  ASSERT_TRUE(res.collision);
+  res.clear();
+
+  // touch links are taken from the checked state's attached body, even though the shapes did not change
+  c_env_->checkSelfCollision(req, res, copy, *acm_);
+  ASSERT_TRUE(res.collision);
+  res.clear();
+  copy.clearAttachedBody("object");
+  copy.attachBody("object", large, poses, robot_model_->getLinkModelNames(), "panda_hand");
+  c_env_->checkSelfCollision(req, res, copy, *acm_);
+  ASSERT_FALSE(res.collision);
+  res.clear();
+
+  // detaching the object removes it from the checks
+  robot_state_->clearAttachedBody("object");
+  c_env_->checkRobotCollision(req, res, *robot_state_, *acm_);
+  ASSERT_FALSE(res.collision);
+}
+
+/** \brief The batched check has to report the same colliding states as individual checks. */
+TEST_F(CollisionDetectionEnvTest, BatchCollision)
+{
+  shapes::ShapeConstPtr box(new shapes::Box(0.3, 0.3, 0.3));
+  Eigen::Isometry3d pos{ Eigen::Isometry3d::Identity() };
+  pos.translation().x() = 0.43;
+  pos.translation().z() = 0.55;
+  c_env_->getWorld()->addToObject("box", box, pos);
+
+  std::vector<moveit::core::RobotState> states(200, *robot_state_);
+  std::vector<const moveit::core::RobotState*> state_ptrs;
+  collision_detection::CollisionRequest req;
+  std::vector<std::size_t> expected;
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    states[i].setToRandomPositions();
+    states[i].update();
+    state_ptrs.push_back(&states[i]);
+
+    collision_detection::CollisionResult res;
+    c_env_->checkCollision(req, res, states[i], *acm_);
+    if (res.collision)
+      expected.push_back(i);
+  }
+  ASSERT_FALSE(expected.empty());
+
+  collision_detection::BatchCollisionRequest batch_req;
+  collision_detection::BatchCollisionResult batch_res;
+  batch_req.num_threads = 4;
+  batch_req.stop_at_first_collision = false;
+  c_env_->checkCollisionBatch(req, batch_req, batch_res, state_ptrs, *acm_);
+  EXPECT_TRUE(batch_res.collision);
+  EXPECT_EQ(batch_res.colliding_indices, expected);
+
+  batch_req.stop_at_first_collision = true;
+  c_env_->checkCollisionBatch(req, batch_req, batch_res, state_ptrs, *acm_);
+  EXPECT_TRUE(batch_res.collision);
+  ASSERT_EQ(batch_res.colliding_indices.size(), 1u);
+  EXPECT_EQ(batch_res.colliding_indices[0], expected[0]);
+
+  // a collision-free batch
+  c_env_->getWorld()->removeObject("box");
+  std::vector<const moveit::core::RobotState*> home(10, robot_state_.get());
+  c_env_->checkCollisionBatch(req, batch_req, batch_res, home, *acm_);
+  EXPECT_FALSE(batch_res.collision);
+  EXPECT_TRUE(batch_res.colliding_indices.empty());
+}
+
+/** \brief Incremental self-collision checks have to find the same collisions as regular ones. */
+TEST_F(CollisionDetectionEnvTest, IncrementalSelfCollision)
+{
+  std::shared_ptr<collision_detection::CollisionEnvFCL> incremental_env(
+      new collision_detection::CollisionEnvFCL(robot_model_));
+  incremental_env->setIncrementalSelfCollision(true);
+  ASSERT_FALSE(std::static_pointer_cast<collision_detection::CollisionEnvFCL>(c_env_)->getIncrementalSelfCollision());
+
+  std::vector<shapes::ShapeConstPtr> shapes{ shapes::ShapeConstPtr(new shapes::Sphere(0.05)) };
+  EigenSTL::vector_Isometry3d poses{ Eigen::Isometry3d::Identity() };
+  robot_state_->attachBody("sphere", shapes, poses, std::set<std::string>{ "panda_hand" }, "panda_hand");
+
+  const std::vector<std::string> wrist_joints{ "panda_joint5", "panda_joint6", "panda_joint7" };
+  collision_detection::CollisionRequest req;
+  random_numbers::RandomNumberGenerator rng(42);
+  for (std::size_t i = 0; i < 200; ++i)
+  {
+    // mostly move the wrist only, so most pairs of links are cached, but change everything from time to time
+    if (i % 20 == 0)
+      robot_state_->setToRandomPositions();
+    else
+      for (const std::string& joint : wrist_joints)
+      {
+        double value;
+        robot_model_->getJointModel(joint)->getVariableRandomPositions(rng, &value);
+        robot_state_->setJointPositions(joint, &value);
+      }
+    robot_state_->update();
+
+    collision_detection::CollisionResult res, incremental_res;
+    c_env_->checkSelfCollision(req, res, *robot_state_, *acm_);
+    incremental_env->checkSelfCollision(req, incremental_res, *robot_state_, *acm_);
+    EXPECT_EQ(incremental_res.collision, res.collision);
+
+    // the same state again is answered from the cache
+    incremental_res.clear();
+    incremental_env->checkSelfCollision(req, incremental_res, *robot_state_, *acm_);
+    EXPECT_EQ(incremental_res.collision, res.collision);
+  }
+}
+
+/** \brief The compact result has to contain the same contacts as the regular one and has to be reusable. */
+TEST_F(CollisionDetectionEnvTest, CompactCollisionResult)
+{
+  shapes::ShapeConstPtr box(new shapes::Box(0.3, 0.3, 0.3));
+  Eigen::Isometry3d pos{ Eigen::Isometry3d::Identity() };
+  pos.translation().x() = 0.43;
+  pos.translation().z() = 0.55;
+  c_env_->getWorld()->addToObject("box", box, pos);
+
+  collision_detection::CollisionRequest req;
+  req.contacts = true;
+  req.max_contacts = 10;
+  req.max_contacts_per_pair = 2;
+  collision_detection::CompactCollisionResult compact_res;
+  for (std::size_t i = 0; i < 50; ++i)
+  {
+    robot_state_->setToRandomPositions();
+    robot_state_->update();
+
+    collision_detection::CollisionResult res;
+    c_env_->checkCollision(req, res, *robot_state_, *acm_);
+    compact_res.clear();
+    c_env_->checkCollision(req, compact_res, *robot_state_, *acm_);
+
+    collision_detection::CollisionResult converted;
+    compact_res.getCollisionResult(converted);
+    EXPECT_EQ(converted.collision, res.collision);
+    EXPECT_EQ(converted.contact_count, res.contact_count);
+    EXPECT_EQ(compact_res.contacts.size(), res.contact_count);
+    ASSERT_EQ(converted.contacts.size(), res.contacts.size());
+    for (const auto& pair_contacts : res.contacts)
+    {
+      auto it = converted.contacts.find(pair_contacts.first);
+      ASSERT_TRUE(it != converted.contacts.end());
+      EXPECT_EQ(it->second.size(), pair_contacts.second.size());
+    }
+  }
+}
+
+/** \brief Distance sessions have to report the same distances as single queries while the robot moves slowly. */
+TEST_F(CollisionDetectionEnvTest, DistanceSession)
+{
+  shapes::ShapeConstPtr box(new shapes::Box(0.1, 0.1, 0.1));
+  Eigen::Isometry3d pos{ Eigen::Isometry3d::Identity() };
+  pos.translation().x() = 0.5;
+  pos.translation().z() = 0.5;
+  c_env_->getWorld()->addToObject("box", box, pos);
+
+  collision_detection::CollisionEnvFCL::DistanceSession session(
+      *std::static_pointer_cast<collision_detection::CollisionEnvFCL>(c_env_));
+
+  collision_detection::DistanceRequest global_req;
+  global_req.type = collision_detection::DistanceRequestType::GLOBAL;
+  global_req.acm = acm_.get();
+  collision_detection::DistanceRequest single_req;
+  single_req.type = collision_detection::DistanceRequestType::SINGLE;
+  single_req.distance_threshold = 0.05;
+  single_req.acm = acm_.get();
+
+  std::size_t pruned_pairs = 0;
+  double joint1 = 0.0;
+  for (std::size_t i = 0; i < 100; ++i)
+  {
+    // small steps, as in a control loop
+    joint1 += 0.01;
+    robot_state_->setJointPositions("panda_joint1", &joint1);
+    robot_state_->update();
+
+    for (const collision_detection::DistanceRequest& req : { global_req, single_req })
+    {
+      collision_detection::DistanceResult res, session_res;
+      c_env_->distanceSelf(req, res, *robot_state_);
+      session.distanceSelf(req, session_res, *robot_state_);
+      EXPECT_NEAR(session_res.minimum_distance.distance, res.minimum_distance.distance, 1e-6);
+      EXPECT_EQ(session_res.distances.size(), res.distances.size());
+      pruned_pairs += session.getPrunedPairCount();
+
+      res.clear();
+      session_res.clear();
+      c_env_->distanceRobot(req, res, *robot_state_);
+      session.distanceRobot(req, session_res, *robot_state_);
+      EXPECT_NEAR(session_res.minimum_distance.distance, res.minimum_distance.distance, 1e-6);
+      EXPECT_EQ(session_res.distances.size(), res.distances.size());
+      pruned_pairs += session.getPrunedPairCount();
+    }
+  }
+  EXPECT_GT(pruned_pairs, 0u);
+
+  // moving the world object has to be noticed
+  pos.translation().x() = 0.2;
+  c_env_->getWorld()->moveObject("box", pos);
+  collision_detection::DistanceResult res, session_res;
+  c_env_->distanceRobot(global_req, res, *robot_state_);
+  session.distanceRobot(global_req, session_res, *robot_state_);
+  EXPECT_NEAR(session_res.minimum_distance.distance, res.minimum_distance.distance, 1e-6);
+}
+
 /** \brief Continuous self collision checks of the robot.
  *
  *  Functionality not supported yet. */
@@ -266,10 +545,8 @@ TEST_F(CollisionDetectionEnvTest, DISABLED_ContinuousCollisionSelf)
   res.clear();
 }
 
-/** \brief Two similar robot poses are used as start and end pose of a continuous collision check.
- *
- *  Functionality not supported yet. */
-TEST_F(CollisionDetectionEnvTest, DISABLED_ContinuousCollisionWorld)
+/** \brief Two similar robot poses are used as start and end pose of a continuous collision check. */
+TEST_F(CollisionDetectionEnvTest, ContinuousCollisionWorld)
 {
   collision_detection::CollisionRequest req;
   req.contacts = true;
@@ -311,9 +588,25 @@ TEST_F(CollisionDetectionEnvTest, DISABLED_ContinuousCollisionWorld)
   ASSERT_FALSE(res.collision);
   res.clear();
 
+  // the hand moves through the box: the flange of panda_link7, the hand and both fingers hit it, one contact each
   c_env_->checkRobotCollision(req, res, state1, state2, *acm_);
   ASSERT_TRUE(res.collision);
   ASSERT_EQ(res.contact_count, 4u);
+  ASSERT_EQ(res.contacts.size(), 4u);
+  for (const std::string link : { "panda_link7", "panda_hand", "panda_leftfinger", "panda_rightfinger" })
+  {
+    const auto it = res.contacts.find(std::make_pair(std::string("box"), link));
+    ASSERT_NE(it, res.contacts.end()) << link;
+    ASSERT_EQ(it->second.size(), 1u) << link;
+    EXPECT_GT(it->second[0].percent_interpolation, 0.0) << link;
+    EXPECT_LT(it->second[0].percent_interpolation, 1.0) << link;
+  }
+
+  // the hand is wider than the flange and the fingers, so it reaches the box first
+  const double hand_time = res.contacts[std::make_pair(std::string("box"), std::string("panda_hand"))][0]
+                               .percent_interpolation;
+  for (const std::string link : { "panda_link7", "panda_leftfinger", "panda_rightfinger" })
+    EXPECT_LT(hand_time, res.contacts[std::make_pair(std::string("box"), link)][0].percent_interpolation) << link;
   res.clear();
 }
 
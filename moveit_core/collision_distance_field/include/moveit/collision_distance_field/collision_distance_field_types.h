@@ -167,6 +167,17 @@ public:
     return res;
   }
 
+  /**
+   * @brief Batched version of getDistanceGradient(). All points are
+   * transformed into the local distance field coordinate system at once
+   * and looked up together, see
+   * distance_field::DistanceField::getDistanceGradients().
+   */
+  void getDistanceGradients(const Eigen::Ref<const Eigen::Matrix3Xd>& points, Eigen::Ref<Eigen::VectorXd> distances,
+                            Eigen::Ref<Eigen::Matrix3Xd> gradients,
+                            Eigen::Ref<Eigen::Array<bool, Eigen::Dynamic, 1>> in_bounds,
+                            bool interpolate = false) const override;
+
   /*
    * @brief determines a set of gradients of the given collision spheres in the
    * distance field
@@ -181,11 +192,13 @@ public:
    * @param maximum_value
    * @param stop_at_first_collision when true the computation is terminated when
    * the first collision is found
+   * @param interpolate when true the distances and gradients are trilinearly
+   * interpolated between cells instead of taken from the nearest cell
    */
   bool getCollisionSphereGradients(const std::vector<CollisionSphere>& sphere_list,
                                    const EigenSTL::vector_Vector3d& sphere_centers, GradientInfo& gradient,
                                    const CollisionType& type, double tolerance, bool subtract_radii,
-                                   double maximum_value, bool stop_at_first_collision);
+                                   double maximum_value, bool stop_at_first_collision, bool interpolate = false);
 
 protected:
   Eigen::Isometry3d pose_;
@@ -197,12 +210,13 @@ protected:
 std::vector<CollisionSphere> determineCollisionSpheres(const bodies::Body* body, Eigen::Isometry3d& relativeTransform);
 
 // determines a set of gradients of the given collision spheres in the distance
-// field
+// field; all sphere centers are looked up in one batch, optionally with
+// trilinear interpolation
 bool getCollisionSphereGradients(const distance_field::DistanceField* distance_field,
                                  const std::vector<CollisionSphere>& sphere_list,
                                  const EigenSTL::vector_Vector3d& sphere_centers, GradientInfo& gradient,
                                  const CollisionType& type, double tolerance, bool subtract_radii, double maximum_value,
-                                 bool stop_at_first_collision);
+                                 bool stop_at_first_collision, bool interpolate = false);
 
 bool getCollisionSphereCollision(const distance_field::DistanceField* distance_field,
                                  const std::vector<CollisionSphere>& sphere_list,
@@ -88,6 +88,11 @@ public:
                   const Eigen::Vector3d& size, const Eigen::Vector3d& origin, bool use_signed_distance_field,
                   double resolution, double collision_tolerance, double max_propogation_distance);
 
+  // keep the CompactCollisionResult overloads of CollisionEnv visible
+  using CollisionEnv::checkCollision;
+  using CollisionEnv::checkRobotCollision;
+  using CollisionEnv::checkSelfCollision;
+
   void checkSelfCollision(const collision_detection::CollisionRequest& req, collision_detection::CollisionResult& res,
                           const moveit::core::RobotState& state) const override;
 
@@ -209,6 +214,19 @@ public:
     return last_gsr_;
   }
 
+  /** \brief Set whether getCollisionGradients() interpolates the distances and gradients of the collision spheres
+   * trilinearly between the cells of the distance fields, instead of using the nearest cell. Interpolated gradients
+   * change continuously with the robot state, which helps gradient-based planners. Disabled by default. */
+  void setGradientInterpolation(bool interpolate)
+  {
+    interpolate_gradients_ = interpolate;
+  }
+
+  bool getGradientInterpolation() const
+  {
+    return interpolate_gradients_;
+  }
+
   void getCollisionGradients(const CollisionRequest& req, CollisionResult& res, const moveit::core::RobotState& state,
                              const AllowedCollisionMatrix* acm, GroupStateRepresentationPtr& gsr) const;
 
@@ -288,6 +306,7 @@ protected:
   double resolution_;
   double collision_tolerance_;
   double max_propogation_distance_;
+  bool interpolate_gradients_ = false;
 
   std::vector<BodyDecompositionConstPtr> link_body_decomposition_vector_;
   std::map<std::string, unsigned int> link_body_decomposition_index_map_;
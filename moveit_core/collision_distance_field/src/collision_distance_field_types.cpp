@@ -43,6 +43,37 @@
 
 const static double EPSILON = 0.0001;
 
+namespace
+{
+// Per-thread buffers for the batched distance field lookups of collision spheres; they only
+// grow, so computing the gradients of a group does not allocate once they are large enough
+struct SphereLookup
+{
+  Eigen::VectorXd distances;
+  Eigen::Matrix3Xd gradients;
+  Eigen::Array<bool, Eigen::Dynamic, 1> in_bounds;
+};
+
+SphereLookup& lookupCollisionSpheres(const distance_field::DistanceField& distance_field,
+                                     const EigenSTL::vector_Vector3d& sphere_centers, std::size_t count,
+                                     bool interpolate)
+{
+  thread_local SphereLookup lookup;
+  const Eigen::Index n = static_cast<Eigen::Index>(count);
+  if (lookup.distances.size() < n)
+  {
+    lookup.distances.resize(n);
+    lookup.gradients.resize(3, n);
+    lookup.in_bounds.resize(n);
+  }
+  if (n > 0)
+    distance_field.getDistanceGradients(Eigen::Map<const Eigen::Matrix3Xd>(sphere_centers[0].data(), 3, n),
+                                        lookup.distances.head(n), lookup.gradients.leftCols(n),
+                                        lookup.in_bounds.head(n), interpolate);
+  return lookup;
+}
+}  // namespace
+
 std::vector<collision_detection::CollisionSphere>
 collision_detection::determineCollisionSpheres(const bodies::Body* body, Eigen::Isometry3d& relative_transform)
 {
@@ -64,21 +95,42 @@ collision_detection::determineCollisionSpheres(const bodies::Body* body, Eigen::
   return css;
 }
 
+void collision_detection::PosedDistanceField::getDistanceGradients(
+    const Eigen::Ref<const Eigen::Matrix3Xd>& points, Eigen::Ref<Eigen::VectorXd> distances,
+    Eigen::Ref<Eigen::Matrix3Xd> gradients, Eigen::Ref<Eigen::Array<bool, Eigen::Dynamic, 1>> in_bounds,
+    bool interpolate) const
+{
+  thread_local Eigen::Matrix3Xd rel_points_buffer;
+  if (rel_points_buffer.cols() < points.cols())
+    rel_points_buffer.resize(3, points.cols());
+  auto rel_points = rel_points_buffer.leftCols(points.cols());
+
+  const Eigen::Isometry3d inverse_pose = pose_.inverse();
+  rel_points.noalias() = inverse_pose.linear() * points;
+  rel_points.colwise() += inverse_pose.translation();
+  distance_field::PropagationDistanceField::getDistanceGradients(rel_points, distances, gradients, in_bounds,
+                                                                 interpolate);
+
+  // as in getDistanceGradient(), the gradients are transformed by the full pose
+  for (Eigen::Index i = 0; i < gradients.cols(); ++i)
+    gradients.col(i) = pose_ * Eigen::Vector3d(gradients.col(i));
+}
+
 bool collision_detection::PosedDistanceField::getCollisionSphereGradients(
     const std::vector<CollisionSphere>& sphere_list, const EigenSTL::vector_Vector3d& sphere_centers,
     GradientInfo& gradient, const collision_detection::CollisionType& type, double tolerance, bool subtract_radii,
-    double maximum_value, bool stop_at_first_collision)
+    double maximum_value, bool stop_at_first_collision, bool interpolate)
 {
   // assumes gradient is properly initialized
 
+  const SphereLookup& lookup = lookupCollisionSpheres(*this, sphere_centers, sphere_list.size(), interpolate);
+
   bool in_collision = false;
   for (unsigned int i = 0; i < sphere_list.size(); i++)
   {
-    Eigen::Vector3d p = sphere_centers[i];
-    Eigen::Vector3d grad(0, 0, 0);
-    bool in_bounds;
-    double dist = this->getDistanceGradient(p.x(), p.y(), p.z(), grad.x(), grad.y(), grad.z(), in_bounds);
-    if (!in_bounds && grad.norm() > 0)
+    const auto grad = lookup.gradients.col(i);
+    double dist = lookup.distances[i];
+    if (!lookup.in_bounds[i] && grad.norm() > 0)
     {
       // out of bounds
       return true;
@@ -132,19 +184,20 @@ bool collision_detection::getCollisionSphereGradients(const distance_field::Dist
                                                       GradientInfo& gradient,
                                                       const collision_detection::CollisionType& type, double tolerance,
                                                       bool subtract_radii, double maximum_value,
-                                                      bool stop_at_first_collision)
+                                                      bool stop_at_first_collision, bool interpolate)
 {
   // assumes gradient is properly initialized
 
+  const SphereLookup& lookup = lookupCollisionSpheres(*distance_field, sphere_centers, sphere_list.size(), interpolate);
+
   bool in_collision = false;
   for (unsigned int i = 0; i < sphere_list.size(); i++)
   {
-    Eigen::Vector3d p = sphere_centers[i];
-    Eigen::Vector3d grad;
-    bool in_bounds;
-    double dist = distance_field->getDistanceGradient(p.x(), p.y(), p.z(), grad.x(), grad.y(), grad.z(), in_bounds);
-    if (!in_bounds && grad.norm() > EPSILON)
+    const auto grad = lookup.gradients.col(i);
+    double dist = lookup.distances[i];
+    if (!lookup.in_bounds[i] && grad.norm() > EPSILON)
     {
+      const Eigen::Vector3d& p = sphere_centers[i];
       ROS_DEBUG("Collision sphere point is out of bounds %lf, %lf, %lf", p.x(), p.y(), p.z());
       return true;
     }
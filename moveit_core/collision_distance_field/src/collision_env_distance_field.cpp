@@ -98,6 +98,7 @@ CollisionEnvDistanceField::CollisionEnvDistanceField(const CollisionEnvDistanceF
   resolution_ = other.resolution_;
   collision_tolerance_ = other.collision_tolerance_;
   max_propogation_distance_ = other.max_propogation_distance_;
+  interpolate_gradients_ = other.interpolate_gradients_;
   link_body_decomposition_vector_ = other.link_body_decomposition_vector_;
   link_body_decomposition_index_map_ = other.link_body_decomposition_index_map_;
   in_group_update_map_ = other.in_group_update_map_;
@@ -394,7 +395,7 @@ bool CollisionEnvDistanceField::getSelfProximityGradients(GroupStateRepresentati
         {
           coll = gsr->link_distance_fields_[j]->getCollisionSphereGradients(
               *collision_spheres_1, *sphere_centers_1, gsr->gradients_[i], collision_detection::SELF,
-              collision_tolerance_, false, max_propogation_distance_, false);
+              collision_tolerance_, false, max_propogation_distance_, false, interpolate_gradients_);
 
           if (coll)
           {
@@ -406,7 +407,7 @@ bool CollisionEnvDistanceField::getSelfProximityGradients(GroupStateRepresentati
 
     coll = getCollisionSphereGradients(gsr->dfce_->distance_field_.get(), *collision_spheres_1, *sphere_centers_1,
                                        gsr->gradients_[i], collision_detection::SELF, collision_tolerance_, false,
-                                       max_propogation_distance_, false);
+                                       max_propogation_distance_, false, interpolate_gradients_);
 
     if (coll)
     {
@@ -1679,7 +1680,7 @@ bool CollisionEnvDistanceField::getEnvironmentProximityGradients(
 
     bool coll = getCollisionSphereGradients(env_distance_field.get(), *collision_spheres_1, *sphere_centers_1,
                                             gsr->gradients_[i], ENVIRONMENT, collision_tolerance_, false,
-                                            max_propogation_distance_, false);
+                                            max_propogation_distance_, false, interpolate_gradients_);
     if (coll)
     {
       in_collision = true;
@@ -320,6 +320,30 @@ public:
    */
   double getDistanceGradient(double x, double y, double z, double& gradient_x, double& gradient_y, double& gradient_z,
                              bool& in_bounds) const;
+
+  /**
+   * \brief Gets the distances and gradients of many locations at
+   * once, as getDistanceGradient() does for a single one.
+   *
+   * The grid coordinates of the points are computed for blocks of
+   * points at a time, before the cells are looked up. With \e
+   * interpolate, the distance is trilinearly interpolated between the
+   * centers of the eight cells surrounding each point, and the
+   * gradient is the derivative of this interpolation. Unlike the
+   * distance of the nearest cell, it changes continuously with the
+   * location.
+   *
+   * @param [in] points The locations, one per column
+   * @param [out] distances The distance for each point
+   * @param [out] gradients The gradient for each point, one per column
+   * @param [out] in_bounds Whether each point is valid for gradient purposes
+   * @param [in] interpolate Whether to interpolate between cells instead of using the nearest cell
+   */
+  virtual void getDistanceGradients(const Eigen::Ref<const Eigen::Matrix3Xd>& points,
+                                    Eigen::Ref<Eigen::VectorXd> distances, Eigen::Ref<Eigen::Matrix3Xd> gradients,
+                                    Eigen::Ref<Eigen::Array<bool, Eigen::Dynamic, 1>> in_bounds,
+                                    bool interpolate = false) const;
+
   /**
    * \brief Gets the distance to the closest obstacle at the given
    * integer cell location. The particulars of this function are
@@ -612,6 +636,17 @@ protected:
   void setPoint(int xCell, int yCell, int zCell, double dist, geometry_msgs::Point& point, std_msgs::ColorRGBA& color,
                 double max_distance) const;
 
+  /**
+   * \brief Implements getDistanceGradients() on top of a function
+   * that returns the distance of a valid cell, so derived classes can
+   * provide a cheaper cell lookup.
+   */
+  template <typename CellDistance>
+  void computeDistanceGradients(const Eigen::Ref<const Eigen::Matrix3Xd>& points, Eigen::Ref<Eigen::VectorXd> distances,
+                                Eigen::Ref<Eigen::Matrix3Xd> gradients,
+                                Eigen::Ref<Eigen::Array<bool, Eigen::Dynamic, 1>> in_bounds, bool interpolate,
+                                const CellDistance& cell_distance) const;
+
   double size_x_;            /**< \brief X size of the distance field */
   double size_y_;            /**< \brief Y size of the distance field */
   double size_z_;            /**< \brief Z size of the distance field */
@@ -622,4 +657,99 @@ protected:
   int inv_twice_resolution_; /**< \brief Computed value 1.0/(2.0*resolution_) */
 };
 
+template <typename CellDistance>
+void DistanceField::computeDistanceGradients(const Eigen::Ref<const Eigen::Matrix3Xd>& points,
+                                             Eigen::Ref<Eigen::VectorXd> distances,
+                                             Eigen::Ref<Eigen::Matrix3Xd> gradients,
+                                             Eigen::Ref<Eigen::Array<bool, Eigen::Dynamic, 1>> in_bounds,
+                                             bool interpolate, const CellDistance& cell_distance) const
+{
+  // number of points whose grid coordinates are computed together
+  static const int BLOCK_SIZE = 32;
+
+  const int num_x = getXNumCells();
+  const int num_y = getYNumCells();
+  const int num_z = getZNumCells();
+  const double uninitialized_distance = getUninitializedDistance();
+  const double inv_resolution = 1.0 / resolution_;
+
+  // for the nearest cell, the same rounding as VoxelGrid::worldToGrid() is used, so results match
+  // getDistanceGradient() exactly; interpolation uses the cells whose centers surround the point
+  const double shift = interpolate ? 0.0 : 0.5 * resolution_;
+  const Eigen::Array3d grid_origin(origin_x_ - shift, origin_y_ - shift, origin_z_ - shift);
+
+  Eigen::Array<double, 3, BLOCK_SIZE> grid;
+  Eigen::Array<double, 3, BLOCK_SIZE> cells;
+  for (Eigen::Index start = 0; start < points.cols(); start += BLOCK_SIZE)
+  {
+    const int count = static_cast<int>(std::min<Eigen::Index>(BLOCK_SIZE, points.cols() - start));
+    grid.leftCols(count) =
+        (points.middleCols(start, count).array().colwise() - grid_origin) * inv_resolution;
+    cells.leftCols(count) = grid.leftCols(count).floor();
+
+    for (int k = 0; k < count; ++k)
+    {
+      const Eigen::Index i = start + k;
+      const int x = static_cast<int>(cells(0, k));
+      const int y = static_cast<int>(cells(1, k));
+      const int z = static_cast<int>(cells(2, k));
+
+      if (!interpolate)
+      {
+        // we need extra padding of 1 to get gradients
+        if (x < 1 || y < 1 || z < 1 || x >= num_x - 1 || y >= num_y - 1 || z >= num_z - 1)
+        {
+          distances[i] = uninitialized_distance;
+          gradients.col(i).setZero();
+          in_bounds[i] = false;
+          continue;
+        }
+        gradients(0, i) = (cell_distance(x + 1, y, z) - cell_distance(x - 1, y, z)) * inv_twice_resolution_;
+        gradients(1, i) = (cell_distance(x, y + 1, z) - cell_distance(x, y - 1, z)) * inv_twice_resolution_;
+        gradients(2, i) = (cell_distance(x, y, z + 1) - cell_distance(x, y, z - 1)) * inv_twice_resolution_;
+        distances[i] = cell_distance(x, y, z);
+        in_bounds[i] = true;
+        continue;
+      }
+
+      if (x < 0 || y < 0 || z < 0 || x >= num_x - 1 || y >= num_y - 1 || z >= num_z - 1)
+      {
+        distances[i] = uninitialized_distance;
+        gradients.col(i).setZero();
+        in_bounds[i] = false;
+        continue;
+      }
+
+      // c[dx][dy][dz] is the distance of cell (x + dx, y + dy, z + dz)
+      double c[2][2][2];
+      for (int dx = 0; dx < 2; ++dx)
+        for (int dy = 0; dy < 2; ++dy)
+          for (int dz = 0; dz < 2; ++dz)
+            c[dx][dy][dz] = cell_distance(x + dx, y + dy, z + dz);
+
+      const double tx = grid(0, k) - cells(0, k);
+      const double ty = grid(1, k) - cells(1, k);
+      const double tz = grid(2, k) - cells(2, k);
+
+      // interpolate along z, then y, then x
+      double cz[2][2];
+      for (int dx = 0; dx < 2; ++dx)
+        for (int dy = 0; dy < 2; ++dy)
+          cz[dx][dy] = c[dx][dy][0] + tz * (c[dx][dy][1] - c[dx][dy][0]);
+      const double cy0 = cz[0][0] + ty * (cz[0][1] - cz[0][0]);
+      const double cy1 = cz[1][0] + ty * (cz[1][1] - cz[1][0]);
+      distances[i] = cy0 + tx * (cy1 - cy0);
+
+      gradients(0, i) = (cy1 - cy0) * inv_resolution;
+      gradients(1, i) = ((1.0 - tx) * (cz[0][1] - cz[0][0]) + tx * (cz[1][1] - cz[1][0])) * inv_resolution;
+      double dz_sum = 0.0;
+      for (int dx = 0; dx < 2; ++dx)
+        for (int dy = 0; dy < 2; ++dy)
+          dz_sum += (dx ? tx : 1.0 - tx) * (dy ? ty : 1.0 - ty) * (c[dx][dy][1] - c[dx][dy][0]);
+      gradients(2, i) = dz_sum * inv_resolution;
+      in_bounds[i] = true;
+    }
+  }
+}
+
 }  // namespace distance_field
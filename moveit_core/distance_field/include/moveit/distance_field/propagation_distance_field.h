@@ -325,6 +325,16 @@ public:
    */
   double getDistance(int x, int y, int z) const override;
 
+  /**
+   * \brief Batched lookup of distances and gradients, see
+   * DistanceField::getDistanceGradients(). The cells are read from
+   * the voxel grid directly instead of through virtual calls.
+   */
+  void getDistanceGradients(const Eigen::Ref<const Eigen::Matrix3Xd>& points, Eigen::Ref<Eigen::VectorXd> distances,
+                            Eigen::Ref<Eigen::Matrix3Xd> gradients,
+                            Eigen::Ref<Eigen::Array<bool, Eigen::Dynamic, 1>> in_bounds,
+                            bool interpolate = false) const override;
+
   bool isCellValid(int x, int y, int z) const override;
   int getXNumCells() const override;
   int getYNumCells() const override;
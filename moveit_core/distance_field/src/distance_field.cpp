@@ -85,6 +85,16 @@ double DistanceField::getDistanceGradient(double x, double y, double z, double&
   return getDistance(gx, gy, gz);
 }
 
+void DistanceField::getDistanceGradients(const Eigen::Ref<const Eigen::Matrix3Xd>& points,
+                                         Eigen::Ref<Eigen::VectorXd> distances,
+                                         Eigen::Ref<Eigen::Matrix3Xd> gradients,
+                                         Eigen::Ref<Eigen::Array<bool, Eigen::Dynamic, 1>> in_bounds,
+                                         bool interpolate) const
+{
+  computeDistanceGradients(points, distances, gradients, in_bounds, interpolate,
+                           [this](int x, int y, int z) { return getDistance(x, y, z); });
+}
+
 void DistanceField::getIsoSurfaceMarkers(double min_distance, double max_distance, const std::string& frame_id,
                                          const ros::Time stamp, visualization_msgs::Marker& inf_marker) const
 {
@@ -601,6 +601,18 @@ double PropagationDistanceField::getDistance(int x, int y, int z) const
   return getDistance(voxel_grid_->getCell(x, y, z));
 }
 
+void PropagationDistanceField::getDistanceGradients(const Eigen::Ref<const Eigen::Matrix3Xd>& points,
+                                                    Eigen::Ref<Eigen::VectorXd> distances,
+                                                    Eigen::Ref<Eigen::Matrix3Xd> gradients,
+                                                    Eigen::Ref<Eigen::Array<bool, Eigen::Dynamic, 1>> in_bounds,
+                                                    bool interpolate) const
+{
+  const VoxelGrid<PropDistanceFieldVoxel>& grid = *voxel_grid_;
+  computeDistanceGradients(points, distances, gradients, in_bounds, interpolate, [this, &grid](int x, int y, int z) {
+    return PropagationDistanceField::getDistance(grid.getCell(x, y, z));
+  });
+}
+
 bool PropagationDistanceField::isCellValid(int x, int y, int z) const
 {
   return voxel_grid_->isCellValid(x, y, z);
@@ -648,6 +648,56 @@ TEST(TestSignedPropagationDistanceField, TestShape)
   ASSERT_TRUE(areDistanceFieldsDistancesEqual(df, test_df));
 }
 
+TEST(TestSignedPropagationDistanceField, TestDistanceGradients)
+{
+  PropagationDistanceField df(WIDTH, HEIGHT, DEPTH, RESOLUTION, ORIGIN_X, ORIGIN_Y, ORIGIN_Z, MAX_DIST, true);
+  shapes::Sphere sphere(.25);
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation() = Eigen::Vector3d(0.5, 0.5, 0.5);
+  df.addShapeToField(&sphere, pose);
+
+  // random points covering the field and its surroundings
+  const int num_points = 1000;
+  Eigen::Matrix3Xd points = Eigen::Matrix3Xd::Random(3, num_points) * 0.6;
+  points.colwise() += Eigen::Vector3d(0.5, 0.5, 0.5);
+
+  Eigen::VectorXd distances(num_points);
+  Eigen::Matrix3Xd gradients(3, num_points);
+  Eigen::Array<bool, Eigen::Dynamic, 1> in_bounds(num_points);
+
+  // the nearest-cell lookup matches getDistanceGradient() exactly
+  df.getDistanceGradients(points, distances, gradients, in_bounds);
+  for (int i = 0; i < num_points; ++i)
+  {
+    Eigen::Vector3d gradient;
+    bool point_in_bounds;
+    double distance = df.getDistanceGradient(points(0, i), points(1, i), points(2, i), gradient.x(), gradient.y(),
+                                             gradient.z(), point_in_bounds);
+    EXPECT_EQ(point_in_bounds, in_bounds[i]);
+    EXPECT_EQ(distance, distances[i]);
+    EXPECT_TRUE(gradient == gradients.col(i));
+  }
+
+  // the interpolated distance equals the cell distance at cell centers
+  Eigen::Matrix3Xd centers(3, 2);
+  centers << 0.4, 0.4, 0.3, 0.4, 0.5, 0.5;
+  df.getDistanceGradients(centers, distances.head(2), gradients.leftCols(2), in_bounds.head(2), true);
+  for (int i = 0; i < 2; ++i)
+  {
+    ASSERT_TRUE(in_bounds[i]);
+    EXPECT_NEAR(df.getDistance(centers(0, i), centers(1, i), centers(2, i)), distances[i], 1e-9);
+  }
+
+  // and changes linearly between neighboring cells
+  double half_way = (distances[0] + distances[1]) / 2.0;
+  double slope = (distances[1] - distances[0]) / RESOLUTION;
+  Eigen::Matrix3Xd middle = centers.rowwise().mean();
+  df.getDistanceGradients(middle, distances.head(1), gradients.leftCols(1), in_bounds.head(1), true);
+  ASSERT_TRUE(in_bounds[0]);
+  EXPECT_NEAR(half_way, distances[0], 1e-9);
+  EXPECT_NEAR(slope, gradients(1, 0), 1e-6);
+}
+
 static const double PERF_WIDTH = 3.0;
 static const double PERF_HEIGHT = 3.0;
 static const double PERF_DEPTH = 4.0;
@@ -415,6 +415,22 @@ public:
                       const moveit::core::RobotState& robot_state,
                       const collision_detection::AllowedCollisionMatrix& acm) const;
 
+  /** \brief Check whether a specified state (\e robot_state) is in collision, with respect to a given
+      allowed collision matrix (\e acm). The contacts are stored in a compact result (\e res), which can be reused
+      for repeated queries without allocating memory. */
+  void checkCollision(const collision_detection::CollisionRequest& req,
+                      collision_detection::CompactCollisionResult& res, const moveit::core::RobotState& robot_state,
+                      const collision_detection::AllowedCollisionMatrix& acm) const;
+
+  /** \brief Check a batch of states (\e states) for collisions, as checkCollision() does for each of them, with respect
+      to a given allowed collision matrix (\e acm). The states are checked in parallel and their collision transforms
+      are expected to be up to date. */
+  void checkCollisionBatch(const collision_detection::CollisionRequest& req,
+                           const collision_detection::BatchCollisionRequest& batch_req,
+                           collision_detection::BatchCollisionResult& res,
+                           const std::vector<const moveit::core::RobotState*>& states,
+                           const collision_detection::AllowedCollisionMatrix& acm) const;
+
   /** \brief Check whether the current state is in collision,
       but use a collision_detection::CollisionRobot instance that has no padding.
       Since the function is non-const, the current state transforms are also updated if needed. */
@@ -679,6 +695,28 @@ public:
   /** \brief Load the geometry of the planning scene from a stream at a certain location using offset*/
   bool loadGeometryFromStream(std::istream& in, const Eigen::Isometry3d& offset);
 
+  /** \brief Save the geometry of the planning scene to a stream, in a versioned binary format. Unlike the plain text
+      format, it stores meshes as arrays that are copied in bulk when loading, e.g. from a memory-mapped file. Octree
+      shapes are not stored. */
+  bool saveGeometryToBinary(std::ostream& out) const;
+
+  /** \brief Save the geometry of the planning scene to the file at \e path, in the binary format */
+  bool saveGeometryToBinaryFile(const std::string& path) const;
+
+  /** \brief Load the geometry of the planning scene from \e size bytes of the binary format at \e data, which need
+      to be aligned to eight bytes */
+  bool loadGeometryFromBinary(const void* data, std::size_t size);
+
+  /** \brief Load the geometry of the planning scene from the binary format at a certain location using offset */
+  bool loadGeometryFromBinary(const void* data, std::size_t size, const Eigen::Isometry3d& offset);
+
+  /** \brief Load the geometry of the planning scene from the binary file at \e path, mapping it into memory */
+  bool loadGeometryFromBinaryFile(const std::string& path);
+
+  /** \brief Load the geometry of the planning scene from the binary file at \e path at a certain location using
+      offset */
+  bool loadGeometryFromBinaryFile(const std::string& path, const Eigen::Isometry3d& offset);
+
   /** \brief Fill the message \e scene with the differences between this instance of PlanningScene with respect to the
      parent.
       If there is no parent, everything is considered to be a diff and the function behaves like getPlanningSceneMsg()
@@ -43,9 +43,12 @@
 #include <moveit/robot_state/conversions.h>
 #include <moveit/exceptions/exceptions.h>
 #include <moveit/robot_state/attached_body.h>
+#include <moveit/utils/binary_io.h>
 #include <moveit/utils/message_checks.h>
 #include <octomap_msgs/conversions.h>
 #include <tf2_eigen/tf2_eigen.h>
+#include <fstream>
+#include <limits>
 #include <memory>
 #include <set>
 
@@ -56,6 +59,9 @@ const std::string PlanningScene::DEFAULT_SCENE_NAME = "(noname)";
 
 const std::string LOGNAME = "planning_scene";
 
+// paths shorter than this are collision checked serially in isPathValid()
+const std::size_t MIN_WAYPOINTS_FOR_BATCH_PATH_CHECK = 256;
+
 class SceneTransforms : public moveit::core::Transforms
 {
 public:
@@ -511,6 +517,35 @@ void PlanningScene::checkCollision(const collision_detection::CollisionRequest&
     getCollisionEnvUnpadded()->checkSelfCollision(req, res, robot_state, acm);
 }
 
+void PlanningScene::checkCollision(const collision_detection::CollisionRequest& req,
+                                   collision_detection::CompactCollisionResult& res,
+                                   const moveit::core::RobotState& robot_state,
+                                   const collision_detection::AllowedCollisionMatrix& acm) const
+{
+  // check collision with the world using the padded version
+  getCollisionEnv()->checkRobotCollision(req, res, robot_state, acm);
+
+  // do self-collision checking with the unpadded version of the robot
+  if (!res.collision || (req.contacts && res.contact_count < req.max_contacts))
+    getCollisionEnvUnpadded()->checkSelfCollision(req, res, robot_state, acm);
+}
+
+void PlanningScene::checkCollisionBatch(const collision_detection::CollisionRequest& req,
+                                        const collision_detection::BatchCollisionRequest& batch_req,
+                                        collision_detection::BatchCollisionResult& res,
+                                        const std::vector<const moveit::core::RobotState*>& states,
+                                        const collision_detection::AllowedCollisionMatrix& acm) const
+{
+  // each worker reuses its own result
+  std::vector<collision_detection::CollisionResult> results(
+      collision_detection::getBatchWorkerCount(batch_req, states.size()));
+  collision_detection::checkCollisionBatch(batch_req, res, states.size(), [&](std::size_t i, std::size_t worker) {
+    results[worker].clear();
+    checkCollision(req, results[worker], *states[i], acm);
+    return results[worker].collision;
+  });
+}
+
 void PlanningScene::checkCollisionUnpadded(const collision_detection::CollisionRequest& req,
                                            collision_detection::CollisionResult& res)
 {
@@ -949,6 +984,137 @@ void PlanningScene::getPlanningSceneMsg(moveit_msgs::PlanningScene& scene_msg,
     getOctomapMsg(scene_msg.world.octomap);
 }
 
+namespace
+{
+const char* const GEOMETRY_MAGIC = "MOVEITSC";
+const std::uint32_t GEOMETRY_VERSION = 1;
+
+bool isBinaryShape(const shapes::Shape& shape)
+{
+  return shape.type == shapes::SPHERE || shape.type == shapes::BOX || shape.type == shapes::CYLINDER ||
+         shape.type == shapes::CONE || shape.type == shapes::PLANE || shape.type == shapes::MESH;
+}
+
+// Shapes are stored as their type followed by their parameters; meshes with their normals, so that loading them
+// only copies arrays
+void writeBinaryShape(moveit::core::BinaryWriter& writer, const shapes::Shape& shape)
+{
+  writer.write<std::uint32_t>(shape.type);
+  switch (shape.type)
+  {
+    case shapes::SPHERE:
+      writer.write(static_cast<const shapes::Sphere&>(shape).radius);
+      break;
+    case shapes::BOX:
+      writer.write(static_cast<const shapes::Box&>(shape).size, 3);
+      break;
+    case shapes::CYLINDER:
+    {
+      const shapes::Cylinder& cylinder = static_cast<const shapes::Cylinder&>(shape);
+      const double parameters[] = { cylinder.radius, cylinder.length };
+      writer.write(parameters, 2);
+      break;
+    }
+    case shapes::CONE:
+    {
+      const shapes::Cone& cone = static_cast<const shapes::Cone&>(shape);
+      const double parameters[] = { cone.radius, cone.length };
+      writer.write(parameters, 2);
+      break;
+    }
+    case shapes::PLANE:
+    {
+      const shapes::Plane& plane = static_cast<const shapes::Plane&>(shape);
+      const double parameters[] = { plane.a, plane.b, plane.c, plane.d };
+      writer.write(parameters, 4);
+      break;
+    }
+    case shapes::MESH:
+    {
+      std::unique_ptr<shapes::Mesh> mesh(static_cast<const shapes::Mesh&>(shape).clone());
+      mesh->computeTriangleNormals();
+      mesh->computeVertexNormals();
+      static_assert(sizeof(unsigned int) == sizeof(std::uint32_t), "Triangles are stored as 32 bit indices");
+      writer.write<std::uint64_t>(mesh->vertex_count);
+      writer.write<std::uint64_t>(mesh->triangle_count);
+      writer.write(mesh->vertices, 3 * mesh->vertex_count);
+      writer.write(mesh->triangles, 3 * mesh->triangle_count);
+      writer.write(mesh->triangle_normals, 3 * mesh->triangle_count);
+      writer.write(mesh->vertex_normals, 3 * mesh->vertex_count);
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+shapes::ShapePtr readBinaryMesh(moveit::core::BinaryReader& reader)
+{
+  std::uint64_t vertex_count, triangle_count;
+  if (!reader.read(vertex_count) || !reader.read(triangle_count) ||
+      vertex_count > std::numeric_limits<unsigned int>::max() / 3 ||
+      triangle_count > std::numeric_limits<unsigned int>::max() / 3)
+    return shapes::ShapePtr();
+  const double* vertices = reader.readArray<double>(3 * vertex_count);
+  const unsigned int* triangles = reader.readArray<unsigned int>(3 * triangle_count);
+  const double* triangle_normals = reader.readArray<double>(3 * triangle_count);
+  const double* vertex_normals = reader.readArray<double>(3 * vertex_count);
+  if (!vertices || !triangles || !triangle_normals || !vertex_normals)
+    return shapes::ShapePtr();
+  for (std::size_t i = 0; i < 3 * triangle_count; ++i)
+    if (triangles[i] >= vertex_count)
+      return shapes::ShapePtr();
+
+  auto mesh = std::make_shared<shapes::Mesh>(static_cast<unsigned int>(vertex_count),
+                                             static_cast<unsigned int>(triangle_count));
+  if (!mesh->triangle_normals)
+    mesh->triangle_normals = new double[3 * triangle_count];
+  if (!mesh->vertex_normals)
+    mesh->vertex_normals = new double[3 * vertex_count];
+  std::copy(vertices, vertices + 3 * vertex_count, mesh->vertices);
+  std::copy(triangles, triangles + 3 * triangle_count, mesh->triangles);
+  std::copy(triangle_normals, triangle_normals + 3 * triangle_count, mesh->triangle_normals);
+  std::copy(vertex_normals, vertex_normals + 3 * vertex_count, mesh->vertex_normals);
+  return mesh;
+}
+
+shapes::ShapePtr readBinaryShape(moveit::core::BinaryReader& reader)
+{
+  std::uint32_t type;
+  double parameters[4];
+  if (!reader.read(type))
+    return shapes::ShapePtr();
+  switch (type)
+  {
+    case shapes::SPHERE:
+      if (reader.read(parameters, 1))
+        return std::make_shared<shapes::Sphere>(parameters[0]);
+      break;
+    case shapes::BOX:
+      if (reader.read(parameters, 3))
+        return std::make_shared<shapes::Box>(parameters[0], parameters[1], parameters[2]);
+      break;
+    case shapes::CYLINDER:
+      if (reader.read(parameters, 2))
+        return std::make_shared<shapes::Cylinder>(parameters[0], parameters[1]);
+      break;
+    case shapes::CONE:
+      if (reader.read(parameters, 2))
+        return std::make_shared<shapes::Cone>(parameters[0], parameters[1]);
+      break;
+    case shapes::PLANE:
+      if (reader.read(parameters, 4))
+        return std::make_shared<shapes::Plane>(parameters[0], parameters[1], parameters[2], parameters[3]);
+      break;
+    case shapes::MESH:
+      return readBinaryMesh(reader);
+    default:
+      break;
+  }
+  return shapes::ShapePtr();
+}
+}  // namespace
+
 void PlanningScene::saveGeometryToStream(std::ostream& out) const
 {
   out << name_ << std::endl;
@@ -1072,6 +1238,147 @@ bool PlanningScene::loadGeometryFromStream(std::istream& in, const Eigen::Isomet
   } while (true);
 }
 
+bool PlanningScene::saveGeometryToBinary(std::ostream& out) const
+{
+  std::vector<collision_detection::CollisionEnv::ObjectConstPtr> objects;
+  for (const std::string& id : world_->getObjectIds())
+    if (id != OCTOMAP_NS)
+      if (collision_detection::CollisionEnv::ObjectConstPtr obj = world_->getObject(id))
+        objects.push_back(obj);
+
+  moveit::core::BinaryWriter writer(out);
+  writer.writeHeader(GEOMETRY_MAGIC, GEOMETRY_VERSION);
+  writer.writeString(name_);
+  writer.write<std::uint64_t>(objects.size());
+  for (const collision_detection::CollisionEnv::ObjectConstPtr& obj : objects)
+  {
+    writer.writeString(obj->id_);
+    float color[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    if (hasObjectColor(obj->id_))
+    {
+      const std_msgs::ColorRGBA& c = getObjectColor(obj->id_);
+      color[0] = c.r;
+      color[1] = c.g;
+      color[2] = c.b;
+      color[3] = c.a;
+    }
+    writer.write(color, 4);
+
+    const std::size_t shape_count =
+        std::count_if(obj->shapes_.begin(), obj->shapes_.end(),
+                      [](const shapes::ShapeConstPtr& shape) { return isBinaryShape(*shape); });
+    if (shape_count != obj->shapes_.size())
+      ROS_WARN_NAMED(LOGNAME, "Skipping shapes of unsupported types of object '%s'", obj->id_.c_str());
+    writer.write<std::uint64_t>(shape_count);
+    for (std::size_t j = 0; j < obj->shapes_.size(); ++j)
+      if (isBinaryShape(*obj->shapes_[j]))
+      {
+        // shape_poses_ is valid isometry by contract
+        const Eigen::Isometry3d& pose = obj->shape_poses_[j];
+        const Eigen::Quaterniond r(pose.linear());
+        const double values[] = { pose.translation().x(), pose.translation().y(), pose.translation().z(), r.x(), r.y(),
+                                  r.z(), r.w() };
+        writer.write(values, 7);
+        writeBinaryShape(writer, *obj->shapes_[j]);
+      }
+  }
+  return writer.good();
+}
+
+bool PlanningScene::saveGeometryToBinaryFile(const std::string& path) const
+{
+  std::ofstream out(path, std::ios::binary);
+  if (!saveGeometryToBinary(out))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Failed to write scene geometry to '%s'", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool PlanningScene::loadGeometryFromBinary(const void* data, std::size_t size)
+{
+  return loadGeometryFromBinary(data, size, Eigen::Isometry3d::Identity());  // Use no offset
+}
+
+bool PlanningScene::loadGeometryFromBinary(const void* data, std::size_t size, const Eigen::Isometry3d& offset)
+{
+  moveit::core::BinaryReader reader(data, size);
+  std::uint32_t version;
+  if (!reader.readHeader(GEOMETRY_MAGIC, GEOMETRY_VERSION, version))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Data is not in a supported version of the binary scene geometry format");
+    return false;
+  }
+  std::string name;
+  std::uint64_t object_count;
+  if (!reader.readString(name) || !reader.read(object_count))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Truncated binary scene geometry");
+    return false;
+  }
+  name_ = name;
+
+  std::vector<shapes::ShapeConstPtr> shapes;
+  EigenSTL::vector_Isometry3d poses;
+  for (std::size_t i = 0; i < object_count; ++i)
+  {
+    std::string id;
+    float color[4];
+    std::uint64_t shape_count;
+    if (!reader.readString(id) || !reader.read(color, 4) || !reader.read(shape_count))
+    {
+      ROS_ERROR_NAMED(LOGNAME, "Truncated binary scene geometry");
+      return false;
+    }
+
+    shapes.clear();
+    poses.clear();
+    for (std::size_t j = 0; j < shape_count; ++j)
+    {
+      double values[7];
+      shapes::ShapePtr shape;
+      if (!reader.read(values, 7) || !(shape = readBinaryShape(reader)))
+      {
+        ROS_ERROR_NAMED(LOGNAME, "Failed to load shape %zu of object '%s' from binary scene geometry", j, id.c_str());
+        return false;
+      }
+      shapes.push_back(shape);
+      // Transform pose by input pose offset
+      poses.push_back(offset * Eigen::Translation3d(values[0], values[1], values[2]) *
+                      Eigen::Quaterniond(values[6], values[3], values[4], values[5]));
+    }
+    world_->addToObject(id, shapes, poses);
+
+    if (color[0] > 0.0f || color[1] > 0.0f || color[2] > 0.0f || color[3] > 0.0f)
+    {
+      std_msgs::ColorRGBA c;
+      c.r = color[0];
+      c.g = color[1];
+      c.b = color[2];
+      c.a = color[3];
+      setObjectColor(id, c);
+    }
+  }
+  return true;
+}
+
+bool PlanningScene::loadGeometryFromBinaryFile(const std::string& path)
+{
+  return loadGeometryFromBinaryFile(path, Eigen::Isometry3d::Identity());  // Use no offset
+}
+
+bool PlanningScene::loadGeometryFromBinaryFile(const std::string& path, const Eigen::Isometry3d& offset)
+{
+  moveit::core::MappedFile file;
+  if (!file.open(path))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Failed to open scene geometry file '%s'", path.c_str());
+    return false;
+  }
+  return loadGeometryFromBinary(file.data(), file.size(), offset);
+}
+
 void PlanningScene::setCurrentState(const moveit_msgs::RobotState& state)
 {
   // The attached bodies will be processed separately by processAttachedCollisionObjectMsgs
@@ -2168,13 +2475,40 @@ bool PlanningScene::isPathValid(const robot_trajectory::RobotTrajectory& traject
   kinematic_constraints::KinematicConstraintSet ks_p(getRobotModel());
   ks_p.add(path_constraints, getTransforms());
   std::size_t n_wp = trajectory.getWayPointCount();
+
+  // only long paths are worth checking for collisions as one parallel batch up front
+  const bool batch = n_wp >= MIN_WAYPOINTS_FOR_BATCH_PATH_CHECK;
+  collision_detection::BatchCollisionResult batch_res;
+  if (batch)
+  {
+    std::vector<const moveit::core::RobotState*> waypoints(n_wp);
+    for (std::size_t i = 0; i < n_wp; ++i)
+      waypoints[i] = &trajectory.getWayPoint(i);
+    collision_detection::CollisionRequest creq;
+    creq.verbose = verbose;
+    creq.group_name = group;
+    collision_detection::BatchCollisionRequest batch_req;
+    batch_req.stop_at_first_collision = !invalid_index;
+    batch_req.min_states_per_thread = 64;
+    checkCollisionBatch(creq, batch_req, batch_res, waypoints, getAllowedCollisionMatrix());
+  }
+  auto colliding = batch_res.colliding_indices.cbegin();
+
   for (std::size_t i = 0; i < n_wp; ++i)
   {
     const moveit::core::RobotState& st = trajectory.getWayPoint(i);
 
     bool this_state_valid = true;
-    if (isStateColliding(st, group, verbose))
+    if (!batch)
+    {
+      if (isStateColliding(st, group, verbose))
+        this_state_valid = false;
+    }
+    else if (colliding != batch_res.colliding_indices.cend() && *colliding == i)
+    {
       this_state_valid = false;
+      ++colliding;
+    }
     if (!isStateFeasible(st, verbose))
       this_state_valid = false;
     if (!ks_p.empty() && !ks_p.decide(st, verbose).satisfied)
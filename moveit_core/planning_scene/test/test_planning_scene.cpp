@@ -212,6 +212,72 @@ TEST(PlanningScene, loadBadSceneGeometry)
   EXPECT_FALSE(ps->loadGeometryFromStream(malformed_scene_geometry));
 }
 
+TEST(PlanningScene, binarySceneGeometry)
+{
+  moveit::core::RobotModelPtr robot_model = moveit::core::loadTestingRobotModel("pr2");
+  auto ps = std::make_shared<planning_scene::PlanningScene>(robot_model->getURDF(), robot_model->getSRDF());
+  ps->setName("binary_scene");
+  auto mesh = std::make_shared<shapes::Mesh>(4, 4);
+  const double vertices[] = { 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+  const unsigned int triangles[] = { 0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3 };
+  std::copy(vertices, vertices + 12, mesh->vertices);
+  std::copy(triangles, triangles + 12, mesh->triangles);
+  mesh->computeTriangleNormals();
+  mesh->computeVertexNormals();
+  Eigen::Isometry3d pose = Eigen::Translation3d(1.0, 2.0, 3.0) * Eigen::AngleAxisd(0.5, Eigen::Vector3d::UnitZ());
+  collision_detection::WorldPtr world = ps->getWorldNonConst();
+  world->addToObject("box", std::make_shared<shapes::Box>(0.1, 0.2, 0.3), pose);
+  world->addToObject("box", std::make_shared<shapes::Cylinder>(0.4, 0.5), Eigen::Isometry3d::Identity());
+  world->addToObject("mesh", mesh, pose.inverse());
+  std_msgs::ColorRGBA color;
+  color.g = 1.0;
+  color.a = 0.5;
+  ps->setObjectColor("mesh", color);
+
+  std::stringstream out;
+  ASSERT_TRUE(ps->saveGeometryToBinary(out));
+  const std::string data = out.str();
+  std::vector<double> buffer(data.size() / sizeof(double) + 1);  // aligned to eight bytes
+  std::copy(data.begin(), data.end(), reinterpret_cast<char*>(buffer.data()));
+
+  auto loaded = std::make_shared<planning_scene::PlanningScene>(robot_model->getURDF(), robot_model->getSRDF());
+  ASSERT_TRUE(loaded->loadGeometryFromBinary(buffer.data(), data.size()));
+  EXPECT_EQ(loaded->getName(), "binary_scene");
+  for (const std::string& id : { "box", "mesh" })
+  {
+    collision_detection::World::ObjectConstPtr expected = ps->getWorld()->getObject(id);
+    collision_detection::World::ObjectConstPtr obj = loaded->getWorld()->getObject(id);
+    ASSERT_TRUE(obj) << id;
+    ASSERT_EQ(obj->shapes_.size(), expected->shapes_.size());
+    for (std::size_t i = 0; i < obj->shapes_.size(); ++i)
+    {
+      EXPECT_EQ(obj->shapes_[i]->type, expected->shapes_[i]->type);
+      EXPECT_TRUE(obj->shape_poses_[i].isApprox(expected->shape_poses_[i], 1e-12));
+    }
+  }
+  const collision_detection::World& loaded_world = *loaded->getWorld();
+  const shapes::Box& box = static_cast<const shapes::Box&>(*loaded_world.getObject("box")->shapes_[0]);
+  EXPECT_EQ(box.size[1], 0.2);
+  const shapes::Mesh& loaded_mesh = static_cast<const shapes::Mesh&>(*loaded_world.getObject("mesh")->shapes_[0]);
+  ASSERT_EQ(loaded_mesh.vertex_count, 4u);
+  ASSERT_EQ(loaded_mesh.triangle_count, 4u);
+  EXPECT_TRUE(std::equal(vertices, vertices + 12, loaded_mesh.vertices));
+  EXPECT_TRUE(std::equal(triangles, triangles + 12, loaded_mesh.triangles));
+  EXPECT_TRUE(std::equal(mesh->triangle_normals, mesh->triangle_normals + 12, loaded_mesh.triangle_normals));
+  EXPECT_FALSE(loaded->hasObjectColor("box"));
+  ASSERT_TRUE(loaded->hasObjectColor("mesh"));
+  EXPECT_EQ(loaded->getObjectColor("mesh").a, 0.5f);
+
+  // truncated data and other formats are rejected
+  auto empty = std::make_shared<planning_scene::PlanningScene>(robot_model->getURDF(), robot_model->getSRDF());
+  EXPECT_FALSE(empty->loadGeometryFromBinary(buffer.data(), data.size() - 8));
+  EXPECT_FALSE(empty->loadGeometryFromBinary(buffer.data(), 4));
+  std::stringstream text;
+  ps->saveGeometryToStream(text);
+  const std::string text_data = text.str();
+  EXPECT_FALSE(empty->loadGeometryFromBinary(text_data.data(), text_data.size()));
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
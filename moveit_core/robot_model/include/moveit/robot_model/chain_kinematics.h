@@ -0,0 +1,150 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <moveit/robot_model/joint_model_group.h>
+#include <Eigen/Geometry>
+#include <string>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+MOVEIT_CLASS_FORWARD(ChainKinematics);  // Defines ChainKinematicsPtr, ConstPtr, WeakPtr... etc
+
+/** \brief Forward kinematics and Jacobian of the serial chain of a JointModelGroup, specialized for a fixed tip link.
+
+    The chain from the parent link of the group's first joint (the base) to the tip is flattened when constructing
+    this class: fixed joints and joint origins are folded into one constant offset per moving joint, and the joint
+    types are resolved, so evaluating the chain needs neither virtual calls nor walking link and joint models.
+
+    For a robot model that does not change at runtime, generateSource() emits the same computation as C++ code with
+    all constants as literals and the rotations about coordinate axes specialized. Compiled into a plugin or
+    application, the generated function can be plugged in with setKernel(). Assigning the chain to its group with
+    JointModelGroup::setChainKinematics() makes RobotState::getJacobian() use it for the tip link. */
+class ChainKinematics
+{
+public:
+  /** \brief Signature of a generated kernel. For the variable values of the group, it writes the transform of the tip
+      relative to the base as a column-major 4x4 matrix and, unless \e jacobian is nullptr, the column-major 6xN
+      Jacobian of the tip origin in the base frame (linear velocity over angular velocity) */
+  typedef void (*KernelFn)(const double* values, double* transform, double* jacobian);
+
+  /** \brief Flatten the chain of \e group that ends in \e tip. Throws moveit::ConstructException if \e group is not a
+      chain, if \e tip is not updated by the group, or if the chain contains joints other than fixed, revolute and
+      prismatic ones, or moving joints outside the group. */
+  ChainKinematics(const JointModelGroup* group, const LinkModel* tip);
+
+  const JointModelGroup* getJointModelGroup() const
+  {
+    return group_;
+  }
+
+  /** \brief The parent link of the first joint of the group. All results are expressed in its frame. */
+  const LinkModel* getBaseLink() const
+  {
+    return base_;
+  }
+
+  const LinkModel* getTipLink() const
+  {
+    return tip_;
+  }
+
+  /** \brief Use a generated kernel instead of the built-in evaluation. Pass nullptr to revert. The kernel must have
+      been generated for the same group and tip of the same robot model. */
+  void setKernel(KernelFn kernel)
+  {
+    kernel_ = kernel;
+  }
+
+  KernelFn getKernel() const
+  {
+    return kernel_;
+  }
+
+  /** \brief Compute the transform of the tip in the base frame, for the variable values of the group */
+  void computeTransform(const double* values, Eigen::Isometry3d& transform) const;
+
+  /** \brief Compute the transform of the tip and the Jacobian of the point at \e reference_point_position (in the tip
+      frame), both in the base frame. The Jacobian has the same layout as the one of RobotState::getJacobian(). */
+  void computeJacobian(const double* values, const Eigen::Vector3d& reference_point_position,
+                       Eigen::Isometry3d& transform, Eigen::MatrixXd& jacobian) const;
+
+  /** \brief Generate self-contained C++ source defining a function \e function_name with the signature of KernelFn,
+      which computes the same results as this chain with all constants folded in */
+  std::string generateSource(const std::string& function_name) const;
+
+private:
+  /** \brief The kind of joint of a moving step; rotations about coordinate axes are specialized */
+  enum StepType
+  {
+    ROTATION_X,
+    ROTATION_Y,
+    ROTATION_Z,
+    ROTATION,
+    TRANSLATION
+  };
+
+  /** \brief One moving joint of the chain, with the constant transform in front of it */
+  struct Step
+  {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    Eigen::Isometry3d offset;
+    StepType type;
+    Eigen::Vector3d axis;
+    /** \brief Negate the variable, for rotations about negative coordinate axes */
+    bool negate;
+    /** \brief Index of the variable in the group, which is the column in the Jacobian */
+    int variable;
+    const JointModel* joint;
+  };
+
+  /** \brief Evaluate the chain, storing the world axis and origin of each step in \e axes and \e origins if given */
+  void evaluate(const double* values, Eigen::Isometry3d& transform, Eigen::Vector3d* axes,
+                Eigen::Vector3d* origins) const;
+
+  const JointModelGroup* group_;
+  const LinkModel* base_;
+  const LinkModel* tip_;
+  std::vector<Step, Eigen::aligned_allocator<Step>> steps_;
+  Eigen::Isometry3d tip_offset_;
+  KernelFn kernel_;
+};
+}  // namespace core
+}  // namespace moveit
@@ -40,6 +40,8 @@
 #include <moveit/robot_model/joint_model.h>
 #include <moveit/robot_model/link_model.h>
 #include <moveit/kinematics_base/kinematics_base.h>
+#include <moveit/macros/class_forward.h>
+#include <moveit/robot_model/name_hash_table.h>
 #include <srdfdom/model.h>
 #include <boost/function.hpp>
 #include <set>
@@ -50,6 +52,7 @@ namespace core
 {
 class RobotModel;
 class JointModelGroup;
+MOVEIT_CLASS_FORWARD(ChainKinematics);  // Defines ChainKinematicsPtr, ConstPtr, WeakPtr... etc
 
 /** \brief Function type that allocates a kinematics solver for a particular group */
 typedef boost::function<kinematics::KinematicsBasePtr(const JointModelGroup*)> SolverAllocatorFn;
@@ -404,6 +407,44 @@ public:
   double distance(const double* state1, const double* state2) const;
   void interpolate(const double* from, const double* to, double t, double* state) const;
 
+  /** \brief Batch variants of the functions above. A batch of \e count group states is laid out contiguously, one
+      state of getVariableCount() values after another. When all active joints are prismatic or bounded revolute
+      joints (see hasLinearActiveJoints()) these are evaluated as vectorized Eigen expressions over the whole batch;
+      otherwise they fall back to the per-state functions. */
+
+  /** \brief Compute the distance between each pair of states in \e states1 and \e states2 */
+  void distance(const double* states1, const double* states2, std::size_t count, double* distances) const;
+
+  /** \brief Compute the distance from \e state to each of the \e count states in \e states */
+  void distanceToStates(const double* state, const double* states, std::size_t count, double* distances) const;
+
+  /** \brief Interpolate each pair of states in \e from and \e to at the matching fraction in \e t.
+      On the vectorized path, mimic variables whose source joint is not part of the group are interpolated linearly. */
+  void interpolate(const double* from, const double* to, const double* t, std::size_t count, double* states) const;
+
+  /** \brief Enforce the bounds on every state in the batch. Return true if any state was changed */
+  bool enforcePositionBounds(double* states, std::size_t count) const
+  {
+    return enforcePositionBounds(states, count, active_joint_models_bounds_);
+  }
+  bool enforcePositionBounds(double* states, std::size_t count, const JointBoundsVector& active_joint_bounds) const;
+
+  /** \brief Check the bounds of every state in the batch. Return true if all states satisfy the bounds.
+      If \e satisfied is not null, the result for each state is stored there. */
+  bool satisfiesPositionBounds(const double* states, std::size_t count, bool* satisfied, double margin = 0.0) const
+  {
+    return satisfiesPositionBounds(states, count, satisfied, active_joint_models_bounds_, margin);
+  }
+  bool satisfiesPositionBounds(const double* states, std::size_t count, bool* satisfied,
+                               const JointBoundsVector& active_joint_bounds, double margin = 0.0) const;
+
+  /** \brief Check if all active joints are prismatic or bounded revolute joints, so that distance, interpolation and
+      bounds reduce to per-variable linear operations */
+  bool hasLinearActiveJoints() const
+  {
+    return linear_active_joints_;
+  }
+
   /** \brief Get the number of variables that describe this joint group. This includes variables necessary for mimic
       joints, so will always be >= the number of items returned by getActiveVariableNames() */
   unsigned int getVariableCount() const
@@ -552,6 +593,19 @@ public:
     return false;
   }
 
+  /** \brief Get the specialized forward kinematics of this chain group, if any */
+  const ChainKinematicsConstPtr& getChainKinematics() const
+  {
+    return chain_kinematics_;
+  }
+
+  /** \brief Set specialized forward kinematics for this chain group (e.g., with a generated kernel). RobotState uses
+      them when computing the Jacobian of their tip link. Pass an empty pointer to remove them. */
+  void setChainKinematics(const ChainKinematicsConstPtr& chain_kinematics)
+  {
+    chain_kinematics_ = chain_kinematics;
+  }
+
   /** \brief Get the default IK timeout */
   double getDefaultIKTimeout() const
   {
@@ -628,6 +682,9 @@ protected:
   /** \brief A map from joint names to their instances. This includes all joints in the group. */
   JointModelMapConst joint_model_map_;
 
+  /** \brief Indices of joints in joint_model_vector_, hashed by name for fast lookups */
+  NameHashTable joint_index_table_;
+
   /** \brief The list of active joint models that are roots in this group */
   std::vector<const JointModel*> joint_roots_;
 
@@ -639,6 +696,9 @@ protected:
       Additionaly, it includes the names of the joints and the index for the first variable of that joint. */
   VariableIndexMap joint_variables_index_map_;
 
+  /** \brief The entries of joint_variables_index_map_, hashed by name for fast lookups */
+  NameHashTable variable_index_table_;
+
   /** \brief The bounds for all the active joint models */
   JointBoundsVector active_joint_models_bounds_;
 
@@ -729,6 +789,12 @@ protected:
 
   bool is_single_dof_;
 
+  /** \brief True if all active joints are prismatic or bounded revolute joints */
+  bool linear_active_joints_;
+
+  /** \brief The distance factor of each group variable (zero for mimic variables) */
+  std::vector<double> variable_distance_factors_;
+
   struct GroupMimicUpdate
   {
     GroupMimicUpdate(int s, int d, double f, double o) : src(s), dest(d), factor(f), offset(o)
@@ -744,6 +810,9 @@ protected:
 
   std::pair<KinematicsSolver, KinematicsSolverMap> group_kinematics_;
 
+  /** \brief Specialized forward kinematics of the chain, if set */
+  ChainKinematicsConstPtr chain_kinematics_;
+
   srdf::Model::Group config_;
 
   /** \brief The set of default states specified for this group in the SRDF */
@@ -0,0 +1,110 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+/** \brief An open-addressing hash table from names to indices, for the fixed sets of names of a robot model.
+
+    Lookups hash the name once and probe a flat array of slots, comparing the stored hashes before comparing any
+    strings, so a successful lookup usually needs a single string comparison and an unsuccessful one usually none. */
+class NameHashTable
+{
+public:
+  NameHashTable();
+
+  /** \brief Map \e name to \e index (which must not be negative), replacing a previous index of the same name */
+  void insert(const std::string& name, int index);
+
+  /** \brief Get the index of \e name, or -1 if it is not in the table */
+  int find(const std::string& name) const
+  {
+    if (slots_.empty())
+      return -1;
+    const std::uint64_t hash = hashName(name);
+    for (std::size_t i = hash & mask_;; i = (i + 1) & mask_)
+    {
+      const Slot& slot = slots_[i];
+      if (slot.index < 0)
+        return -1;
+      if (slot.hash == hash && names_[slot.name] == name)
+        return slot.index;
+    }
+  }
+
+  /** \brief The number of names in the table */
+  std::size_t size() const
+  {
+    return names_.size();
+  }
+
+  /** \brief The 64-bit FNV-1a hash of a name, as used by the table */
+  static std::uint64_t hashName(const std::string& name)
+  {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const char c : name)
+    {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+private:
+  struct Slot
+  {
+    std::uint64_t hash;
+    /** \brief The mapped index, or -1 for empty slots */
+    int index;
+    /** \brief The position of the name in names_ */
+    int name;
+  };
+
+  /** \brief Re-insert all names into \e capacity slots, a power of two */
+  void rehash(std::size_t capacity);
+
+  std::vector<Slot> slots_;
+  std::size_t mask_;
+  std::vector<std::string> names_;
+  std::vector<int> indices_;
+};
+}  // namespace core
+}  // namespace moveit
@@ -50,6 +50,8 @@
 #include <moveit/robot_model/revolute_joint_model.h>
 #include <moveit/robot_model/prismatic_joint_model.h>
 
+#include <moveit/robot_model/name_hash_table.h>
+
 #include <Eigen/Geometry>
 #include <iostream>
 
@@ -438,6 +440,9 @@ public:
   /** \brief Get the index of a variable in the robot state */
   int getVariableIndex(const std::string& variable) const;
 
+  /** \brief Check if a variable (or a joint, whose first variable is meant) exists in the robot state */
+  bool hasVariable(const std::string& variable) const;
+
   /** \brief Get the deepest joint in the kinematic tree that is a common parent of both joints passed as argument */
   const JointModel* getCommonRoot(const JointModel* a, const JointModel* b) const
   {
@@ -483,6 +488,9 @@ protected:
   /** \brief A map from link names to their instances */
   LinkModelMap link_model_map_;
 
+  /** \brief Indices of links in link_model_vector_, hashed by name for fast lookups */
+  NameHashTable link_index_table_;
+
   /** \brief The vector of links that are updated when computeTransforms() is called, in the order they are updated */
   std::vector<LinkModel*> link_model_vector_;
 
@@ -509,6 +517,9 @@ protected:
   /** \brief A map from joint names to their instances */
   JointModelMap joint_model_map_;
 
+  /** \brief Indices of joints in joint_model_vector_, hashed by name for fast lookups */
+  NameHashTable joint_index_table_;
+
   /** \brief The vector of joints in the model, in the order they appear in the state vector */
   std::vector<JointModel*> joint_model_vector_;
 
@@ -560,6 +571,9 @@ protected:
       Additionaly, it includes the names of the joints and the index for the first variable of that joint. */
   VariableIndexMap joint_variables_index_map_;
 
+  /** \brief The entries of joint_variables_index_map_, hashed by name for fast lookups */
+  NameHashTable variable_index_table_;
+
   std::vector<int> active_joint_model_start_index_;
 
   /** \brief The bounds for all the active joint models */
@@ -0,0 +1,99 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_model/robot_model.h>
+#include <string>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+/** \brief The mapping of an ordered list of variable names, such as the names of a sensor_msgs::JointState message,
+    to the variables of a robot model.
+
+    The names are looked up once, when constructing the layout. Messages that keep their ordering, as most publishers
+    of joint states do, can then be converted by index: checking that a message still has the layout with matches()
+    compares the names for equality, without any lookup. */
+class VariableLayout
+{
+public:
+  /** \brief Resolve \e names, which may be variable names or names of joints with a single variable. Names the model
+      does not know are kept and map to no variable. */
+  VariableLayout(const RobotModel& model, const std::vector<std::string>& names);
+
+  /** \brief Check if \e names are the names of this layout, in the same order */
+  bool matches(const std::vector<std::string>& names) const
+  {
+    return names == names_;
+  }
+
+  const std::vector<std::string>& getNames() const
+  {
+    return names_;
+  }
+
+  std::size_t size() const
+  {
+    return names_.size();
+  }
+
+  /** \brief For each name, the index of its variable in the robot state, or -1 if the model does not know it */
+  const std::vector<int>& getVariableIndices() const
+  {
+    return variable_indices_;
+  }
+
+  /** \brief For each name, the joint of its variable, or nullptr if the model does not know it */
+  const std::vector<const JointModel*>& getJointModels() const
+  {
+    return joint_models_;
+  }
+
+  /** \brief Check if every name of the layout is known to the model */
+  bool isComplete() const
+  {
+    return unknown_count_ == 0;
+  }
+
+private:
+  std::vector<std::string> names_;
+  std::vector<int> variable_indices_;
+  std::vector<const JointModel*> joint_models_;
+  std::size_t unknown_count_;
+};
+}  // namespace core
+}  // namespace moveit
@@ -0,0 +1,411 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_model/chain_kinematics.h>
+#include <moveit/robot_model/prismatic_joint_model.h>
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <moveit/exceptions/exceptions.h>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+namespace moveit
+{
+namespace core
+{
+namespace
+{
+// coefficients below this are numerically negligible and dropped from generated code
+const double NEGLIGIBLE = 1e-15;
+
+std::string literal(double value)
+{
+  std::ostringstream ss;
+  ss << std::setprecision(17) << value;
+  std::string s = ss.str();
+  if (s.find_first_of(".e") == std::string::npos)
+    s += ".0";
+  return s;
+}
+
+// generate the expression sum_i coefficient_i * term_i, leaving out negligible terms
+std::string linearCombination(const std::vector<std::pair<double, std::string>>& terms)
+{
+  std::string result;
+  for (const std::pair<double, std::string>& term : terms)
+  {
+    if (std::abs(term.first) < NEGLIGIBLE)
+      continue;
+    const bool negative = term.first < 0.0;
+    std::string product = std::abs(std::abs(term.first) - 1.0) < NEGLIGIBLE ?
+                              term.second :
+                              literal(std::abs(term.first)) + " * " + term.second;
+    if (result.empty())
+      result = negative ? "-" + product : product;
+    else
+      result += (negative ? " - " : " + ") + product;
+  }
+  return result.empty() ? "0.0" : result;
+}
+
+std::string element(const char* array, int index)
+{
+  return std::string(array) + "[" + std::to_string(index) + "]";
+}
+
+// generate code for R = R * rotation and P = P + R * translation; R and P are column-major
+void generateOffset(std::ostream& out, const Eigen::Isometry3d& offset)
+{
+  if (!offset.translation().isZero(NEGLIGIBLE))
+    for (int row = 0; row < 3; ++row)
+    {
+      std::vector<std::pair<double, std::string>> terms;
+      for (int k = 0; k < 3; ++k)
+        terms.emplace_back(offset.translation()[k], element("R", 3 * k + row));
+      out << "  P[" << row << "] += " << linearCombination(terms) << ";\n";
+    }
+
+  if (!offset.linear().isIdentity(NEGLIGIBLE))
+  {
+    out << "  std::copy(R, R + 9, T);\n";
+    for (int col = 0; col < 3; ++col)
+      for (int row = 0; row < 3; ++row)
+      {
+        std::vector<std::pair<double, std::string>> terms;
+        for (int k = 0; k < 3; ++k)
+          terms.emplace_back(offset.linear()(k, col), element("T", 3 * k + row));
+        out << "  R[" << 3 * col + row << "] = " << linearCombination(terms) << ";\n";
+      }
+  }
+}
+
+// generate code that rotates columns a and b of R: a = c * a + s * b, b = c * b - s * a
+void generateAxisRotation(std::ostream& out, int a, int b)
+{
+  for (int row = 0; row < 3; ++row)
+  {
+    out << "  T[0] = R[" << 3 * a + row << "];\n";
+    out << "  R[" << 3 * a + row << "] = c * T[0] + s * R[" << 3 * b + row << "];\n";
+    out << "  R[" << 3 * b + row << "] = c * R[" << 3 * b + row << "] - s * T[0];\n";
+  }
+}
+}  // namespace
+
+ChainKinematics::ChainKinematics(const JointModelGroup* group, const LinkModel* tip)
+  : group_(group), tip_(tip), kernel_(nullptr)
+{
+  if (!group->isChain())
+    throw moveit::ConstructException("Group '" + group->getName() + "' is not a chain");
+  if (!group->isLinkUpdated(tip->getName()))
+    throw moveit::ConstructException("Link '" + tip->getName() + "' is not updated by group '" + group->getName() +
+                                     "'");
+
+  const JointModel* root_joint = group->getJointModels()[0];
+  base_ = root_joint->getParentLinkModel();
+
+  // the links from the first joint of the group to the tip
+  std::vector<const LinkModel*> links;
+  for (const LinkModel* link = tip; link; link = link->getParentLinkModel())
+  {
+    links.push_back(link);
+    if (link->getParentJointModel() == root_joint)
+      break;
+  }
+  std::reverse(links.begin(), links.end());
+
+  Eigen::Isometry3d offset = Eigen::Isometry3d::Identity();
+  for (const LinkModel* link : links)
+  {
+    offset = offset * link->getJointOriginTransform();
+    const JointModel* joint = link->getParentJointModel();
+    if (joint->getType() == JointModel::FIXED)
+      continue;
+    if (joint->getType() != JointModel::REVOLUTE && joint->getType() != JointModel::PRISMATIC)
+      throw moveit::ConstructException("Joint '" + joint->getName() + "' of group '" + group->getName() +
+                                       "' is neither fixed, revolute nor prismatic");
+    if (!group->hasJointModel(joint->getName()))
+      throw moveit::ConstructException("Joint '" + joint->getName() + "' is between the joints of group '" +
+                                       group->getName() + "', but not part of it");
+
+    Step step;
+    step.offset = offset;
+    step.joint = joint;
+    step.variable = group->getVariableGroupIndex(joint->getName());
+    step.negate = false;
+    if (joint->getType() == JointModel::PRISMATIC)
+    {
+      step.type = TRANSLATION;
+      step.axis = static_cast<const PrismaticJointModel*>(joint)->getAxis();
+    }
+    else
+    {
+      step.type = ROTATION;
+      step.axis = static_cast<const RevoluteJointModel*>(joint)->getAxis();
+      for (int i = 0; i < 3; ++i)
+        if (step.axis.isApprox(Eigen::Vector3d::Unit(i)) || step.axis.isApprox(-Eigen::Vector3d::Unit(i)))
+        {
+          step.type = static_cast<StepType>(ROTATION_X + i);
+          step.negate = step.axis[i] < 0.0;
+        }
+    }
+    steps_.push_back(step);
+    offset.setIdentity();
+  }
+  tip_offset_ = offset;
+}
+
+void ChainKinematics::evaluate(const double* values, Eigen::Isometry3d& transform, Eigen::Vector3d* axes,
+                               Eigen::Vector3d* origins) const
+{
+  transform.setIdentity();
+  for (std::size_t i = 0; i < steps_.size(); ++i)
+  {
+    const Step& step = steps_[i];
+    transform = transform * step.offset;
+    if (axes)
+    {
+      axes[i] = transform.linear() * step.axis;
+      origins[i] = transform.translation();
+    }
+
+    const double q = step.negate ? -values[step.variable] : values[step.variable];
+    auto rotation = transform.linear();
+    switch (step.type)
+    {
+      case ROTATION_X:
+      case ROTATION_Y:
+      case ROTATION_Z:
+      {
+        // rotating about coordinate axis i only changes the other two columns of the rotation
+        const double c = std::cos(q);
+        const double s = std::sin(q);
+        const int a = (step.type - ROTATION_X + 1) % 3;
+        const int b = (step.type - ROTATION_X + 2) % 3;
+        const Eigen::Vector3d col_a = rotation.col(a);
+        rotation.col(a) = c * col_a + s * rotation.col(b);
+        rotation.col(b) = c * rotation.col(b) - s * col_a;
+        break;
+      }
+      case ROTATION:
+        rotation = rotation * Eigen::AngleAxisd(q, step.axis).toRotationMatrix();
+        break;
+      case TRANSLATION:
+        transform.translation() += rotation * (step.axis * q);
+        break;
+    }
+  }
+  transform = transform * tip_offset_;
+}
+
+void ChainKinematics::computeTransform(const double* values, Eigen::Isometry3d& transform) const
+{
+  if (kernel_)
+  {
+    kernel_(values, transform.data(), nullptr);
+    transform.makeAffine();
+  }
+  else
+    evaluate(values, transform, nullptr, nullptr);
+}
+
+void ChainKinematics::computeJacobian(const double* values, const Eigen::Vector3d& reference_point_position,
+                                      Eigen::Isometry3d& transform, Eigen::MatrixXd& jacobian) const
+{
+  jacobian.setZero(6, group_->getVariableCount());
+  if (kernel_)
+  {
+    kernel_(values, transform.data(), jacobian.data());
+    transform.makeAffine();
+  }
+  else
+  {
+    std::vector<Eigen::Vector3d> axes(steps_.size());
+    std::vector<Eigen::Vector3d> origins(steps_.size());
+    evaluate(values, transform, axes.data(), origins.data());
+    for (std::size_t i = 0; i < steps_.size(); ++i)
+    {
+      auto column = jacobian.col(steps_[i].variable);
+      if (steps_[i].type == TRANSLATION)
+        column.head<3>() = axes[i];
+      else
+      {
+        column.head<3>() = axes[i].cross(transform.translation() - origins[i]);
+        column.tail<3>() = axes[i];
+      }
+    }
+  }
+
+  // move the reference point from the tip origin; for prismatic joints, the angular part is zero
+  if (!reference_point_position.isZero())
+  {
+    const Eigen::Vector3d offset = transform.linear() * reference_point_position;
+    for (Eigen::Index i = 0; i < jacobian.cols(); ++i)
+      jacobian.col(i).head<3>() += jacobian.col(i).tail<3>().cross(offset);
+  }
+}
+
+std::string ChainKinematics::generateSource(const std::string& function_name) const
+{
+  std::ostringstream out;
+  out << "// Forward kinematics and Jacobian of group '" << group_->getName() << "' from '"
+      << (base_ ? base_->getName() : std::string("model frame")) << "' to '" << tip_->getName() << "'\n";
+  out << "// Generated by moveit::core::ChainKinematics::generateSource(); do not edit.\n";
+  out << "// Plug in with moveit::core::ChainKinematics::setKernel(&" << function_name << ").\n\n";
+  out << "#include <algorithm>\n#include <cmath>\n\n";
+  out << "void " << function_name << "(const double* values, double* transform, double* jacobian)\n{\n";
+  out << "  // rotation (column-major) and translation of the current frame, and scratch space\n";
+  out << "  double R[9] = { 1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0 };\n";
+  out << "  double P[3] = { 0.0, 0.0, 0.0 };\n";
+  out << "  double T[9];\n";
+  out << "  double c, s;\n";
+  if (!steps_.empty())
+  {
+    out << "  // axis and origin of each joint, for the Jacobian\n";
+    out << "  double axes[" << steps_.size() << "][3];\n";
+    out << "  double origins[" << steps_.size() << "][3];\n";
+  }
+  out << "  (void)T;\n  (void)c;\n  (void)s;\n";
+
+  for (std::size_t i = 0; i < steps_.size(); ++i)
+  {
+    const Step& step = steps_[i];
+    out << "\n  // " << step.joint->getName() << "\n";
+    generateOffset(out, step.offset);
+
+    for (int row = 0; row < 3; ++row)
+    {
+      std::vector<std::pair<double, std::string>> terms;
+      for (int k = 0; k < 3; ++k)
+        terms.emplace_back(step.axis[k], element("R", 3 * k + row));
+      out << "  axes[" << i << "][" << row << "] = " << linearCombination(terms) << ";\n";
+      out << "  origins[" << i << "][" << row << "] = P[" << row << "];\n";
+    }
+
+    const std::string value = element("values", step.variable);
+    if (step.type == TRANSLATION)
+    {
+      for (int row = 0; row < 3; ++row)
+        out << "  P[" << row << "] += axes[" << i << "][" << row << "] * " << value << ";\n";
+      continue;
+    }
+
+    out << "  c = std::cos(" << value << ");\n";
+    out << "  s = " << (step.negate ? "-" : "") << "std::sin(" << value << ");\n";
+    switch (step.type)
+    {
+      case ROTATION_X:
+        generateAxisRotation(out, 1, 2);
+        break;
+      case ROTATION_Y:
+        generateAxisRotation(out, 2, 0);
+        break;
+      case ROTATION_Z:
+        generateAxisRotation(out, 0, 1);
+        break;
+      default:
+      {
+        // Rodrigues' formula with the constant axis folded in
+        const Eigen::Vector3d& a = step.axis;
+        out << "  {\n";
+        out << "    const double t = 1.0 - c;\n";
+        out << "    const double m[9] = {\n";
+        for (int col = 0; col < 3; ++col)
+          for (int row = 0; row < 3; ++row)
+          {
+            std::vector<std::pair<double, std::string>> terms;
+            terms.emplace_back(a[row] * a[col], "t");
+            if (row == col)
+              terms.emplace_back(1.0, "c");
+            else
+            {
+              // element (row, col) of the cross product matrix of the axis
+              const int k = 3 - row - col;
+              const double sign = ((col - row + 3) % 3 == 1) ? -1.0 : 1.0;
+              terms.emplace_back(sign * a[k], "s");
+            }
+            out << "      " << linearCombination(terms) << ",\n";
+          }
+        out << "    };\n";
+        out << "    std::copy(R, R + 9, T);\n";
+        out << "    for (int col = 0; col < 3; ++col)\n";
+        out << "      for (int row = 0; row < 3; ++row)\n";
+        out << "        R[3 * col + row] =\n";
+        out << "            T[row] * m[3 * col] + T[3 + row] * m[3 * col + 1] + T[6 + row] * m[3 * col + 2];\n";
+        out << "  }\n";
+        break;
+      }
+    }
+  }
+
+  out << "\n  // " << tip_->getName() << "\n";
+  generateOffset(out, tip_offset_);
+
+  out << "\n  for (int col = 0; col < 3; ++col)\n";
+  out << "  {\n";
+  out << "    std::copy(R + 3 * col, R + 3 * col + 3, transform + 4 * col);\n";
+  out << "    transform[4 * col + 3] = 0.0;\n";
+  out << "  }\n";
+  out << "  std::copy(P, P + 3, transform + 12);\n";
+  out << "  transform[15] = 1.0;\n";
+
+  out << "\n  if (!jacobian)\n    return;\n";
+  out << "  std::fill(jacobian, jacobian + " << 6 * group_->getVariableCount() << ", 0.0);\n";
+  for (std::size_t i = 0; i < steps_.size(); ++i)
+  {
+    const Step& step = steps_[i];
+    const std::string column = "jacobian + " + std::to_string(6 * step.variable);
+    const std::string axis = "axes[" + std::to_string(i) + "]";
+    if (step.type == TRANSLATION)
+    {
+      out << "  std::copy(" << axis << ", " << axis << " + 3, " << column << ");\n";
+      continue;
+    }
+    out << "  {\n";
+    out << "    double* J = " << column << ";\n";
+    out << "    const double* a = " << axis << ";\n";
+    out << "    const double d[3] = { P[0] - origins[" << i << "][0], P[1] - origins[" << i << "][1], P[2] - origins["
+        << i << "][2] };\n";
+    out << "    J[0] = a[1] * d[2] - a[2] * d[1];\n";
+    out << "    J[1] = a[2] * d[0] - a[0] * d[2];\n";
+    out << "    J[2] = a[0] * d[1] - a[1] * d[0];\n";
+    out << "    std::copy(a, a + 3, J + 3);\n";
+    out << "  }\n";
+  }
+  out << "}\n";
+  return out.str();
+}
+}  // namespace core
+}  // namespace moveit
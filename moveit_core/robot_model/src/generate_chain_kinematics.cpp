@@ -0,0 +1,93 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_model/chain_kinematics.h>
+#include <moveit/exceptions/exceptions.h>
+#include <urdf_parser/urdf_parser.h>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+// Generate specialized forward kinematics of a chain group as C++ source, see moveit::core::ChainKinematics
+int main(int argc, char** argv)
+{
+  if (argc < 6 || argc > 7)
+  {
+    fprintf(stderr, "Usage: %s URDF SRDF GROUP TIP_LINK FUNCTION_NAME [OUTPUT_FILE]\n", argv[0]);
+    return 1;
+  }
+
+  urdf::ModelInterfaceSharedPtr urdf_model = urdf::parseURDFFile(argv[1]);
+  if (!urdf_model)
+  {
+    fprintf(stderr, "Failed to parse URDF '%s'\n", argv[1]);
+    return 1;
+  }
+  auto srdf_model = std::make_shared<srdf::Model>();
+  if (!srdf_model->initFile(*urdf_model, argv[2]))
+  {
+    fprintf(stderr, "Failed to parse SRDF '%s'\n", argv[2]);
+    return 1;
+  }
+  moveit::core::RobotModel robot_model(urdf_model, srdf_model);
+
+  const moveit::core::JointModelGroup* group = robot_model.getJointModelGroup(argv[3]);
+  const moveit::core::LinkModel* tip = robot_model.getLinkModel(argv[4]);
+  if (!group || !tip)
+  {
+    fprintf(stderr, "Unknown group '%s' or link '%s'\n", argv[3], argv[4]);
+    return 1;
+  }
+
+  std::string source;
+  try
+  {
+    source = moveit::core::ChainKinematics(group, tip).generateSource(argv[5]);
+  }
+  catch (moveit::ConstructException& e)
+  {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  if (argc == 6)
+  {
+    std::cout << source;
+    return 0;
+  }
+  std::ofstream out(argv[6]);
+  out << source;
+  return out ? 0 : 1;
+}
@@ -41,6 +41,7 @@
 #include <moveit/exceptions/exceptions.h>
 #include <boost/lexical_cast.hpp>
 #include <algorithm>
+#include <limits>
 #include "order_robot_model_items.inc"
 
 namespace moveit
@@ -109,6 +110,7 @@ JointModelGroup::JointModelGroup(const std::string& group_name, const srdf::Mode
   , is_contiguous_index_list_(true)
   , is_chain_(false)
   , is_single_dof_(true)
+  , linear_active_joints_(true)
   , config_(config)
 {
   // sort joints in Depth-First order
@@ -122,6 +124,7 @@ JointModelGroup::JointModelGroup(const std::string& group_name, const srdf::Mode
   {
     joint_model_name_vector_.push_back(joint_model->getName());
     joint_model_map_[joint_model->getName()] = joint_model;
+    joint_index_table_.insert(joint_model->getName(), joint_model_name_vector_.size() - 1);
     unsigned int vc = joint_model->getVariableCount();
     if (vc > 0)
     {
@@ -135,9 +138,17 @@ JointModelGroup::JointModelGroup(const std::string& group_name, const srdf::Mode
         active_joint_model_start_index_.push_back(variable_count_);
         active_joint_models_bounds_.push_back(&joint_model->getVariableBounds());
         active_variable_count_ += vc;
+        if (joint_model->getType() != JointModel::PRISMATIC &&
+            (joint_model->getType() != JointModel::REVOLUTE ||
+             static_cast<const RevoluteJointModel*>(joint_model)->isContinuous()))
+          linear_active_joints_ = false;
+        variable_distance_factors_.insert(variable_distance_factors_.end(), vc, joint_model->getDistanceFactor());
       }
       else
+      {
         mimic_joints_.push_back(joint_model);
+        variable_distance_factors_.insert(variable_distance_factors_.end(), vc, 0.0);
+      }
       for (const std::string& name : name_order)
       {
         variable_names_.push_back(name);
@@ -149,8 +160,10 @@ JointModelGroup::JointModelGroup(const std::string& group_name, const srdf::Mode
       {
         variable_index_list_.push_back(first_index + j);
         joint_variables_index_map_[name_order[j]] = variable_count_ + j;
+        variable_index_table_.insert(name_order[j], variable_count_ + j);
       }
       joint_variables_index_map_[joint_model->getName()] = variable_count_;
+      variable_index_table_.insert(joint_model->getName(), variable_count_);
 
       if (joint_model->getType() == JointModel::REVOLUTE &&
           static_cast<const RevoluteJointModel*>(joint_model)->isContinuous())
@@ -282,7 +295,7 @@ void JointModelGroup::getSubgroups(std::vector<const JointModelGroup*>& sub_grou
 
 bool JointModelGroup::hasJointModel(const std::string& joint) const
 {
-  return joint_model_map_.find(joint) != joint_model_map_.end();
+  return joint_index_table_.find(joint) >= 0;
 }
 
 bool JointModelGroup::hasLinkModel(const std::string& link) const
@@ -303,13 +316,13 @@ const LinkModel* JointModelGroup::getLinkModel(const std::string& name) const
 
 const JointModel* JointModelGroup::getJointModel(const std::string& name) const
 {
-  JointModelMapConst::const_iterator it = joint_model_map_.find(name);
-  if (it == joint_model_map_.end())
+  const int index = joint_index_table_.find(name);
+  if (index < 0)
   {
     ROS_ERROR_NAMED(LOGNAME, "Joint '%s' not found in group '%s'", name.c_str(), name_.c_str());
     return nullptr;
   }
-  return it->second;
+  return joint_model_vector_[index];
 }
 
 void JointModelGroup::getVariableRandomPositions(random_numbers::RandomNumberGenerator& rng, double* values,
@@ -430,6 +443,135 @@ void JointModelGroup::interpolate(const double* from, const double* to, double t
   updateMimicJoints(state);
 }
 
+void JointModelGroup::distance(const double* states1, const double* states2, std::size_t count,
+                               double* distances) const
+{
+  if (!linear_active_joints_)
+  {
+    for (std::size_t k = 0; k < count; ++k)
+      distances[k] = distance(states1 + k * variable_count_, states2 + k * variable_count_);
+    return;
+  }
+  Eigen::Map<const Eigen::ArrayXXd> a(states1, variable_count_, count);
+  Eigen::Map<const Eigen::ArrayXXd> b(states2, variable_count_, count);
+  Eigen::Map<const Eigen::ArrayXd> factors(variable_distance_factors_.data(), variable_count_);
+  Eigen::Map<Eigen::ArrayXd>(distances, count) = ((a - b).abs().colwise() * factors).colwise().sum().transpose();
+}
+
+void JointModelGroup::distanceToStates(const double* state, const double* states, std::size_t count,
+                                       double* distances) const
+{
+  if (!linear_active_joints_)
+  {
+    for (std::size_t k = 0; k < count; ++k)
+      distances[k] = distance(state, states + k * variable_count_);
+    return;
+  }
+  Eigen::Map<const Eigen::ArrayXd> a(state, variable_count_);
+  Eigen::Map<const Eigen::ArrayXXd> b(states, variable_count_, count);
+  Eigen::Map<const Eigen::ArrayXd> factors(variable_distance_factors_.data(), variable_count_);
+  Eigen::Map<Eigen::ArrayXd>(distances, count) =
+      ((b.colwise() - a).abs().colwise() * factors).colwise().sum().transpose();
+}
+
+void JointModelGroup::interpolate(const double* from, const double* to, const double* t, std::size_t count,
+                                  double* states) const
+{
+  if (!linear_active_joints_)
+  {
+    for (std::size_t k = 0; k < count; ++k)
+      interpolate(from + k * variable_count_, to + k * variable_count_, t[k], states + k * variable_count_);
+    return;
+  }
+  Eigen::Map<const Eigen::ArrayXXd> f(from, variable_count_, count);
+  Eigen::Map<const Eigen::ArrayXXd> g(to, variable_count_, count);
+  Eigen::Map<const Eigen::ArrayXd> fractions(t, count);
+  Eigen::Map<Eigen::ArrayXXd>(states, variable_count_, count) = f + (g - f).rowwise() * fractions.transpose();
+  if (!group_mimic_update_.empty())
+    for (std::size_t k = 0; k < count; ++k)
+      updateMimicJoints(states + k * variable_count_);
+}
+
+namespace
+{
+// gather the position bounds of the group variables; mimic variables are left unbounded
+void getVariablePositionBounds(const std::vector<const JointModel*>& active_joints,
+                               const std::vector<int>& active_start_index,
+                               const JointModelGroup::JointBoundsVector& active_joint_bounds,
+                               unsigned int variable_count, Eigen::ArrayXd& min_position,
+                               Eigen::ArrayXd& max_position)
+{
+  min_position.setConstant(variable_count, -std::numeric_limits<double>::infinity());
+  max_position.setConstant(variable_count, std::numeric_limits<double>::infinity());
+  for (std::size_t i = 0; i < active_joints.size(); ++i)
+    for (std::size_t j = 0; j < active_joint_bounds[i]->size(); ++j)
+    {
+      min_position[active_start_index[i] + j] = (*active_joint_bounds[i])[j].min_position_;
+      max_position[active_start_index[i] + j] = (*active_joint_bounds[i])[j].max_position_;
+    }
+}
+}  // namespace
+
+bool JointModelGroup::satisfiesPositionBounds(const double* states, std::size_t count, bool* satisfied,
+                                              const JointBoundsVector& active_joint_bounds, double margin) const
+{
+  assert(active_joint_bounds.size() == active_joint_model_vector_.size());
+  bool all = true;
+  if (!linear_active_joints_)
+  {
+    for (std::size_t k = 0; k < count; ++k)
+    {
+      bool ok = satisfiesPositionBounds(states + k * variable_count_, active_joint_bounds, margin);
+      if (satisfied)
+        satisfied[k] = ok;
+      all = all && ok;
+    }
+    return all;
+  }
+
+  Eigen::ArrayXd min_position, max_position;
+  getVariablePositionBounds(active_joint_model_vector_, active_joint_model_start_index_, active_joint_bounds,
+                            variable_count_, min_position, max_position);
+  min_position -= margin;
+  max_position += margin;
+  Eigen::Map<const Eigen::ArrayXXd> x(states, variable_count_, count);
+  // same comparison as the per-joint check, so that NaN values are treated alike
+  Eigen::Array<bool, 1, Eigen::Dynamic> ok =
+      !((x < min_position.replicate(1, count)) || (x > max_position.replicate(1, count))).colwise().any();
+  if (satisfied)
+    Eigen::Map<Eigen::Array<bool, 1, Eigen::Dynamic>>(satisfied, count) = ok;
+  return ok.all();
+}
+
+bool JointModelGroup::enforcePositionBounds(double* states, std::size_t count,
+                                            const JointBoundsVector& active_joint_bounds) const
+{
+  assert(active_joint_bounds.size() == active_joint_model_vector_.size());
+  bool change = false;
+  if (!linear_active_joints_)
+  {
+    for (std::size_t k = 0; k < count; ++k)
+      if (enforcePositionBounds(states + k * variable_count_, active_joint_bounds))
+        change = true;
+    return change;
+  }
+
+  Eigen::ArrayXd min_position, max_position;
+  getVariablePositionBounds(active_joint_model_vector_, active_joint_model_start_index_, active_joint_bounds,
+                            variable_count_, min_position, max_position);
+  Eigen::Map<Eigen::ArrayXXd> x(states, variable_count_, count);
+  Eigen::Array<bool, 1, Eigen::Dynamic> outside =
+      ((x < min_position.replicate(1, count)) || (x > max_position.replicate(1, count))).colwise().any();
+  if (!outside.any())
+    return false;
+  x = x.max(min_position.replicate(1, count)).min(max_position.replicate(1, count));
+  if (!group_mimic_update_.empty())
+    for (std::size_t k = 0; k < count; ++k)
+      if (outside[k])
+        updateMimicJoints(states + k * variable_count_);
+  return true;
+}
+
 void JointModelGroup::updateMimicJoints(double* values) const
 {
   // update mimic (only local joints as we are dealing with a local group state)
@@ -540,13 +682,10 @@ const LinkModel* JointModelGroup::getOnlyOneEndEffectorTip() const
 
 int JointModelGroup::getVariableGroupIndex(const std::string& variable) const
 {
-  VariableIndexMap::const_iterator it = joint_variables_index_map_.find(variable);
-  if (it == joint_variables_index_map_.end())
-  {
+  const int index = variable_index_table_.find(variable);
+  if (index < 0)
     ROS_ERROR_NAMED(LOGNAME, "Variable '%s' is not part of group '%s'", variable.c_str(), name_.c_str());
-    return -1;
-  }
-  return it->second;
+  return index;
 }
 
 void JointModelGroup::setDefaultIKTimeout(double ik_timeout)
@@ -0,0 +1,81 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_model/name_hash_table.h>
+#include <algorithm>
+
+namespace moveit
+{
+namespace core
+{
+NameHashTable::NameHashTable() : mask_(0)
+{
+}
+
+void NameHashTable::insert(const std::string& name, int index)
+{
+  // keep the table at most half full, so probe sequences stay short
+  if (2 * (names_.size() + 1) > slots_.size())
+    rehash(std::max<std::size_t>(16, 2 * slots_.size()));
+
+  const std::uint64_t hash = hashName(name);
+  std::size_t i = hash & mask_;
+  for (; slots_[i].index >= 0; i = (i + 1) & mask_)
+    if (slots_[i].hash == hash && names_[slots_[i].name] == name)
+    {
+      slots_[i].index = index;
+      indices_[slots_[i].name] = index;
+      return;
+    }
+
+  slots_[i] = Slot{ hash, index, static_cast<int>(names_.size()) };
+  names_.push_back(name);
+  indices_.push_back(index);
+}
+
+void NameHashTable::rehash(std::size_t capacity)
+{
+  slots_.assign(capacity, Slot{ 0, -1, -1 });
+  mask_ = capacity - 1;
+  for (std::size_t n = 0; n < names_.size(); ++n)
+  {
+    const std::uint64_t hash = hashName(names_[n]);
+    std::size_t i = hash & mask_;
+    while (slots_[i].index >= 0)
+      i = (i + 1) & mask_;
+    slots_[i] = Slot{ hash, indices_[n], static_cast<int>(n) };
+  }
+}
+}  // namespace core
+}  // namespace moveit
@@ -294,6 +294,14 @@ void RobotModel::buildJointInfo()
     }
   }
 
+  // hash tables for lookups by name
+  for (const JointModel* joint : joint_model_vector_)
+    joint_index_table_.insert(joint->getName(), joint->getJointIndex());
+  for (const LinkModel* link : link_model_vector_)
+    link_index_table_.insert(link->getName(), link->getLinkIndex());
+  for (const std::pair<const std::string, int>& variable : joint_variables_index_map_)
+    variable_index_table_.insert(variable.first, variable.second);
+
   std::vector<bool> link_considered(link_model_vector_.size(), false);
   for (const LinkModel* link : link_model_vector_)
   {
@@ -1099,19 +1107,19 @@ shapes::ShapePtr RobotModel::constructShape(const urdf::Geometry* geom)
 
 bool RobotModel::hasJointModel(const std::string& name) const
 {
-  return joint_model_map_.find(name) != joint_model_map_.end();
+  return joint_index_table_.find(name) >= 0;
 }
 
 bool RobotModel::hasLinkModel(const std::string& name) const
 {
-  return link_model_map_.find(name) != link_model_map_.end();
+  return link_index_table_.find(name) >= 0;
 }
 
 const JointModel* RobotModel::getJointModel(const std::string& name) const
 {
-  JointModelMap::const_iterator it = joint_model_map_.find(name);
-  if (it != joint_model_map_.end())
-    return it->second;
+  const int index = joint_index_table_.find(name);
+  if (index >= 0)
+    return joint_model_vector_[index];
   ROS_ERROR_NAMED(LOGNAME, "Joint '%s' not found in model '%s'", name.c_str(), model_name_.c_str());
   return nullptr;
 }
@@ -1129,9 +1137,9 @@ const JointModel* RobotModel::getJointModel(int index) const
 
 JointModel* RobotModel::getJointModel(const std::string& name)
 {
-  JointModelMap::const_iterator it = joint_model_map_.find(name);
-  if (it != joint_model_map_.end())
-    return it->second;
+  const int index = joint_index_table_.find(name);
+  if (index >= 0)
+    return joint_model_vector_[index];
   ROS_ERROR_NAMED(LOGNAME, "Joint '%s' not found in model '%s'", name.c_str(), model_name_.c_str());
   return nullptr;
 }
@@ -1156,9 +1164,9 @@ LinkModel* RobotModel::getLinkModel(const std::string& name, bool* has_link)
 {
   if (has_link)
     *has_link = true;  // Start out optimistic
-  LinkModelMap::const_iterator it = link_model_map_.find(name);
-  if (it != link_model_map_.end())
-    return it->second;
+  const int index = link_index_table_.find(name);
+  if (index >= 0)
+    return link_model_vector_[index];
 
   if (has_link)
     *has_link = false;  // Report failure via argument
@@ -1237,12 +1245,17 @@ void RobotModel::getMissingVariableNames(const std::vector<std::string>& variabl
         missing_variables.push_back(variable_name);
 }
 
+bool RobotModel::hasVariable(const std::string& variable) const
+{
+  return variable_index_table_.find(variable) >= 0;
+}
+
 int RobotModel::getVariableIndex(const std::string& variable) const
 {
-  VariableIndexMap::const_iterator it = joint_variables_index_map_.find(variable);
-  if (it == joint_variables_index_map_.end())
+  const int index = variable_index_table_.find(variable);
+  if (index < 0)
     throw Exception("Variable '" + variable + "' is not known to model '" + model_name_ + "'");
-  return it->second;
+  return index;
 }
 
 double RobotModel::getMaximumExtent(const JointBoundsVector& active_joint_bounds) const
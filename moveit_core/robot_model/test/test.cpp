@@ -35,6 +35,7 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_model/variable_layout.h>
 #include <urdf_parser/urdf_parser.h>
 #include <fstream>
 #include <gtest/gtest.h>
@@ -82,6 +83,140 @@ TEST_F(LoadPlanningModelsPr2, Model)
   moveit::tools::Profiler::Status();
 }
 
+TEST_F(LoadPlanningModelsPr2, NameLookup)
+{
+  for (const moveit::core::LinkModel* link : robot_model_->getLinkModels())
+  {
+    ASSERT_TRUE(robot_model_->hasLinkModel(link->getName()));
+    ASSERT_EQ(robot_model_->getLinkModel(link->getName()), link);
+  }
+  const std::vector<std::string>& variables = robot_model_->getVariableNames();
+  for (std::size_t i = 0; i < variables.size(); ++i)
+  {
+    ASSERT_TRUE(robot_model_->hasVariable(variables[i]));
+    ASSERT_EQ(robot_model_->getVariableIndex(variables[i]), static_cast<int>(i));
+  }
+  for (const moveit::core::JointModelGroup* group : robot_model_->getJointModelGroups())
+  {
+    const std::vector<std::string>& group_variables = group->getVariableNames();
+    for (std::size_t i = 0; i < group_variables.size(); ++i)
+      ASSERT_EQ(group->getVariableGroupIndex(group_variables[i]), static_cast<int>(i));
+    for (const moveit::core::JointModel* joint : group->getJointModels())
+      ASSERT_EQ(group->getJointModel(joint->getName()), joint);
+  }
+
+  EXPECT_FALSE(robot_model_->hasJointModel("no_such_joint"));
+  EXPECT_FALSE(robot_model_->hasLinkModel("no_such_link"));
+  EXPECT_FALSE(robot_model_->hasVariable("no_such_variable"));
+  EXPECT_THROW(robot_model_->getVariableIndex("no_such_variable"), moveit::Exception);
+}
+
+TEST(NameHashTable, InsertAndFind)
+{
+  moveit::core::NameHashTable table;
+  EXPECT_EQ(table.find("a"), -1);
+  for (int i = 0; i < 100; ++i)
+    table.insert("name_" + std::to_string(i), i);
+  table.insert("name_7", 1000);
+  EXPECT_EQ(table.size(), 100u);
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(table.find("name_" + std::to_string(i)), i == 7 ? 1000 : i);
+  EXPECT_EQ(table.find("name_100"), -1);
+  EXPECT_EQ(table.find(""), -1);
+}
+
+TEST_F(LoadPlanningModelsPr2, VariableLayout)
+{
+  const std::vector<std::string> names = { "r_elbow_flex_joint", "unknown_joint", "torso_lift_joint" };
+  moveit::core::VariableLayout layout(*robot_model_, names);
+  EXPECT_TRUE(layout.matches(names));
+  EXPECT_FALSE(layout.matches({ "torso_lift_joint", "unknown_joint", "r_elbow_flex_joint" }));
+  EXPECT_FALSE(layout.isComplete());
+  ASSERT_EQ(layout.size(), 3u);
+  EXPECT_EQ(layout.getVariableIndices()[0], robot_model_->getVariableIndex("r_elbow_flex_joint"));
+  EXPECT_EQ(layout.getVariableIndices()[1], -1);
+  EXPECT_EQ(layout.getJointModels()[1], nullptr);
+  EXPECT_EQ(layout.getJointModels()[2], robot_model_->getJointModel("torso_lift_joint"));
+}
+
+namespace
+{
+// compare the batch functions of a group against the single-state ones
+void checkGroupBatchFunctions(const moveit::core::JointModelGroup* group)
+{
+  SCOPED_TRACE(group->getName());
+  const std::size_t n = group->getVariableCount();
+  const std::size_t count = 50;
+  random_numbers::RandomNumberGenerator rng(42);
+  std::vector<double> states1(n * count), states2(n * count), fractions(count);
+  for (std::size_t k = 0; k < count; ++k)
+  {
+    group->getVariableRandomPositions(rng, &states1[k * n]);
+    group->getVariableRandomPositions(rng, &states2[k * n]);
+    fractions[k] = rng.uniform01();
+    // push some states outside of the bounds
+    if (k % 3 == 0)
+      for (std::size_t i = 0; i < n; ++i)
+        states2[k * n + i] *= 1.5;
+  }
+
+  std::vector<double> distances(count), distances_to(count);
+  group->distance(states1.data(), states2.data(), count, distances.data());
+  group->distanceToStates(states1.data(), states2.data(), count, distances_to.data());
+  for (std::size_t k = 0; k < count; ++k)
+  {
+    EXPECT_NEAR(distances[k], group->distance(&states1[k * n], &states2[k * n]), 1e-9);
+    EXPECT_NEAR(distances_to[k], group->distance(&states1[0], &states2[k * n]), 1e-9);
+  }
+
+  std::vector<double> interpolated(n * count), expected(n * count);
+  group->interpolate(states1.data(), states1.data() + n, fractions.data(), count - 1, interpolated.data());
+  for (std::size_t k = 0; k + 1 < count; ++k)
+  {
+    group->interpolate(&states1[k * n], &states1[(k + 1) * n], fractions[k], &expected[k * n]);
+    for (std::size_t i = 0; i < n; ++i)
+      EXPECT_NEAR(interpolated[k * n + i], expected[k * n + i], 1e-9);
+  }
+
+  std::unique_ptr<bool[]> satisfied(new bool[count]);
+  EXPECT_TRUE(group->satisfiesPositionBounds(states1.data(), count, nullptr));
+  bool all = group->satisfiesPositionBounds(states2.data(), count, satisfied.get());
+  bool expected_all = true;
+  for (std::size_t k = 0; k < count; ++k)
+  {
+    EXPECT_EQ(satisfied[k], group->satisfiesPositionBounds(&states2[k * n]));
+    expected_all = expected_all && satisfied[k];
+  }
+  EXPECT_EQ(all, expected_all);
+
+  expected = states2;
+  bool changed = group->enforcePositionBounds(states2.data(), count);
+  bool expected_changed = false;
+  for (std::size_t k = 0; k < count; ++k)
+    if (group->enforcePositionBounds(&expected[k * n]))
+      expected_changed = true;
+  EXPECT_EQ(changed, expected_changed);
+  for (std::size_t i = 0; i < n * count; ++i)
+    EXPECT_NEAR(states2[i], expected[i], 1e-9);
+  EXPECT_TRUE(group->satisfiesPositionBounds(states2.data(), count, nullptr));
+}
+}  // namespace
+
+TEST_F(LoadPlanningModelsPr2, GroupBatchFunctions)
+{
+  // the arm has continuous joints, so the per-state fallback is used
+  const moveit::core::JointModelGroup* arm = robot_model_->getJointModelGroup("right_arm");
+  EXPECT_FALSE(arm->hasLinearActiveJoints());
+  checkGroupBatchFunctions(arm);
+
+  moveit::core::RobotModelConstPtr panda = moveit::core::loadTestingRobotModel("panda");
+  const moveit::core::JointModelGroup* panda_arm = panda->getJointModelGroup("panda_arm");
+  EXPECT_TRUE(panda_arm->hasLinearActiveJoints());
+  checkGroupBatchFunctions(panda_arm);
+  // the hand has a mimic finger joint
+  checkGroupBatchFunctions(panda->getJointModelGroup("hand"));
+}
+
 TEST(SiblingAssociateLinks, SimpleYRobot)
 {
   /* base_link - a - b - c
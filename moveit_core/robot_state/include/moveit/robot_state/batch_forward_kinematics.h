@@ -0,0 +1,167 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_state/robot_state.h>
+#include <eigen_stl_containers/eigen_stl_containers.h>
+#include <Eigen/Core>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+MOVEIT_CLASS_FORWARD(BatchForwardKinematics);  // Defines BatchForwardKinematicsPtr, ConstPtr, WeakPtr... etc
+
+/** \brief Computes forward kinematics for many configurations of a robot at once.
+
+    RobotState::update() walks the kinematic tree once per configuration. This class walks it once for a whole
+    batch: the positions of all configurations are stored as one column per variable, and the link transforms as
+    twelve columns per link (the 3x4 affine part in column-major order), so every step along the tree is an array
+    operation across all configurations that the compiler can vectorize.
+
+    The variables not covered by the batch (those outside the group, if one is specified) and the transforms of
+    links that do not depend on the batch are taken from a reference state. Mimic joints follow their source
+    variable, as after RobotState::updateMimicJoints(). Attached bodies are not considered.
+
+    An instance keeps its buffers between calls to compute(), so it should not be shared between threads. */
+class BatchForwardKinematics
+{
+public:
+  /** \brief Prepare forward kinematics for the variables of \e group, or for all variables of the robot if \e group
+      is nullptr. All other variables are fixed to their values in \e reference. */
+  BatchForwardKinematics(const RobotState& reference, const JointModelGroup* group = nullptr);
+
+  /** \brief The number of variables of a configuration, i.e. the number of columns compute() expects. These are the
+      variables of the group in the order of JointModelGroup::getVariableIndexList(), or all variables of the robot. */
+  std::size_t getVariableCount() const
+  {
+    return variable_count_;
+  }
+
+  /** \brief The links whose transforms depend on the batched variables, ordered from the root to the leaves */
+  const std::vector<const LinkModel*>& getLinkModels() const
+  {
+    return link_models_;
+  }
+
+  /** \brief Compute the transforms of all links in getLinkModels() for every configuration. \e positions holds one
+      configuration per row and getVariableCount() columns. */
+  void compute(const Eigen::Ref<const Eigen::MatrixXd>& positions);
+
+  /** \brief The number of configurations of the last call to compute() */
+  std::size_t getStateCount() const
+  {
+    return static_cast<std::size_t>(transforms_.rows());
+  }
+
+  /** \brief Get the transform of \e link in the model frame for configuration \e state of the last call to
+      compute(). Links that do not depend on the batched variables have their transform from the reference state. */
+  Eigen::Isometry3d getGlobalLinkTransform(const LinkModel* link, std::size_t state) const;
+
+  /** \brief Get the transforms of \e link for all configurations as a matrix with one row per configuration and
+      twelve columns: the rotation in column-major order followed by the translation. \e link must be one of
+      getLinkModels(). */
+  Eigen::Ref<const Eigen::MatrixXd> getGlobalLinkTransforms(const LinkModel* link) const
+  {
+    assert(link_slots_[link->getLinkIndex()] >= 0);
+    return transforms_.middleCols(12 * link_slots_[link->getLinkIndex()], 12);
+  }
+
+  /** \brief Compute the Jacobian of \e group for the point at \e reference_point_position on \e link, for
+      configuration \e state of the last call to compute(). The result is the same as the one of
+      RobotState::getJacobian() for that configuration. Only chains of revolute and prismatic joints are supported.
+      \return True if the Jacobian was successfully computed, false otherwise */
+  bool getJacobian(const JointModelGroup* group, const LinkModel* link, std::size_t state,
+                   const Eigen::Vector3d& reference_point_position, Eigen::MatrixXd& jacobian) const;
+
+  /** \brief Compute the time derivative of the Jacobian of getJacobian() for the velocities \e qdot of the variables
+      of \e group, as RobotState::getJacobianDerivative() does.
+      \return True if the derivative was successfully computed, false otherwise */
+  bool getJacobianDerivative(const JointModelGroup* group, const LinkModel* link, std::size_t state,
+                             const Eigen::Vector3d& reference_point_position, const Eigen::VectorXd& qdot,
+                             Eigen::MatrixXd& jacobian_derivative) const;
+
+private:
+  /** \brief One step along the kinematic tree, computing the transform of one link */
+  struct LinkStep
+  {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    /** \brief Slot of the parent link in transforms_, or -1 if the parent transform is constant */
+    int parent_slot;
+
+    /** \brief Transform of the joint origin, premultiplied by the parent transform if that is constant */
+    Eigen::Isometry3d origin;
+
+    const JointModel* joint;
+    JointModel::JointType type;
+
+    /** \brief The joint axis for revolute and prismatic joints */
+    Eigen::Vector3d axis;
+
+    /** \brief For single-variable joints: the (mimicked) variable, with the mimic factor and offset */
+    int variable;
+    double factor;
+    double offset;
+  };
+
+  /** \brief Fill values_ with the positions of the variable of a single-variable joint */
+  void computeJointValues(const LinkStep& step, const Eigen::Ref<const Eigen::MatrixXd>& positions);
+
+  std::size_t variable_count_;
+  std::vector<const LinkModel*> link_models_;
+  std::vector<LinkStep, Eigen::aligned_allocator<LinkStep>> steps_;
+
+  /** \brief For each link of the robot, its slot in transforms_, or -1 */
+  std::vector<int> link_slots_;
+
+  /** \brief For each variable of the robot, its column in the positions passed to compute(), or -1 */
+  std::vector<int> variable_columns_;
+
+  std::vector<double> reference_positions_;
+  EigenSTL::vector_Isometry3d reference_transforms_;
+
+  /** \brief Link transforms, twelve columns per link and one row per configuration */
+  Eigen::MatrixXd transforms_;
+
+  /** \brief Scratch buffers for joint values and rotations */
+  Eigen::ArrayXd values_;
+  Eigen::ArrayXd cos_;
+  Eigen::ArrayXd sin_;
+  Eigen::ArrayXXd rotation_;
+};
+}  // namespace core
+}  // namespace moveit
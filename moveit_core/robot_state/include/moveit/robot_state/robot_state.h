@@ -38,7 +38,9 @@
 #pragma once
 
 #include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_model/variable_layout.h>
 #include <moveit/robot_state/attached_body.h>
+#include <moveit/robot_state/robot_state_arena.h>
 #include <moveit/transforms/transforms.h>
 #include <sensor_msgs/JointState.h>
 #include <visualization_msgs/MarkerArray.h>
@@ -92,11 +94,28 @@ public:
   /** \brief A state can be constructed from a specified robot model. No values are initialized.
       Call setToDefaultValues() if a state needs to provide valid information. */
   RobotState(const RobotModelConstPtr& robot_model);
+
+  /** \brief Construct a state for the specified robot model, with control over its storage.
+
+      With \e positions_only, the memory for joint, link and collision body transforms is only allocated once they are
+      first computed, e.g. by update(). This makes states that only carry variable values, like the waypoints of many
+      planners, cheaper to create and copy. Until then, the const transform getters must not be used, as is already
+      the case for any state with dirty transforms. Copies of such a state are positions-only as well, as long as its
+      transforms were not computed.
+
+      With an \e arena, the memory of the state is taken from the arena, see RobotStateArena. Copies take their
+      memory from the per-thread pool again, unless they are given an arena as well.
+      No values are initialized. */
+  RobotState(const RobotModelConstPtr& robot_model, bool positions_only,
+             const RobotStateArenaPtr& arena = RobotStateArenaPtr());
   ~RobotState();
 
-  /** \brief Copy constructor. */
+  /** \brief Copy constructor. The copy does not use the arena of \e other, so it does not keep the arena alive. */
   RobotState(const RobotState& other);
 
+  /** \brief Copy constructor taking the memory of the copy from \e arena */
+  RobotState(const RobotState& other, const RobotStateArenaPtr& arena);
+
   /** \brief Copy operator */
   RobotState& operator=(const RobotState& other);
 
@@ -184,6 +203,11 @@ public:
   void setVariablePositions(const std::vector<std::string>& variable_names,
                             const std::vector<double>& variable_position);
 
+  /** \brief Set the positions of the variables of \e layout, one value per name of the layout. Names the model does
+      not know are skipped. No names are looked up, so this is the fast way to set variables from a stream of messages
+      with the same ordering. */
+  void setVariablePositions(const VariableLayout& layout, const double* position);
+
   /** \brief Set the position of a single variable. An exception is thrown if the variable name is not known */
   void setVariablePosition(const std::string& variable, double value)
   {
@@ -278,6 +302,10 @@ public:
   void setVariableVelocities(const std::vector<std::string>& variable_names,
                              const std::vector<double>& variable_velocity);
 
+  /** \brief Set the velocities of the variables of \e layout, one value per name of the layout. Names the model does
+      not know are skipped. */
+  void setVariableVelocities(const VariableLayout& layout, const double* velocity);
+
   /** \brief Set the velocity of a variable. If an unknown variable name is specified, an exception is thrown. */
   void setVariableVelocity(const std::string& variable, double value)
   {
@@ -468,6 +496,10 @@ public:
   void setVariableEffort(const std::vector<std::string>& variable_names,
                          const std::vector<double>& variable_acceleration);
 
+  /** \brief Set the effort of the variables of \e layout, one value per name of the layout. Names the model does not
+      know are skipped. */
+  void setVariableEffort(const VariableLayout& layout, const double* effort);
+
   /** \brief Set the effort of a variable. If an unknown variable name is specified, an exception is thrown. */
   void setVariableEffort(const std::string& variable, double value)
   {
@@ -1209,6 +1241,8 @@ public:
                    Eigen::MatrixXd& jacobian, bool use_quaternion_representation = false) const;
 
   /** \brief Compute the Jacobian with reference to a particular point on a given link, for a specified group.
+   * The result is cached until the link transforms of this state change, so repeated calls for the same arguments
+   * do not recompute it.
    * \param group The group to compute the Jacobian for
    * \param link The link model to compute the Jacobian for
    * \param reference_point_position The reference point position (with respect to the link specified in link)
@@ -1218,12 +1252,7 @@ public:
    * \return True if jacobian was successfully computed, false otherwise
    */
   bool getJacobian(const JointModelGroup* group, const LinkModel* link, const Eigen::Vector3d& reference_point_position,
-                   Eigen::MatrixXd& jacobian, bool use_quaternion_representation = false)
-  {
-    updateLinkTransforms();
-    return static_cast<const RobotState*>(this)->getJacobian(group, link, reference_point_position, jacobian,
-                                                             use_quaternion_representation);
-  }
+                   Eigen::MatrixXd& jacobian, bool use_quaternion_representation = false);
 
   /** \brief Compute the Jacobian with reference to the last link of a specified group. If the group is not a chain, an
    * exception is thrown.
@@ -1241,10 +1270,39 @@ public:
    * \return The computed Jacobian.
    */
   Eigen::MatrixXd getJacobian(const JointModelGroup* group,
-                              const Eigen::Vector3d& reference_point_position = Eigen::Vector3d(0.0, 0.0, 0.0))
+                              const Eigen::Vector3d& reference_point_position = Eigen::Vector3d(0.0, 0.0, 0.0));
+
+  /** \brief Compute the time derivative of the Jacobian of getJacobian() (without quaternion representation) while
+   * the group moves with the velocities \e qdot, given in the order of the variables of the group. Only chains of
+   * revolute and prismatic joints are supported.
+   * \param group The group to compute the Jacobian derivative for
+   * \param link The link model to compute the Jacobian derivative for
+   * \param reference_point_position The reference point position (with respect to the link specified in link)
+   * \param qdot The velocities of the variables of the group
+   * \param jacobian_derivative The resultant derivative of the Jacobian
+   * \return True if the derivative was successfully computed, false otherwise
+   */
+  bool getJacobianDerivative(const JointModelGroup* group, const LinkModel* link,
+                             const Eigen::Vector3d& reference_point_position, const Eigen::VectorXd& qdot,
+                             Eigen::MatrixXd& jacobian_derivative) const;
+
+  /** \brief Compute the time derivative of the Jacobian of getJacobian() (without quaternion representation) while
+   * the group moves with the velocities \e qdot, given in the order of the variables of the group. Only chains of
+   * revolute and prismatic joints are supported.
+   * \param group The group to compute the Jacobian derivative for
+   * \param link The link model to compute the Jacobian derivative for
+   * \param reference_point_position The reference point position (with respect to the link specified in link)
+   * \param qdot The velocities of the variables of the group
+   * \param jacobian_derivative The resultant derivative of the Jacobian
+   * \return True if the derivative was successfully computed, false otherwise
+   */
+  bool getJacobianDerivative(const JointModelGroup* group, const LinkModel* link,
+                             const Eigen::Vector3d& reference_point_position, const Eigen::VectorXd& qdot,
+                             Eigen::MatrixXd& jacobian_derivative)
   {
     updateLinkTransforms();
-    return static_cast<const RobotState*>(this)->getJacobian(group, reference_point_position);
+    return static_cast<const RobotState*>(this)->getJacobianDerivative(group, link, reference_point_position, qdot,
+                                                                       jacobian_derivative);
   }
 
   /** \brief Given a twist for a particular link (\e tip), compute the corresponding velocity for every variable and
@@ -1255,11 +1313,7 @@ public:
   /** \brief Given a twist for a particular link (\e tip), compute the corresponding velocity for every variable and
    * store it in \e qdot */
   void computeVariableVelocity(const JointModelGroup* jmg, Eigen::VectorXd& qdot, const Eigen::VectorXd& twist,
-                               const LinkModel* tip)
-  {
-    updateLinkTransforms();
-    static_cast<const RobotState*>(this)->computeVariableVelocity(jmg, qdot, twist, tip);
-  }
+                               const LinkModel* tip);
 
   /** \brief Given the velocities for the variables in this group (\e qdot) and an amount of time (\e dt),
       update the current state using the Euler forward method. If the constraint specified is satisfied, return true,
@@ -1281,6 +1335,17 @@ public:
       setVariableVelocities(msg.name, msg.velocity);
   }
 
+  /** \brief Set positions and velocities from \e msg, whose names need to match \e layout (see
+      VariableLayout::matches()). Names the model does not know are skipped. */
+  void setVariableValues(const sensor_msgs::JointState& msg, const VariableLayout& layout)
+  {
+    assert(layout.matches(msg.name));
+    if (msg.position.size() == layout.size())
+      setVariablePositions(layout, msg.position.data());
+    if (msg.velocity.size() == layout.size())
+      setVariableVelocities(layout, msg.velocity.data());
+  }
+
   /** \brief Set all joints to their default positions.
        The default position is 0, or if that is not within bounds then half way
        between min and max bound.  */
@@ -1333,6 +1398,21 @@ public:
   /** \brief Update all transforms. */
   void update(bool force = false);
 
+  /** \brief Compute link transforms on demand, one link at a time.
+
+      By default, getGlobalLinkTransform() updates all links below the common root of the joints changed since the
+      last update. In lazy mode it only computes the requested link and those of its ancestors that are out of date,
+      which is much cheaper when only a single tip link is of interest, e.g. while sampling IK solutions or
+      checking position constraints. The other links stay dirty until the next full update.
+      The mode is copied along with the state. */
+  void setLazyLinkTransforms(bool lazy);
+
+  /** \brief Check whether link transforms are computed on demand; see setLazyLinkTransforms() */
+  bool hasLazyLinkTransforms() const
+  {
+    return lazy_link_transforms_ != nullptr;
+  }
+
   /** \brief Update the state after setting a particular link to the input global transform pose.
 
       This "warps" the given link to the given pose, neglecting the joint values of its parent joint.
@@ -1364,7 +1444,10 @@ public:
 
   const Eigen::Isometry3d& getGlobalLinkTransform(const LinkModel* link)
   {
-    updateLinkTransforms();
+    if (lazy_link_transforms_)
+      updateLinkTransform(link);
+    else
+      updateLinkTransforms();
     return global_link_transforms_[link->getLinkIndex()];
   }
 
@@ -1422,6 +1505,8 @@ public:
     unsigned char& dirty = dirty_joint_transforms_[idx];
     if (dirty)
     {
+      if (!transforms_memory_)
+        allocTransforms();
       joint->computeTransform(position_ + joint->getFirstVariableIndex(), variable_joint_transforms_[idx]);
       dirty = 0;
     }
@@ -1817,12 +1902,15 @@ public:
 
 private:
   void allocMemory();
+  void allocTransforms();
+  void freeMemory();
   void initTransforms();
   void copyFrom(const RobotState& other);
 
   void markDirtyJointTransforms(const JointModel* joint)
   {
     dirty_joint_transforms_[joint->getJointIndex()] = 1;
+    markDirtyLazyLinkTransforms(joint);
     dirty_link_transforms_ =
         dirty_link_transforms_ == nullptr ? joint : robot_model_->getCommonRoot(dirty_link_transforms_, joint);
   }
@@ -1830,12 +1918,32 @@ private:
   void markDirtyJointTransforms(const JointModelGroup* group)
   {
     for (const JointModel* jm : group->getActiveJointModels())
+    {
       dirty_joint_transforms_[jm->getJointIndex()] = 1;
+      markDirtyLazyLinkTransforms(jm);
+    }
     dirty_link_transforms_ = dirty_link_transforms_ == nullptr ?
                                  group->getCommonRoot() :
                                  robot_model_->getCommonRoot(dirty_link_transforms_, group->getCommonRoot());
   }
 
+  /** \brief Record that the links below \e joint are out of date, when link transforms are computed on demand */
+  void markDirtyLazyLinkTransforms(const JointModel* joint)
+  {
+    if (lazy_link_transforms_)
+      lazy_link_transforms_->joint_epochs[joint->getJointIndex()] = ++lazy_link_transforms_->epoch;
+  }
+
+  /** \brief Mark all joint and link transforms dirty */
+  void markDirtyAllTransforms();
+
+  /** \brief Forget the cached Jacobian; called whenever link transforms change */
+  void invalidateJacobianCache()
+  {
+    if (jacobian_cache_)
+      jacobian_cache_->valid = false;
+  }
+
   void markVelocity();
   void markAcceleration();
   void markEffort();
@@ -1862,6 +1970,7 @@ private:
       // as this function is always used in combination of
       // updateMimicJoint(group->getMimicJointModels()) + markDirtyJointTransforms(group);
       dirty_joint_transforms_[jm->getJointIndex()] = 1;
+      markDirtyLazyLinkTransforms(jm);
     }
   }
 
@@ -1879,6 +1988,15 @@ private:
 
   void updateLinkTransformsInternal(const JointModel* start);
 
+  /** \brief Compute the global transform of \e link from the one of its parent link */
+  void computeLinkTransform(const LinkModel* link);
+
+  /** \brief Compute the transform of \e link and of its out of date ancestors only */
+  void updateLinkTransform(const LinkModel* link);
+
+  /** \brief Start tracking the link transforms individually, treating the dirty subtree as out of date */
+  void resetLazyLinkTransforms();
+
   void getMissingKeys(const std::map<std::string, double>& variable_map,
                       std::vector<std::string>& missing_variables) const;
   void getStateTreeJointString(std::ostream& ss, const JointModel* jm, const std::string& pfx0, bool last) const;
@@ -1893,8 +2011,16 @@ private:
   bool checkCollisionTransforms() const;
 
   RobotModelConstPtr robot_model_;
+
+  /** \brief The arena the memory of this state is taken from, if any */
+  RobotStateArenaPtr arena_;
+
+  /** \brief Memory for the dirty flags and the variable values */
   void* memory_;
 
+  /** \brief Memory for the transforms; nullptr until needed for positions-only states */
+  void* transforms_memory_;
+
   double* position_;
   double* velocity_;
   double* acceleration_;
@@ -1906,7 +2032,7 @@ private:
   const JointModel* dirty_link_transforms_;
   const JointModel* dirty_collision_body_transforms_;
 
-  // All the following transform variables point into aligned memory in memory_
+  // All the following transform variables point into aligned memory in transforms_memory_
   // They are updated lazily, based on the flags in dirty_joint_transforms_
   // resp. the pointers dirty_link_transforms_ and dirty_collision_body_transforms_
   Eigen::Isometry3d* variable_joint_transforms_;         ///< Local transforms of all joints
@@ -1914,6 +2040,31 @@ private:
   Eigen::Isometry3d* global_collision_body_transforms_;  ///< Transforms from model frame to collision bodies
   unsigned char* dirty_joint_transforms_;
 
+  /** \brief The arguments and result of the last call to the non-const getJacobian() */
+  struct JacobianCache
+  {
+    bool valid = false;
+    const JointModelGroup* group = nullptr;
+    const LinkModel* link = nullptr;
+    Eigen::Vector3d reference_point_position;
+    bool use_quaternion_representation = false;
+    Eigen::MatrixXd jacobian;
+  };
+
+  /** \brief Allocated on the first call to the non-const getJacobian() */
+  std::unique_ptr<JacobianCache> jacobian_cache_;
+
+  /** \brief Per-joint and per-link change stamps, present only while link transforms are computed on demand.
+      A link transform is up to date if it was computed after the last change of every joint above it. */
+  struct LazyLinkTransforms
+  {
+    std::size_t epoch = 0;                  ///< Incremented whenever a joint transform is marked dirty
+    std::vector<std::size_t> joint_epochs;  ///< The epoch of the last change of each joint
+    std::vector<std::size_t> link_epochs;   ///< The epoch at which each link transform was last computed
+    std::vector<const LinkModel*> path;     ///< Scratch space for the links from a requested link to the root
+  };
+  std::unique_ptr<LazyLinkTransforms> lazy_link_transforms_;
+
   /** \brief All attached bodies that are part of this state, indexed by their name */
   std::map<std::string, AttachedBody*> attached_body_map_;
 
@@ -0,0 +1,96 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <moveit/robot_model/robot_model.h>
+#include <algorithm>
+#include <atomic>
+
+namespace moveit
+{
+namespace core
+{
+MOVEIT_CLASS_FORWARD(RobotStateArena);  // Defines RobotStateArenaPtr, ConstPtr, WeakPtr... etc
+
+/** \brief A block of memory from which many RobotState instances of one RobotModel take their storage.
+
+    A RobotState normally gets its memory from a small per-thread pool, which avoids the global allocator once states
+    are created and destroyed repeatedly. When a known number of states is built at once, e.g. the waypoints of a
+    trajectory, an arena reserves the memory for all of them with a single allocation instead. Memory taken from the
+    arena is only returned when the arena itself is destroyed; the states keep the arena alive through their shared
+    pointer. Copies of these states do not use the arena, unless it is passed to the copy constructor explicitly, so
+    a long-lived copy does not pin the whole arena. When the arena is exhausted, states fall back to the per-thread
+    pool.
+
+    Allocation is thread-safe. */
+class RobotStateArena
+{
+public:
+  /** \brief Reserve memory for \e num_states states of \e robot_model, including their transforms */
+  RobotStateArena(const RobotModel& robot_model, std::size_t num_states);
+  ~RobotStateArena();
+
+  RobotStateArena(const RobotStateArena&) = delete;
+  RobotStateArena& operator=(const RobotStateArena&) = delete;
+
+  /** \brief Take \e bytes from the arena. Returns nullptr if there is not enough memory left. */
+  void* allocate(std::size_t bytes);
+
+  /** \brief Check whether \e memory was taken from this arena */
+  bool owns(const void* memory) const
+  {
+    return memory >= memory_ && memory < static_cast<const char*>(memory_) + capacity_;
+  }
+
+  /** \brief The total number of bytes reserved */
+  std::size_t getCapacity() const
+  {
+    return capacity_;
+  }
+
+  /** \brief The number of bytes taken so far */
+  std::size_t getUsedBytes() const
+  {
+    return std::min(used_.load(), capacity_);
+  }
+
+private:
+  void* memory_;
+  std::size_t capacity_;
+  std::atomic<std::size_t> used_;
+};
+}  // namespace core
+}  // namespace moveit
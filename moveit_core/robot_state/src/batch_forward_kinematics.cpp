@@ -0,0 +1,282 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_state/batch_forward_kinematics.h>
+#include <moveit/robot_model/prismatic_joint_model.h>
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <algorithm>
+#include "chain_jacobian.inc"
+
+namespace moveit
+{
+namespace core
+{
+namespace
+{
+// index of element (row, col) of the 3x4 affine part of a transform, in column-major order
+inline Eigen::Index component(int row, int col)
+{
+  return 3 * col + row;
+}
+}  // namespace
+
+BatchForwardKinematics::BatchForwardKinematics(const RobotState& reference, const JointModelGroup* group)
+{
+  const RobotModelConstPtr& model = reference.getRobotModel();
+
+  RobotState state(reference);
+  state.update();
+  reference_positions_.assign(state.getVariablePositions(), state.getVariablePositions() + model->getVariableCount());
+  reference_transforms_.reserve(model->getLinkModelCount());
+  for (const LinkModel* link : model->getLinkModels())
+    reference_transforms_.push_back(state.getGlobalLinkTransform(link));
+
+  variable_columns_.assign(model->getVariableCount(), -1);
+  if (group)
+  {
+    const std::vector<int>& indices = group->getVariableIndexList();
+    for (std::size_t i = 0; i < indices.size(); ++i)
+      variable_columns_[indices[i]] = i;
+    variable_count_ = indices.size();
+    link_models_ = group->getUpdatedLinkModels();
+  }
+  else
+  {
+    for (std::size_t i = 0; i < variable_columns_.size(); ++i)
+      variable_columns_[i] = i;
+    variable_count_ = variable_columns_.size();
+    link_models_ = model->getLinkModels();
+  }
+
+  // parents need to be computed before their children
+  std::sort(link_models_.begin(), link_models_.end(),
+            [](const LinkModel* a, const LinkModel* b) { return a->getLinkIndex() < b->getLinkIndex(); });
+
+  link_slots_.assign(model->getLinkModelCount(), -1);
+  steps_.reserve(link_models_.size());
+  for (std::size_t i = 0; i < link_models_.size(); ++i)
+  {
+    const LinkModel* link = link_models_[i];
+    link_slots_[link->getLinkIndex()] = i;
+
+    LinkStep step;
+    const LinkModel* parent = link->getParentLinkModel();
+    step.parent_slot = parent ? link_slots_[parent->getLinkIndex()] : -1;
+    if (step.parent_slot >= 0)
+      step.origin = link->getJointOriginTransform();
+    else if (parent)
+      step.origin = reference_transforms_[parent->getLinkIndex()] * link->getJointOriginTransform();
+    else
+      step.origin = link->getJointOriginTransform();
+
+    step.joint = link->getParentJointModel();
+    step.type = step.joint->getType();
+    if (step.type == JointModel::REVOLUTE)
+      step.axis = static_cast<const RevoluteJointModel*>(step.joint)->getAxis();
+    else if (step.type == JointModel::PRISMATIC)
+      step.axis = static_cast<const PrismaticJointModel*>(step.joint)->getAxis();
+    else
+      step.axis = Eigen::Vector3d::Zero();
+
+    if (const JointModel* mimic = step.joint->getMimic())
+    {
+      step.variable = mimic->getFirstVariableIndex();
+      step.factor = step.joint->getMimicFactor();
+      step.offset = step.joint->getMimicOffset();
+    }
+    else
+    {
+      step.variable = step.joint->getFirstVariableIndex();
+      step.factor = 1.0;
+      step.offset = 0.0;
+    }
+    steps_.push_back(step);
+  }
+}
+
+void BatchForwardKinematics::computeJointValues(const LinkStep& step,
+                                                const Eigen::Ref<const Eigen::MatrixXd>& positions)
+{
+  const int column = variable_columns_[step.variable];
+  if (column >= 0)
+    values_ = positions.col(column).array();
+  else
+    values_.setConstant(reference_positions_[step.variable]);
+  if (step.factor != 1.0 || step.offset != 0.0)
+    values_ = values_ * step.factor + step.offset;
+}
+
+void BatchForwardKinematics::compute(const Eigen::Ref<const Eigen::MatrixXd>& positions)
+{
+  assert(static_cast<std::size_t>(positions.cols()) == variable_count_);
+  const Eigen::Index count = positions.rows();
+
+  // the buffers only reallocate when the number of configurations changes
+  transforms_.resize(count, 12 * steps_.size());
+  values_.resize(count);
+  cos_.resize(count);
+  sin_.resize(count);
+  rotation_.resize(count, 9);
+
+  for (std::size_t slot = 0; slot < steps_.size(); ++slot)
+  {
+    const LinkStep& step = steps_[slot];
+    auto link = transforms_.middleCols(12 * slot, 12).array();
+
+    // transform of the joint origin in the model frame
+    if (step.parent_slot >= 0)
+    {
+      const auto parent = transforms_.middleCols(12 * step.parent_slot, 12).array();
+      for (int col = 0; col < 4; ++col)
+        for (int row = 0; row < 3; ++row)
+        {
+          auto out = link.col(component(row, col));
+          out = parent.col(component(row, 0)) * step.origin(0, col) +
+                parent.col(component(row, 1)) * step.origin(1, col) +
+                parent.col(component(row, 2)) * step.origin(2, col);
+          if (col == 3)
+            out += parent.col(component(row, 3));
+        }
+    }
+    else
+    {
+      for (int col = 0; col < 4; ++col)
+        for (int row = 0; row < 3; ++row)
+          link.col(component(row, col)).setConstant(step.origin(row, col));
+    }
+
+    // apply the joint transform
+    switch (step.type)
+    {
+      case JointModel::FIXED:
+        break;
+      case JointModel::REVOLUTE:
+      {
+        // R = c * I + s * [a]x + (1 - c) * a * a^T, so for the rows r of the origin rotation A:
+        // (A * R)_r = c * A_r + s * A_r * [a]x + (1 - c) * (A_r . a) * a^T
+        computeJointValues(step, positions);
+        cos_ = values_.cos();
+        sin_ = values_.sin();
+        const Eigen::Vector3d& a = step.axis;
+        for (int row = 0; row < 3; ++row)
+        {
+          const auto a0 = link.col(component(row, 0));
+          const auto a1 = link.col(component(row, 1));
+          const auto a2 = link.col(component(row, 2));
+          // the joint values are not needed anymore, so values_ holds (1 - c) * (A_r . a)
+          values_ = (a0 * a.x() + a1 * a.y() + a2 * a.z()) * (1.0 - cos_);
+          rotation_.col(component(row, 0)) = cos_ * a0 + sin_ * (a1 * a.z() - a2 * a.y()) + values_ * a.x();
+          rotation_.col(component(row, 1)) = cos_ * a1 + sin_ * (a2 * a.x() - a0 * a.z()) + values_ * a.y();
+          rotation_.col(component(row, 2)) = cos_ * a2 + sin_ * (a0 * a.y() - a1 * a.x()) + values_ * a.z();
+        }
+        link.leftCols(9) = rotation_;
+        break;
+      }
+      case JointModel::PRISMATIC:
+      {
+        computeJointValues(step, positions);
+        const Eigen::Vector3d& a = step.axis;
+        for (int row = 0; row < 3; ++row)
+          link.col(component(row, 3)) +=
+              values_ * (link.col(component(row, 0)) * a.x() + link.col(component(row, 1)) * a.y() +
+                         link.col(component(row, 2)) * a.z());
+        break;
+      }
+      default:
+      {
+        // multi-variable joints (planar, floating) are rare and usually at the root, so they are composed per state
+        const std::size_t num_variables = step.joint->getVariableCount();
+        const int first = step.joint->getFirstVariableIndex();
+        std::vector<double> joint_values(num_variables);
+        Eigen::Isometry3d joint_transform;
+        Eigen::Isometry3d transform;
+        for (Eigen::Index i = 0; i < count; ++i)
+        {
+          for (std::size_t v = 0; v < num_variables; ++v)
+          {
+            const int column = variable_columns_[first + v];
+            joint_values[v] = column >= 0 ? positions(i, column) : reference_positions_[first + v];
+          }
+          step.joint->computeTransform(joint_values.data(), joint_transform);
+          for (int col = 0; col < 4; ++col)
+            for (int row = 0; row < 3; ++row)
+              transform(row, col) = link(i, component(row, col));
+          transform.makeAffine();
+          transform = transform * joint_transform;
+          for (int col = 0; col < 4; ++col)
+            for (int row = 0; row < 3; ++row)
+              link(i, component(row, col)) = transform(row, col);
+        }
+        break;
+      }
+    }
+  }
+}
+
+Eigen::Isometry3d BatchForwardKinematics::getGlobalLinkTransform(const LinkModel* link, std::size_t state) const
+{
+  const int slot = link_slots_[link->getLinkIndex()];
+  if (slot < 0)
+    return reference_transforms_[link->getLinkIndex()];
+
+  assert(state < getStateCount());
+  Eigen::Isometry3d transform;
+  for (int col = 0; col < 4; ++col)
+    for (int row = 0; row < 3; ++row)
+      transform(row, col) = transforms_(state, 12 * slot + component(row, col));
+  transform.makeAffine();
+  return transform;
+}
+
+bool BatchForwardKinematics::getJacobian(const JointModelGroup* group, const LinkModel* link, std::size_t state,
+                                         const Eigen::Vector3d& reference_point_position,
+                                         Eigen::MatrixXd& jacobian) const
+{
+  auto link_transform = [this, state](const LinkModel* l) { return getGlobalLinkTransform(l, state); };
+  return computeChainJacobian(group, link, reference_point_position, link_transform, nullptr, &jacobian, nullptr);
+}
+
+bool BatchForwardKinematics::getJacobianDerivative(const JointModelGroup* group, const LinkModel* link,
+                                                   std::size_t state, const Eigen::Vector3d& reference_point_position,
+                                                   const Eigen::VectorXd& qdot,
+                                                   Eigen::MatrixXd& jacobian_derivative) const
+{
+  if (qdot.size() != static_cast<Eigen::Index>(group->getVariableCount()))
+    return false;
+  auto link_transform = [this, state](const LinkModel* l) { return getGlobalLinkTransform(l, state); };
+  return computeChainJacobian(group, link, reference_point_position, link_transform, qdot.data(), nullptr,
+                              &jacobian_derivative);
+}
+}  // namespace core
+}  // namespace moveit
@@ -147,8 +147,11 @@ double CartesianInterpolator::computeCartesianPath(RobotState* start_state, cons
       consistency_limits.push_back(limit);
     }
 
+  // the waypoints take their memory from a single allocation
+  RobotStateArenaPtr arena = std::make_shared<RobotStateArena>(*start_state->getRobotModel(), steps + 1);
+
   traj.clear();
-  traj.push_back(RobotStatePtr(new moveit::core::RobotState(*start_state)));
+  traj.push_back(RobotStatePtr(new moveit::core::RobotState(*start_state, arena)));
 
   double last_valid_percentage = 0.0;
   for (std::size_t i = 1; i <= steps; ++i)
@@ -161,7 +164,7 @@ double CartesianInterpolator::computeCartesianPath(RobotState* start_state, cons
     // Explicitly use a single IK attempt only: We want a smooth trajectory.
     // Random seeding (of additional attempts) would probably create IK jumps.
     if (start_state->setFromIK(group, pose, link->getName(), consistency_limits, 0.0, validCallback, options))
-      traj.push_back(RobotStatePtr(new moveit::core::RobotState(*start_state)));
+      traj.push_back(RobotStatePtr(new moveit::core::RobotState(*start_state, arena)));
     else
       break;
 
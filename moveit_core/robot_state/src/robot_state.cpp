@@ -37,6 +37,7 @@
 
 #include <moveit/robot_state/robot_state.h>
 #include <moveit/robot_state/cartesian_interpolator.h>
+#include <moveit/robot_model/chain_kinematics.h>
 #include <moveit/transforms/transforms.h>
 #include <geometric_shapes/check_isometry.h>
 #include <geometric_shapes/shape_operations.h>
@@ -46,6 +47,10 @@
 #include <moveit/macros/console_colors.h>
 #include <boost/bind.hpp>
 #include <moveit/robot_model/aabb.h>
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include "chain_jacobian.inc"
 
 namespace moveit
 {
@@ -53,8 +58,152 @@ namespace core
 {
 const std::string LOGNAME = "robot_state";
 
-RobotState::RobotState(const RobotModelConstPtr& robot_model)
+namespace
+{
+// Number of blocks of each size kept in the per-thread pool of state memory
+const std::size_t MAX_POOLED_BLOCKS = 32;
+
+// Alignment of the blocks handed out by RobotStateArena, sufficient for doubles and pointers
+const std::size_t ARENA_ALIGNMENT = alignof(std::max_align_t);
+
+constexpr unsigned int EXTRA_ALIGNMENT_BYTES = EIGEN_MAX_ALIGN_BYTES - 1;
+
+// Per-thread free lists of state memory, one per block size. As all states of a robot model use blocks of the same
+// sizes, creating and destroying states in a loop reuses the same few blocks instead of calling malloc and free.
+class StateMemoryPool
+{
+public:
+  ~StateMemoryPool()
+  {
+    for (std::pair<std::size_t, std::vector<void*>>& free_list : free_lists_)
+      for (void* block : free_list.second)
+        free(block);
+    destroyed = true;
+  }
+
+  void* allocate(std::size_t bytes)
+  {
+    std::vector<void*>& free_list = getFreeList(bytes);
+    if (free_list.empty())
+      return malloc(bytes);
+    void* block = free_list.back();
+    free_list.pop_back();
+    return block;
+  }
+
+  void release(void* block, std::size_t bytes)
+  {
+    std::vector<void*>& free_list = getFreeList(bytes);
+    if (free_list.size() < MAX_POOLED_BLOCKS)
+      free_list.push_back(block);
+    else
+      free(block);
+  }
+
+  // states destroyed after the pool of their thread (e.g. static ones) return their memory directly
+  static thread_local bool destroyed;
+
+private:
+  std::vector<void*>& getFreeList(std::size_t bytes)
+  {
+    for (std::pair<std::size_t, std::vector<void*>>& free_list : free_lists_)
+      if (free_list.first == bytes)
+        return free_list.second;
+    free_lists_.emplace_back(bytes, std::vector<void*>());
+    free_lists_.back().second.reserve(MAX_POOLED_BLOCKS);
+    return free_lists_.back().second;
+  }
+
+  std::vector<std::pair<std::size_t, std::vector<void*>>> free_lists_;
+};
+
+thread_local bool StateMemoryPool::destroyed = false;
+
+StateMemoryPool& getStateMemoryPool()
+{
+  static thread_local StateMemoryPool pool;
+  return pool;
+}
+
+void* allocateStateMemory(std::size_t bytes, const RobotStateArenaPtr& arena)
+{
+  if (arena)
+    if (void* memory = arena->allocate(bytes))
+      return memory;
+  if (StateMemoryPool::destroyed)
+    return malloc(bytes);
+  return getStateMemoryPool().allocate(bytes);
+}
+
+void freeStateMemory(void* memory, std::size_t bytes, const RobotStateArenaPtr& arena)
+{
+  if (!memory || (arena && arena->owns(memory)))
+    return;
+  if (StateMemoryPool::destroyed)
+    free(memory);
+  else
+    getStateMemoryPool().release(memory, bytes);
+}
+
+// the dirty flags of the joint transforms are stored in whole doubles, in front of the variables
+std::size_t getDirtyJointTransformDoubles(const RobotModel& robot_model)
+{
+  return 1 + robot_model.getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
+}
+
+std::size_t getTransformCount(const RobotModel& robot_model)
+{
+  return robot_model.getJointModelCount() + robot_model.getLinkModelCount() + robot_model.getLinkGeometryCount();
+}
+
+// bytes for the dirty flags, positions, velocities and accelerations (shared with efforts)
+std::size_t getVariableMemoryBytes(const RobotModel& robot_model)
+{
+  return sizeof(double) * (robot_model.getVariableCount() * 3 + getDirtyJointTransformDoubles(robot_model));
+}
+
+std::size_t getTransformMemoryBytes(const RobotModel& robot_model)
+{
+  return sizeof(Eigen::Isometry3d) * getTransformCount(robot_model) + EXTRA_ALIGNMENT_BYTES;
+}
+
+std::size_t alignArenaBytes(std::size_t bytes)
+{
+  return (bytes + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+}  // namespace
+
+RobotStateArena::RobotStateArena(const RobotModel& robot_model, std::size_t num_states)
+  : capacity_(num_states * (alignArenaBytes(getVariableMemoryBytes(robot_model)) +
+                            alignArenaBytes(getTransformMemoryBytes(robot_model))))
+  , used_(0)
+{
+  memory_ = malloc(capacity_);
+  if (!memory_)
+    throw std::bad_alloc();
+}
+
+RobotStateArena::~RobotStateArena()
+{
+  free(memory_);
+}
+
+void* RobotStateArena::allocate(std::size_t bytes)
+{
+  bytes = alignArenaBytes(bytes);
+  const std::size_t offset = used_.fetch_add(bytes);
+  if (offset + bytes > capacity_)
+    return nullptr;
+  return static_cast<char*>(memory_) + offset;
+}
+
+RobotState::RobotState(const RobotModelConstPtr& robot_model) : RobotState(robot_model, false)
+{
+}
+
+RobotState::RobotState(const RobotModelConstPtr& robot_model, bool positions_only, const RobotStateArenaPtr& arena)
   : robot_model_(robot_model)
+  , arena_(arena)
   , has_velocity_(false)
   , has_acceleration_(false)
   , has_effort_(false)
@@ -63,66 +212,76 @@ RobotState::RobotState(const RobotModelConstPtr& robot_model)
   , rng_(nullptr)
 {
   allocMemory();
+  if (!positions_only)
+    allocTransforms();
   initTransforms();
 }
 
-RobotState::RobotState(const RobotState& other) : rng_(nullptr)
+RobotState::RobotState(const RobotState& other) : RobotState(other, RobotStateArenaPtr())
+{
+}
+
+RobotState::RobotState(const RobotState& other, const RobotStateArenaPtr& arena) : arena_(arena), rng_(nullptr)
 {
   robot_model_ = other.robot_model_;
   allocMemory();
+  if (other.transforms_memory_)
+    allocTransforms();
   copyFrom(other);
 }
 
 RobotState::~RobotState()
 {
   clearAttachedBodies();
-  free(memory_);
+  freeMemory();
   if (rng_)
     delete rng_;
 }
 
 void RobotState::allocMemory()
+{
+  memory_ = allocateStateMemory(getVariableMemoryBytes(*robot_model_), arena_);
+  dirty_joint_transforms_ = reinterpret_cast<unsigned char*>(memory_);
+  position_ = reinterpret_cast<double*>(memory_) + getDirtyJointTransformDoubles(*robot_model_);
+  velocity_ = position_ + robot_model_->getVariableCount();
+  // acceleration and effort share the memory (not both can be specified)
+  effort_ = acceleration_ = velocity_ + robot_model_->getVariableCount();
+
+  transforms_memory_ = nullptr;
+  variable_joint_transforms_ = nullptr;
+  global_link_transforms_ = nullptr;
+  global_collision_body_transforms_ = nullptr;
+}
+
+void RobotState::allocTransforms()
 {
   static_assert((sizeof(Eigen::Isometry3d) / EIGEN_MAX_ALIGN_BYTES) * EIGEN_MAX_ALIGN_BYTES == sizeof(Eigen::Isometry3d),
                 "sizeof(Eigen::Isometry3d) should be a multiple of EIGEN_MAX_ALIGN_BYTES");
 
-  constexpr unsigned int extra_alignment_bytes = EIGEN_MAX_ALIGN_BYTES - 1;
-  // memory for the dirty joint transforms
-  const int nr_doubles_for_dirty_joint_transforms =
-      1 + robot_model_->getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
-  const size_t bytes =
-      sizeof(Eigen::Isometry3d) * (robot_model_->getJointModelCount() + robot_model_->getLinkModelCount() +
-                                   robot_model_->getLinkGeometryCount()) +
-      sizeof(double) * (robot_model_->getVariableCount() * 3 + nr_doubles_for_dirty_joint_transforms) +
-      extra_alignment_bytes;
-  memory_ = malloc(bytes);
+  transforms_memory_ = allocateStateMemory(getTransformMemoryBytes(*robot_model_), arena_);
 
   // make the memory for transforms align at EIGEN_MAX_ALIGN_BYTES
   // https://eigen.tuxfamily.org/dox/classEigen_1_1aligned__allocator.html
-  variable_joint_transforms_ = reinterpret_cast<Eigen::Isometry3d*>(((uintptr_t)memory_ + extra_alignment_bytes) &
-                                                                    ~(uintptr_t)extra_alignment_bytes);
+  variable_joint_transforms_ = reinterpret_cast<Eigen::Isometry3d*>(
+      ((uintptr_t)transforms_memory_ + EXTRA_ALIGNMENT_BYTES) & ~(uintptr_t)EXTRA_ALIGNMENT_BYTES);
   global_link_transforms_ = variable_joint_transforms_ + robot_model_->getJointModelCount();
   global_collision_body_transforms_ = global_link_transforms_ + robot_model_->getLinkModelCount();
-  dirty_joint_transforms_ =
-      reinterpret_cast<unsigned char*>(global_collision_body_transforms_ + robot_model_->getLinkGeometryCount());
-  position_ = reinterpret_cast<double*>(dirty_joint_transforms_) + nr_doubles_for_dirty_joint_transforms;
-  velocity_ = position_ + robot_model_->getVariableCount();
-  // acceleration and effort share the memory (not both can be specified)
-  effort_ = acceleration_ = velocity_ + robot_model_->getVariableCount();
+
+  // initialize last row of transformation matrices, which will not be modified by transform updates anymore
+  for (size_t i = 0, end = getTransformCount(*robot_model_); i != end; ++i)
+    variable_joint_transforms_[i].makeAffine();
+}
+
+void RobotState::freeMemory()
+{
+  freeStateMemory(memory_, getVariableMemoryBytes(*robot_model_), arena_);
+  freeStateMemory(transforms_memory_, getTransformMemoryBytes(*robot_model_), arena_);
 }
 
 void RobotState::initTransforms()
 {
   // mark all transforms as dirty
-  const int nr_doubles_for_dirty_joint_transforms =
-      1 + robot_model_->getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
-  memset(dirty_joint_transforms_, 1, sizeof(double) * nr_doubles_for_dirty_joint_transforms);
-
-  // initialize last row of transformation matrices, which will not be modified by transform updates anymore
-  for (size_t i = 0, end = robot_model_->getJointModelCount() + robot_model_->getLinkModelCount() +
-                           robot_model_->getLinkGeometryCount();
-       i != end; ++i)
-    variable_joint_transforms_[i].makeAffine();
+  memset(dirty_joint_transforms_, 1, sizeof(double) * getDirtyJointTransformDoubles(*robot_model_));
 }
 
 RobotState& RobotState::operator=(const RobotState& other)
@@ -140,6 +299,7 @@ void RobotState::copyFrom(const RobotState& other)
 
   dirty_collision_body_transforms_ = other.dirty_collision_body_transforms_;
   dirty_link_transforms_ = other.dirty_link_transforms_;
+  invalidateJacobianCache();
 
   if (dirty_link_transforms_ == robot_model_->getRootJoint())
   {
@@ -147,23 +307,34 @@ void RobotState::copyFrom(const RobotState& other)
     memcpy(position_, other.position_,
            robot_model_->getVariableCount() * sizeof(double) *
                (1 + (has_velocity_ ? 1 : 0) + ((has_acceleration_ || has_effort_) ? 1 : 0)));
-    // and just initialize transforms
+    // and just mark the transforms dirty
     initTransforms();
   }
   else
   {
-    // copy all the memory; maybe avoid copying velocity and acceleration if possible
-    const int nr_doubles_for_dirty_joint_transforms =
-        1 + robot_model_->getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
+    // some transforms are up to date, so the other state has memory for them
+    if (!transforms_memory_)
+      allocTransforms();
+    memcpy((void*)variable_joint_transforms_, (void*)other.variable_joint_transforms_,
+           sizeof(Eigen::Isometry3d) * getTransformCount(*robot_model_));
+
+    // copy the dirty flags and variables; maybe avoid copying velocity and acceleration if possible
     const size_t bytes =
-        sizeof(Eigen::Isometry3d) * (robot_model_->getJointModelCount() + robot_model_->getLinkModelCount() +
-                                     robot_model_->getLinkGeometryCount()) +
         sizeof(double) *
-            (robot_model_->getVariableCount() * (1 + ((has_velocity_ || has_acceleration_ || has_effort_) ? 1 : 0) +
-                                                 ((has_acceleration_ || has_effort_) ? 1 : 0)) +
-             nr_doubles_for_dirty_joint_transforms);
-    memcpy((void*)variable_joint_transforms_, (void*)other.variable_joint_transforms_, bytes);
+        (robot_model_->getVariableCount() * (1 + ((has_velocity_ || has_acceleration_ || has_effort_) ? 1 : 0) +
+                                             ((has_acceleration_ || has_effort_) ? 1 : 0)) +
+         getDirtyJointTransformDoubles(*robot_model_));
+    memcpy(memory_, other.memory_, bytes);
+  }
+
+  if (other.lazy_link_transforms_)
+  {
+    if (!lazy_link_transforms_)
+      lazy_link_transforms_.reset(new LazyLinkTransforms());
+    resetLazyLinkTransforms();
   }
+  else
+    lazy_link_transforms_.reset();
 
   // copy attached bodies
   clearAttachedBodies();
@@ -173,6 +344,13 @@ void RobotState::copyFrom(const RobotState& other)
                it.second->getSubframeTransforms());
 }
 
+void RobotState::markDirtyAllTransforms()
+{
+  memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
+  dirty_link_transforms_ = robot_model_->getRootJoint();
+  markDirtyLazyLinkTransforms(dirty_link_transforms_);
+}
+
 bool RobotState::checkJointTransforms(const JointModel* joint) const
 {
   if (dirtyJointTransform(joint))
@@ -276,8 +454,7 @@ void RobotState::setToRandomPositions()
 {
   random_numbers::RandomNumberGenerator& rng = getRandomNumberGenerator();
   robot_model_->getVariableRandomPositions(rng, position_);
-  memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
-  dirty_link_transforms_ = robot_model_->getRootJoint();
+  markDirtyAllTransforms();
   // mimic values are correctly set in RobotModel
 }
 
@@ -341,8 +518,7 @@ void RobotState::setToDefaultValues()
   robot_model_->getVariableDefaultPositions(position_);  // mimic values are updated
   // set velocity & acceleration to 0
   memset(velocity_, 0, sizeof(double) * 2 * robot_model_->getVariableCount());
-  memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
-  dirty_link_transforms_ = robot_model_->getRootJoint();
+  markDirtyAllTransforms();
 }
 
 void RobotState::setVariablePositions(const double* position)
@@ -353,8 +529,7 @@ void RobotState::setVariablePositions(const double* position)
   // the full state includes mimic joint values, so no need to update mimic here
 
   // Since all joint values have potentially changed, we will need to recompute all transforms
-  memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
-  dirty_link_transforms_ = robot_model_->getRootJoint();
+  markDirtyAllTransforms();
 }
 
 void RobotState::setVariablePositions(const std::map<std::string, double>& variable_map)
@@ -400,6 +575,28 @@ void RobotState::setVariablePositions(const std::vector<std::string>& variable_n
   }
 }
 
+void RobotState::setVariablePositions(const VariableLayout& layout, const double* position)
+{
+  const std::vector<int>& indices = layout.getVariableIndices();
+  const std::vector<const JointModel*>& joints = layout.getJointModels();
+  for (std::size_t i = 0; i < indices.size(); ++i)
+    if (indices[i] >= 0)
+    {
+      position_[indices[i]] = position[i];
+      markDirtyJointTransforms(joints[i]);
+      updateMimicJoint(joints[i]);
+    }
+}
+
+void RobotState::setVariableVelocities(const VariableLayout& layout, const double* velocity)
+{
+  markVelocity();
+  const std::vector<int>& indices = layout.getVariableIndices();
+  for (std::size_t i = 0; i < indices.size(); ++i)
+    if (indices[i] >= 0)
+      velocity_[indices[i]] = velocity[i];
+}
+
 void RobotState::setVariableVelocities(const std::map<std::string, double>& variable_map)
 {
   markVelocity();
@@ -469,6 +666,15 @@ void RobotState::setVariableEffort(const std::vector<std::string>& variable_name
     effort_[robot_model_->getVariableIndex(variable_names[i])] = variable_effort[i];
 }
 
+void RobotState::setVariableEffort(const VariableLayout& layout, const double* effort)
+{
+  markEffort();
+  const std::vector<int>& indices = layout.getVariableIndices();
+  for (std::size_t i = 0; i < indices.size(); ++i)
+    if (indices[i] >= 0)
+      effort_[indices[i]] = effort[i];
+}
+
 void RobotState::invertVelocity()
 {
   if (has_velocity_)
@@ -636,8 +842,7 @@ void RobotState::update(bool force)
   // make sure we do everything from scratch if needed
   if (force)
   {
-    memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
-    dirty_link_transforms_ = robot_model_->getRootJoint();
+    markDirtyAllTransforms();
   }
 
   // this actually triggers all needed updates
@@ -676,6 +881,8 @@ void RobotState::updateLinkTransforms()
 {
   if (dirty_link_transforms_ != nullptr)
   {
+    if (!transforms_memory_)
+      allocTransforms();
     updateLinkTransformsInternal(dirty_link_transforms_);
     if (dirty_collision_body_transforms_)
       dirty_collision_body_transforms_ =
@@ -688,35 +895,12 @@ void RobotState::updateLinkTransforms()
 
 void RobotState::updateLinkTransformsInternal(const JointModel* start)
 {
+  invalidateJacobianCache();
   for (const LinkModel* link : start->getDescendantLinkModels())
   {
-    int idx_link = link->getLinkIndex();
-    const LinkModel* parent = link->getParentLinkModel();
-    if (parent)  // root JointModel will not have a parent
-    {
-      int idx_parent = parent->getLinkIndex();
-      if (link->parentJointIsFixed())  // fixed joint
-        global_link_transforms_[idx_link].affine().noalias() =
-            global_link_transforms_[idx_parent].affine() * link->getJointOriginTransform().matrix();
-      else  // non-fixed joint
-      {
-        if (link->jointOriginTransformIsIdentity())  // Link has identity transform
-          global_link_transforms_[idx_link].affine().noalias() =
-              global_link_transforms_[idx_parent].affine() * getJointTransform(link->getParentJointModel()).matrix();
-        else  // Link has non-identity transform
-          global_link_transforms_[idx_link].affine().noalias() =
-              global_link_transforms_[idx_parent].affine() * link->getJointOriginTransform().matrix() *
-              getJointTransform(link->getParentJointModel()).matrix();
-      }
-    }
-    else  // is the origin / root / 'model frame'
-    {
-      if (link->jointOriginTransformIsIdentity())
-        global_link_transforms_[idx_link] = getJointTransform(link->getParentJointModel());
-      else
-        global_link_transforms_[idx_link].affine().noalias() =
-            link->getJointOriginTransform().affine() * getJointTransform(link->getParentJointModel()).matrix();
-    }
+    computeLinkTransform(link);
+    if (lazy_link_transforms_)
+      lazy_link_transforms_->link_epochs[link->getLinkIndex()] = lazy_link_transforms_->epoch;
   }
 
   // update attached bodies tf; these are usually very few, so we update them all
@@ -725,6 +909,86 @@ void RobotState::updateLinkTransformsInternal(const JointModel* start)
     it->second->computeTransform(global_link_transforms_[it->second->getAttachedLink()->getLinkIndex()]);
 }
 
+void RobotState::computeLinkTransform(const LinkModel* link)
+{
+  int idx_link = link->getLinkIndex();
+  const LinkModel* parent = link->getParentLinkModel();
+  if (parent)  // root JointModel will not have a parent
+  {
+    int idx_parent = parent->getLinkIndex();
+    if (link->parentJointIsFixed())  // fixed joint
+      global_link_transforms_[idx_link].affine().noalias() =
+          global_link_transforms_[idx_parent].affine() * link->getJointOriginTransform().matrix();
+    else  // non-fixed joint
+    {
+      if (link->jointOriginTransformIsIdentity())  // Link has identity transform
+        global_link_transforms_[idx_link].affine().noalias() =
+            global_link_transforms_[idx_parent].affine() * getJointTransform(link->getParentJointModel()).matrix();
+      else  // Link has non-identity transform
+        global_link_transforms_[idx_link].affine().noalias() =
+            global_link_transforms_[idx_parent].affine() * link->getJointOriginTransform().matrix() *
+            getJointTransform(link->getParentJointModel()).matrix();
+    }
+  }
+  else  // is the origin / root / 'model frame'
+  {
+    if (link->jointOriginTransformIsIdentity())
+      global_link_transforms_[idx_link] = getJointTransform(link->getParentJointModel());
+    else
+      global_link_transforms_[idx_link].affine().noalias() =
+          link->getJointOriginTransform().affine() * getJointTransform(link->getParentJointModel()).matrix();
+  }
+}
+
+void RobotState::setLazyLinkTransforms(bool lazy)
+{
+  if (!lazy)
+    lazy_link_transforms_.reset();
+  else if (!lazy_link_transforms_)
+  {
+    lazy_link_transforms_.reset(new LazyLinkTransforms());
+    resetLazyLinkTransforms();
+  }
+}
+
+void RobotState::resetLazyLinkTransforms()
+{
+  // links outside of the dirty subtree are up to date; all others are older than the change of its root
+  LazyLinkTransforms& lazy = *lazy_link_transforms_;
+  lazy.epoch = 1;
+  lazy.joint_epochs.assign(robot_model_->getJointModelCount(), 0);
+  lazy.link_epochs.assign(robot_model_->getLinkModelCount(), 0);
+  if (dirty_link_transforms_)
+    lazy.joint_epochs[dirty_link_transforms_->getJointIndex()] = lazy.epoch;
+}
+
+void RobotState::updateLinkTransform(const LinkModel* link)
+{
+  LazyLinkTransforms& lazy = *lazy_link_transforms_;
+  // nothing changed since the last update of this link
+  if (dirty_link_transforms_ == nullptr || lazy.link_epochs[link->getLinkIndex()] == lazy.epoch)
+    return;
+  if (!transforms_memory_)
+    allocTransforms();
+
+  lazy.path.clear();
+  for (const LinkModel* l = link; l; l = l->getParentLinkModel())
+    lazy.path.push_back(l);
+
+  // walk down from the root; once a link is out of date, so are all the links below it
+  std::size_t last_change = 0;
+  for (std::vector<const LinkModel*>::reverse_iterator it = lazy.path.rbegin(); it != lazy.path.rend(); ++it)
+  {
+    last_change = std::max(last_change, lazy.joint_epochs[(*it)->getParentJointModel()->getJointIndex()]);
+    std::size_t& link_epoch = lazy.link_epochs[(*it)->getLinkIndex()];
+    if (link_epoch < last_change)
+    {
+      computeLinkTransform(*it);
+      link_epoch = lazy.epoch;
+    }
+  }
+}
+
 void RobotState::updateStateWithLinkAt(const LinkModel* link, const Eigen::Isometry3d& transform, bool backward)
 {
   updateLinkTransforms();  // no link transforms must be dirty, otherwise the transform we set will be overwritten
@@ -736,6 +1000,7 @@ void RobotState::updateStateWithLinkAt(const LinkModel* link, const Eigen::Isome
   else
     dirty_collision_body_transforms_ = link->getParentJointModel();
 
+  invalidateJacobianCache();
   global_link_transforms_[link->getLinkIndex()] = transform;
 
   // update link transforms for descendant links only (leaving the transform for the current link untouched)
@@ -904,8 +1169,7 @@ void RobotState::interpolate(const RobotState& to, double t, RobotState& state)
 {
   robot_model_->interpolate(getVariablePositions(), to.getVariablePositions(), t, state.getVariablePositions());
 
-  memset(state.dirty_joint_transforms_, 1, state.robot_model_->getJointModelCount() * sizeof(unsigned char));
-  state.dirty_link_transforms_ = state.robot_model_->getRootJoint();
+  state.markDirtyAllTransforms();
 }
 
 void RobotState::interpolate(const RobotState& to, double t, RobotState& state, const JointModelGroup* joint_group) const
@@ -1244,6 +1508,44 @@ Eigen::MatrixXd RobotState::getJacobian(const JointModelGroup* group,
   return result;
 }
 
+Eigen::MatrixXd RobotState::getJacobian(const JointModelGroup* group, const Eigen::Vector3d& reference_point_position)
+{
+  Eigen::MatrixXd result;
+  if (!getJacobian(group, group->getLinkModels().back(), reference_point_position, result, false))
+    throw Exception("Unable to compute Jacobian");
+  return result;
+}
+
+bool RobotState::getJacobian(const JointModelGroup* group, const LinkModel* link,
+                             const Eigen::Vector3d& reference_point_position, Eigen::MatrixXd& jacobian,
+                             bool use_quaternion_representation)
+{
+  // updating the link transforms invalidates the cache if they change
+  updateLinkTransforms();
+  if (!jacobian_cache_)
+    jacobian_cache_.reset(new JacobianCache());
+
+  JacobianCache& cache = *jacobian_cache_;
+  if (cache.valid && cache.group == group && cache.link == link &&
+      cache.reference_point_position == reference_point_position &&
+      cache.use_quaternion_representation == use_quaternion_representation)
+  {
+    jacobian = cache.jacobian;
+    return true;
+  }
+
+  if (!static_cast<const RobotState*>(this)->getJacobian(group, link, reference_point_position, jacobian,
+                                                         use_quaternion_representation))
+    return false;
+  cache.valid = true;
+  cache.group = group;
+  cache.link = link;
+  cache.reference_point_position = reference_point_position;
+  cache.use_quaternion_representation = use_quaternion_representation;
+  cache.jacobian = jacobian;
+  return true;
+}
+
 bool RobotState::getJacobian(const JointModelGroup* group, const LinkModel* link,
                              const Eigen::Vector3d& reference_point_position, Eigen::MatrixXd& jacobian,
                              bool use_quaternion_representation) const
@@ -1263,6 +1565,17 @@ bool RobotState::getJacobian(const JointModelGroup* group, const LinkModel* link
     return false;
   }
 
+  // use the specialized kinematics of the chain if they end in this link
+  const ChainKinematicsConstPtr& chain_kinematics = group->getChainKinematics();
+  if (chain_kinematics && chain_kinematics->getTipLink() == link && !use_quaternion_representation)
+  {
+    std::vector<double> values;
+    copyJointGroupPositions(group, values);
+    Eigen::Isometry3d tip_transform;
+    chain_kinematics->computeJacobian(values.data(), reference_point_position, tip_transform, jacobian);
+    return true;
+  }
+
   const moveit::core::JointModel* root_joint_model = group->getJointModels()[0];  // group->getJointRoots()[0];
   const moveit::core::LinkModel* root_link_model = root_joint_model->getParentLinkModel();
   // getGlobalLinkTransform() returns a valid isometry by contract
@@ -1352,6 +1665,32 @@ bool RobotState::getJacobian(const JointModelGroup* group, const LinkModel* link
   return true;
 }
 
+bool RobotState::getJacobianDerivative(const JointModelGroup* group, const LinkModel* link,
+                                       const Eigen::Vector3d& reference_point_position, const Eigen::VectorXd& qdot,
+                                       Eigen::MatrixXd& jacobian_derivative) const
+{
+  BOOST_VERIFY(checkLinkTransforms());
+
+  if (qdot.size() != static_cast<Eigen::Index>(group->getVariableCount()))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Expected %u velocities for group '%s', but got %u", group->getVariableCount(),
+                    group->getName().c_str(), static_cast<unsigned int>(qdot.size()));
+    return false;
+  }
+
+  auto link_transform = [this](const LinkModel* l) -> const Eigen::Isometry3d& { return getGlobalLinkTransform(l); };
+  if (!computeChainJacobian(group, link, reference_point_position, link_transform, qdot.data(), nullptr,
+                            &jacobian_derivative))
+  {
+    ROS_ERROR_NAMED(LOGNAME,
+                    "Cannot compute the Jacobian derivative of link '%s' for group '%s', which needs to be a chain of "
+                    "revolute and prismatic joints updating the link",
+                    link->getName().c_str(), group->getName().c_str());
+    return false;
+  }
+  return true;
+}
+
 bool RobotState::setFromDiffIK(const JointModelGroup* jmg, const Eigen::VectorXd& twist, const std::string& tip,
                                double dt, const GroupStateValidityCallbackFn& constraint)
 {
@@ -1368,16 +1707,14 @@ bool RobotState::setFromDiffIK(const JointModelGroup* jmg, const geometry_msgs::
   return setFromDiffIK(jmg, t, tip, dt, constraint);
 }
 
-void RobotState::computeVariableVelocity(const JointModelGroup* jmg, Eigen::VectorXd& qdot,
-                                         const Eigen::VectorXd& twist, const LinkModel* tip) const
+namespace
+{
+// compute the variable velocities for a twist of the tip, given the Jacobian j of the tip origin
+void computeVariableVelocityFromJacobian(Eigen::MatrixXd& j, const Eigen::Isometry3d& tip_transform,
+                                         Eigen::VectorXd& qdot, const Eigen::VectorXd& twist)
 {
-  // Get the Jacobian of the group at the current configuration
-  Eigen::MatrixXd j(6, jmg->getVariableCount());
-  Eigen::Vector3d reference_point(0.0, 0.0, 0.0);
-  getJacobian(jmg, tip, reference_point, j, false);
-
   // Rotate the jacobian to the end-effector frame
-  Eigen::Isometry3d e_mb = getGlobalLinkTransform(tip).inverse();
+  Eigen::Isometry3d e_mb = tip_transform.inverse();
   Eigen::MatrixXd e_wb = Eigen::ArrayXXd::Zero(6, 6);
   e_wb.block(0, 0, 3, 3) = e_mb.matrix().block(0, 0, 3, 3);
   e_wb.block(3, 3, 3, 3) = e_mb.matrix().block(0, 0, 3, 3);
@@ -1408,6 +1745,27 @@ void RobotState::computeVariableVelocity(const JointModelGroup* jmg, Eigen::Vect
   // Compute joint velocity
   qdot = jinv * twist;
 }
+}  // namespace
+
+void RobotState::computeVariableVelocity(const JointModelGroup* jmg, Eigen::VectorXd& qdot,
+                                         const Eigen::VectorXd& twist, const LinkModel* tip) const
+{
+  // Get the Jacobian of the group at the current configuration
+  Eigen::MatrixXd j(6, jmg->getVariableCount());
+  Eigen::Vector3d reference_point(0.0, 0.0, 0.0);
+  getJacobian(jmg, tip, reference_point, j, false);
+  computeVariableVelocityFromJacobian(j, getGlobalLinkTransform(tip), qdot, twist);
+}
+
+void RobotState::computeVariableVelocity(const JointModelGroup* jmg, Eigen::VectorXd& qdot,
+                                         const Eigen::VectorXd& twist, const LinkModel* tip)
+{
+  // the non-const getJacobian() reuses the cached Jacobian if the state did not change
+  Eigen::MatrixXd j(6, jmg->getVariableCount());
+  Eigen::Vector3d reference_point(0.0, 0.0, 0.0);
+  getJacobian(jmg, tip, reference_point, j, false);
+  computeVariableVelocityFromJacobian(j, getGlobalLinkTransform(tip), qdot, twist);
+}
 
 bool RobotState::integrateVariableVelocity(const JointModelGroup* jmg, const Eigen::VectorXd& qdot, double dt,
                                            const GroupStateValidityCallbackFn& constraint)
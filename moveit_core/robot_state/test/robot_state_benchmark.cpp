@@ -35,6 +35,7 @@
 /* Author: Robert Haschke */
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_state/batch_forward_kinematics.h>
 #include <moveit/utils/robot_model_test_utils.h>
 #include <eigen_stl_containers/eigen_stl_containers.h>
 #include <gtest/gtest.h>
@@ -106,6 +107,62 @@ TEST_F(Timing, stateUpdate)
   }
 }
 
+TEST_F(Timing, batchForwardKinematics)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2_description");
+  ASSERT_TRUE(bool(model));
+  moveit::core::RobotState state(model);
+  state.setToDefaultValues();
+
+  const size_t num_states = 1000;
+  const size_t runs = 100;
+  for (const moveit::core::JointModelGroup* group : { model->getJointModelGroup("right_arm"),
+                                                       static_cast<const moveit::core::JointModelGroup*>(nullptr) })
+  {
+    const size_t num_variables = group ? group->getVariableCount() : model->getVariableCount();
+    Eigen::MatrixXd positions(num_states, num_variables);
+    std::vector<double> values;
+    for (size_t i = 0; i < num_states; ++i)
+    {
+      if (group)
+      {
+        state.setToRandomPositions(group);
+        state.copyJointGroupPositions(group, values);
+      }
+      else
+      {
+        state.setToRandomPositions();
+        values.assign(state.getVariablePositions(), state.getVariablePositions() + num_variables);
+      }
+      positions.row(i) = Eigen::Map<const Eigen::RowVectorXd>(values.data(), num_variables);
+    }
+
+    // the per-state path reads one configuration at a time
+    const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> rows = positions;
+
+    std::cerr << (group ? "right_arm" : "all variables") << std::endl;
+    double gold_standard = 0;
+    {
+      ScopedTimer t("RobotState updates: ", &gold_standard);
+      for (size_t run = 0; run < runs; ++run)
+        for (size_t i = 0; i < num_states; ++i)
+        {
+          if (group)
+            state.setJointGroupPositions(group, rows.row(i).data());
+          else
+            state.setVariablePositions(rows.row(i).data());
+          state.update();
+        }
+    }
+    moveit::core::BatchForwardKinematics fk(state, group);
+    {
+      ScopedTimer t("Batched forward kinematics: ", &gold_standard);
+      for (size_t run = 0; run < runs; ++run)
+        fk.compute(positions);
+    }
+  }
+}
+
 TEST_F(Timing, multiply)
 {
   size_t runs = 1e7;
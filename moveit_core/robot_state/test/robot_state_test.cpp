@@ -560,6 +560,229 @@ TEST_F(OneRobot, testPrintCurrentPositionWithJointLimits)
   state.printStatePositionsWithJointLimits(joint_model_group);
 }
 
+TEST_F(OneRobot, PositionsOnly)
+{
+  moveit::core::RobotState state(robot_model_);
+  state.setToRandomPositions();
+  state.update();
+
+  // a positions-only state computes the same transforms once they are needed
+  moveit::core::RobotState positions_only(robot_model_, true);
+  positions_only.setVariablePositions(state.getVariablePositions());
+  std::stringstream ss;
+  positions_only.printTransforms(ss);
+  EXPECT_EQ(ss.str(), "No transforms computed\n");
+
+  moveit::core::RobotState copy(positions_only);
+  positions_only.update();
+  copy.update();
+  for (const moveit::core::LinkModel* link : robot_model_->getLinkModels())
+  {
+    EXPECT_TRUE(positions_only.getGlobalLinkTransform(link).isApprox(state.getGlobalLinkTransform(link)));
+    EXPECT_TRUE(copy.getGlobalLinkTransform(link).isApprox(state.getGlobalLinkTransform(link)));
+  }
+
+  // copies of an updated state have up-to-date transforms
+  moveit::core::RobotState other(robot_model_, true);
+  other = positions_only;
+  EXPECT_FALSE(other.dirtyLinkTransforms());
+  const moveit::core::LinkModel* link = robot_model_->getLinkModels().back();
+  EXPECT_TRUE(other.getGlobalLinkTransform(link).isApprox(state.getGlobalLinkTransform(link)));
+}
+
+TEST_F(OneRobot, Arena)
+{
+  auto arena = std::make_shared<moveit::core::RobotStateArena>(*robot_model_, 2);
+  EXPECT_EQ(arena->getUsedBytes(), 0u);
+
+  moveit::core::RobotState reference(robot_model_);
+  reference.setToRandomPositions();
+  reference.update();
+
+  std::vector<moveit::core::RobotStatePtr> states;
+  states.push_back(std::make_shared<moveit::core::RobotState>(reference, arena));
+  EXPECT_GT(arena->getUsedBytes(), 0u);
+  // plain copies take their memory from the per-thread pool
+  const std::size_t used_bytes = arena->getUsedBytes();
+  moveit::core::RobotState copy(*states.back());
+  EXPECT_EQ(arena->getUsedBytes(), used_bytes);
+  // copies given the arena take their memory from it, until it is exhausted
+  for (std::size_t i = 0; i < 3; ++i)
+    states.push_back(std::make_shared<moveit::core::RobotState>(*states.back(), arena));
+  EXPECT_EQ(arena->getUsedBytes(), arena->getCapacity());
+
+  // the states keep the arena alive
+  std::weak_ptr<moveit::core::RobotStateArena> weak_arena = arena;
+  arena.reset();
+  EXPECT_FALSE(weak_arena.expired());
+  for (moveit::core::RobotStatePtr& state : states)
+  {
+    state->setToRandomPositions();
+    state->update();
+  }
+  const moveit::core::LinkModel* link = robot_model_->getLinkModels().back();
+  *states.front() = reference;
+  EXPECT_TRUE(states.front()->getGlobalLinkTransform(link).isApprox(reference.getGlobalLinkTransform(link)));
+  states.clear();
+
+  // but the copy does not
+  EXPECT_TRUE(weak_arena.expired());
+  copy.update();
+  EXPECT_TRUE(copy.getGlobalLinkTransform(link).isApprox(reference.getGlobalLinkTransform(link)));
+}
+
+TEST(LazyLinkTransforms, MatchFullUpdate)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2");
+  const moveit::core::JointModelGroup* left_arm = model->getJointModelGroup("left_arm");
+  const moveit::core::JointModelGroup* right_arm = model->getJointModelGroup("right_arm");
+  const moveit::core::LinkModel* left_tip = model->getLinkModel("l_wrist_roll_link");
+  const moveit::core::LinkModel* right_tip = model->getLinkModel("r_wrist_roll_link");
+
+  moveit::core::RobotState state(model);
+  state.setToRandomPositions();
+  state.setLazyLinkTransforms(true);
+  EXPECT_TRUE(state.hasLazyLinkTransforms());
+
+  moveit::core::RobotState expected(state);
+  expected.setLazyLinkTransforms(false);
+  for (std::size_t i = 0; i < 10; ++i)
+  {
+    state.setToRandomPositions(i % 2 ? left_arm : right_arm);
+    expected.setVariablePositions(state.getVariablePositions());
+    expected.update();
+
+    // only the requested tip is computed; the rest of the state stays dirty
+    EXPECT_TRUE(state.getGlobalLinkTransform(left_tip).isApprox(expected.getGlobalLinkTransform(left_tip)));
+    EXPECT_TRUE(state.dirtyLinkTransforms());
+    EXPECT_TRUE(state.getGlobalLinkTransform(right_tip).isApprox(expected.getGlobalLinkTransform(right_tip)));
+  }
+
+  // a full update brings all links up to date, and further changes are tracked again
+  state.update();
+  EXPECT_FALSE(state.dirtyLinkTransforms());
+  for (const moveit::core::LinkModel* link : model->getLinkModels())
+    EXPECT_TRUE(state.getGlobalLinkTransform(link).isApprox(expected.getGlobalLinkTransform(link))) << link->getName();
+  state.setToRandomPositions(left_arm);
+  expected.setVariablePositions(state.getVariablePositions());
+  expected.update();
+  EXPECT_TRUE(state.getGlobalLinkTransform(left_tip).isApprox(expected.getGlobalLinkTransform(left_tip)));
+
+  // copies keep the mode and the pending changes
+  moveit::core::RobotState copy(state);
+  EXPECT_TRUE(copy.hasLazyLinkTransforms());
+  for (const moveit::core::LinkModel* link : model->getLinkModels())
+    EXPECT_TRUE(copy.getGlobalLinkTransform(link).isApprox(expected.getGlobalLinkTransform(link))) << link->getName();
+}
+
+TEST(VariableLayout, SetVariableValues)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("panda");
+  moveit::core::RobotState expected(model);
+  expected.setToRandomPositions();
+
+  sensor_msgs::JointState msg;
+  for (const std::string& name : model->getVariableNames())
+  {
+    msg.name.push_back(name);
+    msg.position.push_back(expected.getVariablePosition(name));
+  }
+  std::reverse(msg.name.begin(), msg.name.end());
+  std::reverse(msg.position.begin(), msg.position.end());
+  msg.name.push_back("unknown_joint");
+  msg.position.push_back(1.0);
+
+  moveit::core::VariableLayout layout(*model, msg.name);
+  moveit::core::RobotState state(model);
+  state.setToDefaultValues();
+  state.setVariableValues(msg, layout);
+  for (const std::string& name : model->getVariableNames())
+    EXPECT_EQ(state.getVariablePosition(name), expected.getVariablePosition(name)) << name;
+  EXPECT_FALSE(state.hasVelocities());
+
+  state.update();
+  expected.update();
+  const moveit::core::LinkModel* link = model->getLinkModels().back();
+  EXPECT_TRUE(state.getGlobalLinkTransform(link).isApprox(expected.getGlobalLinkTransform(link)));
+}
+
+TEST(Jacobian, Cache)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("panda");
+  const moveit::core::JointModelGroup* group = model->getJointModelGroup("panda_arm");
+  const moveit::core::LinkModel* link = model->getLinkModel("panda_link8");
+  const Eigen::Vector3d reference_point(0.0, 0.0, 0.1);
+
+  moveit::core::RobotState state(model);
+  state.setToRandomPositions();
+  Eigen::MatrixXd jacobian;
+  Eigen::MatrixXd cached;
+  ASSERT_TRUE(state.getJacobian(group, link, reference_point, jacobian));
+  ASSERT_TRUE(state.getJacobian(group, link, reference_point, cached));
+  EXPECT_EQ(jacobian, cached);
+
+  // changing the state or the arguments must not return the cached Jacobian
+  for (std::size_t i = 0; i < 10; ++i)
+  {
+    state.setToRandomPositions(group);
+    moveit::core::RobotState copy(state);
+    copy.update();
+    const moveit::core::RobotState& reference = copy;  // the const getJacobian() does not cache
+    ASSERT_TRUE(state.getJacobian(group, link, reference_point, cached));
+    ASSERT_TRUE(reference.getJacobian(group, link, reference_point, jacobian));
+    EXPECT_TRUE(cached.isApprox(jacobian));
+    ASSERT_TRUE(state.getJacobian(group, link, Eigen::Vector3d::Zero(), cached));
+    ASSERT_TRUE(reference.getJacobian(group, link, Eigen::Vector3d::Zero(), jacobian));
+    EXPECT_TRUE(cached.isApprox(jacobian));
+  }
+
+  // assigning another state replaces the cached Jacobian
+  moveit::core::RobotState other(model);
+  other.setToRandomPositions(group);
+  other.update();
+  state = other;
+  ASSERT_TRUE(state.getJacobian(group, link, Eigen::Vector3d::Zero(), cached));
+  ASSERT_TRUE(static_cast<const moveit::core::RobotState&>(other).getJacobian(group, link, Eigen::Vector3d::Zero(),
+                                                                                jacobian));
+  EXPECT_TRUE(cached.isApprox(jacobian));
+}
+
+TEST(Jacobian, Derivative)
+{
+  moveit::core::RobotModelPtr model = moveit::core::loadTestingRobotModel("panda");
+  const moveit::core::JointModelGroup* group = model->getJointModelGroup("panda_arm");
+  const moveit::core::LinkModel* link = model->getLinkModel("panda_link8");
+  const Eigen::Vector3d reference_point(0.1, -0.05, 0.2);
+  const double h = 1e-6;
+
+  moveit::core::RobotState state(model);
+  for (std::size_t i = 0; i < 10; ++i)
+  {
+    state.setToRandomPositions(group);
+    Eigen::VectorXd q;
+    state.copyJointGroupPositions(group, q);
+    const Eigen::VectorXd qdot = Eigen::VectorXd::Random(group->getVariableCount());
+
+    Eigen::MatrixXd jacobian_derivative;
+    ASSERT_TRUE(state.getJacobianDerivative(group, link, reference_point, qdot, jacobian_derivative));
+
+    // compare against central differences along the velocity
+    Eigen::MatrixXd jacobian_forward;
+    Eigen::MatrixXd jacobian_backward;
+    state.setJointGroupPositions(group, q + h * qdot);
+    ASSERT_TRUE(state.getJacobian(group, link, reference_point, jacobian_forward));
+    state.setJointGroupPositions(group, q - h * qdot);
+    ASSERT_TRUE(state.getJacobian(group, link, reference_point, jacobian_backward));
+    const Eigen::MatrixXd expected = (jacobian_forward - jacobian_backward) / (2.0 * h);
+    EXPECT_LT((jacobian_derivative - expected).cwiseAbs().maxCoeff(), 1e-6) << jacobian_derivative << "\n"
+                                                                             << expected;
+  }
+
+  Eigen::MatrixXd jacobian_derivative;
+  EXPECT_FALSE(state.getJacobianDerivative(group, link, reference_point, Eigen::VectorXd::Zero(3),
+                                           jacobian_derivative));
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,140 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_state/batch_forward_kinematics.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <gtest/gtest.h>
+
+using namespace moveit::core;
+
+static const std::size_t NUM_STATES = 50;
+
+// compare the batched transforms of all links against RobotState::update()
+static void checkBatch(const RobotState& reference, const JointModelGroup* group)
+{
+  BatchForwardKinematics fk(reference, group);
+  const std::size_t num_variables = group ? group->getVariableCount() : reference.getVariableCount();
+  ASSERT_EQ(fk.getVariableCount(), num_variables);
+
+  std::vector<RobotState> states(NUM_STATES, reference);
+  Eigen::MatrixXd positions(NUM_STATES, num_variables);
+  for (std::size_t i = 0; i < NUM_STATES; ++i)
+  {
+    std::vector<double> values;
+    if (group)
+    {
+      states[i].setToRandomPositions(group);
+      states[i].copyJointGroupPositions(group, values);
+    }
+    else
+    {
+      states[i].setToRandomPositions();
+      values.assign(states[i].getVariablePositions(), states[i].getVariablePositions() + num_variables);
+    }
+    states[i].update();
+    positions.row(i) = Eigen::Map<const Eigen::RowVectorXd>(values.data(), num_variables);
+  }
+
+  fk.compute(positions);
+  ASSERT_EQ(fk.getStateCount(), NUM_STATES);
+  for (std::size_t i = 0; i < NUM_STATES; ++i)
+    for (const LinkModel* link : reference.getRobotModel()->getLinkModels())
+    {
+      const Eigen::Isometry3d& expected = states[i].getGlobalLinkTransform(link);
+      EXPECT_TRUE(fk.getGlobalLinkTransform(link, i).isApprox(expected, 1e-10))
+          << link->getName() << " in state " << i;
+    }
+}
+
+TEST(BatchForwardKinematics, AllVariables)
+{
+  RobotModelPtr model = loadTestingRobotModel("pr2");
+  RobotState reference(model);
+  reference.setToDefaultValues();
+  checkBatch(reference, nullptr);
+}
+
+TEST(BatchForwardKinematics, Group)
+{
+  RobotModelPtr model = loadTestingRobotModel("pr2");
+  RobotState reference(model);
+  reference.setToRandomPositions();
+  for (const char* name : { "right_arm", "arms", "whole_body" })
+  {
+    const JointModelGroup* group = model->getJointModelGroup(name);
+    ASSERT_TRUE(group) << name;
+    checkBatch(reference, group);
+  }
+}
+
+TEST(BatchForwardKinematics, MimicJoints)
+{
+  RobotModelPtr model = loadTestingRobotModel("panda");
+  RobotState reference(model);
+  reference.setToDefaultValues();
+  const JointModelGroup* group = model->getJointModelGroup("hand");
+  ASSERT_TRUE(group);
+  ASSERT_FALSE(model->getMimicJointModels().empty());
+  checkBatch(reference, group);
+  checkBatch(reference, nullptr);
+}
+
+TEST(BatchForwardKinematics, LinkTransformLayout)
+{
+  RobotModelPtr model = loadTestingRobotModel("panda");
+  RobotState state(model);
+  state.setToRandomPositions();
+  state.update();
+  const JointModelGroup* group = model->getJointModelGroup("panda_arm");
+
+  std::vector<double> values;
+  state.copyJointGroupPositions(group, values);
+  BatchForwardKinematics fk(state, group);
+  fk.compute(Eigen::Map<const Eigen::RowVectorXd>(values.data(), values.size()));
+
+  const LinkModel* link = model->getLinkModel("panda_link8");
+  const Eigen::Isometry3d& expected = state.getGlobalLinkTransform(link);
+  Eigen::Ref<const Eigen::MatrixXd> transforms = fk.getGlobalLinkTransforms(link);
+  ASSERT_EQ(transforms.rows(), 1);
+  ASSERT_EQ(transforms.cols(), 12);
+  for (int col = 0; col < 4; ++col)
+    for (int row = 0; row < 3; ++row)
+      EXPECT_NEAR(transforms(0, 3 * col + row), expected(row, col), 1e-10);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
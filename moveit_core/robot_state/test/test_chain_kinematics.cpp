@@ -0,0 +1,179 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_model/chain_kinematics.h>
+#include <moveit/robot_state/robot_state.h>
+#include <moveit/exceptions/exceptions.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <gtest/gtest.h>
+
+using namespace moveit::core;
+
+// generated by moveit_generate_chain_kinematics at build time, see CMakeLists.txt
+void pandaArmKinematics(const double* values, double* transform, double* jacobian);
+
+static const std::size_t NUM_STATES = 50;
+
+// compare the chain against RobotState, with and without the chain assigned to the group
+static void checkChain(const RobotModelPtr& model, const std::string& group_name, const std::string& tip_name)
+{
+  JointModelGroup* group = model->getJointModelGroup(group_name);
+  const LinkModel* tip = model->getLinkModel(tip_name);
+  ASSERT_TRUE(group && tip);
+  auto chain = std::make_shared<ChainKinematics>(group, tip);
+  ASSERT_EQ(chain->getTipLink(), tip);
+  ASSERT_EQ(chain->getBaseLink(), group->getJointModels()[0]->getParentLinkModel());
+
+  const Eigen::Vector3d reference_point(0.1, -0.2, 0.05);
+  RobotState state(model);
+  for (std::size_t i = 0; i < NUM_STATES; ++i)
+  {
+    state.setToRandomPositions();
+    state.update();
+    std::vector<double> values;
+    state.copyJointGroupPositions(group, values);
+
+    Eigen::Isometry3d expected_transform = state.getGlobalLinkTransform(tip);
+    if (chain->getBaseLink())
+      expected_transform = state.getGlobalLinkTransform(chain->getBaseLink()).inverse() * expected_transform;
+    Eigen::Isometry3d transform;
+    chain->computeTransform(values.data(), transform);
+    EXPECT_TRUE(transform.isApprox(expected_transform, 1e-10)) << "state " << i;
+
+    for (const Eigen::Vector3d& point : { Eigen::Vector3d::Zero().eval(), reference_point })
+    {
+      Eigen::MatrixXd expected_jacobian;
+      group->setChainKinematics(ChainKinematicsConstPtr());
+      ASSERT_TRUE(state.getJacobian(group, tip, point, expected_jacobian));
+
+      Eigen::MatrixXd jacobian;
+      chain->computeJacobian(values.data(), point, transform, jacobian);
+      EXPECT_TRUE(transform.isApprox(expected_transform, 1e-10)) << "state " << i;
+      EXPECT_TRUE(jacobian.isApprox(expected_jacobian, 1e-10)) << "state " << i << "\n"
+                                                               << jacobian << "\n"
+                                                               << expected_jacobian;
+
+      // RobotState uses the chain once it is assigned to the group
+      group->setChainKinematics(chain);
+      ASSERT_TRUE(state.getJacobian(group, tip, point, jacobian));
+      EXPECT_TRUE(jacobian.isApprox(expected_jacobian, 1e-10)) << "state " << i;
+    }
+  }
+  group->setChainKinematics(ChainKinematicsConstPtr());
+}
+
+TEST(ChainKinematics, Panda)
+{
+  RobotModelPtr model = loadTestingRobotModel("panda");
+  checkChain(model, "panda_arm", "panda_link8");
+  checkChain(model, "panda_arm", "panda_link4");
+}
+
+TEST(ChainKinematics, PR2)
+{
+  RobotModelPtr model = loadTestingRobotModel("pr2");
+  checkChain(model, "right_arm", "r_wrist_roll_link");
+  checkChain(model, "left_arm", "l_forearm_link");
+}
+
+TEST(ChainKinematics, InvalidChain)
+{
+  RobotModelPtr model = loadTestingRobotModel("pr2");
+  EXPECT_THROW(ChainKinematics(model->getJointModelGroup("arms"), model->getLinkModel("r_wrist_roll_link")),
+               moveit::ConstructException);
+  EXPECT_THROW(ChainKinematics(model->getJointModelGroup("right_arm"), model->getLinkModel("l_wrist_roll_link")),
+               moveit::ConstructException);
+}
+
+TEST(ChainKinematics, GenerateSource)
+{
+  RobotModelPtr model = loadTestingRobotModel("panda");
+  ChainKinematics chain(model->getJointModelGroup("panda_arm"), model->getLinkModel("panda_link8"));
+  const std::string source = chain.generateSource("pandaArmKinematics");
+  EXPECT_NE(source.find("void pandaArmKinematics(const double* values, double* transform, double* jacobian)"),
+            std::string::npos);
+  // all joints of the panda rotate about the z axis of their frame, so no general rotation is needed
+  EXPECT_EQ(source.find("Rodrigues"), std::string::npos);
+  EXPECT_EQ(source.find("virtual"), std::string::npos);
+}
+
+TEST(ChainKinematics, GeneratedKernel)
+{
+  RobotModelPtr model = loadTestingRobotModel("panda");
+  JointModelGroup* group = model->getJointModelGroup("panda_arm");
+  const LinkModel* tip = model->getLinkModel("panda_link8");
+  auto chain = std::make_shared<ChainKinematics>(group, tip);
+  chain->setKernel(&pandaArmKinematics);
+
+  RobotState state(model);
+  for (std::size_t i = 0; i < NUM_STATES; ++i)
+  {
+    state.setToRandomPositions();
+    state.update();
+    std::vector<double> values;
+    state.copyJointGroupPositions(group, values);
+
+    const Eigen::Isometry3d expected_transform =
+        state.getGlobalLinkTransform(chain->getBaseLink()).inverse() * state.getGlobalLinkTransform(tip);
+    Eigen::MatrixXd expected_jacobian;
+    ASSERT_TRUE(state.getJacobian(group, tip, Eigen::Vector3d::Zero(), expected_jacobian));
+
+    // the kernel itself
+    Eigen::Matrix4d transform;
+    Eigen::MatrixXd jacobian(6, values.size());
+    pandaArmKinematics(values.data(), transform.data(), jacobian.data());
+    EXPECT_TRUE(transform.isApprox(expected_transform.matrix(), 1e-10)) << "state " << i << "\n"
+                                                                       << transform << "\n"
+                                                                       << expected_transform.matrix();
+    EXPECT_TRUE(jacobian.isApprox(expected_jacobian, 1e-10)) << "state " << i << "\n"
+                                                             << jacobian << "\n"
+                                                             << expected_jacobian;
+    pandaArmKinematics(values.data(), transform.data(), nullptr);
+    EXPECT_TRUE(transform.isApprox(expected_transform.matrix(), 1e-10)) << "state " << i;
+
+    // the kernel plugged into the chain, also for a point off the tip origin
+    const Eigen::Vector3d point(0.1, -0.2, 0.05);
+    ASSERT_TRUE(state.getJacobian(group, tip, point, expected_jacobian));
+    Eigen::Isometry3d chain_transform;
+    chain->computeJacobian(values.data(), point, chain_transform, jacobian);
+    EXPECT_TRUE(chain_transform.isApprox(expected_transform, 1e-10)) << "state " << i;
+    EXPECT_TRUE(jacobian.isApprox(expected_jacobian, 1e-10)) << "state " << i;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
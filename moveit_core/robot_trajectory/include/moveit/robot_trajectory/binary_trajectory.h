@@ -0,0 +1,73 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_trajectory/columnar_trajectory.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <ostream>
+#include <string>
+
+namespace robot_trajectory
+{
+/** \brief Write \e trajectory to \e out in the binary trajectory format.
+
+    The format stores the reference state, the names of the group variables and the matrices of the trajectory as
+    contiguous arrays, so loading a trajectory from a memory-mapped file copies them in bulk instead of parsing each
+    value. Files are versioned and use the byte order of the machine writing them; see moveit/utils/binary_io.h.
+    @return False if writing failed */
+bool saveTrajectoryToBinary(const ColumnarTrajectory& trajectory, std::ostream& out);
+
+/** \brief Write \e trajectory to the file at \e path in the binary trajectory format */
+bool saveTrajectoryToBinaryFile(const ColumnarTrajectory& trajectory, const std::string& path);
+
+/** \brief Write \e trajectory, which needs to have a group and at least one waypoint, to the file at \e path in the
+    binary trajectory format */
+bool saveTrajectoryToBinaryFile(const RobotTrajectory& trajectory, const std::string& path);
+
+/** \brief Construct a trajectory from \e size bytes of the binary trajectory format at \e data, which need to be
+    aligned to eight bytes. The trajectory needs to be for \e robot_model.
+    @return The trajectory, or nullptr if the data is not a valid trajectory for the model */
+ColumnarTrajectoryPtr loadTrajectoryFromBinary(const moveit::core::RobotModelConstPtr& robot_model, const void* data,
+                                               std::size_t size);
+
+/** \brief Map the file at \e path into memory and construct the trajectory from it
+    @return The trajectory, or nullptr if the file is not a valid trajectory for the model */
+ColumnarTrajectoryPtr loadTrajectoryFromBinaryFile(const moveit::core::RobotModelConstPtr& robot_model,
+                                                   const std::string& path);
+
+/** \brief Replace the content of \e trajectory with the trajectory in the file at \e path, which needs to be for the
+    robot model of \e trajectory */
+bool loadTrajectoryFromBinaryFile(const std::string& path, RobotTrajectory& trajectory);
+}  // namespace robot_trajectory
@@ -0,0 +1,205 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit_msgs/RobotTrajectory.h>
+#include <Eigen/Core>
+#include <vector>
+
+namespace robot_trajectory
+{
+MOVEIT_CLASS_FORWARD(ColumnarTrajectory);  // Defines ColumnarTrajectoryPtr, ConstPtr, WeakPtr... etc
+
+/** \brief A trajectory of a joint model group, stored as contiguous matrices instead of one RobotState per waypoint.
+
+    The positions, velocities and accelerations of the variables of the group are kept column-major, with one column
+    per waypoint, together with the time of each waypoint from the start. Variables outside of the group are the same
+    for all waypoints and taken from a single reference state. RobotStates are only materialized on demand, so long
+    and dense trajectories need a fraction of the memory of a RobotTrajectory and convert to and from messages in
+    bulk. */
+class ColumnarTrajectory
+{
+public:
+  /** \brief Construct an empty trajectory for \e group, taking the variables outside of it from \e reference_state */
+  ColumnarTrajectory(const moveit::core::RobotState& reference_state, const moveit::core::JointModelGroup* group);
+
+  /** \brief Copy \e trajectory, which needs to have a group and at least one waypoint. Variables outside of the group
+      are taken from its first waypoint. */
+  explicit ColumnarTrajectory(const RobotTrajectory& trajectory);
+
+  const moveit::core::RobotModelConstPtr& getRobotModel() const
+  {
+    return reference_state_.getRobotModel();
+  }
+
+  const moveit::core::JointModelGroup* getGroup() const
+  {
+    return group_;
+  }
+
+  const moveit::core::RobotState& getReferenceState() const
+  {
+    return reference_state_;
+  }
+
+  /** \brief The number of rows of the matrices, i.e. the number of variables of the group */
+  std::size_t getVariableCount() const
+  {
+    return variable_count_;
+  }
+
+  std::size_t getWayPointCount() const
+  {
+    return time_from_start_.size();
+  }
+
+  bool empty() const
+  {
+    return time_from_start_.empty();
+  }
+
+  bool hasVelocities() const
+  {
+    return !velocities_.empty();
+  }
+
+  bool hasAccelerations() const
+  {
+    return !accelerations_.empty();
+  }
+
+  /** \brief Reserve memory for \e count waypoints */
+  void reserve(std::size_t count);
+
+  void clear();
+
+  /** \brief Add the values of the group variables of \e state as a waypoint, \e dt after the last one */
+  void addSuffixWayPoint(const moveit::core::RobotState& state, double dt);
+
+  /** \brief Add a waypoint \e dt after the last one, from arrays of getVariableCount() values in the order of the group
+      variables. \e velocities and \e accelerations may be nullptr. */
+  void addSuffixWayPoint(const double* positions, const double* velocities, const double* accelerations, double dt);
+
+  /** \brief Replace all waypoints with \e count waypoints given as arrays with one column per waypoint, in the layout
+      of getPositions(), and the times from start. \e velocities and \e accelerations may be nullptr. */
+  void setWayPoints(std::size_t count, const double* times_from_start, const double* positions,
+                    const double* velocities, const double* accelerations);
+
+  /** \brief The positions as a matrix with one column per waypoint */
+  Eigen::Map<const Eigen::MatrixXd> getPositions() const
+  {
+    return Eigen::Map<const Eigen::MatrixXd>(positions_.data(), variable_count_, getWayPointCount());
+  }
+
+  Eigen::Map<Eigen::MatrixXd> getPositions()
+  {
+    return Eigen::Map<Eigen::MatrixXd>(positions_.data(), variable_count_, getWayPointCount());
+  }
+
+  /** \brief The velocities as a matrix with one column per waypoint; empty without velocities */
+  Eigen::Map<const Eigen::MatrixXd> getVelocities() const
+  {
+    return Eigen::Map<const Eigen::MatrixXd>(velocities_.data(), variable_count_,
+                                             hasVelocities() ? getWayPointCount() : 0);
+  }
+
+  Eigen::Map<Eigen::MatrixXd> getVelocities()
+  {
+    return Eigen::Map<Eigen::MatrixXd>(velocities_.data(), variable_count_, hasVelocities() ? getWayPointCount() : 0);
+  }
+
+  /** \brief The accelerations as a matrix with one column per waypoint; empty without accelerations */
+  Eigen::Map<const Eigen::MatrixXd> getAccelerations() const
+  {
+    return Eigen::Map<const Eigen::MatrixXd>(accelerations_.data(), variable_count_,
+                                             hasAccelerations() ? getWayPointCount() : 0);
+  }
+
+  Eigen::Map<Eigen::MatrixXd> getAccelerations()
+  {
+    return Eigen::Map<Eigen::MatrixXd>(accelerations_.data(), variable_count_,
+                                       hasAccelerations() ? getWayPointCount() : 0);
+  }
+
+  /** \brief The time of each waypoint from the start of the trajectory */
+  const std::vector<double>& getTimesFromStart() const
+  {
+    return time_from_start_;
+  }
+
+  double getWayPointDurationFromStart(std::size_t index) const
+  {
+    return time_from_start_[index];
+  }
+
+  double getDuration() const
+  {
+    return time_from_start_.empty() ? 0.0 : time_from_start_.back();
+  }
+
+  /** \brief Set the group variables of \e state to the waypoint at \e index. Velocities and accelerations are only
+      set if the trajectory has them; variables outside of the group are left untouched. */
+  void getWayPoint(std::size_t index, moveit::core::RobotState& state) const;
+
+  /** \brief Materialize the waypoint at \e index as a new state, based on the reference state */
+  moveit::core::RobotStatePtr createWayPoint(std::size_t index) const;
+
+  /** \brief Materialize all waypoints into \e trajectory, replacing its content */
+  void getRobotTrajectory(RobotTrajectory& trajectory) const;
+
+  /** \brief Fill \e trajectory with the active joints of the group, in the format of
+      RobotTrajectory::getRobotTrajectoryMsg() */
+  void getRobotTrajectoryMsg(moveit_msgs::RobotTrajectory& trajectory) const;
+
+  /** \brief Replace the content of this trajectory with \e trajectory. Group variables that are not part of the
+      message keep the values of the reference state; joints that are not part of the group are ignored. */
+  void setRobotTrajectoryMsg(const moveit_msgs::RobotTrajectory& trajectory);
+
+private:
+  /** \brief Set the mimic variables of the group in the last waypoint from the variables they mimic */
+  void updateMimicVariables();
+
+  moveit::core::RobotState reference_state_;
+  const moveit::core::JointModelGroup* group_;
+  std::size_t variable_count_;
+
+  std::vector<double> positions_;
+  std::vector<double> velocities_;
+  std::vector<double> accelerations_;
+  std::vector<double> time_from_start_;
+};
+}  // namespace robot_trajectory
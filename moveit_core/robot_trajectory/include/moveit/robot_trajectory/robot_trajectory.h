@@ -41,6 +41,7 @@
 #include <moveit_msgs/RobotTrajectory.h>
 #include <moveit_msgs/RobotState.h>
 #include <deque>
+#include <vector>
 
 namespace robot_trajectory
 {
@@ -134,12 +135,10 @@ public:
       return 0.0;
   }
 
-  void setWayPointDurationFromPrevious(std::size_t index, double value)
-  {
-    if (duration_from_previous_.size() <= index)
-      duration_from_previous_.resize(index + 1, 0.0);
-    duration_from_previous_[index] = value;
-  }
+  /** @brief Set the duration of waypoint \e index from the previous one. Setting the durations in increasing order
+   *  of \e index keeps the durations from start up to date at no extra cost.
+   */
+  void setWayPointDurationFromPrevious(std::size_t index, double value);
 
   bool empty() const
   {
@@ -166,6 +165,7 @@ public:
     state->update();
     waypoints_.push_back(state);
     duration_from_previous_.push_back(dt);
+    updateDurationsFromStart(duration_from_previous_.size() - 1);
   }
 
   void addPrefixWayPoint(const moveit::core::RobotState& state, double dt)
@@ -178,6 +178,7 @@ public:
     state->update();
     waypoints_.push_front(state);
     duration_from_previous_.push_front(dt);
+    updateDurationsFromStart(0);
   }
 
   void insertWayPoint(std::size_t index, const moveit::core::RobotState& state, double dt)
@@ -190,6 +191,7 @@ public:
     state->update();
     waypoints_.insert(waypoints_.begin() + index, state);
     duration_from_previous_.insert(duration_from_previous_.begin() + index, dt);
+    updateDurationsFromStart(index);
   }
 
   /**
@@ -249,7 +251,7 @@ public:
   void unwind();
   void unwind(const moveit::core::RobotState& state);
 
-  /** @brief Finds the waypoint indicies before and after a duration from start.
+  /** @brief Finds the waypoint indicies before and after a duration from start, by binary search.
    *  @param The duration from start.
    *  @param The waypoint index before the supplied duration.
    *  @param The waypoint index after (or equal to) the supplied duration.
@@ -266,10 +268,80 @@ public:
    */
   bool getStateAtDurationFromStart(const double request_duration, moveit::core::RobotStatePtr& output_state) const;
 
+  /** @brief Computes the Jacobian of the group of this trajectory at every waypoint, with forward kinematics for all
+   * waypoints computed in one batched pass. Variables outside the group are taken from the first waypoint.
+   *  @param The link the reference point is attached to. The group must be a chain of revolute and prismatic joints
+   *  that updates it.
+   *  @param The reference point position, in the frame of the link.
+   *  @param The resulting Jacobians, one per waypoint, as computed by RobotState::getJacobian().
+   *  @param If not nullptr, the resulting time derivatives of the Jacobians for the velocities of the waypoints (zero
+   *  for waypoints without velocities), as computed by RobotState::getJacobianDerivative().
+   *  @return True if the Jacobians were computed, false otherwise (the trajectory has no group or it is not suitable).
+   */
+  bool getJacobians(const moveit::core::LinkModel* link, const Eigen::Vector3d& reference_point_position,
+                    std::vector<Eigen::MatrixXd>& jacobians,
+                    std::vector<Eigen::MatrixXd>* jacobian_derivatives = nullptr) const;
+
 private:
+  /** @brief Recompute the durations from start of all waypoints from \e index on */
+  void updateDurationsFromStart(std::size_t index);
+
   moveit::core::RobotModelConstPtr robot_model_;
   const moveit::core::JointModelGroup* group_;
   std::deque<moveit::core::RobotStatePtr> waypoints_;
   std::deque<double> duration_from_previous_;
+
+  /** @brief The running sums of duration_from_previous_; only the first valid_durations_from_start_ are up to date,
+   *  which is all of them unless durations were set out of order */
+  std::vector<double> durations_from_start_;
+  std::size_t valid_durations_from_start_ = 0;
+};
+
+/** @brief Samples a trajectory at a fixed period in a single forward pass.
+ *
+ *  Sampling with RobotTrajectory::getStateAtDurationFromStart() searches the waypoints for every sample. The sampler
+ *  instead walks the waypoints along with the sample times and writes each sample into a state provided by the
+ *  caller, without allocating memory. The samples are taken at multiples of the period after the start time, followed
+ *  by a final sample at the end of the trajectory. The trajectory must outlive the sampler and not be modified while
+ *  sampling.
+ */
+class RobotTrajectorySampler
+{
+public:
+  /** @param trajectory The trajectory to sample
+   *  @param period The time between samples; needs to be positive
+   *  @param start_time The duration from start of the first sample
+   */
+  RobotTrajectorySampler(const RobotTrajectory& trajectory, double period, double start_time = 0.0);
+
+  /** @brief Write the next sample into \e state, interpolating the positions linearly in time. Variables outside of
+   *  the group of the trajectory are interpolated as well.
+   *  @return False if there are no more samples (or the trajectory is empty), leaving \e state untouched
+   */
+  bool next(moveit::core::RobotState& state);
+
+  /** @brief Check if all samples were taken */
+  bool done() const
+  {
+    return done_;
+  }
+
+  /** @brief The duration from start of the next sample */
+  double getTime() const
+  {
+    return time_;
+  }
+
+private:
+  const RobotTrajectory& trajectory_;
+  double period_;
+  double start_time_;
+  std::size_t sample_count_;  ///< The number of samples taken so far
+  double time_;
+  bool done_;
+
+  double duration_;
+  std::size_t index_;  ///< The first waypoint reached at or after time_, or the last one
+  double index_time_;  ///< The duration from start of waypoint index_
 };
 }  // namespace robot_trajectory
@@ -0,0 +1,197 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_trajectory/binary_trajectory.h>
+#include <moveit/utils/binary_io.h>
+#include <fstream>
+#include <limits>
+
+namespace robot_trajectory
+{
+namespace
+{
+const char* const LOGNAME = "robot_trajectory";
+const char* const MAGIC = "MOVEITTJ";
+const std::uint32_t VERSION = 1;
+
+const std::uint32_t HAS_VELOCITIES = 1;
+const std::uint32_t HAS_ACCELERATIONS = 2;
+}  // namespace
+
+bool saveTrajectoryToBinary(const ColumnarTrajectory& trajectory, std::ostream& out)
+{
+  moveit::core::BinaryWriter writer(out);
+  writer.writeHeader(MAGIC, VERSION);
+  writer.writeString(trajectory.getRobotModel()->getName());
+  writer.writeString(trajectory.getGroup()->getName());
+
+  const moveit::core::RobotState& reference_state = trajectory.getReferenceState();
+  writer.write<std::uint64_t>(reference_state.getVariableCount());
+  writer.write(reference_state.getVariablePositions(), reference_state.getVariableCount());
+
+  const std::vector<std::string>& variable_names = trajectory.getGroup()->getVariableNames();
+  writer.write<std::uint64_t>(variable_names.size());
+  for (const std::string& name : variable_names)
+    writer.writeString(name);
+
+  const std::size_t values = trajectory.getWayPointCount() * trajectory.getVariableCount();
+  writer.write<std::uint64_t>(trajectory.getWayPointCount());
+  writer.write<std::uint32_t>((trajectory.hasVelocities() ? HAS_VELOCITIES : 0) |
+                              (trajectory.hasAccelerations() ? HAS_ACCELERATIONS : 0));
+  writer.write(trajectory.getTimesFromStart().data(), trajectory.getWayPointCount());
+  writer.write(trajectory.getPositions().data(), values);
+  if (trajectory.hasVelocities())
+    writer.write(trajectory.getVelocities().data(), values);
+  if (trajectory.hasAccelerations())
+    writer.write(trajectory.getAccelerations().data(), values);
+  return writer.good();
+}
+
+bool saveTrajectoryToBinaryFile(const ColumnarTrajectory& trajectory, const std::string& path)
+{
+  std::ofstream out(path, std::ios::binary);
+  if (!saveTrajectoryToBinary(trajectory, out))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Failed to write trajectory to '%s'", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool saveTrajectoryToBinaryFile(const RobotTrajectory& trajectory, const std::string& path)
+{
+  return saveTrajectoryToBinaryFile(ColumnarTrajectory(trajectory), path);
+}
+
+ColumnarTrajectoryPtr loadTrajectoryFromBinary(const moveit::core::RobotModelConstPtr& robot_model, const void* data,
+                                               std::size_t size)
+{
+  moveit::core::BinaryReader reader(data, size);
+  std::uint32_t version;
+  if (!reader.readHeader(MAGIC, VERSION, version))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Data is not in a supported version of the binary trajectory format");
+    return ColumnarTrajectoryPtr();
+  }
+
+  std::string robot_name, group_name;
+  if (!reader.readString(robot_name) || !reader.readString(group_name))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Truncated binary trajectory");
+    return ColumnarTrajectoryPtr();
+  }
+  if (robot_name != robot_model->getName() || !robot_model->hasJointModelGroup(group_name))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Binary trajectory for group '%s' of robot '%s' does not match robot '%s'",
+                    group_name.c_str(), robot_name.c_str(), robot_model->getName().c_str());
+    return ColumnarTrajectoryPtr();
+  }
+  const moveit::core::JointModelGroup* group = robot_model->getJointModelGroup(group_name);
+
+  std::uint64_t variable_count;
+  const double* reference_positions = nullptr;
+  if (!reader.read(variable_count) || variable_count != robot_model->getVariableCount() ||
+      !(reference_positions = reader.readArray<double>(variable_count)))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Binary trajectory does not have a valid reference state");
+    return ColumnarTrajectoryPtr();
+  }
+
+  // the group needs to have the variables the trajectory was recorded with, in the same order
+  const std::vector<std::string>& variable_names = group->getVariableNames();
+  bool valid = reader.read(variable_count) && variable_count == variable_names.size();
+  std::string name;
+  for (std::size_t i = 0; valid && i < variable_names.size(); ++i)
+    valid = reader.readString(name) && name == variable_names[i];
+  if (!valid)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "The variables of the binary trajectory do not match group '%s'", group_name.c_str());
+    return ColumnarTrajectoryPtr();
+  }
+
+  std::uint64_t count;
+  std::uint32_t flags;
+  const double* times = nullptr;
+  const double* positions = nullptr;
+  const double* velocities = nullptr;
+  const double* accelerations = nullptr;
+  valid = reader.read(count) && reader.read(flags) &&
+          (variable_count == 0 || count <= std::numeric_limits<std::size_t>::max() / variable_count);
+  if (valid)
+  {
+    // the arrays are used in place, so they are copied only once, into the trajectory
+    const std::size_t values = count * variable_count;
+    times = reader.readArray<double>(count);
+    positions = reader.readArray<double>(values);
+    if (flags & HAS_VELOCITIES)
+      velocities = reader.readArray<double>(values);
+    if (flags & HAS_ACCELERATIONS)
+      accelerations = reader.readArray<double>(values);
+    valid = times && positions && (velocities || !(flags & HAS_VELOCITIES)) &&
+            (accelerations || !(flags & HAS_ACCELERATIONS));
+  }
+  if (!valid)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Truncated binary trajectory");
+    return ColumnarTrajectoryPtr();
+  }
+
+  moveit::core::RobotState reference_state(robot_model);
+  reference_state.setVariablePositions(reference_positions);
+  ColumnarTrajectoryPtr trajectory = std::make_shared<ColumnarTrajectory>(reference_state, group);
+  trajectory->setWayPoints(count, times, positions, velocities, accelerations);
+  return trajectory;
+}
+
+ColumnarTrajectoryPtr loadTrajectoryFromBinaryFile(const moveit::core::RobotModelConstPtr& robot_model,
+                                                   const std::string& path)
+{
+  moveit::core::MappedFile file;
+  if (!file.open(path))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Failed to open trajectory file '%s'", path.c_str());
+    return ColumnarTrajectoryPtr();
+  }
+  return loadTrajectoryFromBinary(robot_model, file.data(), file.size());
+}
+
+bool loadTrajectoryFromBinaryFile(const std::string& path, RobotTrajectory& trajectory)
+{
+  ColumnarTrajectoryPtr columns = loadTrajectoryFromBinaryFile(trajectory.getRobotModel(), path);
+  if (!columns)
+    return false;
+  columns->getRobotTrajectory(trajectory);
+  return true;
+}
+}  // namespace robot_trajectory
@@ -0,0 +1,335 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_trajectory/columnar_trajectory.h>
+#include <moveit/exceptions/exceptions.h>
+#include <tf2_eigen/tf2_eigen.h>
+#include <algorithm>
+
+namespace robot_trajectory
+{
+namespace
+{
+// The row of the first variable of joint \e name in the matrices of \e group, or -1 if the group does not have it
+int getJointRow(const moveit::core::JointModelGroup* group, const std::string& name)
+{
+  if (!group->hasJointModel(name))
+    return -1;
+  const moveit::core::JointModel* joint = group->getJointModel(name);
+  return joint->getVariableCount() == 0 ? -1 : group->getVariableGroupIndex(joint->getVariableNames()[0]);
+}
+}  // namespace
+
+ColumnarTrajectory::ColumnarTrajectory(const moveit::core::RobotState& reference_state,
+                                       const moveit::core::JointModelGroup* group)
+  : reference_state_(reference_state), group_(group), variable_count_(group->getVariableCount())
+{
+}
+
+ColumnarTrajectory::ColumnarTrajectory(const RobotTrajectory& trajectory)
+  : reference_state_(trajectory.empty() ? moveit::core::RobotState(trajectory.getRobotModel()) :
+                                          trajectory.getFirstWayPoint())
+  , group_(trajectory.getGroup())
+  , variable_count_(group_ ? group_->getVariableCount() : 0)
+{
+  if (!group_)
+    throw moveit::ConstructException("Cannot store a trajectory without a group in columns");
+  if (trajectory.empty())
+    throw moveit::ConstructException("Cannot store an empty trajectory in columns");
+
+  reserve(trajectory.getWayPointCount());
+  for (std::size_t i = 0; i < trajectory.getWayPointCount(); ++i)
+    addSuffixWayPoint(trajectory.getWayPoint(i), trajectory.getWayPointDurationFromPrevious(i));
+}
+
+void ColumnarTrajectory::reserve(std::size_t count)
+{
+  positions_.reserve(count * variable_count_);
+  time_from_start_.reserve(count);
+}
+
+void ColumnarTrajectory::clear()
+{
+  positions_.clear();
+  velocities_.clear();
+  accelerations_.clear();
+  time_from_start_.clear();
+}
+
+void ColumnarTrajectory::addSuffixWayPoint(const moveit::core::RobotState& state, double dt)
+{
+  const std::size_t offset = positions_.size();
+  positions_.resize(offset + variable_count_);
+  state.copyJointGroupPositions(group_, positions_.data() + offset);
+
+  // earlier waypoints without velocities or accelerations get zeros once the first waypoint has them
+  if (state.hasVelocities() || hasVelocities())
+  {
+    velocities_.resize(offset + variable_count_, 0.0);
+    if (state.hasVelocities())
+      state.copyJointGroupVelocities(group_, velocities_.data() + offset);
+  }
+  if (state.hasAccelerations() || hasAccelerations())
+  {
+    accelerations_.resize(offset + variable_count_, 0.0);
+    if (state.hasAccelerations())
+      state.copyJointGroupAccelerations(group_, accelerations_.data() + offset);
+  }
+  time_from_start_.push_back(getDuration() + dt);
+}
+
+void ColumnarTrajectory::addSuffixWayPoint(const double* positions, const double* velocities,
+                                           const double* accelerations, double dt)
+{
+  const std::size_t offset = positions_.size();
+  positions_.insert(positions_.end(), positions, positions + variable_count_);
+  if (velocities || hasVelocities())
+  {
+    velocities_.resize(offset, 0.0);
+    if (velocities)
+      velocities_.insert(velocities_.end(), velocities, velocities + variable_count_);
+    else
+      velocities_.resize(offset + variable_count_, 0.0);
+  }
+  if (accelerations || hasAccelerations())
+  {
+    accelerations_.resize(offset, 0.0);
+    if (accelerations)
+      accelerations_.insert(accelerations_.end(), accelerations, accelerations + variable_count_);
+    else
+      accelerations_.resize(offset + variable_count_, 0.0);
+  }
+  time_from_start_.push_back(getDuration() + dt);
+}
+
+void ColumnarTrajectory::setWayPoints(std::size_t count, const double* times_from_start, const double* positions,
+                                      const double* velocities, const double* accelerations)
+{
+  clear();
+  const std::size_t values = count * variable_count_;
+  positions_.assign(positions, positions + values);
+  if (velocities)
+    velocities_.assign(velocities, velocities + values);
+  if (accelerations)
+    accelerations_.assign(accelerations, accelerations + values);
+  time_from_start_.assign(times_from_start, times_from_start + count);
+}
+
+void ColumnarTrajectory::getWayPoint(std::size_t index, moveit::core::RobotState& state) const
+{
+  const std::size_t offset = index * variable_count_;
+  state.setJointGroupPositions(group_, positions_.data() + offset);
+  if (hasVelocities())
+    state.setJointGroupVelocities(group_, velocities_.data() + offset);
+  if (hasAccelerations())
+    state.setJointGroupAccelerations(group_, accelerations_.data() + offset);
+}
+
+moveit::core::RobotStatePtr ColumnarTrajectory::createWayPoint(std::size_t index) const
+{
+  moveit::core::RobotStatePtr state = std::make_shared<moveit::core::RobotState>(reference_state_);
+  getWayPoint(index, *state);
+  return state;
+}
+
+void ColumnarTrajectory::getRobotTrajectory(RobotTrajectory& trajectory) const
+{
+  trajectory = RobotTrajectory(getRobotModel(), group_);
+  double last_time = 0.0;
+  for (std::size_t i = 0; i < getWayPointCount(); ++i)
+  {
+    trajectory.addSuffixWayPoint(createWayPoint(i), time_from_start_[i] - last_time);
+    last_time = time_from_start_[i];
+  }
+}
+
+void ColumnarTrajectory::getRobotTrajectoryMsg(moveit_msgs::RobotTrajectory& trajectory) const
+{
+  trajectory = moveit_msgs::RobotTrajectory();
+  if (empty())
+    return;
+
+  // resolve the rows of the active joints once, for all waypoints
+  std::vector<int> onedof_rows;
+  std::vector<const moveit::core::JointModel*> mdof;
+  std::vector<int> mdof_rows;
+  for (const moveit::core::JointModel* joint : group_->getActiveJointModels())
+  {
+    const int row = group_->getVariableGroupIndex(joint->getVariableNames()[0]);
+    if (joint->getVariableCount() == 1)
+    {
+      trajectory.joint_trajectory.joint_names.push_back(joint->getName());
+      onedof_rows.push_back(row);
+    }
+    else
+    {
+      trajectory.multi_dof_joint_trajectory.joint_names.push_back(joint->getName());
+      mdof.push_back(joint);
+      mdof_rows.push_back(row);
+    }
+  }
+
+  const std::size_t count = getWayPointCount();
+  if (!onedof_rows.empty())
+  {
+    trajectory.joint_trajectory.header.frame_id = getRobotModel()->getModelFrame();
+    trajectory.joint_trajectory.header.stamp = ros::Time(0);
+    trajectory.joint_trajectory.points.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      trajectory_msgs::JointTrajectoryPoint& point = trajectory.joint_trajectory.points[i];
+      const std::size_t offset = i * variable_count_;
+      point.positions.resize(onedof_rows.size());
+      for (std::size_t j = 0; j < onedof_rows.size(); ++j)
+        point.positions[j] = positions_[offset + onedof_rows[j]];
+      if (hasVelocities())
+      {
+        point.velocities.resize(onedof_rows.size());
+        for (std::size_t j = 0; j < onedof_rows.size(); ++j)
+          point.velocities[j] = velocities_[offset + onedof_rows[j]];
+      }
+      if (hasAccelerations())
+      {
+        point.accelerations.resize(onedof_rows.size());
+        for (std::size_t j = 0; j < onedof_rows.size(); ++j)
+          point.accelerations[j] = accelerations_[offset + onedof_rows[j]];
+      }
+      point.time_from_start = ros::Duration(time_from_start_[i]);
+    }
+  }
+
+  if (!mdof.empty())
+  {
+    trajectory.multi_dof_joint_trajectory.header.frame_id = getRobotModel()->getModelFrame();
+    trajectory.multi_dof_joint_trajectory.header.stamp = ros::Time(0);
+    trajectory.multi_dof_joint_trajectory.points.resize(count);
+    Eigen::Isometry3d transform;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      trajectory_msgs::MultiDOFJointTrajectoryPoint& point = trajectory.multi_dof_joint_trajectory.points[i];
+      point.transforms.resize(mdof.size());
+      for (std::size_t j = 0; j < mdof.size(); ++j)
+      {
+        mdof[j]->computeTransform(positions_.data() + i * variable_count_ + mdof_rows[j], transform);
+        point.transforms[j] = tf2::eigenToTransform(transform).transform;
+      }
+      point.time_from_start = ros::Duration(time_from_start_[i]);
+    }
+  }
+}
+
+void ColumnarTrajectory::setRobotTrajectoryMsg(const moveit_msgs::RobotTrajectory& trajectory)
+{
+  clear();
+  const trajectory_msgs::JointTrajectory& onedof = trajectory.joint_trajectory;
+  const trajectory_msgs::MultiDOFJointTrajectory& mdof = trajectory.multi_dof_joint_trajectory;
+
+  // resolve the rows of the joints in the message once, for all waypoints
+  std::vector<int> onedof_rows;
+  for (const std::string& name : onedof.joint_names)
+    onedof_rows.push_back(getJointRow(group_, name));
+  std::vector<int> mdof_rows;
+  for (const std::string& name : mdof.joint_names)
+    mdof_rows.push_back(getJointRow(group_, name));
+
+  std::vector<double> reference_positions(variable_count_);
+  reference_state_.copyJointGroupPositions(group_, reference_positions.data());
+
+  const std::size_t count = std::max(onedof.points.size(), mdof.points.size());
+  const ros::Time start_stamp = onedof.points.empty() ? mdof.header.stamp : onedof.header.stamp;
+  reserve(count);
+  Eigen::Isometry3d transform;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const std::size_t offset = positions_.size();
+    positions_.insert(positions_.end(), reference_positions.begin(), reference_positions.end());
+    ros::Time stamp = start_stamp;
+    if (onedof.points.size() > i)
+    {
+      const trajectory_msgs::JointTrajectoryPoint& point = onedof.points[i];
+      for (std::size_t j = 0; j < onedof_rows.size(); ++j)
+        if (onedof_rows[j] >= 0)
+          positions_[offset + onedof_rows[j]] = point.positions[j];
+      if (!point.velocities.empty())
+      {
+        velocities_.resize(offset + variable_count_, 0.0);
+        for (std::size_t j = 0; j < onedof_rows.size(); ++j)
+          if (onedof_rows[j] >= 0)
+            velocities_[offset + onedof_rows[j]] = point.velocities[j];
+      }
+      if (!point.accelerations.empty())
+      {
+        accelerations_.resize(offset + variable_count_, 0.0);
+        for (std::size_t j = 0; j < onedof_rows.size(); ++j)
+          if (onedof_rows[j] >= 0)
+            accelerations_[offset + onedof_rows[j]] = point.accelerations[j];
+      }
+      stamp = onedof.header.stamp + point.time_from_start;
+    }
+    if (mdof.points.size() > i)
+    {
+      for (std::size_t j = 0; j < mdof_rows.size(); ++j)
+        if (mdof_rows[j] >= 0)
+        {
+          transform = tf2::transformToEigen(mdof.points[i].transforms[j]);
+          group_->getJointModel(mdof.joint_names[j])
+              ->computeVariablePositions(transform, positions_.data() + offset + mdof_rows[j]);
+        }
+      stamp = mdof.header.stamp + mdof.points[i].time_from_start;
+    }
+
+    // waypoints without velocities or accelerations get zeros once an earlier waypoint had them
+    if (hasVelocities())
+      velocities_.resize(offset + variable_count_, 0.0);
+    if (hasAccelerations())
+      accelerations_.resize(offset + variable_count_, 0.0);
+    updateMimicVariables();
+    time_from_start_.push_back((stamp - start_stamp).toSec());
+  }
+}
+
+void ColumnarTrajectory::updateMimicVariables()
+{
+  double* positions = positions_.data() + positions_.size() - variable_count_;
+  for (const moveit::core::JointModel* joint : group_->getMimicJointModels())
+  {
+    const moveit::core::JointModel* mimic = joint->getMimic();
+    const int mimic_row = getJointRow(group_, mimic->getName());
+    const double value = mimic_row >= 0 ? positions[mimic_row] :
+                                          reference_state_.getVariablePosition(mimic->getFirstVariableIndex());
+    positions[getJointRow(group_, joint->getName())] = joint->getMimicFactor() * value + joint->getMimicOffset();
+  }
+}
+
+}  // namespace robot_trajectory
@@ -36,9 +36,10 @@
 
 #include <moveit/robot_trajectory/robot_trajectory.h>
 #include <moveit/robot_state/conversions.h>
+#include <moveit/robot_state/batch_forward_kinematics.h>
 #include <tf2_eigen/tf2_eigen.h>
 #include <boost/math/constants/constants.hpp>
-#include <numeric>
+#include <algorithm>
 
 namespace robot_trajectory
 {
@@ -81,7 +82,9 @@ const std::string& RobotTrajectory::getGroupName() const
 
 double RobotTrajectory::getDuration() const
 {
-  return std::accumulate(duration_from_previous_.begin(), duration_from_previous_.end(), 0.0);
+  if (duration_from_previous_.empty())
+    return 0.0;
+  return getWayPointDurationFromStart(duration_from_previous_.size() - 1);
 }
 
 double RobotTrajectory::getAverageSegmentDuration() const
@@ -98,6 +101,8 @@ void RobotTrajectory::swap(RobotTrajectory& other)
   std::swap(group_, other.group_);
   waypoints_.swap(other.waypoints_);
   duration_from_previous_.swap(other.duration_from_previous_);
+  durations_from_start_.swap(other.durations_from_start_);
+  std::swap(valid_durations_from_start_, other.valid_durations_from_start_);
 }
 
 void RobotTrajectory::append(const RobotTrajectory& source, double dt, size_t start_index, size_t end_index)
@@ -113,6 +118,7 @@ void RobotTrajectory::append(const RobotTrajectory& source, double dt, size_t st
                                  std::next(source.duration_from_previous_.begin(), end_index));
   if (duration_from_previous_.size() > index)
     duration_from_previous_[index] += dt;
+  updateDurationsFromStart(index);
 }
 
 void RobotTrajectory::reverse()
@@ -128,6 +134,7 @@ void RobotTrajectory::reverse()
     duration_from_previous_.push_back(duration_from_previous_.front());
     std::reverse(duration_from_previous_.begin(), duration_from_previous_.end());
     duration_from_previous_.pop_back();
+    updateDurationsFromStart(0);
   }
 }
 
@@ -216,6 +223,39 @@ void RobotTrajectory::clear()
 {
   waypoints_.clear();
   duration_from_previous_.clear();
+  durations_from_start_.clear();
+  valid_durations_from_start_ = 0;
+}
+
+void RobotTrajectory::setWayPointDurationFromPrevious(std::size_t index, double value)
+{
+  if (duration_from_previous_.size() <= index)
+    duration_from_previous_.resize(index + 1, 0.0);
+  duration_from_previous_[index] = value;
+
+  // only extend the up to date durations from start if they reach this waypoint; the later ones are out of date now
+  durations_from_start_.resize(duration_from_previous_.size());
+  if (index <= valid_durations_from_start_)
+  {
+    durations_from_start_[index] = (index > 0 ? durations_from_start_[index - 1] : 0.0) + value;
+    valid_durations_from_start_ = index + 1;
+  }
+}
+
+void RobotTrajectory::updateDurationsFromStart(std::size_t index)
+{
+  const std::size_t count = duration_from_previous_.size();
+  durations_from_start_.resize(count);
+  double time = 0.0;
+  std::size_t i = std::min(index, valid_durations_from_start_);
+  if (i > 0)
+    time = durations_from_start_[i - 1];
+  for (; i < count; ++i)
+  {
+    time += duration_from_previous_[i];
+    durations_from_start_[i] = time;
+  }
+  valid_durations_from_start_ = count;
 }
 
 void RobotTrajectory::getRobotTrajectoryMsg(moveit_msgs::RobotTrajectory& trajectory,
@@ -445,24 +485,34 @@ void RobotTrajectory::findWayPointIndicesForDurationAfterStart(const double& dur
     return;
   }
 
-  // Find indicies
-  std::size_t index = 0, num_points = waypoints_.size();
+  // Find indicies: binary search within the up to date durations from start, linear search beyond them
+  const std::size_t num_points = waypoints_.size();
+  const std::size_t valid = std::min(valid_durations_from_start_, num_points);
+  std::size_t index =
+      std::lower_bound(durations_from_start_.begin(), durations_from_start_.begin() + valid, duration) -
+      durations_from_start_.begin();
   double running_duration = 0.0;
-  for (; index < num_points; ++index)
+  if (index < valid)
+    running_duration = durations_from_start_[index];
+  else
   {
-    running_duration += duration_from_previous_[index];
-    if (running_duration >= duration)
-      break;
+    if (valid > 0)
+      running_duration = durations_from_start_[valid - 1];
+    for (; index < num_points; ++index)
+    {
+      running_duration += duration_from_previous_[index];
+      if (running_duration >= duration)
+        break;
+    }
   }
   before = std::max<int>(index - 1, 0);
   after = std::min<int>(index, num_points - 1);
 
   // Compute duration blend
-  double before_time = running_duration - duration_from_previous_[index];
-  if (after == before)
+  if (after == before || index == num_points)
     blend = 1.0;
   else
-    blend = (duration - before_time) / duration_from_previous_[index];
+    blend = (duration - (running_duration - duration_from_previous_[index])) / duration_from_previous_[index];
 }
 
 double RobotTrajectory::getWayPointDurationFromStart(std::size_t index) const
@@ -471,9 +521,12 @@ double RobotTrajectory::getWayPointDurationFromStart(std::size_t index) const
     return 0.0;
   if (index >= duration_from_previous_.size())
     index = duration_from_previous_.size() - 1;
+  if (index < valid_durations_from_start_)
+    return durations_from_start_[index];
 
-  double time = 0.0;
-  for (std::size_t i = 0; i <= index; ++i)
+  // continue from the last up to date duration from start
+  double time = valid_durations_from_start_ > 0 ? durations_from_start_[valid_durations_from_start_ - 1] : 0.0;
+  for (std::size_t i = valid_durations_from_start_; i <= index; ++i)
     time += duration_from_previous_[i];
   return time;
 }
@@ -499,4 +552,104 @@ bool RobotTrajectory::getStateAtDurationFromStart(const double request_duration,
   return true;
 }
 
+bool RobotTrajectory::getJacobians(const moveit::core::LinkModel* link, const Eigen::Vector3d& reference_point_position,
+                                   std::vector<Eigen::MatrixXd>& jacobians,
+                                   std::vector<Eigen::MatrixXd>* jacobian_derivatives) const
+{
+  if (!group_)
+  {
+    ROS_ERROR_NAMED("robot_trajectory", "Cannot compute Jacobians for a trajectory without a group");
+    return false;
+  }
+
+  const std::size_t count = waypoints_.size();
+  jacobians.resize(count);
+  if (jacobian_derivatives)
+    jacobian_derivatives->resize(count);
+  if (count == 0)
+    return true;
+
+  Eigen::MatrixXd positions(count, group_->getVariableCount());
+  Eigen::VectorXd values;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    waypoints_[i]->copyJointGroupPositions(group_, values);
+    positions.row(i) = values.transpose();
+  }
+  moveit::core::BatchForwardKinematics fk(*waypoints_.front(), group_);
+  fk.compute(positions);
+
+  Eigen::VectorXd velocities;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    bool success = fk.getJacobian(group_, link, i, reference_point_position, jacobians[i]);
+    if (success && jacobian_derivatives)
+    {
+      if (waypoints_[i]->hasVelocities())
+        waypoints_[i]->copyJointGroupVelocities(group_, velocities);
+      else
+        velocities.setZero(group_->getVariableCount());
+      success = fk.getJacobianDerivative(group_, link, i, reference_point_position, velocities,
+                                         (*jacobian_derivatives)[i]);
+    }
+    if (!success)
+    {
+      ROS_ERROR_NAMED("robot_trajectory",
+                      "Cannot compute Jacobians of link '%s' for group '%s', which needs to be a chain of revolute and "
+                      "prismatic joints updating the link",
+                      link->getName().c_str(), group_->getName().c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+RobotTrajectorySampler::RobotTrajectorySampler(const RobotTrajectory& trajectory, double period, double start_time)
+  : trajectory_(trajectory)
+  , period_(period)
+  , start_time_(start_time)
+  , sample_count_(0)
+  , done_(trajectory.empty())
+  , duration_(trajectory.getDuration())
+  , index_(0)
+  , index_time_(trajectory.getWayPointDurationFromPrevious(0))
+{
+  if (period <= 0.0)
+  {
+    ROS_ERROR_NAMED("robot_trajectory", "Cannot sample a trajectory with a period of %f s", period);
+    done_ = true;
+  }
+  time_ = std::min(start_time_, duration_);
+}
+
+bool RobotTrajectorySampler::next(moveit::core::RobotState& state)
+{
+  if (done_)
+    return false;
+
+  // advance to the first waypoint reached at or after the sample time, as findWayPointIndicesForDurationAfterStart()
+  const std::size_t count = trajectory_.getWayPointCount();
+  while (index_time_ < time_ && index_ + 1 < count)
+  {
+    ++index_;
+    index_time_ += trajectory_.getWayPointDurationFromPrevious(index_);
+  }
+
+  const std::size_t before = index_time_ < time_ || index_ == 0 ? index_ : index_ - 1;
+  double blend = 1.0;
+  if (before != index_)
+  {
+    const double duration = trajectory_.getWayPointDurationFromPrevious(index_);
+    blend = (time_ - (index_time_ - duration)) / duration;
+  }
+  trajectory_.getWayPoint(before).interpolate(trajectory_.getWayPoint(index_), blend, state);
+
+  // the last sample is the one at the end of the trajectory
+  if (time_ >= duration_)
+    done_ = true;
+  else
+    time_ = std::min(start_time_ + static_cast<double>(++sample_count_) * period_, duration_);
+  return true;
+}
+
 }  // end of namespace robot_trajectory
@@ -34,11 +34,15 @@
 
 /* Author: Ioan Sucan */
 
+#include <moveit/exceptions/exceptions.h>
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_trajectory/binary_trajectory.h>
+#include <moveit/robot_trajectory/columnar_trajectory.h>
 #include <moveit/robot_trajectory/robot_trajectory.h>
 #include <moveit/utils/robot_model_test_utils.h>
 #include <gtest/gtest.h>
+#include <sstream>
 
 class RobotTrajectoryTestFixture : public testing::Test
 {
@@ -204,6 +208,222 @@ TEST_F(RobotTrajectoryTestFixture, RobotTrajectoryDeepCopy)
   EXPECT_NE(trajectory_first_state_after_update[0], trajectory_copy_first_state_after_update[0]);
 }
 
+TEST_F(RobotTrajectoryTestFixture, Jacobians)
+{
+  robot_trajectory::RobotTrajectory trajectory(robot_model_, arm_jmg_name_);
+  const moveit::core::JointModelGroup* group = trajectory.getGroup();
+  const moveit::core::LinkModel* link = robot_model_->getLinkModel("panda_link8");
+  const Eigen::Vector3d reference_point(0.0, 0.05, 0.1);
+  for (std::size_t i = 0; i < 10; ++i)
+  {
+    robot_state_->setToRandomPositions(group);
+    std::vector<double> velocities(group->getVariableCount(), 0.1 * i);
+    robot_state_->setJointGroupVelocities(group, velocities);
+    trajectory.addSuffixWayPoint(*robot_state_, 0.1);
+  }
+
+  std::vector<Eigen::MatrixXd> jacobians;
+  std::vector<Eigen::MatrixXd> jacobian_derivatives;
+  ASSERT_TRUE(trajectory.getJacobians(link, reference_point, jacobians, &jacobian_derivatives));
+  ASSERT_EQ(jacobians.size(), trajectory.getWayPointCount());
+  ASSERT_EQ(jacobian_derivatives.size(), trajectory.getWayPointCount());
+  for (std::size_t i = 0; i < trajectory.getWayPointCount(); ++i)
+  {
+    const moveit::core::RobotState& waypoint = trajectory.getWayPoint(i);
+    Eigen::MatrixXd expected;
+    ASSERT_TRUE(waypoint.getJacobian(group, link, reference_point, expected));
+    EXPECT_TRUE(jacobians[i].isApprox(expected, 1e-10)) << "waypoint " << i;
+
+    Eigen::VectorXd qdot;
+    waypoint.copyJointGroupVelocities(group, qdot);
+    ASSERT_TRUE(waypoint.getJacobianDerivative(group, link, reference_point, qdot, expected));
+    EXPECT_TRUE(jacobian_derivatives[i].isApprox(expected, 1e-10)) << "waypoint " << i;
+  }
+
+  robot_trajectory::RobotTrajectory no_group(robot_model_, nullptr);
+  EXPECT_FALSE(no_group.getJacobians(link, reference_point, jacobians));
+}
+
+TEST_F(RobotTrajectoryTestFixture, DurationsFromStart)
+{
+  robot_trajectory::RobotTrajectoryPtr trajectory;
+  initTestTrajectory(trajectory);
+  trajectory->addPrefixWayPoint(robot_state_, 0.3);
+  trajectory->insertWayPoint(2, robot_state_, 0.2);
+
+  // setting durations out of order leaves the later durations from start to be accumulated on demand
+  trajectory->setWayPointDurationFromPrevious(3, 0.4);
+  trajectory->setWayPointDurationFromPrevious(1, 0.5);
+  double expected = 0.0;
+  for (std::size_t i = 0; i < trajectory->getWayPointCount(); ++i)
+  {
+    expected += trajectory->getWayPointDurationFromPrevious(i);
+    EXPECT_NEAR(trajectory->getWayPointDurationFromStart(i), expected, 1e-12) << "waypoint " << i;
+
+    int before, after;
+    double blend;
+    trajectory->findWayPointIndicesForDurationAfterStart(expected - 0.01, before, after, blend);
+    EXPECT_EQ(after, static_cast<int>(i));
+    EXPECT_EQ(before, std::max(0, after - 1));
+  }
+  EXPECT_NEAR(trajectory->getDuration(), expected, 1e-12);
+
+  trajectory->reverse();
+  EXPECT_NEAR(trajectory->getDuration(), expected, 1e-12);
+}
+
+TEST_F(RobotTrajectoryTestFixture, Sampler)
+{
+  robot_trajectory::RobotTrajectory trajectory(robot_model_, arm_jmg_name_);
+  const moveit::core::JointModelGroup* group = trajectory.getGroup();
+  for (std::size_t i = 0; i < 10; ++i)
+  {
+    robot_state_->setToRandomPositions(group);
+    trajectory.addSuffixWayPoint(*robot_state_, 0.1 + 0.02 * i);
+  }
+
+  // the samples match those of getStateAtDurationFromStart(), ending with the last waypoint
+  const double period = 0.03;
+  robot_trajectory::RobotTrajectorySampler sampler(trajectory, period);
+  moveit::core::RobotState sample(robot_model_);
+  moveit::core::RobotStatePtr expected = std::make_shared<moveit::core::RobotState>(robot_model_);
+  std::size_t count = 0;
+  while (!sampler.done())
+  {
+    const double time = sampler.getTime();
+    ASSERT_TRUE(sampler.next(sample));
+    ASSERT_TRUE(trajectory.getStateAtDurationFromStart(time, expected));
+    for (std::size_t j = 0; j < robot_model_->getVariableCount(); ++j)
+      EXPECT_NEAR(sample.getVariablePosition(j), expected->getVariablePosition(j), 1e-12) << "time " << time;
+    ++count;
+  }
+  EXPECT_EQ(count, static_cast<std::size_t>(std::ceil(trajectory.getDuration() / period)) + 1);
+  EXPECT_FALSE(sampler.next(sample));
+  for (std::size_t j = 0; j < robot_model_->getVariableCount(); ++j)
+    EXPECT_EQ(sample.getVariablePosition(j), trajectory.getLastWayPoint().getVariablePosition(j));
+
+  robot_trajectory::RobotTrajectory empty(robot_model_, arm_jmg_name_);
+  robot_trajectory::RobotTrajectorySampler empty_sampler(empty, period);
+  EXPECT_TRUE(empty_sampler.done());
+  EXPECT_FALSE(empty_sampler.next(sample));
+}
+
+TEST_F(RobotTrajectoryTestFixture, ColumnarTrajectory)
+{
+  robot_trajectory::RobotTrajectory trajectory(robot_model_, arm_jmg_name_);
+  const moveit::core::JointModelGroup* group = trajectory.getGroup();
+  for (std::size_t i = 0; i < 10; ++i)
+  {
+    robot_state_->setToRandomPositions(group);
+    std::vector<double> velocities(group->getVariableCount(), 0.1 * i);
+    robot_state_->setJointGroupVelocities(group, velocities);
+    trajectory.addSuffixWayPoint(*robot_state_, 0.1 + 0.01 * i);
+  }
+
+  robot_trajectory::ColumnarTrajectory columns(trajectory);
+  ASSERT_EQ(columns.getWayPointCount(), trajectory.getWayPointCount());
+  EXPECT_EQ(columns.getPositions().rows(), static_cast<long>(group->getVariableCount()));
+  EXPECT_TRUE(columns.hasVelocities());
+  EXPECT_FALSE(columns.hasAccelerations());
+  EXPECT_NEAR(columns.getDuration(), trajectory.getDuration(), 1e-12);
+  for (std::size_t i = 0; i < trajectory.getWayPointCount(); ++i)
+  {
+    Eigen::VectorXd expected;
+    trajectory.getWayPoint(i).copyJointGroupPositions(group, expected);
+    EXPECT_EQ(columns.getPositions().col(i), expected);
+    trajectory.getWayPoint(i).copyJointGroupVelocities(group, expected);
+    EXPECT_EQ(columns.getVelocities().col(i), expected);
+    EXPECT_NEAR(columns.getWayPointDurationFromStart(i), trajectory.getWayPointDurationFromStart(i), 1e-12);
+  }
+
+  // the bulk conversion to messages matches the one of RobotTrajectory
+  moveit_msgs::RobotTrajectory expected_msg;
+  moveit_msgs::RobotTrajectory msg;
+  trajectory.getRobotTrajectoryMsg(expected_msg);
+  columns.getRobotTrajectoryMsg(msg);
+  EXPECT_EQ(msg, expected_msg);
+
+  // and so is the conversion back, including materialized states
+  robot_trajectory::ColumnarTrajectory from_msg(columns.getReferenceState(), group);
+  from_msg.setRobotTrajectoryMsg(msg);
+  ASSERT_EQ(from_msg.getWayPointCount(), columns.getWayPointCount());
+  EXPECT_TRUE(from_msg.getPositions().isApprox(columns.getPositions()));
+  EXPECT_TRUE(from_msg.getVelocities().isApprox(columns.getVelocities()));
+  robot_trajectory::RobotTrajectory materialized(robot_model_, nullptr);
+  from_msg.getRobotTrajectory(materialized);
+  ASSERT_EQ(materialized.getWayPointCount(), trajectory.getWayPointCount());
+  EXPECT_EQ(materialized.getGroup(), group);
+  for (std::size_t i = 0; i < trajectory.getWayPointCount(); ++i)
+  {
+    EXPECT_NEAR(materialized.getWayPointDurationFromPrevious(i), trajectory.getWayPointDurationFromPrevious(i), 1e-9);
+    EXPECT_TRUE(materialized.getWayPoint(i).getGlobalLinkTransform("panda_link8").isApprox(
+        trajectory.getWayPoint(i).getGlobalLinkTransform("panda_link8")));
+  }
+
+  robot_trajectory::RobotTrajectory no_group(robot_model_, nullptr);
+  no_group.addSuffixWayPoint(*robot_state_, 0.1);
+  EXPECT_THROW(robot_trajectory::ColumnarTrajectory invalid(no_group), moveit::ConstructException);
+}
+
+TEST_F(RobotTrajectoryTestFixture, BinaryTrajectory)
+{
+  robot_trajectory::RobotTrajectory trajectory(robot_model_, arm_jmg_name_);
+  const moveit::core::JointModelGroup* group = trajectory.getGroup();
+  for (std::size_t i = 0; i < 10; ++i)
+  {
+    robot_state_->setToRandomPositions(group);
+    std::vector<double> values(group->getVariableCount(), 0.1 * i);
+    robot_state_->setJointGroupVelocities(group, values);
+    robot_state_->setJointGroupAccelerations(group, values);
+    trajectory.addSuffixWayPoint(*robot_state_, 0.1);
+  }
+  robot_trajectory::ColumnarTrajectory columns(trajectory);
+
+  std::stringstream out;
+  ASSERT_TRUE(robot_trajectory::saveTrajectoryToBinary(columns, out));
+  const std::string data = out.str();
+  std::vector<double> buffer(data.size() / sizeof(double) + 1);  // aligned to eight bytes
+  std::copy(data.begin(), data.end(), reinterpret_cast<char*>(buffer.data()));
+
+  robot_trajectory::ColumnarTrajectoryPtr loaded =
+      robot_trajectory::loadTrajectoryFromBinary(robot_model_, buffer.data(), data.size());
+  ASSERT_TRUE(loaded);
+  EXPECT_EQ(loaded->getGroup(), group);
+  EXPECT_EQ(loaded->getPositions(), columns.getPositions());
+  EXPECT_EQ(loaded->getVelocities(), columns.getVelocities());
+  EXPECT_EQ(loaded->getAccelerations(), columns.getAccelerations());
+  EXPECT_EQ(loaded->getTimesFromStart(), columns.getTimesFromStart());
+  for (std::size_t i = 0; i < robot_model_->getVariableCount(); ++i)
+    EXPECT_EQ(loaded->getReferenceState().getVariablePosition(i), columns.getReferenceState().getVariablePosition(i));
+
+  // misaligned buffers are copied instead of used in place
+  std::vector<char> misaligned(data.size() + 1);
+  std::copy(data.begin(), data.end(), misaligned.begin() + 1);
+  loaded = robot_trajectory::loadTrajectoryFromBinary(robot_model_, misaligned.data() + 1, data.size());
+  ASSERT_TRUE(loaded);
+  EXPECT_EQ(loaded->getPositions(), columns.getPositions());
+  EXPECT_EQ(loaded->getVelocities(), columns.getVelocities());
+  EXPECT_EQ(loaded->getTimesFromStart(), columns.getTimesFromStart());
+
+  // truncated data and other robots are rejected
+  EXPECT_FALSE(robot_trajectory::loadTrajectoryFromBinary(robot_model_, buffer.data(), data.size() - 8));
+  EXPECT_FALSE(robot_trajectory::loadTrajectoryFromBinary(moveit::core::loadTestingRobotModel("pr2"), buffer.data(),
+                                                          data.size()));
+
+  // files are mapped into memory
+  const std::string path = testing::TempDir() + "test_robot_trajectory.bin";
+  ASSERT_TRUE(robot_trajectory::saveTrajectoryToBinaryFile(trajectory, path));
+  robot_trajectory::RobotTrajectory from_file(robot_model_, nullptr);
+  ASSERT_TRUE(robot_trajectory::loadTrajectoryFromBinaryFile(path, from_file));
+  ASSERT_EQ(from_file.getWayPointCount(), trajectory.getWayPointCount());
+  EXPECT_EQ(from_file.getGroup(), group);
+  EXPECT_NEAR(from_file.getDuration(), trajectory.getDuration(), 1e-12);
+  for (std::size_t i = 0; i < trajectory.getWayPointCount(); ++i)
+    for (std::size_t j = 0; j < robot_model_->getVariableCount(); ++j)
+      EXPECT_EQ(from_file.getWayPoint(i).getVariablePosition(j), trajectory.getWayPoint(i).getVariablePosition(j));
+  std::remove(path.c_str());
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
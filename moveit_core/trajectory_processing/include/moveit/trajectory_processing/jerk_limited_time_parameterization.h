@@ -0,0 +1,84 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <map>
+#include <string>
+
+namespace trajectory_processing
+{
+/// \brief This class sets the timestamps of a trajectory
+/// to enforce velocity, acceleration and jerk constraints.
+///
+/// The trajectory is first parameterized with TimeOptimalTrajectoryGeneration,
+/// which is time-optimal under velocity and acceleration limits but lets the
+/// acceleration jump. A cubic spline with zero velocity and acceleration at both
+/// ends is then fit through the resampled waypoints, and the intervals violating
+/// a limit are stretched until the velocities, accelerations and (piecewise constant)
+/// jerks of the spline are within bounds. Waypoints carry the spline velocities
+/// and accelerations, so a controller interpolating them with cubic splines
+/// tracks a jerk-limited motion.
+/// To bring the ends of the spline to rest, the second and second-last
+/// waypoints are moved, so they should be re-checked for collisions.
+/// Segments next to a moved waypoint are split until it is within the path tolerance,
+/// and segments where the spline overshoots the position bounds are slowed down;
+/// computeTimeStamps() fails if this does not succeed.
+///
+/// Velocity and acceleration limits are taken from the robot model. Jerk limits are not part
+/// of the robot model and need to be set with setJerkLimits(); variables without one are not jerk-limited.
+class JerkLimitedTimeParameterization
+{
+public:
+  JerkLimitedTimeParameterization(const double path_tolerance = 0.1, const double resample_dt = 0.1,
+                                  const double min_angle_change = 0.001);
+
+  /// \brief Set the maximum jerk of each variable, by variable name
+  void setJerkLimits(const std::map<std::string, double>& jerk_limits);
+  const std::map<std::string, double>& getJerkLimits() const
+  {
+    return jerk_limits_;
+  }
+
+  bool computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory, const double max_velocity_scaling_factor = 1.0,
+                         const double max_acceleration_scaling_factor = 1.0) const;
+
+private:
+  const double path_tolerance_;
+  const double resample_dt_;
+  const double min_angle_change_;
+  std::map<std::string, double> jerk_limits_;
+};
+}  // namespace trajectory_processing
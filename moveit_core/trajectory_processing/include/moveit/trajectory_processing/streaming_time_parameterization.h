@@ -0,0 +1,111 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <Eigen/Core>
+#include <vector>
+
+namespace trajectory_processing
+{
+/// \brief This class time-parameterizes a trajectory whose waypoints arrive incrementally,
+/// e.g. from a planner streaming its solution or a teleoperation interface.
+///
+/// Waypoints are appended with addWayPoint(). Each call to computeTimeStamps() runs
+/// TimeOptimalTrajectoryGeneration on the waypoints that are not yet committed, starting
+/// from the velocity the committed part ends with and stopping at the last known waypoint.
+/// The prefix of the result that leaves enough path to brake before the next waypoint is
+/// committed: it is appended to the caller's trajectory and never changes again, so it can
+/// be sent to the controllers while more waypoints are planned. The remainder is returned
+/// as the stoppable tail that brings the robot to rest at the last waypoint, to be executed
+/// if no further waypoints arrive in time. finish() commits the tail once the last waypoint is known.
+///
+/// Committed points only lie on the straight parts of the path, so the re-parameterization
+/// starting there continues with the same position and velocity. Where the path turns back
+/// on itself, the motion comes to rest.
+class StreamingTimeParameterization
+{
+public:
+  StreamingTimeParameterization(const moveit::core::RobotState& start_state,
+                                const moveit::core::JointModelGroup* group,
+                                const double max_velocity_scaling_factor = 1.0,
+                                const double max_acceleration_scaling_factor = 1.0, const double path_tolerance = 0.1,
+                                const double resample_dt = 0.1, const double min_angle_change = 0.001);
+
+  /// \brief Append a waypoint. Waypoints too close to the previous one are ignored
+  void addWayPoint(const moveit::core::RobotState& state);
+
+  /// \brief Parameterize the waypoints added so far.
+  /// Appends the newly committed waypoints to committed, the first call also adds the start state.
+  /// tail is replaced by the waypoints following the committed ones that bring the robot to rest.
+  bool computeTimeStamps(robot_trajectory::RobotTrajectory& committed, robot_trajectory::RobotTrajectory& tail);
+
+  /// \brief Commit the motion to rest at the last waypoint. Adding further waypoints afterwards starts from rest.
+  bool finish(robot_trajectory::RobotTrajectory& committed);
+
+  /// \brief Duration of the motion committed so far
+  double getCommittedDuration() const
+  {
+    return committed_duration_;
+  }
+
+  /// \brief Number of waypoints not committed yet, not counting the point the next parameterization starts at
+  std::size_t getPendingWayPointCount() const
+  {
+    return points_.size() - 1;
+  }
+
+private:
+  bool parameterize(robot_trajectory::RobotTrajectory& committed, robot_trajectory::RobotTrajectory* tail);
+  void setWayPoint(const Eigen::VectorXd& position, const Eigen::VectorXd& velocity,
+                   const Eigen::VectorXd& acceleration);
+
+  const moveit::core::JointModelGroup* group_;
+  const double path_tolerance_;
+  const double resample_dt_;
+  const double min_angle_change_;
+
+  Eigen::VectorXd max_velocity_;
+  Eigen::VectorXd max_acceleration_;
+  std::vector<bool> continuous_;
+
+  // points_[0] is the last committed point, the parameterization continues from it with path velocity velocity_
+  std::vector<Eigen::VectorXd> points_;
+  double velocity_;
+  bool start_committed_;
+  double committed_duration_;
+  moveit::core::RobotState waypoint_;
+};
+}  // namespace trajectory_processing
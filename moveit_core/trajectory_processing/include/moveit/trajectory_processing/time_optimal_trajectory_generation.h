@@ -40,6 +40,7 @@
 
 #include <Eigen/Core>
 #include <list>
+#include <vector>
 #include <moveit/robot_trajectory/robot_trajectory.h>
 
 namespace trajectory_processing
@@ -60,6 +61,12 @@ public:
   virtual Eigen::VectorXd getConfig(double s) const = 0;
   virtual Eigen::VectorXd getTangent(double s) const = 0;
   virtual Eigen::VectorXd getCurvature(double s) const = 0;
+
+  /** @brief Variants of the functions above writing into a preallocated vector of the path dimension */
+  virtual void getConfig(double s, Eigen::VectorXd& config) const = 0;
+  virtual void getTangent(double s, Eigen::VectorXd& tangent) const = 0;
+  virtual void getCurvature(double s, Eigen::VectorXd& curvature) const = 0;
+
   virtual std::list<double> getSwitchingPoints() const = 0;
   virtual PathSegment* clone() const = 0;
 
@@ -73,27 +80,44 @@ class Path
 {
 public:
   Path(const std::list<Eigen::VectorXd>& path, double max_deviation = 0.0);
+  Path(const std::vector<Eigen::VectorXd>& path, double max_deviation = 0.0);
+  /** @brief Path through the points in [begin, end), e.g. a prefix of a reused buffer */
+  Path(std::vector<Eigen::VectorXd>::const_iterator begin, std::vector<Eigen::VectorXd>::const_iterator end,
+       double max_deviation = 0.0);
   Path(const Path& path);
+  Path(Path&& path) = default;
   double getLength() const;
   Eigen::VectorXd getConfig(double s) const;
   Eigen::VectorXd getTangent(double s) const;
   Eigen::VectorXd getCurvature(double s) const;
+  void getConfig(double s, Eigen::VectorXd& config) const;
+  void getTangent(double s, Eigen::VectorXd& tangent) const;
+  void getCurvature(double s, Eigen::VectorXd& curvature) const;
   double getNextSwitchingPoint(double s, bool& discontinuity) const;
-  std::list<std::pair<double, bool>> getSwitchingPoints() const;
+
+  /** @brief Switching points sorted by path position; the flag marks discontinuities of the path curvature */
+  const std::vector<std::pair<double, bool>>& getSwitchingPoints() const;
 
 private:
-  PathSegment* getPathSegment(double& s) const;
+  void initialize(std::vector<Eigen::VectorXd>::const_iterator path, std::vector<Eigen::VectorXd>::const_iterator end,
+                  double max_deviation);
+
+  /** @brief Find the segment containing the path position s by binary search and make s relative to it */
+  const PathSegment* getPathSegment(double& s) const;
   double length_;
-  std::list<std::pair<double, bool>> switching_points_;
-  std::list<std::unique_ptr<PathSegment>> path_segments_;
+  std::vector<std::pair<double, bool>> switching_points_;
+  std::vector<std::unique_ptr<PathSegment>> path_segments_;
+  std::vector<double> path_segment_positions_;
 };
 
 class Trajectory
 {
 public:
-  /// @brief Generates a time-optimal trajectory
-  Trajectory(const Path& path, const Eigen::VectorXd& max_velocity, const Eigen::VectorXd& max_acceleration,
-             double time_step = 0.001);
+  /** @brief Generates a time-optimal trajectory
+      @param initial_path_velocity Velocity along the path at its start, to continue a motion that is already
+      underway. It needs to allow stopping within the path, otherwise the generation fails. */
+  Trajectory(Path path, const Eigen::VectorXd& max_velocity, const Eigen::VectorXd& max_acceleration,
+             double time_step = 0.001, double initial_path_velocity = 0.0);
 
   ~Trajectory();
 
@@ -113,6 +137,10 @@ public:
   /** @brief Return the acceleration vector for a given point in time */
   Eigen::VectorXd getAcceleration(double time) const;
 
+  /** @brief Return position, velocity and acceleration for a given point in time, writing into preallocated vectors */
+  void getState(double time, Eigen::VectorXd& position, Eigen::VectorXd& velocity,
+                Eigen::VectorXd& acceleration) const;
+
 private:
   struct TrajectoryStep
   {
@@ -133,8 +161,8 @@ private:
                                          double& before_acceleration, double& after_acceleration);
   bool getNextVelocitySwitchingPoint(double path_pos, TrajectoryStep& next_switching_point, double& before_acceleration,
                                      double& after_acceleration);
-  bool integrateForward(std::list<TrajectoryStep>& trajectory, double acceleration);
-  void integrateBackward(std::list<TrajectoryStep>& start_trajectory, double path_pos, double path_vel,
+  bool integrateForward(std::vector<TrajectoryStep>& trajectory, double acceleration);
+  void integrateBackward(std::vector<TrajectoryStep>& start_trajectory, double path_pos, double path_vel,
                          double acceleration);
   double getMinMaxPathAcceleration(double path_position, double path_velocity, bool max);
   double getMinMaxPhaseSlope(double path_position, double path_velocity, bool max);
@@ -143,20 +171,25 @@ private:
   double getAccelerationMaxPathVelocityDeriv(double path_pos);
   double getVelocityMaxPathVelocityDeriv(double path_pos);
 
-  std::list<TrajectoryStep>::const_iterator getTrajectorySegment(double time) const;
+  /** @brief Index of the first step after time (binary search), clamped to the last step */
+  std::size_t getTrajectorySegment(double time) const;
+
+  /** @brief Path position and velocity at a given point in time. Returns the index of the step before time */
+  std::size_t getPathState(double time, double& path_pos, double& path_vel) const;
 
   Path path_;
   Eigen::VectorXd max_velocity_;
   Eigen::VectorXd max_acceleration_;
   unsigned int joint_num_;
   bool valid_;
-  std::list<TrajectoryStep> trajectory_;
-  std::list<TrajectoryStep> end_trajectory_;  // non-empty only if the trajectory generation failed.
+  std::vector<TrajectoryStep> trajectory_;
+  std::vector<TrajectoryStep> end_trajectory_;  // non-empty only if the trajectory generation failed.
 
   const double time_step_;
 
-  mutable double cached_time_;
-  mutable std::list<TrajectoryStep>::const_iterator cached_trajectory_segment_;
+  // scratch space for the path derivatives, so that the integration does not allocate
+  mutable Eigen::VectorXd tangent_;
+  mutable Eigen::VectorXd curvature_;
 };
 
 class TimeOptimalTrajectoryGeneration
@@ -169,9 +202,29 @@ public:
   bool computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory, const double max_velocity_scaling_factor = 1.0,
                          const double max_acceleration_scaling_factor = 1.0) const;
 
+  /** @brief Time-parameterize many trajectories of the same group across worker threads.
+      The joint limits are looked up once for the whole batch and every worker reuses its buffers.
+      @param durations Receives the duration of each trajectory, or -1.0 where the parameterization failed
+      @param thread_count Maximum number of workers, 0 for one per thread of the global moveit::core::WorkerPool
+      @return true if all trajectories were parameterized */
+  bool computeTimeStamps(const std::vector<robot_trajectory::RobotTrajectoryPtr>& trajectories,
+                         std::vector<double>& durations, const double max_velocity_scaling_factor = 1.0,
+                         const double max_acceleration_scaling_factor = 1.0, const unsigned int thread_count = 0) const;
+
 private:
+  struct Workspace;
+
+  bool computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory, const Eigen::VectorXd& max_velocity,
+                         const Eigen::VectorXd& max_acceleration, Workspace& workspace) const;
+
   const double path_tolerance_;
   const double resample_dt_;
   const double min_angle_change_;
 };
+
+/** @brief Get the velocity and acceleration limits TimeOptimalTrajectoryGeneration uses for the variables of group.
+    Unbounded variables default to 1.0 and all limits are at least 0.01, so that the integration terminates. */
+void getTimeOptimalLimits(const moveit::core::JointModelGroup* group, double velocity_scaling_factor,
+                          double acceleration_scaling_factor, Eigen::VectorXd& max_velocity,
+                          Eigen::VectorXd& max_acceleration);
 }  // namespace trajectory_processing
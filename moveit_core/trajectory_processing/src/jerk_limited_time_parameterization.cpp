@@ -0,0 +1,476 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/trajectory_processing/jerk_limited_time_parameterization.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <ros/console.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace trajectory_processing
+{
+namespace
+{
+const std::string LOGNAME = "trajectory_processing.jerk_limited_time_parameterization";
+
+// segments are stretched until all limits are met within this tolerance, then the whole trajectory is scaled
+constexpr double LIMIT_TOLERANCE = 1.01;
+constexpr unsigned int MAX_ITERATIONS = 1000;
+// segments leaving the position bounds or the path are refined at most this many times
+constexpr unsigned int MAX_REFINEMENTS = 6;
+// factor by which segments overshooting the position bounds are slowed down
+constexpr double OVERSHOOT_TIME_FACTOR = 1.5;
+
+// The path of a single joint along the spline knots
+struct SingleJointSpline
+{
+  std::vector<double> positions_;
+  std::vector<double> velocities_;
+  std::vector<double> accelerations_;
+  bool position_bounded_;
+  double min_position_;
+  double max_position_;
+  double max_velocity_;
+  double max_acceleration_;
+  double max_jerk_;
+};
+
+/*
+  Fit a cubic spline with zero velocity at both ends through the positions x, with time intervals dt.
+  The accelerations a at the knots solve the tridiagonal system
+    dt[i-1] * a[i-1] + 2 * (dt[i-1] + dt[i]) * a[i] + dt[i] * a[i+1] =
+        6 * ((x[i+1] - x[i]) / dt[i] - (x[i] - x[i-1]) / dt[i-1])
+  with the first and last rows clamping the end velocities. The jerk is constant on each segment.
+*/
+void fitCubicSpline(const std::vector<double>& dt, SingleJointSpline& spline, std::vector<double>& scratch)
+{
+  const std::vector<double>& x = spline.positions_;
+  std::vector<double>& v = spline.velocities_;
+  std::vector<double>& a = spline.accelerations_;
+  const std::size_t n = x.size();
+  // v holds the right hand side and scratch the modified upper diagonal during the forward sweep
+  scratch.resize(n);
+
+  double diag = 2.0 * dt[0];
+  scratch[0] = dt[0] / diag;
+  v[0] = 6.0 * (x[1] - x[0]) / dt[0] / diag;
+  for (std::size_t i = 1; i < n; ++i)
+  {
+    const double lower = dt[i - 1];
+    const double upper = i + 1 < n ? dt[i] : 0.0;
+    double rhs;
+    if (i + 1 < n)
+    {
+      diag = 2.0 * (dt[i - 1] + dt[i]);
+      rhs = 6.0 * ((x[i + 1] - x[i]) / dt[i] - (x[i] - x[i - 1]) / dt[i - 1]);
+    }
+    else
+    {
+      diag = 2.0 * dt[i - 1];
+      rhs = -6.0 * (x[i] - x[i - 1]) / dt[i - 1];
+    }
+    const double denom = diag - lower * scratch[i - 1];
+    scratch[i] = upper / denom;
+    v[i] = (rhs - lower * v[i - 1]) / denom;
+  }
+
+  a[n - 1] = v[n - 1];
+  for (std::size_t i = n - 1; i-- > 0;)
+    a[i] = v[i] - scratch[i] * a[i + 1];
+
+  for (std::size_t i = 0; i + 1 < n; ++i)
+    v[i] = (x[i + 1] - x[i]) / dt[i] - (2.0 * a[i] + a[i + 1]) * dt[i] / 6.0;
+  v[n - 1] = 0.0;
+}
+
+/*
+  Move the second and second-last knot so that the spline also starts and ends with zero acceleration.
+  The end accelerations are linear in these two positions, so two extra fits give the 2x2 system to solve.
+*/
+void fitCubicSplineAtRest(const std::vector<double>& dt, SingleJointSpline& spline, std::vector<double>& scratch)
+{
+  std::vector<double>& x = spline.positions_;
+  const std::size_t n = x.size();
+  const std::size_t first = 1;
+  const std::size_t last = n - 2;
+
+  fitCubicSpline(dt, spline, scratch);
+  const double a0 = spline.accelerations_[0];
+  const double an = spline.accelerations_[n - 1];
+
+  x[first] += 1.0;
+  fitCubicSpline(dt, spline, scratch);
+  const double d00 = spline.accelerations_[0] - a0;
+  const double dn0 = spline.accelerations_[n - 1] - an;
+  x[first] -= 1.0;
+
+  x[last] += 1.0;
+  fitCubicSpline(dt, spline, scratch);
+  const double d01 = spline.accelerations_[0] - a0;
+  const double dn1 = spline.accelerations_[n - 1] - an;
+  x[last] -= 1.0;
+
+  const double det = d00 * dn1 - d01 * dn0;
+  if (std::abs(det) > std::numeric_limits<double>::epsilon())
+  {
+    x[first] += (-a0 * dn1 + an * d01) / det;
+    x[last] += (-an * d00 + a0 * dn0) / det;
+  }
+  fitCubicSpline(dt, spline, scratch);
+}
+
+// Factor by which segment i needs to be stretched to satisfy the limits of this joint
+double getSegmentTimeFactor(const std::vector<double>& dt, const SingleJointSpline& spline, std::size_t i)
+{
+  const double v0 = spline.velocities_[i];
+  const double a0 = spline.accelerations_[i];
+  const double a1 = spline.accelerations_[i + 1];
+  const double jerk = (a1 - a0) / dt[i];
+
+  // the velocity peaks at the knots or where the (linear) acceleration crosses zero
+  double max_velocity = std::max(std::abs(v0), std::abs(spline.velocities_[i + 1]));
+  if (jerk != 0.0)
+  {
+    const double t = -a0 / jerk;
+    if (t > 0.0 && t < dt[i])
+      max_velocity = std::max(max_velocity, std::abs(v0 + a0 * t + 0.5 * jerk * t * t));
+  }
+
+  // stretching a segment by f scales velocities by 1/f, accelerations by 1/f^2 and jerks by 1/f^3
+  double factor = max_velocity / spline.max_velocity_;
+  factor = std::max(factor, std::sqrt(std::max(std::abs(a0), std::abs(a1)) / spline.max_acceleration_));
+  factor = std::max(factor, std::cbrt(std::abs(jerk) / spline.max_jerk_));
+  return factor;
+}
+
+// Insert two intermediate knots into each segment of very short trajectories, which need at least four knots
+void subdivide(std::vector<double>& dt, std::vector<SingleJointSpline>& splines)
+{
+  std::vector<double> new_dt;
+  for (double d : dt)
+    new_dt.insert(new_dt.end(), 3, d / 3.0);
+  for (SingleJointSpline& spline : splines)
+  {
+    std::vector<double> positions;
+    for (std::size_t i = 0; i + 1 < spline.positions_.size(); ++i)
+      for (int k = 0; k < 3; ++k)
+        positions.push_back(spline.positions_[i] + k * (spline.positions_[i + 1] - spline.positions_[i]) / 3.0);
+    positions.push_back(spline.positions_.back());
+    spline.positions_ = positions;
+    spline.velocities_.resize(positions.size());
+    spline.accelerations_.resize(positions.size());
+  }
+  dt = new_dt;
+}
+
+// Position of the spline at time t into segment i
+double getSplinePosition(const std::vector<double>& dt, const SingleJointSpline& spline, std::size_t i, double t)
+{
+  const double a0 = spline.accelerations_[i];
+  const double jerk = (spline.accelerations_[i + 1] - a0) / dt[i];
+  return spline.positions_[i] + t * (spline.velocities_[i] + t * (0.5 * a0 + t * jerk / 6.0));
+}
+
+// Check that segment i of the spline stays within the position bounds of its joint
+bool isSegmentWithinBounds(const std::vector<double>& dt, const SingleJointSpline& spline,
+                           const std::vector<double>& path, std::size_t i)
+{
+  if (!spline.position_bounded_)
+    return true;
+  // never be stricter than the path itself, which may start or end slightly out of bounds
+  const double min_position = std::min({ spline.min_position_, path[i], path[i + 1] });
+  const double max_position = std::max({ spline.max_position_, path[i], path[i + 1] });
+
+  // the position peaks at the knots or where the (quadratic) velocity crosses zero
+  double lowest = std::min(spline.positions_[i], spline.positions_[i + 1]);
+  double highest = std::max(spline.positions_[i], spline.positions_[i + 1]);
+  const double v0 = spline.velocities_[i];
+  const double a0 = spline.accelerations_[i];
+  const double jerk = (spline.accelerations_[i + 1] - a0) / dt[i];
+  std::vector<double> roots;
+  if (jerk != 0.0)
+  {
+    const double discriminant = a0 * a0 - 2.0 * jerk * v0;
+    if (discriminant >= 0.0)
+    {
+      roots.push_back((-a0 + std::sqrt(discriminant)) / jerk);
+      roots.push_back((-a0 - std::sqrt(discriminant)) / jerk);
+    }
+  }
+  else if (a0 != 0.0)
+    roots.push_back(-v0 / a0);
+  for (double t : roots)
+  {
+    if (t > 0.0 && t < dt[i])
+    {
+      const double position = getSplinePosition(dt, spline, i, t);
+      lowest = std::min(lowest, position);
+      highest = std::max(highest, position);
+    }
+  }
+  return lowest >= min_position && highest <= max_position;
+}
+
+// Distance in joint space between knot i of the splines and the corresponding knot on the path
+double getDistanceFromPath(const std::vector<SingleJointSpline>& splines, const std::vector<std::vector<double>>& path,
+                           std::size_t i)
+{
+  double squared_distance = 0.0;
+  for (std::size_t j = 0; j < splines.size(); ++j)
+    squared_distance += std::pow(splines[j].positions_[i] - path[j][i], 2);
+  return std::sqrt(squared_distance);
+}
+
+// Split the given (sorted) segments in half, adding a knot on the path in the middle of each
+void splitSegments(const std::vector<std::size_t>& segments, std::vector<double>& dt,
+                   std::vector<SingleJointSpline>& splines, std::vector<std::vector<double>>& path)
+{
+  std::vector<double> new_dt;
+  std::vector<std::vector<double>> new_path(path.size());
+  std::vector<std::size_t>::const_iterator split = segments.begin();
+  for (std::size_t i = 0; i < dt.size(); ++i)
+  {
+    for (std::size_t j = 0; j < path.size(); ++j)
+      new_path[j].push_back(path[j][i]);
+    if (split != segments.end() && *split == i)
+    {
+      new_dt.insert(new_dt.end(), 2, dt[i] / 2.0);
+      for (std::size_t j = 0; j < path.size(); ++j)
+        new_path[j].push_back(0.5 * (path[j][i] + path[j][i + 1]));
+      ++split;
+    }
+    else
+      new_dt.push_back(dt[i]);
+  }
+  for (std::size_t j = 0; j < path.size(); ++j)
+  {
+    new_path[j].push_back(path[j].back());
+    splines[j].positions_ = new_path[j];
+    splines[j].velocities_.resize(new_path[j].size());
+    splines[j].accelerations_.resize(new_path[j].size());
+  }
+  dt = new_dt;
+  path = new_path;
+}
+
+// Stretch the segments of the splines until all velocity, acceleration and jerk limits hold
+void fitSplinesWithinLimits(std::vector<double>& dt, std::vector<SingleJointSpline>& splines,
+                            std::vector<double>& scratch)
+{
+  // Stretch the segments violating a limit, a bit at a time as stretching also affects the neighbors
+  std::vector<double> time_factor(dt.size());
+  for (unsigned int iteration = 0; iteration < MAX_ITERATIONS; ++iteration)
+  {
+    bool within_limits = true;
+    std::fill(time_factor.begin(), time_factor.end(), 1.0);
+    for (SingleJointSpline& spline : splines)
+    {
+      fitCubicSplineAtRest(dt, spline, scratch);
+      for (std::size_t i = 0; i < dt.size(); ++i)
+      {
+        const double factor = getSegmentTimeFactor(dt, spline, i);
+        if (factor > LIMIT_TOLERANCE)
+          within_limits = false;
+        time_factor[i] = std::max(time_factor[i], (factor - 1.0) / 16.0 + 1.0);
+      }
+    }
+    if (within_limits)
+      break;
+    for (std::size_t i = 0; i < dt.size(); ++i)
+      dt[i] *= time_factor[i];
+  }
+
+  // Scaling all intervals by the same factor keeps the knot positions, so this forces all limits to hold exactly
+  double global_factor = 1.0;
+  for (SingleJointSpline& spline : splines)
+  {
+    fitCubicSplineAtRest(dt, spline, scratch);
+    for (std::size_t i = 0; i < dt.size(); ++i)
+      global_factor = std::max(global_factor, getSegmentTimeFactor(dt, spline, i));
+  }
+  if (global_factor > 1.0)
+  {
+    for (double& d : dt)
+      d *= global_factor;
+    for (SingleJointSpline& spline : splines)
+      fitCubicSpline(dt, spline, scratch);
+  }
+}
+}  // namespace
+
+JerkLimitedTimeParameterization::JerkLimitedTimeParameterization(const double path_tolerance,
+                                                                 const double resample_dt,
+                                                                 const double min_angle_change)
+  : path_tolerance_(path_tolerance), resample_dt_(resample_dt), min_angle_change_(min_angle_change)
+{
+}
+
+void JerkLimitedTimeParameterization::setJerkLimits(const std::map<std::string, double>& jerk_limits)
+{
+  jerk_limits_ = jerk_limits;
+}
+
+bool JerkLimitedTimeParameterization::computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory,
+                                                        const double max_velocity_scaling_factor,
+                                                        const double max_acceleration_scaling_factor) const
+{
+  // time-optimal parameterization under velocity and acceleration limits; this also validates the input
+  TimeOptimalTrajectoryGeneration totg(path_tolerance_, resample_dt_, min_angle_change_);
+  if (!totg.computeTimeStamps(trajectory, max_velocity_scaling_factor, max_acceleration_scaling_factor))
+    return false;
+  if (trajectory.getWayPointCount() < 2)
+    return true;
+
+  const moveit::core::JointModelGroup* group = trajectory.getGroup();
+  const std::vector<std::string>& vars = group->getVariableNames();
+  const std::vector<int>& idx = group->getVariableIndexList();
+  const moveit::core::RobotModel& rmodel = group->getParentModel();
+  const std::size_t num_joints = group->getVariableCount();
+  const std::size_t num_points = trajectory.getWayPointCount();
+
+  const double velocity_scaling_factor =
+      max_velocity_scaling_factor > 0.0 && max_velocity_scaling_factor <= 1.0 ? max_velocity_scaling_factor : 1.0;
+  const double acceleration_scaling_factor =
+      max_acceleration_scaling_factor > 0.0 && max_acceleration_scaling_factor <= 1.0 ?
+          max_acceleration_scaling_factor :
+          1.0;
+
+  std::vector<double> dt(num_points - 1);
+  for (std::size_t i = 1; i < num_points; ++i)
+    dt[i - 1] = trajectory.getWayPointDurationFromPrevious(i);
+
+  // Same limits as used by TimeOptimalTrajectoryGeneration, plus the jerk limits
+  Eigen::VectorXd max_velocity, max_acceleration;
+  getTimeOptimalLimits(group, velocity_scaling_factor, acceleration_scaling_factor, max_velocity, max_acceleration);
+  std::vector<SingleJointSpline> splines(num_joints);
+  for (std::size_t j = 0; j < num_joints; ++j)
+  {
+    SingleJointSpline& spline = splines[j];
+    spline.positions_.resize(num_points);
+    for (std::size_t i = 0; i < num_points; ++i)
+      spline.positions_[i] = trajectory.getWayPoint(i).getVariablePosition(idx[j]);
+    spline.velocities_.resize(num_points);
+    spline.accelerations_.resize(num_points);
+
+    const moveit::core::VariableBounds& bounds = rmodel.getVariableBounds(vars[j]);
+    spline.position_bounded_ = bounds.position_bounded_;
+    spline.min_position_ = bounds.min_position_;
+    spline.max_position_ = bounds.max_position_;
+    spline.max_velocity_ = max_velocity[j];
+    spline.max_acceleration_ = max_acceleration[j];
+
+    std::map<std::string, double>::const_iterator jerk_limit = jerk_limits_.find(vars[j]);
+    spline.max_jerk_ = std::numeric_limits<double>::infinity();
+    if (jerk_limit != jerk_limits_.end())
+    {
+      if (jerk_limit->second <= 0.0)
+      {
+        ROS_ERROR_NAMED(LOGNAME, "Jerk limit %f of variable '%s' must be greater than zero", jerk_limit->second,
+                        vars[j].c_str());
+        return false;
+      }
+      spline.max_jerk_ = jerk_limit->second;
+    }
+  }
+
+  if (num_points < 4)
+    subdivide(dt, splines);
+
+  // The knots initially lie on the path found by TimeOptimalTrajectoryGeneration. Moving the second and second-last
+  // knot must keep the spline within path_tolerance_ of it, which is achieved by splitting the adjacent segments,
+  // and the cubic overshoot between the knots must stay within the position bounds, which is achieved by slowing
+  // down the overshooting segments.
+  std::vector<std::vector<double>> path(num_joints);
+  for (std::size_t j = 0; j < num_joints; ++j)
+    path[j] = splines[j].positions_;
+
+  std::vector<double> scratch;
+  std::vector<std::size_t> off_path_segments;
+  std::vector<std::size_t> out_of_bounds_segments;
+  for (unsigned int refinement = 0;; ++refinement)
+  {
+    fitSplinesWithinLimits(dt, splines, scratch);
+
+    off_path_segments.clear();
+    for (std::size_t i : { std::size_t(1), dt.size() - 1 })
+      if (getDistanceFromPath(splines, path, i) > path_tolerance_)
+        off_path_segments.insert(off_path_segments.end(), { i - 1, i });
+    std::sort(off_path_segments.begin(), off_path_segments.end());
+    off_path_segments.erase(std::unique(off_path_segments.begin(), off_path_segments.end()), off_path_segments.end());
+
+    out_of_bounds_segments.clear();
+    for (std::size_t i = 0; i < dt.size(); ++i)
+      for (std::size_t j = 0; j < num_joints; ++j)
+        if (!isSegmentWithinBounds(dt, splines[j], path[j], i))
+        {
+          out_of_bounds_segments.push_back(i);
+          break;
+        }
+
+    if (off_path_segments.empty() && out_of_bounds_segments.empty())
+      break;
+    if (refinement == MAX_REFINEMENTS)
+    {
+      ROS_ERROR_NAMED(LOGNAME, "Jerk-limited trajectory leaves the position bounds or deviates from the path by more "
+                               "than %f",
+                      path_tolerance_);
+      return false;
+    }
+    for (std::size_t i : out_of_bounds_segments)
+      dt[i] *= OVERSHOOT_TIME_FACTOR;
+    for (std::size_t j = 0; j < num_joints; ++j)
+      splines[j].positions_ = path[j];
+    if (!off_path_segments.empty())
+      splitSegments(off_path_segments, dt, splines, path);
+  }
+
+  // Convert back into a RobotTrajectory
+  moveit::core::RobotState waypoint = trajectory.getWayPoint(0);
+  trajectory.clear();
+  for (std::size_t i = 0; i <= dt.size(); ++i)
+  {
+    for (std::size_t j = 0; j < num_joints; ++j)
+    {
+      waypoint.setVariablePosition(idx[j], splines[j].positions_[i]);
+      waypoint.setVariableVelocity(idx[j], splines[j].velocities_[i]);
+      waypoint.setVariableAcceleration(idx[j], splines[j].accelerations_[i]);
+    }
+    waypoint.update();
+    trajectory.addSuffixWayPoint(waypoint, i > 0 ? dt[i - 1] : 0.0);
+  }
+  return true;
+}
+}  // namespace trajectory_processing
@@ -0,0 +1,276 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/trajectory_processing/streaming_time_parameterization.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <ros/console.h>
+#include <algorithm>
+#include <cmath>
+
+namespace trajectory_processing
+{
+namespace
+{
+const std::string LOGNAME = "trajectory_processing.streaming_time_parameterization";
+
+// samples closer than this to a straight segment of the waypoint path are considered to lie on it
+constexpr double STRAIGHT_TOLERANCE = 1e-9;
+// the path reverses at a waypoint if the sum of the directions before and after it is shorter than this
+constexpr double REVERSAL_TOLERANCE = 1e-6;
+
+// The path turns back at points[i]. It cannot be blended there, the motion has to come to rest instead
+bool isReversal(const std::vector<Eigen::VectorXd>& points, std::size_t i)
+{
+  return ((points[i] - points[i - 1]).normalized() + (points[i + 1] - points[i]).normalized()).norm() <
+         REVERSAL_TOLERANCE;
+}
+
+double getScalingFactor(double max_scaling_factor, const char* name)
+{
+  if (max_scaling_factor > 0.0 && max_scaling_factor <= 1.0)
+    return max_scaling_factor;
+  if (max_scaling_factor == 0.0)
+    ROS_DEBUG_NAMED(LOGNAME, "A %s of 0.0 was specified, defaulting to 1.0 instead.", name);
+  else
+    ROS_WARN_NAMED(LOGNAME, "Invalid %s %f specified, defaulting to 1.0 instead.", name, max_scaling_factor);
+  return 1.0;
+}
+}  // namespace
+
+StreamingTimeParameterization::StreamingTimeParameterization(const moveit::core::RobotState& start_state,
+                                                             const moveit::core::JointModelGroup* group,
+                                                             const double max_velocity_scaling_factor,
+                                                             const double max_acceleration_scaling_factor,
+                                                             const double path_tolerance, const double resample_dt,
+                                                             const double min_angle_change)
+  : group_(group)
+  , path_tolerance_(path_tolerance)
+  , resample_dt_(resample_dt)
+  , min_angle_change_(min_angle_change)
+  , velocity_(0.0)
+  , start_committed_(false)
+  , committed_duration_(0.0)
+  , waypoint_(start_state)
+{
+  getTimeOptimalLimits(group, getScalingFactor(max_velocity_scaling_factor, "max_velocity_scaling_factor"),
+                       getScalingFactor(max_acceleration_scaling_factor, "max_acceleration_scaling_factor"),
+                       max_velocity_, max_acceleration_);
+
+  // TimeOptimalTrajectoryGeneration does not handle wrap-arounds, so continuous joints get unwound as points arrive
+  const std::vector<int>& idx = group->getVariableIndexList();
+  const moveit::core::RobotModel& rmodel = group->getParentModel();
+  continuous_.resize(idx.size(), false);
+  Eigen::VectorXd start(idx.size());
+  for (std::size_t j = 0; j < idx.size(); ++j)
+  {
+    const moveit::core::JointModel* joint = rmodel.getJointOfVariable(idx[j]);
+    continuous_[j] = joint->getType() == moveit::core::JointModel::REVOLUTE &&
+                     static_cast<const moveit::core::RevoluteJointModel*>(joint)->isContinuous();
+    start[j] = start_state.getVariablePosition(idx[j]);
+  }
+  points_.push_back(start);
+  waypoint_.zeroVelocities();
+  waypoint_.zeroAccelerations();
+}
+
+void StreamingTimeParameterization::addWayPoint(const moveit::core::RobotState& state)
+{
+  const std::vector<int>& idx = group_->getVariableIndexList();
+  const Eigen::VectorXd& previous = points_.back();
+  Eigen::VectorXd point(idx.size());
+  bool diverse_point = false;
+  for (std::size_t j = 0; j < idx.size(); ++j)
+  {
+    point[j] = state.getVariablePosition(idx[j]);
+    if (continuous_[j])
+    {
+      const double delta = point[j] - previous[j];
+      point[j] = previous[j] + delta - 2.0 * M_PI * std::round(delta / (2.0 * M_PI));
+    }
+    if (std::abs(point[j] - previous[j]) > min_angle_change_)
+      diverse_point = true;
+  }
+
+  if (diverse_point)
+    points_.push_back(point);
+}
+
+bool StreamingTimeParameterization::computeTimeStamps(robot_trajectory::RobotTrajectory& committed,
+                                                      robot_trajectory::RobotTrajectory& tail)
+{
+  tail.clear();
+  return parameterize(committed, &tail);
+}
+
+bool StreamingTimeParameterization::finish(robot_trajectory::RobotTrajectory& committed)
+{
+  return parameterize(committed, nullptr);
+}
+
+void StreamingTimeParameterization::setWayPoint(const Eigen::VectorXd& position, const Eigen::VectorXd& velocity,
+                                                const Eigen::VectorXd& acceleration)
+{
+  const std::vector<int>& idx = group_->getVariableIndexList();
+  for (std::size_t j = 0; j < idx.size(); ++j)
+  {
+    waypoint_.setVariablePosition(idx[j], position[j]);
+    waypoint_.setVariableVelocity(idx[j], velocity[j]);
+    waypoint_.setVariableAcceleration(idx[j], acceleration[j]);
+  }
+}
+
+bool StreamingTimeParameterization::parameterize(robot_trajectory::RobotTrajectory& committed,
+                                                 robot_trajectory::RobotTrajectory* tail)
+{
+  const std::size_t num_joints = points_[0].size();
+  if (!start_committed_)
+  {
+    const Eigen::VectorXd zero = Eigen::VectorXd::Zero(num_joints);
+    setWayPoint(points_[0], zero, zero);
+    committed.addSuffixWayPoint(waypoint_, 0.0);
+    start_committed_ = true;
+  }
+  if (points_.size() < 2)
+    return true;
+
+  // TimeOptimalTrajectoryGeneration cannot blend a path turning back on itself, so the path is split into pieces
+  // ending at rest where it reverses. piece_ends[p] is the index of the last point of piece p
+  std::vector<std::size_t> piece_ends;
+  for (std::size_t i = 1; i + 1 < points_.size(); ++i)
+    if (isReversal(points_, i))
+      piece_ends.push_back(i);
+  piece_ends.push_back(points_.size() - 1);
+
+  std::vector<Trajectory> pieces;
+  std::vector<double> piece_starts;
+  pieces.reserve(piece_ends.size());
+  double duration = 0.0;
+  for (std::size_t p = 0; p < piece_ends.size(); ++p)
+  {
+    const std::size_t first = p > 0 ? piece_ends[p - 1] : 0;
+    pieces.emplace_back(Path(std::vector<Eigen::VectorXd>(points_.begin() + first, points_.begin() + piece_ends[p] + 1),
+                             path_tolerance_),
+                        max_velocity_, max_acceleration_, 0.001, p > 0 ? 0.0 : velocity_);
+    if (!pieces.back().isValid())
+    {
+      ROS_ERROR_NAMED(LOGNAME, "Unable to parameterize trajectory.");
+      return false;
+    }
+    piece_starts.push_back(duration);
+    duration += pieces.back().getDuration();
+  }
+
+  // Resample, always including the end of the trajectory. The first point is already committed
+  const std::size_t sample_count = std::ceil(duration / resample_dt_);
+  std::vector<double> times(sample_count);
+  std::vector<std::size_t> sample_pieces(sample_count);
+  std::vector<Eigen::VectorXd> positions(sample_count, Eigen::VectorXd(num_joints));
+  std::vector<Eigen::VectorXd> velocities(sample_count, Eigen::VectorXd(num_joints));
+  std::vector<Eigen::VectorXd> accelerations(sample_count, Eigen::VectorXd(num_joints));
+  std::size_t piece = 0;
+  for (std::size_t k = 0; k < sample_count; ++k)
+  {
+    times[k] = std::min(duration, (k + 1) * resample_dt_);
+    while (piece + 1 < pieces.size() && times[k] > piece_starts[piece + 1])
+      ++piece;
+    sample_pieces[k] = piece;
+    pieces[piece].getState(times[k] - piece_starts[piece], positions[k], velocities[k], accelerations[k]);
+  }
+
+  // A sample can be committed if it lies on the straight line from points_[j] to points_[j + 1] and braking along
+  // it takes at most half the distance left to points_[j + 1]. The blend at points_[j + 1] takes at most the other
+  // half when the path is rebuilt starting at the sample, so stopping stays feasible whatever waypoints follow.
+  // Segments are only searched forward within the piece of the sample, and the sample has to move towards
+  // points_[j + 1], so that a path retracing itself does not assign samples to a segment running the opposite way.
+  std::size_t commit_count = tail ? 0 : sample_count;
+  std::size_t commit_segment = 0;
+  std::size_t segment = 0;
+  for (std::size_t k = 0; tail && k < sample_count; ++k)
+  {
+    const std::size_t piece_begin = sample_pieces[k] > 0 ? piece_ends[sample_pieces[k] - 1] : 0;
+    for (std::size_t j = std::max(segment, piece_begin); j < piece_ends[sample_pieces[k]]; ++j)
+    {
+      Eigen::VectorXd direction = points_[j + 1] - points_[j];
+      const double length = direction.norm();
+      direction /= length;
+      const double along = (positions[k] - points_[j]).dot(direction);
+      if (along < 0.0 || along > length || velocities[k].dot(direction) <= 0.0 ||
+          (positions[k] - points_[j] - along * direction).norm() > STRAIGHT_TOLERANCE)
+        continue;
+
+      segment = j;
+      const double remaining = length - along;
+      const double path_acceleration = (max_acceleration_.array() / direction.array().abs()).minCoeff();
+      const double path_velocity = velocities[k].norm();
+      if (remaining > min_angle_change_ && path_velocity * path_velocity / path_acceleration <= remaining)
+      {
+        commit_count = k + 1;
+        commit_segment = j;
+      }
+      break;
+    }
+  }
+
+  double last_time = 0.0;
+  for (std::size_t k = 0; k < sample_count; ++k)
+  {
+    setWayPoint(positions[k], velocities[k], accelerations[k]);
+    if (k < commit_count)
+      committed.addSuffixWayPoint(waypoint_, times[k] - last_time);
+    else
+      tail->addSuffixWayPoint(waypoint_, times[k] - last_time);
+    last_time = times[k];
+  }
+
+  if (!tail)
+  {
+    committed_duration_ += duration;
+    points_.erase(points_.begin(), points_.end() - 1);
+    velocity_ = 0.0;
+  }
+  else if (commit_count > 0)
+  {
+    const std::size_t last = commit_count - 1;
+    committed_duration_ += times[last];
+    points_.erase(points_.begin(), points_.begin() + commit_segment + 1);
+    points_.insert(points_.begin(), positions[last]);
+
+    // the sample moves along the first segment of the new path, clamp numerical noise to its velocity limit
+    const Eigen::VectorXd direction = (points_[1] - points_[0]).normalized();
+    velocity_ = std::min(velocities[last].norm(), (max_velocity_.array() / direction.array().abs()).minCoeff());
+  }
+  return true;
+}
+}  // namespace trajectory_processing
@@ -39,8 +39,10 @@
 #include <limits>
 #include <Eigen/Geometry>
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <moveit/utils/worker_pool.h>
 #include <ros/console.h>
 #include <vector>
 
@@ -52,20 +54,20 @@ class LinearPathSegment : public PathSegment
 {
 public:
   LinearPathSegment(const Eigen::VectorXd& start, const Eigen::VectorXd& end)
-    : PathSegment((end - start).norm()), end_(end), start_(start)
+    : PathSegment((end - start).norm()), end_(end), start_(start), tangent_((end - start) / length_)
   {
   }
 
   Eigen::VectorXd getConfig(double s) const override
   {
-    s /= length_;
-    s = std::max(0.0, std::min(1.0, s));
-    return (1.0 - s) * start_ + s * end_;
+    Eigen::VectorXd config;
+    getConfig(s, config);
+    return config;
   }
 
   Eigen::VectorXd getTangent(double /* s */) const override
   {
-    return (end_ - start_) / length_;
+    return tangent_;
   }
 
   Eigen::VectorXd getCurvature(double /* s */) const override
@@ -73,6 +75,23 @@ public:
     return Eigen::VectorXd::Zero(start_.size());
   }
 
+  void getConfig(double s, Eigen::VectorXd& config) const override
+  {
+    s /= length_;
+    s = std::max(0.0, std::min(1.0, s));
+    config = (1.0 - s) * start_ + s * end_;
+  }
+
+  void getTangent(double /* s */, Eigen::VectorXd& tangent) const override
+  {
+    tangent = tangent_;
+  }
+
+  void getCurvature(double /* s */, Eigen::VectorXd& curvature) const override
+  {
+    curvature.setZero(start_.size());
+  }
+
   std::list<double> getSwitchingPoints() const override
   {
     return std::list<double>();
@@ -86,6 +105,7 @@ public:
 private:
   Eigen::VectorXd end_;
   Eigen::VectorXd start_;
+  Eigen::VectorXd tangent_;
 };
 
 class CircularPathSegment : public PathSegment
@@ -136,20 +156,41 @@ public:
 
   Eigen::VectorXd getConfig(double s) const override
   {
-    const double angle = s / radius;
-    return center + radius * (x * cos(angle) + y * sin(angle));
+    Eigen::VectorXd config;
+    getConfig(s, config);
+    return config;
   }
 
   Eigen::VectorXd getTangent(double s) const override
   {
-    const double angle = s / radius;
-    return -x * sin(angle) + y * cos(angle);
+    Eigen::VectorXd tangent;
+    getTangent(s, tangent);
+    return tangent;
   }
 
   Eigen::VectorXd getCurvature(double s) const override
+  {
+    Eigen::VectorXd curvature;
+    getCurvature(s, curvature);
+    return curvature;
+  }
+
+  void getConfig(double s, Eigen::VectorXd& config) const override
+  {
+    const double angle = s / radius;
+    config = center + radius * (x * cos(angle) + y * sin(angle));
+  }
+
+  void getTangent(double s, Eigen::VectorXd& tangent) const override
   {
     const double angle = s / radius;
-    return -1.0 / radius * (x * cos(angle) + y * sin(angle));
+    tangent = -x * sin(angle) + y * cos(angle);
+  }
+
+  void getCurvature(double s, Eigen::VectorXd& curvature) const override
+  {
+    const double angle = s / radius;
+    curvature = -1.0 / radius * (x * cos(angle) + y * sin(angle));
   }
 
   std::list<double> getSwitchingPoints() const override
@@ -187,50 +228,61 @@ private:
 
 Path::Path(const std::list<Eigen::VectorXd>& path, double max_deviation) : length_(0.0)
 {
-  if (path.size() < 2)
+  const std::vector<Eigen::VectorXd> points(path.begin(), path.end());
+  initialize(points.begin(), points.end(), max_deviation);
+}
+
+Path::Path(const std::vector<Eigen::VectorXd>& path, double max_deviation) : length_(0.0)
+{
+  initialize(path.begin(), path.end(), max_deviation);
+}
+
+Path::Path(std::vector<Eigen::VectorXd>::const_iterator begin, std::vector<Eigen::VectorXd>::const_iterator end,
+           double max_deviation)
+  : length_(0.0)
+{
+  initialize(begin, end, max_deviation);
+}
+
+void Path::initialize(std::vector<Eigen::VectorXd>::const_iterator path,
+                      std::vector<Eigen::VectorXd>::const_iterator end, double max_deviation)
+{
+  const std::size_t size = end - path;
+  if (size < 2)
     return;
-  std::list<Eigen::VectorXd>::const_iterator path_iterator1 = path.begin();
-  std::list<Eigen::VectorXd>::const_iterator path_iterator2 = path_iterator1;
-  ++path_iterator2;
-  std::list<Eigen::VectorXd>::const_iterator path_iterator3;
-  Eigen::VectorXd start_config = *path_iterator1;
-  while (path_iterator2 != path.end())
-  {
-    path_iterator3 = path_iterator2;
-    ++path_iterator3;
-    if (max_deviation > 0.0 && path_iterator3 != path.end())
-    {
-      CircularPathSegment* blend_segment =
-          new CircularPathSegment(0.5 * (*path_iterator1 + *path_iterator2), *path_iterator2,
-                                  0.5 * (*path_iterator2 + *path_iterator3), max_deviation);
+  path_segments_.reserve(max_deviation > 0.0 ? 2 * size : size);
+  Eigen::VectorXd start_config = path[0];
+  for (std::size_t i = 1; i < size; ++i)
+  {
+    if (max_deviation > 0.0 && i + 1 < size)
+    {
+      std::unique_ptr<CircularPathSegment> blend_segment = std::make_unique<CircularPathSegment>(
+          0.5 * (path[i - 1] + path[i]), path[i], 0.5 * (path[i] + path[i + 1]), max_deviation);
       Eigen::VectorXd end_config = blend_segment->getConfig(0.0);
       if ((end_config - start_config).norm() > 0.000001)
       {
         path_segments_.push_back(std::make_unique<LinearPathSegment>(start_config, end_config));
       }
-      path_segments_.emplace_back(blend_segment);
-
       start_config = blend_segment->getConfig(blend_segment->getLength());
+      path_segments_.push_back(std::move(blend_segment));
     }
     else
     {
-      path_segments_.push_back(std::make_unique<LinearPathSegment>(start_config, *path_iterator2));
-      start_config = *path_iterator2;
+      path_segments_.push_back(std::make_unique<LinearPathSegment>(start_config, path[i]));
+      start_config = path[i];
     }
-    path_iterator1 = path_iterator2;
-    ++path_iterator2;
   }
 
   // Create list of switching point candidates, calculate total path length and
   // absolute positions of path segments
+  path_segment_positions_.reserve(path_segments_.size());
   for (std::unique_ptr<PathSegment>& path_segment : path_segments_)
   {
     path_segment->position_ = length_;
-    std::list<double> local_switching_points = path_segment->getSwitchingPoints();
-    for (std::list<double>::const_iterator point = local_switching_points.begin();
-         point != local_switching_points.end(); ++point)
+    path_segment_positions_.push_back(length_);
+    for (double point : path_segment->getSwitchingPoints())
     {
-      switching_points_.push_back(std::make_pair(length_ + *point, false));
+      switching_points_.push_back(std::make_pair(length_ + point, false));
     }
     length_ += path_segment->getLength();
     while (!switching_points_.empty() && switching_points_.back().first >= length_)
@@ -240,8 +292,12 @@ Path::Path(const std::list<Eigen::VectorXd>& path, double max_deviation) : lengt
   switching_points_.pop_back();
 }
 
-Path::Path(const Path& path) : length_(path.length_), switching_points_(path.switching_points_)
+Path::Path(const Path& path)
+  : length_(path.length_)
+  , switching_points_(path.switching_points_)
+  , path_segment_positions_(path.path_segment_positions_)
 {
+  path_segments_.reserve(path.path_segments_.size());
   for (const std::unique_ptr<PathSegment>& path_segment : path.path_segments_)
   {
     path_segments_.emplace_back(path_segment->clone());
@@ -253,18 +309,14 @@ double Path::getLength() const
   return length_;
 }
 
-PathSegment* Path::getPathSegment(double& s) const
+const PathSegment* Path::getPathSegment(double& s) const
 {
-  std::list<std::unique_ptr<PathSegment>>::const_iterator it = path_segments_.begin();
-  std::list<std::unique_ptr<PathSegment>>::const_iterator next = it;
-  ++next;
-  while (next != path_segments_.end() && s >= (*next)->position_)
-  {
-    it = next;
-    ++next;
-  }
-  s -= (*it)->position_;
-  return (*it).get();
+  // the last segment starting at or before s, or the first segment if s is before the start
+  const std::size_t index =
+      std::upper_bound(path_segment_positions_.begin() + 1, path_segment_positions_.end(), s) -
+      path_segment_positions_.begin() - 1;
+  s -= path_segment_positions_[index];
+  return path_segments_[index].get();
 }
 
 Eigen::VectorXd Path::getConfig(double s) const
@@ -285,13 +337,29 @@ Eigen::VectorXd Path::getCurvature(double s) const
   return path_segment->getCurvature(s);
 }
 
+void Path::getConfig(double s, Eigen::VectorXd& config) const
+{
+  const PathSegment* path_segment = getPathSegment(s);
+  path_segment->getConfig(s, config);
+}
+
+void Path::getTangent(double s, Eigen::VectorXd& tangent) const
+{
+  const PathSegment* path_segment = getPathSegment(s);
+  path_segment->getTangent(s, tangent);
+}
+
+void Path::getCurvature(double s, Eigen::VectorXd& curvature) const
+{
+  const PathSegment* path_segment = getPathSegment(s);
+  path_segment->getCurvature(s, curvature);
+}
+
 double Path::getNextSwitchingPoint(double s, bool& discontinuity) const
 {
-  std::list<std::pair<double, bool>>::const_iterator it = switching_points_.begin();
-  while (it != switching_points_.end() && it->first <= s)
-  {
-    ++it;
-  }
+  std::vector<std::pair<double, bool>>::const_iterator it =
+      std::upper_bound(switching_points_.begin(), switching_points_.end(), s,
+                       [](double value, const std::pair<double, bool>& point) { return value < point.first; });
   if (it == switching_points_.end())
   {
     discontinuity = true;
@@ -301,7 +369,7 @@ double Path::getNextSwitchingPoint(double s, bool& discontinuity) const
   return it->first;
 }
 
-std::list<std::pair<double, bool>> Path::getSwitchingPoints() const
+const std::vector<std::pair<double, bool>>& Path::getSwitchingPoints() const
 {
   return switching_points_;
 }
@@ -311,18 +379,19 @@ static double squared(double d)
   return d * d;
 }
 
-Trajectory::Trajectory(const Path& path, const Eigen::VectorXd& max_velocity, const Eigen::VectorXd& max_acceleration,
-                       double time_step)
-  : path_(path)
+Trajectory::Trajectory(Path path, const Eigen::VectorXd& max_velocity, const Eigen::VectorXd& max_acceleration,
+                       double time_step, double initial_path_velocity)
+  : path_(std::move(path))
   , max_velocity_(max_velocity)
   , max_acceleration_(max_acceleration)
   , joint_num_(max_velocity.size())
   , valid_(true)
   , time_step_(time_step)
-  , cached_time_(std::numeric_limits<double>::max())
+  , tangent_(joint_num_)
+  , curvature_(joint_num_)
 {
-  trajectory_.push_back(TrajectoryStep(0.0, 0.0));
-  double after_acceleration = getMinMaxPathAcceleration(0.0, 0.0, true);
+  trajectory_.push_back(TrajectoryStep(0.0, initial_path_velocity));
+  double after_acceleration = getMinMaxPathAcceleration(0.0, initial_path_velocity, true);
   while (valid_ && !integrateForward(trajectory_, after_acceleration) && valid_)
   {
     double before_acceleration;
@@ -343,16 +412,13 @@ Trajectory::Trajectory(const Path& path, const Eigen::VectorXd& max_velocity, co
   if (valid_)
   {
     // Calculate timing
-    std::list<TrajectoryStep>::iterator previous = trajectory_.begin();
-    std::list<TrajectoryStep>::iterator it = previous;
-    it->time_ = 0.0;
-    ++it;
-    while (it != trajectory_.end())
+    trajectory_[0].time_ = 0.0;
+    for (std::size_t i = 1; i < trajectory_.size(); ++i)
     {
-      it->time_ =
-          previous->time_ + (it->path_pos_ - previous->path_pos_) / ((it->path_vel_ + previous->path_vel_) / 2.0);
-      previous = it;
-      ++it;
+      const TrajectoryStep& previous = trajectory_[i - 1];
+      TrajectoryStep& step = trajectory_[i];
+      step.time_ =
+          previous.time_ + (step.path_pos_ - previous.path_pos_) / ((step.path_vel_ + previous.path_vel_) / 2.0);
     }
   }
 }
@@ -508,13 +574,13 @@ bool Trajectory::getNextVelocitySwitchingPoint(double path_pos, TrajectoryStep&
 }
 
 // Returns true if end of path is reached
-bool Trajectory::integrateForward(std::list<TrajectoryStep>& trajectory, double acceleration)
+bool Trajectory::integrateForward(std::vector<TrajectoryStep>& trajectory, double acceleration)
 {
   double path_pos = trajectory.back().path_pos_;
   double path_vel = trajectory.back().path_vel_;
 
-  std::list<std::pair<double, bool>> switching_points = path_.getSwitchingPoints();
-  std::list<std::pair<double, bool>>::iterator next_discontinuity = switching_points.begin();
+  const std::vector<std::pair<double, bool>>& switching_points = path_.getSwitchingPoints();
+  std::vector<std::pair<double, bool>>::const_iterator next_discontinuity = switching_points.begin();
 
   while (true)
   {
@@ -602,7 +668,7 @@ bool Trajectory::integrateForward(std::list<TrajectoryStep>& trajectory, double
 
       if (getAccelerationMaxPathVelocity(after) < getVelocityMaxPathVelocity(after))
       {
-        if (after > next_discontinuity->first)
+        if (next_discontinuity != switching_points.end() && after > next_discontinuity->first)
         {
           return false;
         }
@@ -624,32 +690,31 @@ bool Trajectory::integrateForward(std::list<TrajectoryStep>& trajectory, double
   }
 }
 
-void Trajectory::integrateBackward(std::list<TrajectoryStep>& start_trajectory, double path_pos, double path_vel,
+void Trajectory::integrateBackward(std::vector<TrajectoryStep>& start_trajectory, double path_pos, double path_vel,
                                    double acceleration)
 {
-  std::list<TrajectoryStep>::iterator start2 = start_trajectory.end();
-  --start2;
-  std::list<TrajectoryStep>::iterator start1 = start2;
-  --start1;
-  std::list<TrajectoryStep> trajectory;
+  std::size_t start2 = start_trajectory.size() - 1;
+  std::size_t start1 = start2 - 1;
+  // the backward trajectory is collected in reverse order, so its back() is the step closest to the start
+  std::vector<TrajectoryStep> trajectory;
   double slope;
-  assert(start1->path_pos_ <= path_pos);
+  assert(start_trajectory[start1].path_pos_ <= path_pos);
 
-  while (start1 != start_trajectory.begin() || path_pos >= 0.0)
+  while (start1 != 0 || path_pos >= 0.0)
   {
-    if (start1->path_pos_ <= path_pos)
+    if (start_trajectory[start1].path_pos_ <= path_pos)
     {
-      trajectory.push_front(TrajectoryStep(path_pos, path_vel));
+      trajectory.push_back(TrajectoryStep(path_pos, path_vel));
       path_vel -= time_step_ * acceleration;
-      path_pos -= time_step_ * 0.5 * (path_vel + trajectory.front().path_vel_);
+      path_pos -= time_step_ * 0.5 * (path_vel + trajectory.back().path_vel_);
       acceleration = getMinMaxPathAcceleration(path_pos, path_vel, false);
-      slope = (trajectory.front().path_vel_ - path_vel) / (trajectory.front().path_pos_ - path_pos);
+      slope = (trajectory.back().path_vel_ - path_vel) / (trajectory.back().path_pos_ - path_pos);
 
       if (path_vel < 0.0)
       {
         valid_ = false;
         ROS_ERROR_NAMED(LOGNAME, "Error while integrating backward: Negative path velocity");
-        end_trajectory_ = trajectory;
+        end_trajectory_.assign(trajectory.rbegin(), trajectory.rend());
         return;
       }
     }
@@ -661,30 +726,33 @@ void Trajectory::integrateBackward(std::list<TrajectoryStep>& start_trajectory,
 
     // Check for intersection between current start trajectory and backward
     // trajectory segments
-    const double start_slope = (start2->path_vel_ - start1->path_vel_) / (start2->path_pos_ - start1->path_pos_);
+    const TrajectoryStep& step1 = start_trajectory[start1];
+    const TrajectoryStep& step2 = start_trajectory[start2];
+    const double start_slope = (step2.path_vel_ - step1.path_vel_) / (step2.path_pos_ - step1.path_pos_);
     const double intersection_path_pos =
-        (start1->path_vel_ - path_vel + slope * path_pos - start_slope * start1->path_pos_) / (slope - start_slope);
-    if (std::max(start1->path_pos_, path_pos) - EPS <= intersection_path_pos &&
-        intersection_path_pos <= EPS + std::min(start2->path_pos_, trajectory.front().path_pos_))
+        (step1.path_vel_ - path_vel + slope * path_pos - start_slope * step1.path_pos_) / (slope - start_slope);
+    if (std::max(step1.path_pos_, path_pos) - EPS <= intersection_path_pos &&
+        intersection_path_pos <= EPS + std::min(step2.path_pos_, trajectory.back().path_pos_))
     {
-      const double intersection_path_vel =
-          start1->path_vel_ + start_slope * (intersection_path_pos - start1->path_pos_);
-      start_trajectory.erase(start2, start_trajectory.end());
+      const double intersection_path_vel = step1.path_vel_ + start_slope * (intersection_path_pos - step1.path_pos_);
+      start_trajectory.erase(start_trajectory.begin() + start2, start_trajectory.end());
       start_trajectory.push_back(TrajectoryStep(intersection_path_pos, intersection_path_vel));
-      start_trajectory.splice(start_trajectory.end(), trajectory);
+      start_trajectory.insert(start_trajectory.end(), trajectory.rbegin(), trajectory.rend());
       return;
     }
   }
 
   valid_ = false;
   ROS_ERROR_NAMED(LOGNAME, "Error while integrating backward: Did not hit start trajectory");
-  end_trajectory_ = trajectory;
+  end_trajectory_.assign(trajectory.rbegin(), trajectory.rend());
 }
 
 double Trajectory::getMinMaxPathAcceleration(double path_pos, double path_vel, bool max)
 {
-  Eigen::VectorXd config_deriv = path_.getTangent(path_pos);
-  Eigen::VectorXd config_deriv2 = path_.getCurvature(path_pos);
+  path_.getTangent(path_pos, tangent_);
+  path_.getCurvature(path_pos, curvature_);
+  const Eigen::VectorXd& config_deriv = tangent_;
+  const Eigen::VectorXd& config_deriv2 = curvature_;
   double factor = max ? 1.0 : -1.0;
   double max_path_acceleration = std::numeric_limits<double>::max();
   for (unsigned int i = 0; i < joint_num_; ++i)
@@ -707,8 +775,10 @@ double Trajectory::getMinMaxPhaseSlope(double path_pos, double path_vel, bool ma
 double Trajectory::getAccelerationMaxPathVelocity(double path_pos) const
 {
   double max_path_velocity = std::numeric_limits<double>::infinity();
-  const Eigen::VectorXd config_deriv = path_.getTangent(path_pos);
-  const Eigen::VectorXd config_deriv2 = path_.getCurvature(path_pos);
+  path_.getTangent(path_pos, tangent_);
+  path_.getCurvature(path_pos, curvature_);
+  const Eigen::VectorXd& config_deriv = tangent_;
+  const Eigen::VectorXd& config_deriv2 = curvature_;
   for (unsigned int i = 0; i < joint_num_; ++i)
   {
     if (config_deriv[i] != 0.0)
@@ -737,7 +807,8 @@ double Trajectory::getAccelerationMaxPathVelocity(double path_pos) const
 
 double Trajectory::getVelocityMaxPathVelocity(double path_pos) const
 {
-  const Eigen::VectorXd tangent = path_.getTangent(path_pos);
+  path_.getTangent(path_pos, tangent_);
+  const Eigen::VectorXd& tangent = tangent_;
   double max_path_velocity = std::numeric_limits<double>::max();
   for (unsigned int i = 0; i < joint_num_; ++i)
   {
@@ -754,7 +825,8 @@ double Trajectory::getAccelerationMaxPathVelocityDeriv(double path_pos)
 
 double Trajectory::getVelocityMaxPathVelocityDeriv(double path_pos)
 {
-  const Eigen::VectorXd tangent = path_.getTangent(path_pos);
+  path_.getTangent(path_pos, tangent_);
+  const Eigen::VectorXd& tangent = tangent_;
   double max_path_velocity = std::numeric_limits<double>::max();
   unsigned int active_constraint;
   for (unsigned int i = 0; i < joint_num_; ++i)
@@ -766,7 +838,8 @@ double Trajectory::getVelocityMaxPathVelocityDeriv(double path_pos)
       active_constraint = i;
     }
   }
-  return -(max_velocity_[active_constraint] * path_.getCurvature(path_pos)[active_constraint]) /
+  path_.getCurvature(path_pos, curvature_);
+  return -(max_velocity_[active_constraint] * curvature_[active_constraint]) /
          (tangent[active_constraint] * std::abs(tangent[active_constraint]));
 }
 
@@ -780,83 +853,71 @@ double Trajectory::getDuration() const
   return trajectory_.back().time_;
 }
 
-std::list<Trajectory::TrajectoryStep>::const_iterator Trajectory::getTrajectorySegment(double time) const
+std::size_t Trajectory::getTrajectorySegment(double time) const
 {
   if (time >= trajectory_.back().time_)
-  {
-    std::list<TrajectoryStep>::const_iterator last = trajectory_.end();
-    last--;
-    return last;
-  }
-  else
-  {
-    if (time < cached_time_)
-    {
-      cached_trajectory_segment_ = trajectory_.begin();
-    }
-    while (time >= cached_trajectory_segment_->time_)
-    {
-      ++cached_trajectory_segment_;
-    }
-    cached_time_ = time;
-    return cached_trajectory_segment_;
-  }
+    return trajectory_.size() - 1;
+  // the first step after time; never the initial step so that there always is a previous one
+  const std::size_t index =
+      std::upper_bound(trajectory_.begin(), trajectory_.end(), time,
+                       [](double value, const TrajectoryStep& step) { return value < step.time_; }) -
+      trajectory_.begin();
+  return std::max<std::size_t>(index, 1);
 }
 
-Eigen::VectorXd Trajectory::getPosition(double time) const
+std::size_t Trajectory::getPathState(double time, double& path_pos, double& path_vel) const
 {
-  std::list<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
-  std::list<TrajectoryStep>::const_iterator previous = it;
-  previous--;
+  const std::size_t index = getTrajectorySegment(time);
+  const TrajectoryStep& step = trajectory_[index];
+  const TrajectoryStep& previous = trajectory_[index - 1];
 
-  double time_step = it->time_ - previous->time_;
+  double time_step = step.time_ - previous.time_;
   const double acceleration =
-      2.0 * (it->path_pos_ - previous->path_pos_ - time_step * previous->path_vel_) / (time_step * time_step);
+      2.0 * (step.path_pos_ - previous.path_pos_ - time_step * previous.path_vel_) / (time_step * time_step);
 
-  time_step = time - previous->time_;
-  const double path_pos =
-      previous->path_pos_ + time_step * previous->path_vel_ + 0.5 * time_step * time_step * acceleration;
+  time_step = time - previous.time_;
+  path_pos = previous.path_pos_ + time_step * previous.path_vel_ + 0.5 * time_step * time_step * acceleration;
+  path_vel = previous.path_vel_ + time_step * acceleration;
+  return index - 1;
+}
 
+Eigen::VectorXd Trajectory::getPosition(double time) const
+{
+  double path_pos, path_vel;
+  getPathState(time, path_pos, path_vel);
   return path_.getConfig(path_pos);
 }
 
 Eigen::VectorXd Trajectory::getVelocity(double time) const
 {
-  std::list<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
-  std::list<TrajectoryStep>::const_iterator previous = it;
-  previous--;
-
-  double time_step = it->time_ - previous->time_;
-  const double acceleration =
-      2.0 * (it->path_pos_ - previous->path_pos_ - time_step * previous->path_vel_) / (time_step * time_step);
-
-  time_step = time - previous->time_;
-  const double path_pos =
-      previous->path_pos_ + time_step * previous->path_vel_ + 0.5 * time_step * time_step * acceleration;
-  const double path_vel = previous->path_vel_ + time_step * acceleration;
-
+  double path_pos, path_vel;
+  getPathState(time, path_pos, path_vel);
   return path_.getTangent(path_pos) * path_vel;
 }
 
 Eigen::VectorXd Trajectory::getAcceleration(double time) const
 {
-  std::list<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
-  std::list<TrajectoryStep>::const_iterator previous = it;
-  previous--;
+  Eigen::VectorXd position, velocity, acceleration;
+  getState(time, position, velocity, acceleration);
+  return acceleration;
+}
 
-  double time_step = it->time_ - previous->time_;
-  const double acceleration =
-      2.0 * (it->path_pos_ - previous->path_pos_ - time_step * previous->path_vel_) / (time_step * time_step);
-
-  time_step = time - previous->time_;
-  const double path_pos =
-      previous->path_pos_ + time_step * previous->path_vel_ + 0.5 * time_step * time_step * acceleration;
-  const double path_vel = previous->path_vel_ + time_step * acceleration;
-  Eigen::VectorXd path_acc =
-      (path_.getTangent(path_pos) * path_vel - path_.getTangent(previous->path_pos_) * previous->path_vel_);
+void Trajectory::getState(double time, Eigen::VectorXd& position, Eigen::VectorXd& velocity,
+                          Eigen::VectorXd& acceleration) const
+{
+  double path_pos, path_vel;
+  const TrajectoryStep& previous = trajectory_[getPathState(time, path_pos, path_vel)];
+
+  path_.getConfig(path_pos, position);
+  path_.getTangent(path_pos, velocity);
+  velocity *= path_vel;
+
+  // finite difference of the velocity w.r.t. the previous trajectory step
+  path_.getTangent(previous.path_pos_, acceleration);
+  acceleration = velocity - acceleration * previous.path_vel_;
+  const double time_step = time - previous.time_;
   if (time_step > 0.0)
-    path_acc /= time_step;
-  return path_acc;
+    acceleration /= time_step;
 }
 
 TimeOptimalTrajectoryGeneration::TimeOptimalTrajectoryGeneration(const double path_tolerance, const double resample_dt,
@@ -869,6 +930,36 @@ TimeOptimalTrajectoryGeneration::~TimeOptimalTrajectoryGeneration()
 {
 }
 
+namespace
+{
+double verifyScalingFactor(const double max_scaling_factor, const char* name)
+{
+  double scaling_factor = 1.0;
+  if (max_scaling_factor > 0.0 && max_scaling_factor <= 1.0)
+  {
+    scaling_factor = max_scaling_factor;
+  }
+  else if (max_scaling_factor == 0.0)
+  {
+    ROS_DEBUG_NAMED(LOGNAME, "A %s of 0.0 was specified, defaulting to %f instead.", name, scaling_factor);
+  }
+  else
+  {
+    ROS_WARN_NAMED(LOGNAME, "Invalid %s %f specified, defaulting to %f instead.", name, max_scaling_factor,
+                   scaling_factor);
+  }
+  return scaling_factor;
+}
+}  // namespace
+
+struct TimeOptimalTrajectoryGeneration::Workspace
+{
+  std::vector<Eigen::VectorXd> points;
+  Eigen::VectorXd position;
+  Eigen::VectorXd velocity;
+  Eigen::VectorXd acceleration;
+};
+
 bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory,
                                                         const double max_velocity_scaling_factor,
                                                         const double max_acceleration_scaling_factor) const
@@ -884,94 +975,116 @@ bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotT
   }
 
   // Validate scaling
-  double velocity_scaling_factor = 1.0;
-  if (max_velocity_scaling_factor > 0.0 && max_velocity_scaling_factor <= 1.0)
-  {
-    velocity_scaling_factor = max_velocity_scaling_factor;
-  }
-  else if (max_velocity_scaling_factor == 0.0)
-  {
-    ROS_DEBUG_NAMED(LOGNAME, "A max_velocity_scaling_factor of 0.0 was specified, defaulting to %f instead.",
-                    velocity_scaling_factor);
-  }
-  else
-  {
-    ROS_WARN_NAMED(LOGNAME, "Invalid max_velocity_scaling_factor %f specified, defaulting to %f instead.",
-                   max_velocity_scaling_factor, velocity_scaling_factor);
-  }
+  const double velocity_scaling_factor =
+      verifyScalingFactor(max_velocity_scaling_factor, "max_velocity_scaling_factor");
+  const double acceleration_scaling_factor =
+      verifyScalingFactor(max_acceleration_scaling_factor, "max_acceleration_scaling_factor");
 
-  double acceleration_scaling_factor = 1.0;
-  if (max_acceleration_scaling_factor > 0.0 && max_acceleration_scaling_factor <= 1.0)
-  {
-    acceleration_scaling_factor = max_acceleration_scaling_factor;
-  }
-  else if (max_acceleration_scaling_factor == 0.0)
-  {
-    ROS_DEBUG_NAMED(LOGNAME, "A max_acceleration_scaling_factor of 0.0 was specified, defaulting to %f instead.",
-                    acceleration_scaling_factor);
-  }
-  else
-  {
-    ROS_WARN_NAMED(LOGNAME, "Invalid max_acceleration_scaling_factor %f specified, defaulting to %f instead.",
-                   max_acceleration_scaling_factor, acceleration_scaling_factor);
-  }
+  Eigen::VectorXd max_velocity, max_acceleration;
+  getTimeOptimalLimits(group, velocity_scaling_factor, acceleration_scaling_factor, max_velocity, max_acceleration);
 
-  // This lib does not actually work properly when angles wrap around, so we need to unwind the path first
-  trajectory.unwind();
+  Workspace workspace;
+  return computeTimeStamps(trajectory, max_velocity, max_acceleration, workspace);
+}
 
-  // This is pretty much copied from IterativeParabolicTimeParameterization::applyVelocityConstraints
-  const std::vector<std::string>& vars = group->getVariableNames();
-  const std::vector<int>& idx = group->getVariableIndexList();
-  const moveit::core::RobotModel& rmodel = group->getParentModel();
-  const unsigned num_joints = group->getVariableCount();
-  const unsigned num_points = trajectory.getWayPointCount();
+bool TimeOptimalTrajectoryGeneration::computeTimeStamps(
+    const std::vector<robot_trajectory::RobotTrajectoryPtr>& trajectories, std::vector<double>& durations,
+    const double max_velocity_scaling_factor, const double max_acceleration_scaling_factor,
+    const unsigned int thread_count) const
+{
+  durations.assign(trajectories.size(), -1.0);
+  if (trajectories.empty())
+    return true;
 
-  // Get the limits (we do this at same time, unlike IterativeParabolicTimeParameterization)
-  Eigen::VectorXd max_velocity(num_joints);
-  Eigen::VectorXd max_acceleration(num_joints);
-  for (size_t j = 0; j < num_joints; ++j)
+  const moveit::core::JointModelGroup* group = trajectories.front()->getGroup();
+  if (!group)
   {
-    const moveit::core::VariableBounds& bounds = rmodel.getVariableBounds(vars[j]);
-
-    // Limits need to be non-zero, otherwise we never exit
-    max_velocity[j] = 1.0;
-    if (bounds.velocity_bounded_)
+    ROS_ERROR_NAMED(LOGNAME, "It looks like the planner did not set the group the plan was computed for");
+    return false;
+  }
+  for (const robot_trajectory::RobotTrajectoryPtr& trajectory : trajectories)
+  {
+    if (trajectory->getGroup() != group)
     {
-      max_velocity[j] = std::min(fabs(bounds.max_velocity_), fabs(bounds.min_velocity_)) * velocity_scaling_factor;
-      max_velocity[j] = std::max(0.01, max_velocity[j]);
+      ROS_ERROR_NAMED(LOGNAME, "All trajectories of a batch need to be for group '%s'", group->getName().c_str());
+      return false;
     }
+  }
 
-    max_acceleration[j] = 1.0;
-    if (bounds.acceleration_bounded_)
+  // The limits are shared by all trajectories, the workspaces by all trajectories of a worker
+  const double velocity_scaling_factor =
+      verifyScalingFactor(max_velocity_scaling_factor, "max_velocity_scaling_factor");
+  const double acceleration_scaling_factor =
+      verifyScalingFactor(max_acceleration_scaling_factor, "max_acceleration_scaling_factor");
+  Eigen::VectorXd max_velocity, max_acceleration;
+  getTimeOptimalLimits(group, velocity_scaling_factor, acceleration_scaling_factor, max_velocity, max_acceleration);
+
+  const std::size_t count = trajectories.size();
+  moveit::core::WorkerPool& pool = moveit::core::WorkerPool::getGlobal();
+  const std::size_t max_workers = pool.getMaxWorkerCount();
+  const std::size_t num_threads = thread_count ? std::min<std::size_t>(thread_count, max_workers) : max_workers;
+  const std::size_t num_workers = std::max<std::size_t>(1, std::min(num_threads, count));
+  std::atomic<std::size_t> next_index(0);
+  std::atomic<bool> success(true);
+
+  auto work = [&](std::size_t /*worker*/) {
+    Workspace workspace;
+    for (std::size_t i = next_index++; i < count; i = next_index++)
     {
-      max_acceleration[j] =
-          std::min(fabs(bounds.max_acceleration_), fabs(bounds.min_acceleration_)) * acceleration_scaling_factor;
-      max_acceleration[j] = std::max(0.01, max_acceleration[j]);
+      robot_trajectory::RobotTrajectory& trajectory = *trajectories[i];
+      if (trajectory.empty())
+        durations[i] = 0.0;
+      else if (computeTimeStamps(trajectory, max_velocity, max_acceleration, workspace))
+        durations[i] = trajectory.getDuration();
+      else
+        success = false;
     }
-  }
+  };
+
+  pool.run(num_workers, work);
+  return success;
+}
+
+bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory,
+                                                        const Eigen::VectorXd& max_velocity,
+                                                        const Eigen::VectorXd& max_acceleration,
+                                                        Workspace& workspace) const
+{
+  // This lib does not actually work properly when angles wrap around, so we need to unwind the path first
+  trajectory.unwind();
+
+  const std::vector<int>& idx = trajectory.getGroup()->getVariableIndexList();
+  const unsigned num_joints = idx.size();
+  const unsigned num_points = trajectory.getWayPointCount();
 
   // Have to convert into Eigen data structs and remove repeated points
   //  (https://github.com/tobiaskunz/trajectories/issues/3)
-  std::list<Eigen::VectorXd> points;
+  // The point vectors are kept in the workspace, so that their memory is reused across trajectories.
+  // Only the first point_count of them belong to this trajectory
+  std::vector<Eigen::VectorXd>& points = workspace.points;
+  std::size_t point_count = 0;
   for (size_t p = 0; p < num_points; ++p)
   {
     moveit::core::RobotStatePtr waypoint = trajectory.getWayPointPtr(p);
-    Eigen::VectorXd new_point(num_joints);
+    if (point_count == points.size())
+      points.emplace_back(num_joints);
+    Eigen::VectorXd& new_point = points[point_count];
+    new_point.resize(num_joints);
     bool diverse_point = (p == 0);
 
     for (size_t j = 0; j < num_joints; j++)
     {
       new_point[j] = waypoint->getVariablePosition(idx[j]);
-      if (p > 0 && std::abs(new_point[j] - points.back()[j]) > min_angle_change_)
+      if (p > 0 && std::abs(new_point[j] - points[point_count - 1][j]) > min_angle_change_)
         diverse_point = true;
     }
 
     if (diverse_point)
-      points.push_back(new_point);
+      ++point_count;
   }
 
   // Return trajectory with only the first waypoint if there are not multiple diverse points
-  if (points.size() == 1)
+  if (point_count == 1)
   {
     ROS_DEBUG_NAMED(LOGNAME,
                     "Trajectory is parameterized with 0.0 dynamics since it only contains a single distinct waypoint.");
@@ -984,7 +1097,8 @@ bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotT
   }
 
   // Now actually call the algorithm
-  Trajectory parameterized(Path(points, path_tolerance_), max_velocity, max_acceleration, 0.001);
+  Trajectory parameterized(Path(points.begin(), points.begin() + point_count, path_tolerance_), max_velocity,
+                           max_acceleration, 0.001);
   if (!parameterized.isValid())
   {
     ROS_ERROR_NAMED(LOGNAME, "Unable to parameterize trajectory.");
@@ -998,13 +1112,17 @@ bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotT
   moveit::core::RobotState waypoint = moveit::core::RobotState(trajectory.getWayPoint(0));
   trajectory.clear();
   double last_t = 0;
+  Eigen::VectorXd& position = workspace.position;
+  Eigen::VectorXd& velocity = workspace.velocity;
+  Eigen::VectorXd& acceleration = workspace.acceleration;
+  position.resize(num_joints);
+  velocity.resize(num_joints);
+  acceleration.resize(num_joints);
   for (size_t sample = 0; sample <= sample_count; ++sample)
   {
     // always sample the end of the trajectory as well
     double t = std::min(parameterized.getDuration(), sample * resample_dt_);
-    Eigen::VectorXd position = parameterized.getPosition(t);
-    Eigen::VectorXd velocity = parameterized.getVelocity(t);
-    Eigen::VectorXd acceleration = parameterized.getAcceleration(t);
+    parameterized.getState(t, position, velocity, acceleration);
 
     for (size_t j = 0; j < num_joints; ++j)
     {
@@ -1019,4 +1137,38 @@ bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotT
 
   return true;
 }
+
+void getTimeOptimalLimits(const moveit::core::JointModelGroup* group, double velocity_scaling_factor,
+                          double acceleration_scaling_factor, Eigen::VectorXd& max_velocity,
+                          Eigen::VectorXd& max_acceleration)
+{
+  // This is pretty much copied from IterativeParabolicTimeParameterization::applyVelocityConstraints
+  const std::vector<std::string>& vars = group->getVariableNames();
+  const moveit::core::RobotModel& rmodel = group->getParentModel();
+  const unsigned num_joints = group->getVariableCount();
+
+  // Get the limits (we do this at same time, unlike IterativeParabolicTimeParameterization)
+  max_velocity.resize(num_joints);
+  max_acceleration.resize(num_joints);
+  for (size_t j = 0; j < num_joints; ++j)
+  {
+    const moveit::core::VariableBounds& bounds = rmodel.getVariableBounds(vars[j]);
+
+    // Limits need to be non-zero, otherwise we never exit
+    max_velocity[j] = 1.0;
+    if (bounds.velocity_bounded_)
+    {
+      max_velocity[j] = std::min(fabs(bounds.max_velocity_), fabs(bounds.min_velocity_)) * velocity_scaling_factor;
+      max_velocity[j] = std::max(0.01, max_velocity[j]);
+    }
+
+    max_acceleration[j] = 1.0;
+    if (bounds.acceleration_bounded_)
+    {
+      max_acceleration[j] =
+          std::min(fabs(bounds.max_acceleration_), fabs(bounds.min_acceleration_)) * acceleration_scaling_factor;
+      max_acceleration[j] = std::max(0.01, max_acceleration[j]);
+    }
+  }
+}
 }  // namespace trajectory_processing
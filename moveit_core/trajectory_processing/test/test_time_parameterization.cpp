@@ -41,6 +41,9 @@
 #include <moveit/robot_trajectory/robot_trajectory.h>
 #include <moveit/trajectory_processing/iterative_spline_parameterization.h>
 #include <moveit/trajectory_processing/iterative_time_parameterization.h>
+#include <moveit/trajectory_processing/jerk_limited_time_parameterization.h>
+#include <moveit/trajectory_processing/streaming_time_parameterization.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
 #include <moveit/utils/robot_model_test_utils.h>
 
 // Static variables used in all tests
@@ -180,6 +183,226 @@ TEST(TestTimeParameterization, TestRepeatedPoint)
   ASSERT_LT(TRAJECTORY.getWayPointDurationFromStart(TRAJECTORY.getWayPointCount() - 1), 0.001);
 }
 
+TEST(TestTimeParameterization, TestJerkLimited)
+{
+  const moveit::core::JointModelGroup* group = TRAJECTORY.getGroup();
+  const std::string& variable = group->getVariableNames()[0];
+  const int index = group->getVariableIndexList()[0];
+  const moveit::core::VariableBounds& bounds = RMODEL->getVariableBounds(variable);
+  const double max_jerk = 5.0;
+
+  trajectory_processing::JerkLimitedTimeParameterization time_parameterization;
+  time_parameterization.setJerkLimits({ { variable, max_jerk } });
+  EXPECT_EQ(initStraightTrajectory(TRAJECTORY), 0);
+
+  ros::WallTime wt = ros::WallTime::now();
+  EXPECT_TRUE(time_parameterization.computeTimeStamps(TRAJECTORY));
+  std::cout << "JerkLimitedTimeParameterization took " << (ros::WallTime::now() - wt).toSec() << std::endl;
+  printTrajectory(TRAJECTORY);
+
+  const std::size_t count = TRAJECTORY.getWayPointCount();
+  ASSERT_GE(count, 4u);
+  EXPECT_NEAR(TRAJECTORY.getWayPoint(0).getVariableVelocity(index), 0.0, 1e-9);
+  EXPECT_NEAR(TRAJECTORY.getWayPoint(0).getVariableAcceleration(index), 0.0, 1e-9);
+  EXPECT_NEAR(TRAJECTORY.getWayPoint(count - 1).getVariableVelocity(index), 0.0, 1e-9);
+  EXPECT_NEAR(TRAJECTORY.getWayPoint(count - 1).getVariableAcceleration(index), 0.0, 1e-9);
+  EXPECT_NEAR(TRAJECTORY.getWayPoint(count - 1).getVariablePosition(index), 2.0, 1e-6);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const moveit::core::RobotState& point = TRAJECTORY.getWayPoint(i);
+    EXPECT_LE(std::abs(point.getVariableVelocity(index)), bounds.max_velocity_ + 1e-6);
+    if (bounds.acceleration_bounded_)
+      EXPECT_LE(std::abs(point.getVariableAcceleration(index)), bounds.max_acceleration_ + 1e-6);
+    if (i > 0)
+    {
+      const double jerk =
+          (point.getVariableAcceleration(index) - TRAJECTORY.getWayPoint(i - 1).getVariableAcceleration(index)) /
+          TRAJECTORY.getWayPointDurationFromPrevious(i);
+      EXPECT_LE(std::abs(jerk), max_jerk + 1e-6);
+    }
+  }
+}
+
+TEST(TestTimeParameterization, TestJerkLimitedNearPositionLimit)
+{
+  const moveit::core::JointModelGroup* group = TRAJECTORY.getGroup();
+  const std::string& variable = group->getVariableNames()[0];
+  const int index = group->getVariableIndexList()[0];
+  const moveit::core::VariableBounds& bounds = RMODEL->getVariableBounds(variable);
+  ASSERT_TRUE(bounds.position_bounded_);
+
+  // move one joint straight into its upper position limit
+  moveit::core::RobotState state(RMODEL);
+  state.setToDefaultValues();
+  TRAJECTORY.clear();
+  const int num = 10;
+  for (int i = 0; i <= num; ++i)
+  {
+    state.setVariablePosition(index, bounds.max_position_ - 1.0 + static_cast<double>(i) / num);
+    TRAJECTORY.addSuffixWayPoint(state, 0.0);
+  }
+
+  trajectory_processing::JerkLimitedTimeParameterization time_parameterization;
+  time_parameterization.setJerkLimits({ { variable, 5.0 } });
+  ASSERT_TRUE(time_parameterization.computeTimeStamps(TRAJECTORY));
+
+  const std::size_t count = TRAJECTORY.getWayPointCount();
+  EXPECT_NEAR(TRAJECTORY.getWayPoint(count - 1).getVariablePosition(index), bounds.max_position_, 1e-6);
+  // neither the waypoints nor the cubic spline between them may overshoot the limit
+  for (std::size_t i = 1; i < count; ++i)
+  {
+    const moveit::core::RobotState& from = TRAJECTORY.getWayPoint(i - 1);
+    const double dt = TRAJECTORY.getWayPointDurationFromPrevious(i);
+    const double acceleration = from.getVariableAcceleration(index);
+    const double jerk = (TRAJECTORY.getWayPoint(i).getVariableAcceleration(index) - acceleration) / dt;
+    for (int k = 0; k <= 20; ++k)
+    {
+      const double t = dt * k / 20.0;
+      const double position = from.getVariablePosition(index) +
+                              t * (from.getVariableVelocity(index) + t * (0.5 * acceleration + t * jerk / 6.0));
+      EXPECT_LE(position, bounds.max_position_ + 1e-9) << "waypoint " << i - 1 << ", t = " << t;
+    }
+  }
+}
+
+TEST(TestTimeParameterization, TestStreaming)
+{
+  const moveit::core::JointModelGroup* group = TRAJECTORY.getGroup();
+  const std::vector<int>& idx = group->getVariableIndexList();
+  Eigen::VectorXd max_velocity, max_acceleration;
+  trajectory_processing::getTimeOptimalLimits(group, 1.0, 1.0, max_velocity, max_acceleration);
+
+  // a zig-zag path, streamed two waypoints at a time
+  moveit::core::RobotState state(RMODEL);
+  state.setToDefaultValues();
+  trajectory_processing::StreamingTimeParameterization time_parameterization(state, group);
+  robot_trajectory::RobotTrajectory committed(RMODEL, group);
+  robot_trajectory::RobotTrajectory tail(RMODEL, group);
+  robot_trajectory::RobotTrajectory full(RMODEL, group);
+  full.addSuffixWayPoint(state, 0.0);
+  for (int i = 1; i <= 12; ++i)
+  {
+    state.setVariablePosition(idx[0], 0.3 * i);
+    state.setVariablePosition(idx[1], i % 2 ? 0.2 : -0.2);
+    time_parameterization.addWayPoint(state);
+    full.addSuffixWayPoint(state, 0.0);
+    if (i % 2)
+      continue;
+
+    const std::size_t committed_count = committed.getWayPointCount();
+    ASSERT_TRUE(time_parameterization.computeTimeStamps(committed, tail));
+    EXPECT_GE(committed.getWayPointCount(), committed_count);
+    ASSERT_GT(tail.getWayPointCount(), 0u);
+
+    // the tail brings the robot to rest at the last waypoint
+    const moveit::core::RobotState& end = tail.getLastWayPoint();
+    EXPECT_NEAR(end.getVariablePosition(idx[0]), 0.3 * i, 1e-6);
+    EXPECT_NEAR(end.getVariablePosition(idx[1]), -0.2, 1e-6);
+    for (int index : idx)
+      EXPECT_NEAR(end.getVariableVelocity(index), 0.0, 1e-9);
+  }
+  ASSERT_TRUE(time_parameterization.finish(committed));
+  EXPECT_EQ(time_parameterization.getPendingWayPointCount(), 0u);
+
+  const std::size_t count = committed.getWayPointCount();
+  ASSERT_GT(count, 2u);
+  EXPECT_NEAR(committed.getDuration(), time_parameterization.getCommittedDuration(), 1e-9);
+  for (std::size_t j = 0; j < idx.size(); ++j)
+  {
+    EXPECT_NEAR(committed.getWayPoint(0).getVariableVelocity(idx[j]), 0.0, 1e-9);
+    EXPECT_NEAR(committed.getLastWayPoint().getVariableVelocity(idx[j]), 0.0, 1e-9);
+    EXPECT_NEAR(committed.getLastWayPoint().getVariablePosition(idx[j]), state.getVariablePosition(idx[j]), 1e-6);
+  }
+
+  // velocities are within bounds and continuous across the committed chunks
+  for (std::size_t i = 1; i < count; ++i)
+  {
+    const moveit::core::RobotState& point = committed.getWayPoint(i);
+    const moveit::core::RobotState& previous = committed.getWayPoint(i - 1);
+    const double dt = committed.getWayPointDurationFromPrevious(i);
+    for (std::size_t j = 0; j < idx.size(); ++j)
+    {
+      EXPECT_LE(std::abs(point.getVariableVelocity(idx[j])), max_velocity[j] + 1e-6);
+      EXPECT_LE(std::abs(point.getVariableVelocity(idx[j]) - previous.getVariableVelocity(idx[j])),
+                max_acceleration[j] * dt + 1e-2);
+    }
+  }
+
+  // knowing only part of the path can only make the motion slower than the time-optimal one
+  trajectory_processing::TimeOptimalTrajectoryGeneration totg;
+  ASSERT_TRUE(totg.computeTimeStamps(full));
+  EXPECT_GE(committed.getDuration(), full.getDuration() - 1e-3);
+
+  // a path retracing itself, streamed one waypoint at a time, comes to rest wherever it turns back
+  moveit::core::RobotState start(RMODEL);
+  start.setToDefaultValues();
+  trajectory_processing::StreamingTimeParameterization retrace_parameterization(start, group);
+  robot_trajectory::RobotTrajectory retrace(RMODEL, group);
+  moveit::core::RobotState turn(start);
+  turn.setVariablePosition(idx[0], start.getVariablePosition(idx[0]) + 0.6);
+  turn.setVariablePosition(idx[1], start.getVariablePosition(idx[1]) + 0.3);
+  for (int i = 1; i <= 5; ++i)
+  {
+    retrace_parameterization.addWayPoint(i % 2 ? turn : start);
+    ASSERT_TRUE(retrace_parameterization.computeTimeStamps(retrace, tail));
+  }
+  ASSERT_TRUE(retrace_parameterization.finish(retrace));
+  EXPECT_NEAR(retrace.getLastWayPoint().getVariablePosition(idx[0]), turn.getVariablePosition(idx[0]), 1e-6);
+  for (std::size_t i = 1; i < retrace.getWayPointCount(); ++i)
+  {
+    const moveit::core::RobotState& point = retrace.getWayPoint(i);
+    const moveit::core::RobotState& previous = retrace.getWayPoint(i - 1);
+    const double dt = retrace.getWayPointDurationFromPrevious(i);
+    for (std::size_t j = 0; j < idx.size(); ++j)
+      EXPECT_LE(std::abs(point.getVariableVelocity(idx[j]) - previous.getVariableVelocity(idx[j])),
+                max_acceleration[j] * dt + 1e-2)
+          << "waypoint " << i;
+  }
+}
+
+TEST(TestTimeParameterization, TestTimeOptimalBatch)
+{
+  const moveit::core::JointModelGroup* group = TRAJECTORY.getGroup();
+  const std::vector<int>& idx = group->getVariableIndexList();
+  trajectory_processing::TimeOptimalTrajectoryGeneration totg;
+
+  // straight trajectories of increasing length, each parameterized on its own for reference
+  std::vector<robot_trajectory::RobotTrajectoryPtr> trajectories;
+  std::vector<double> expected_durations;
+  moveit::core::RobotState state(RMODEL);
+  state.setToDefaultValues();
+  for (std::size_t i = 0; i < 16; ++i)
+  {
+    auto trajectory = std::make_shared<robot_trajectory::RobotTrajectory>(RMODEL, group);
+    for (std::size_t j = 0; j <= i + 1; ++j)
+    {
+      state.setVariablePosition(idx[0], 0.1 * j);
+      state.setVariablePosition(idx[1], 0.05 * (j % 2));
+      trajectory->addSuffixWayPoint(state, 0.0);
+    }
+    robot_trajectory::RobotTrajectory reference(*trajectory, true);
+    ASSERT_TRUE(totg.computeTimeStamps(reference, 0.5));
+    expected_durations.push_back(reference.getDuration());
+    trajectories.push_back(trajectory);
+  }
+  trajectories.push_back(std::make_shared<robot_trajectory::RobotTrajectory>(RMODEL, group));
+  expected_durations.push_back(0.0);
+
+  std::vector<double> durations;
+  ASSERT_TRUE(totg.computeTimeStamps(trajectories, durations, 0.5, 1.0, 4));
+  ASSERT_EQ(durations.size(), trajectories.size());
+  for (std::size_t i = 0; i < trajectories.size(); ++i)
+  {
+    EXPECT_DOUBLE_EQ(durations[i], expected_durations[i]);
+    EXPECT_DOUBLE_EQ(trajectories[i]->getDuration(), expected_durations[i]);
+  }
+
+  // all trajectories of a batch need to share the group
+  trajectories.push_back(std::make_shared<robot_trajectory::RobotTrajectory>(RMODEL, "left_arm"));
+  trajectories.back()->addSuffixWayPoint(state, 0.0);
+  EXPECT_FALSE(totg.computeTimeStamps(trajectories, durations));
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,110 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <chrono>
+#include <random>
+
+using trajectory_processing::Path;
+using trajectory_processing::TimeOptimalTrajectoryGeneration;
+using trajectory_processing::Trajectory;
+
+namespace
+{
+// random walk through joint space with the given number of waypoints
+std::vector<Eigen::VectorXd> createWaypoints(std::size_t count, std::size_t dof, double step_size)
+{
+  std::mt19937 generator(count);
+  std::uniform_real_distribution<double> step(-step_size, step_size);
+  std::vector<Eigen::VectorXd> waypoints(count, Eigen::VectorXd::Zero(dof));
+  for (std::size_t i = 1; i < count; ++i)
+    for (std::size_t j = 0; j < dof; ++j)
+      waypoints[i][j] = waypoints[i - 1][j] + step(generator);
+  return waypoints;
+}
+
+double elapsedMilliseconds(const std::chrono::steady_clock::time_point& start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+}  // namespace
+
+TEST(TimeOptimalTrajectoryGeneration, PathParameterization)
+{
+  const Eigen::VectorXd max_velocity = Eigen::VectorXd::Constant(7, 1.5);
+  const Eigen::VectorXd max_acceleration = Eigen::VectorXd::Constant(7, 3.0);
+  for (std::size_t count : { 100, 1000, 10000 })
+  {
+    const std::vector<Eigen::VectorXd> waypoints = createWaypoints(count, 7, 0.05);
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Trajectory trajectory(Path(waypoints, 0.1), max_velocity, max_acceleration, 0.001);
+    const double elapsed = elapsedMilliseconds(start);
+    ASSERT_TRUE(trajectory.isValid());
+    std::cerr << count << " waypoints: " << elapsed << "ms for a duration of " << trajectory.getDuration() << "s"
+              << std::endl;
+  }
+}
+
+TEST(TimeOptimalTrajectoryGeneration, ComputeTimeStamps)
+{
+  moveit::core::RobotModelConstPtr robot_model = moveit::core::loadTestingRobotModel("panda");
+  const moveit::core::JointModelGroup* group = robot_model->getJointModelGroup("panda_arm");
+  ASSERT_TRUE(group);
+  moveit::core::RobotState state(robot_model);
+  state.setToDefaultValues();
+
+  TimeOptimalTrajectoryGeneration totg;
+  for (std::size_t count : { 100, 1000, 10000 })
+  {
+    robot_trajectory::RobotTrajectory trajectory(robot_model, group);
+    for (const Eigen::VectorXd& waypoint : createWaypoints(count, group->getVariableCount(), 0.02))
+    {
+      state.setJointGroupPositions(group, waypoint);
+      state.enforceBounds(group);
+      trajectory.addSuffixWayPoint(state, 0.0);
+    }
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(totg.computeTimeStamps(trajectory));
+    std::cerr << count << " waypoints: " << elapsedMilliseconds(start) << "ms for a duration of "
+              << trajectory.getDuration() << "s" << std::endl;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,214 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+/** \file binary_io.h
+ *  \brief Helpers for versioned binary files that are read from memory, e.g. a memory-mapped file
+ *
+ *  Files start with an eight character magic string identifying their content, a version number and a byte order
+ *  mark, and store their values in native byte order. Every value or array is padded to a multiple of eight bytes,
+ *  so arrays are aligned within a mapped file and can be copied in bulk, without parsing individual elements.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+/** \brief A file mapped into memory for reading */
+class MappedFile
+{
+public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /** \brief Map the file at \e path, unmapping any previously mapped file. Returns false if it cannot be read. */
+  bool open(const std::string& path);
+
+  void close();
+
+  bool isOpen() const
+  {
+    return open_;
+  }
+
+  const char* data() const
+  {
+    return data_;
+  }
+
+  std::size_t size() const
+  {
+    return size_;
+  }
+
+private:
+  bool open_;
+  const char* data_;
+  std::size_t size_;
+  std::vector<char> buffer_;  ///< The content of the file on platforms without memory mapping
+};
+
+/** \brief Write values to a stream in the layout expected by BinaryReader */
+class BinaryWriter
+{
+public:
+  explicit BinaryWriter(std::ostream& out) : out_(out)
+  {
+  }
+
+  /** \brief Write the file header with the eight characters of \e magic and \e version */
+  void writeHeader(const char* magic, std::uint32_t version);
+
+  template <typename T>
+  void write(const T* values, std::size_t count)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written");
+    writeBytes(values, sizeof(T) * count);
+  }
+
+  template <typename T>
+  void write(const T& value)
+  {
+    write(&value, 1);
+  }
+
+  void writeString(const std::string& value);
+
+  bool good() const
+  {
+    return out_.good();
+  }
+
+private:
+  /** \brief Write \e bytes bytes, followed by padding up to a multiple of eight bytes */
+  void writeBytes(const void* data, std::size_t bytes);
+
+  std::ostream& out_;
+};
+
+/** \brief Read values written by BinaryWriter from a buffer, checking that they lie within the buffer */
+class BinaryReader
+{
+public:
+  BinaryReader(const void* data, std::size_t size) : data_(static_cast<const char*>(data)), size_(size), offset_(0)
+  {
+  }
+
+  /** \brief Check the header of the file for \e magic and the byte order. On success, \e version is the version the
+      file was written with, which is at most \e max_version. */
+  bool readHeader(const char* magic, std::uint32_t max_version, std::uint32_t& version);
+
+  /** \brief Return a pointer to the next \e bytes bytes in the buffer and advance past them and their padding, or
+      nullptr if the buffer is too short */
+  const char* readBytes(std::size_t bytes);
+
+  /** \brief Return a pointer to the next \e count values in the buffer, or nullptr if the buffer is too short.
+      If the buffer is aligned to eight bytes, as memory-mapped files are, the values are not copied. Otherwise they
+      are copied to memory owned by the reader, so the pointer is only valid as long as the reader. */
+  template <typename T>
+  const T* readArray(std::size_t count)
+  {
+    static_assert(std::is_trivially_copyable<T>::value && alignof(T) <= 8, "Only aligned values can be read in place");
+    if (count > (size_ - offset_) / sizeof(T))
+      return nullptr;
+    if (reinterpret_cast<std::uintptr_t>(data_ + offset_) % alignof(T) == 0)
+      return reinterpret_cast<const T*>(readBytes(sizeof(T) * count));
+
+    // std::uint64_t storage is aligned for any T read here, and never empty, so values is not nullptr
+    copies_.emplace_back(sizeof(T) * count / sizeof(std::uint64_t) + 1);
+    T* values = reinterpret_cast<T*>(copies_.back().data());
+    if (!read(values, count))
+      return nullptr;
+    return values;
+  }
+
+  /** \brief Copy \e count values from the buffer to \e values */
+  template <typename T>
+  bool read(T* values, std::size_t count)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read");
+    if (count > (size_ - offset_) / sizeof(T))
+      return false;
+    const char* bytes = readBytes(sizeof(T) * count);
+    if (!bytes)
+      return false;
+    std::memcpy(values, bytes, sizeof(T) * count);
+    return true;
+  }
+
+  template <typename T>
+  bool read(T& value)
+  {
+    return read(&value, 1);
+  }
+
+  /** \brief Read \e count values, appending them to \e values */
+  template <typename T>
+  bool read(std::vector<T>& values, std::size_t count)
+  {
+    if (count > (size_ - offset_) / sizeof(T))
+      return false;
+    const std::size_t offset = values.size();
+    values.resize(offset + count);
+    return read(values.data() + offset, count);
+  }
+
+  bool readString(std::string& value);
+
+  /** \brief The number of bytes that were not read yet */
+  std::size_t getRemainingBytes() const
+  {
+    return size_ - offset_;
+  }
+
+private:
+  const char* data_;
+  std::size_t size_;
+  std::size_t offset_;
+  std::vector<std::vector<std::uint64_t>> copies_;  ///< Arrays read from a misaligned buffer
+};
+}  // namespace core
+}  // namespace moveit
@@ -0,0 +1,96 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+/** \brief A fixed set of threads that run the workers of parallel loops.
+ *
+ *  Worker i > 0 of every run() is executed by the same background thread, so thread_local caches of the work
+ *  functions stay warm from one run to the next. Worker 0 runs on the calling thread. */
+class WorkerPool
+{
+public:
+  /** \brief Start \e thread_count background threads, or one less than the number of hardware threads if 0 */
+  explicit WorkerPool(std::size_t thread_count = 0);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  /** \brief The maximum number of workers of a run(), including the calling thread */
+  std::size_t getMaxWorkerCount() const
+  {
+    return threads_.size() + 1;
+  }
+
+  /** \brief Call \e work with the worker indices 0 ... \e worker_count - 1 concurrently and wait for all of them.
+   *
+   *  \e worker_count is capped to getMaxWorkerCount(). While the pool is busy with a run() of another thread, or
+   *  when called from within a worker, all workers are run in sequence on the calling thread, so a worker must not
+   *  wait for another one. An exception thrown by a worker is rethrown after all of them have finished. */
+  void run(std::size_t worker_count, const std::function<void(std::size_t worker)>& work);
+
+  /** \brief The pool shared by the batch functions of MoveIt, created on first use */
+  static WorkerPool& getGlobal();
+
+private:
+  void threadMain(std::size_t worker);
+
+  std::vector<std::thread> threads_;
+
+  std::mutex run_mutex_;  // held for the duration of a run()
+  std::mutex mutex_;      // protects the members below
+  std::condition_variable start_condition_;
+  std::condition_variable done_condition_;
+  const std::function<void(std::size_t)>* work_;
+  std::size_t worker_count_;
+  std::size_t pending_;
+  std::size_t generation_;
+  bool stop_;
+  std::exception_ptr exception_;
+};
+}  // namespace core
+}  // namespace moveit
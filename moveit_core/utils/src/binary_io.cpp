@@ -0,0 +1,173 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/utils/binary_io.h>
+#include <algorithm>
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace moveit
+{
+namespace core
+{
+namespace
+{
+const std::size_t ALIGNMENT = 8;
+const std::size_t MAGIC_LENGTH = 8;
+const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+std::size_t getPadding(std::size_t bytes)
+{
+  return (ALIGNMENT - bytes % ALIGNMENT) % ALIGNMENT;
+}
+}  // namespace
+
+MappedFile::MappedFile() : open_(false), data_(nullptr), size_(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+  close();
+#ifdef _WIN32
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in)
+    return false;
+  buffer_.resize(static_cast<std::size_t>(in.tellg()));
+  in.seekg(0);
+  if (!in.read(buffer_.data(), buffer_.size()))
+    return false;
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+#else
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    ::close(fd);
+    return false;
+  }
+  size_ = static_cast<std::size_t>(st.st_size);
+  if (size_ > 0)
+  {
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+      ::close(fd);
+      size_ = 0;
+      return false;
+    }
+    data_ = static_cast<const char*>(data);
+  }
+  // the mapping stays valid after closing the descriptor
+  ::close(fd);
+#endif
+  open_ = true;
+  return true;
+}
+
+void MappedFile::close()
+{
+#ifndef _WIN32
+  if (data_)
+    munmap(const_cast<char*>(data_), size_);
+#endif
+  buffer_.clear();
+  open_ = false;
+  data_ = nullptr;
+  size_ = 0;
+}
+
+void BinaryWriter::writeHeader(const char* magic, std::uint32_t version)
+{
+  writeBytes(magic, MAGIC_LENGTH);
+  write(version);
+  write(BYTE_ORDER_MARK);
+}
+
+void BinaryWriter::writeString(const std::string& value)
+{
+  write<std::uint64_t>(value.size());
+  writeBytes(value.data(), value.size());
+}
+
+void BinaryWriter::writeBytes(const void* data, std::size_t bytes)
+{
+  static const char ZEROS[ALIGNMENT] = {};
+  out_.write(static_cast<const char*>(data), bytes);
+  out_.write(ZEROS, getPadding(bytes));
+}
+
+bool BinaryReader::readHeader(const char* magic, std::uint32_t max_version, std::uint32_t& version)
+{
+  const char* file_magic = readBytes(MAGIC_LENGTH);
+  std::uint32_t byte_order_mark;
+  return file_magic && std::memcmp(file_magic, magic, MAGIC_LENGTH) == 0 && read(version) && version > 0 &&
+         version <= max_version && read(byte_order_mark) && byte_order_mark == BYTE_ORDER_MARK;
+}
+
+const char* BinaryReader::readBytes(std::size_t bytes)
+{
+  const std::size_t remaining = size_ - offset_;
+  if (bytes > remaining)
+    return nullptr;
+  const char* result = data_ + offset_;
+  offset_ += std::min(bytes + getPadding(bytes), remaining);
+  return result;
+}
+
+bool BinaryReader::readString(std::string& value)
+{
+  std::uint64_t length;
+  if (!read(length) || length > getRemainingBytes())
+    return false;
+  const char* bytes = readBytes(length);
+  value.assign(bytes, length);
+  return true;
+}
+}  // namespace core
+}  // namespace moveit
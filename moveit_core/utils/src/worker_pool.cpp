@@ -0,0 +1,162 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/utils/worker_pool.h>
+#include <algorithm>
+
+namespace moveit
+{
+namespace core
+{
+namespace
+{
+// set on threads executing a worker, whose nested runs are done inline
+thread_local bool IN_WORKER = false;
+
+struct InWorker
+{
+  InWorker()
+  {
+    IN_WORKER = true;
+  }
+  ~InWorker()
+  {
+    IN_WORKER = false;
+  }
+};
+}  // namespace
+
+WorkerPool::WorkerPool(std::size_t thread_count)
+  : work_(nullptr), worker_count_(0), pending_(0), generation_(0), stop_(false)
+{
+  if (thread_count == 0)
+    thread_count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+  threads_.reserve(thread_count);
+  for (std::size_t i = 0; i < thread_count; ++i)
+    threads_.emplace_back(&WorkerPool::threadMain, this, i + 1);
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_condition_.notify_all();
+  for (std::thread& thread : threads_)
+    thread.join();
+}
+
+void WorkerPool::run(std::size_t worker_count, const std::function<void(std::size_t worker)>& work)
+{
+  worker_count = std::min(worker_count, getMaxWorkerCount());
+  std::unique_lock<std::mutex> run_lock(run_mutex_, std::defer_lock);
+  if (worker_count <= 1 || IN_WORKER || !run_lock.try_lock())
+  {
+    for (std::size_t worker = 0; worker < worker_count; ++worker)
+      work(worker);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    work_ = &work;
+    worker_count_ = worker_count;
+    pending_ = worker_count - 1;
+    exception_ = nullptr;
+    ++generation_;
+  }
+  start_condition_.notify_all();
+
+  std::exception_ptr exception;
+  try
+  {
+    InWorker in_worker;
+    work(0);
+  }
+  catch (...)
+  {
+    exception = std::current_exception();
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_condition_.wait(lock, [this] { return pending_ == 0; });
+  work_ = nullptr;
+  if (!exception)
+    exception = exception_;
+  lock.unlock();
+  if (exception)
+    std::rethrow_exception(exception);
+}
+
+void WorkerPool::threadMain(std::size_t worker)
+{
+  IN_WORKER = true;
+  std::size_t generation = 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true)
+  {
+    start_condition_.wait(lock, [&] { return stop_ || generation_ != generation; });
+    if (stop_)
+      return;
+    generation = generation_;
+    if (worker >= worker_count_)
+      continue;
+
+    const std::function<void(std::size_t)>& work = *work_;
+    lock.unlock();
+    std::exception_ptr exception;
+    try
+    {
+      work(worker);
+    }
+    catch (...)
+    {
+      exception = std::current_exception();
+    }
+    lock.lock();
+    if (exception && !exception_)
+      exception_ = exception;
+    if (--pending_ == 0)
+      done_condition_.notify_one();
+  }
+}
+
+WorkerPool& WorkerPool::getGlobal()
+{
+  static WorkerPool pool;
+  return pool;
+}
+}  // namespace core
+}  // namespace moveit
@@ -135,7 +135,8 @@ void MoveGroupMoveAction::executeMoveCallbackPlanAndExecute(const moveit_msgs::M
   opt.before_execution_callback_ = boost::bind(&MoveGroupMoveAction::startMoveExecutionCallback, this);
 
   opt.plan_callback_ =
-      boost::bind(&MoveGroupMoveAction::planUsingPlanningPipeline, this, boost::cref(motion_plan_request), _1);
+      boost::bind(&MoveGroupMoveAction::planUsingPlanningPipeline, this, boost::cref(motion_plan_request),
+                  boost::cref(planning_scene_diff), _1);
   if (goal->planning_options.look_around && context_->plan_with_sensing_)
   {
     opt.plan_callback_ = boost::bind(&plan_execution::PlanWithSensing::computePlan, context_->plan_with_sensing_.get(),
@@ -165,12 +166,12 @@ void MoveGroupMoveAction::executeMoveCallbackPlanOnly(const moveit_msgs::MoveGro
 {
   ROS_INFO_NAMED(getName(), "Planning request received for MoveGroup action. Forwarding to planning pipeline.");
 
-  // lock the scene so that it does not modify the world representation while diff() is called
-  planning_scene_monitor::LockedPlanningSceneRO lscene(context_->planning_scene_monitor_);
-  const planning_scene::PlanningSceneConstPtr& the_scene =
+  // plan on a snapshot so that scene updates are not blocked while planning
+  const planning_scene::PlanningSceneConstPtr snapshot = context_->planning_scene_monitor_->getPlanningSceneSnapshot();
+  const planning_scene::PlanningSceneConstPtr the_scene =
       (moveit::core::isEmpty(goal->planning_options.planning_scene_diff)) ?
-          static_cast<const planning_scene::PlanningSceneConstPtr&>(lscene) :
-          lscene->diff(goal->planning_options.planning_scene_diff);
+          snapshot :
+          snapshot->diff(goal->planning_options.planning_scene_diff);
   planning_interface::MotionPlanResponse res;
 
   if (preempt_requested_)
@@ -204,6 +205,7 @@ void MoveGroupMoveAction::executeMoveCallbackPlanOnly(const moveit_msgs::MoveGro
 }
 
 bool MoveGroupMoveAction::planUsingPlanningPipeline(const planning_interface::MotionPlanRequest& req,
+                                                    const moveit_msgs::PlanningScene& scene_diff,
                                                     plan_execution::ExecutableMotionPlan& plan)
 {
   setMoveState(PLANNING);
@@ -219,10 +221,14 @@ bool MoveGroupMoveAction::planUsingPlanningPipeline(const planning_interface::Mo
     return solved;
   }
 
-  planning_scene_monitor::LockedPlanningSceneRO lscene(plan.planning_scene_monitor_);
+  // plan.planning_scene_ follows the monitored scene for validating the plan during execution,
+  // planning itself uses a snapshot so that scene updates are not blocked meanwhile
+  planning_scene::PlanningSceneConstPtr scene = plan.planning_scene_monitor_->getPlanningSceneSnapshot();
+  if (!moveit::core::isEmpty(scene_diff))
+    scene = scene->diff(scene_diff);
   try
   {
-    solved = planning_pipeline->generatePlan(plan.planning_scene_, req, res);
+    solved = planning_pipeline->generatePlan(scene, req, res);
   }
   catch (std::exception& ex)
   {
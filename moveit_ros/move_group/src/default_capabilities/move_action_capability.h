@@ -61,6 +61,7 @@ private:
   void preemptMoveCallback();
   void setMoveState(MoveGroupState state);
   bool planUsingPlanningPipeline(const planning_interface::MotionPlanRequest& req,
+                                 const moveit_msgs::PlanningScene& scene_diff,
                                  plan_execution::ExecutableMotionPlan& plan);
 
   std::unique_ptr<actionlib::SimpleActionServer<moveit_msgs::MoveGroupAction> > move_action_server_;
@@ -68,11 +68,12 @@ bool MoveGroupPlanService::computePlanService(moveit_msgs::GetMotionPlan::Reques
     return true;
   }
 
-  planning_scene_monitor::LockedPlanningSceneRO ps(context_->planning_scene_monitor_);
+  // plan on a snapshot, so that scene updates are not blocked for the duration of the planning request
+  const planning_scene::PlanningSceneConstPtr scene = context_->planning_scene_monitor_->getPlanningSceneSnapshot();
   try
   {
     planning_interface::MotionPlanResponse mp_res;
-    planning_pipeline->generatePlan(ps, req.motion_plan_request, mp_res);
+    planning_pipeline->generatePlan(scene, req.motion_plan_request, mp_res);
     mp_res.getMessage(res.motion_plan_response);
   }
   catch (std::exception& ex)
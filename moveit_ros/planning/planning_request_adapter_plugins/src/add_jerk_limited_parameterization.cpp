@@ -0,0 +1,124 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/planning_request_adapter/planning_request_adapter.h>
+#include <moveit/trajectory_processing/jerk_limited_time_parameterization.h>
+#include <class_loader/class_loader.hpp>
+#include <ros/ros.h>
+
+namespace default_planner_request_adapters
+{
+using namespace trajectory_processing;
+
+/** @brief This adapter uses the jerk-limited time parameterization method.
+    Jerk limits are read from the joint limits parameters (max_jerk, has_jerk_limits). */
+class AddJerkLimitedParameterization : public planning_request_adapter::PlanningRequestAdapter
+{
+public:
+  static const std::string ROBOT_DESCRIPTION_PARAM_NAME;
+
+  AddJerkLimitedParameterization() : planning_request_adapter::PlanningRequestAdapter()
+  {
+  }
+
+  void initialize(const ros::NodeHandle& /*nh*/) override
+  {
+    // the joint limits live next to the ones read by the RobotModelLoader, so resolve them the same way
+    ros::NodeHandle nh("~");
+    std::string robot_description;
+    if (!nh.searchParam(ROBOT_DESCRIPTION_PARAM_NAME, robot_description))
+    {
+      ROS_WARN("Robot model parameter '%s' not found. Trajectories will only be velocity and acceleration limited.",
+               ROBOT_DESCRIPTION_PARAM_NAME.c_str());
+      return;
+    }
+    const std::string joint_limits_param = robot_description + "_planning/joint_limits";
+
+    XmlRpc::XmlRpcValue joint_limits;
+    std::map<std::string, double> jerk_limits;
+    if (nh.getParam(joint_limits_param, joint_limits) && joint_limits.getType() == XmlRpc::XmlRpcValue::TypeStruct)
+    {
+      for (XmlRpc::XmlRpcValue::iterator it = joint_limits.begin(); it != joint_limits.end(); ++it)
+      {
+        double max_jerk;
+        if (!nh.getParam(joint_limits_param + "/" + it->first + "/max_jerk", max_jerk))
+          continue;
+        bool has_jerk_limits = true;
+        nh.getParam(joint_limits_param + "/" + it->first + "/has_jerk_limits", has_jerk_limits);
+        if (has_jerk_limits)
+          jerk_limits[it->first] = max_jerk;
+      }
+    }
+    if (jerk_limits.empty())
+      ROS_WARN_STREAM("No jerk limits found in '" << joint_limits_param
+                                                  << "'. Trajectories will only be velocity and acceleration limited.");
+    else
+      ROS_INFO_STREAM("Loaded jerk limits for " << jerk_limits.size() << " joints");
+    time_parameterization_.setJerkLimits(jerk_limits);
+  }
+
+  std::string getDescription() const override
+  {
+    return "Add Jerk-Limited Parameterization";
+  }
+
+  bool adaptAndPlan(const PlannerFn& planner, const planning_scene::PlanningSceneConstPtr& planning_scene,
+                    const planning_interface::MotionPlanRequest& req, planning_interface::MotionPlanResponse& res,
+                    std::vector<std::size_t>& /*added_path_index*/) const override
+  {
+    bool result = planner(planning_scene, req, res);
+    if (result && res.trajectory_)
+    {
+      ROS_DEBUG("Running '%s'", getDescription().c_str());
+      if (!time_parameterization_.computeTimeStamps(*res.trajectory_, req.max_velocity_scaling_factor,
+                                                    req.max_acceleration_scaling_factor))
+      {
+        ROS_ERROR("Time parametrization for the solution path failed.");
+        result = false;
+      }
+    }
+
+    return result;
+  }
+
+private:
+  JerkLimitedTimeParameterization time_parameterization_;
+};
+
+const std::string AddJerkLimitedParameterization::ROBOT_DESCRIPTION_PARAM_NAME = "robot_description";
+
+}  // namespace default_planner_request_adapters
+
+CLASS_LOADER_REGISTER_CLASS(default_planner_request_adapters::AddJerkLimitedParameterization,
+                            planning_request_adapter::PlanningRequestAdapter);
@@ -191,11 +191,15 @@ private:
   void jointStateCallback(const sensor_msgs::JointStateConstPtr& joint_state);
   void tfCallback();
 
+  /** \brief Get the layout of joint states with \e names, resolving the names if they are new */
+  const moveit::core::VariableLayout& getJointStateLayout(const std::vector<std::string>& names);
+
   ros::NodeHandle nh_;
   std::shared_ptr<tf2_ros::Buffer> tf_buffer_;
   moveit::core::RobotModelConstPtr robot_model_;
   moveit::core::RobotState robot_state_;
   std::map<const moveit::core::JointModel*, ros::Time> joint_time_;
+  std::vector<moveit::core::VariableLayout> joint_state_layouts_;  // Layouts of recently received joint states
   bool state_monitor_started_;
   bool copy_dynamics_;  // Copy velocity and effort from joint_state
   ros::Time monitor_start_time_;
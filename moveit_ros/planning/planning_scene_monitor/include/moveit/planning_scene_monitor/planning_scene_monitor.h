@@ -202,6 +202,19 @@ public:
     return scene_const_;
   }
 
+  /** @brief Return an immutable snapshot of the monitored planning scene, without locking it.
+   *
+   * The monitor publishes a new snapshot with every update it applies to the scene, while still holding the
+   * scene's write lock, so readers holding on to a snapshot, e.g. for a whole planning request, do not block
+   * the monitor's updates. Geometry updates publish a full copy of the scene, state and transform updates a
+   * diff of the last full copy. Releasing a LockedPlanningSceneRW publishes a full copy as well. The snapshot
+   * gets its own copy of the monitor's octomap, so octomap updates do not modify published snapshots.
+   * @return The latest snapshot, null if there is no scene */
+  planning_scene::PlanningSceneConstPtr getPlanningSceneSnapshot() const
+  {
+    return std::atomic_load(&scene_snapshot_);
+  }
+
   /** @brief Return true if the scene \e scene can be updated directly
       or indirectly by this monitor. This function will return true if
       the pointer of the scene is the same as the one maintained,
@@ -459,6 +472,10 @@ protected:
   bool getShapeTransformCache(const std::string& target_frame, const ros::Time& target_time,
                               occupancy_map_monitor::ShapeTransformCache& cache) const;
 
+  /** @brief Publish a snapshot of the scene for getPlanningSceneSnapshot() after an update of type update_type.
+      Must be called while holding the write lock on scene_update_mutex_, but no lock on the octree. */
+  void updateSceneSnapshot(SceneUpdateType update_type);
+
   /// The name of this scene monitor
   std::string monitor_name_;
 
@@ -469,6 +486,9 @@ protected:
   ros::Time last_update_time_;                     /// Last time the state was updated
   ros::Time last_robot_motion_time_;               /// Last time the robot has moved
 
+  planning_scene::PlanningSceneConstPtr scene_snapshot_;       /// immutable copy of scene_, swapped atomically
+  planning_scene::PlanningSceneConstPtr scene_snapshot_base_;  /// last full copy, state updates are diffs of it
+
   ros::NodeHandle nh_;
   ros::NodeHandle root_nh_;
   ros::CallbackQueue queue_;
@@ -41,6 +41,12 @@
 
 #include <limits>
 
+namespace
+{
+// joint states usually come from a few publishers, each of which keeps the order of its joints
+const std::size_t MAX_JOINT_STATE_LAYOUTS = 8;
+}  // namespace
+
 planning_scene_monitor::CurrentStateMonitor::CurrentStateMonitor(const moveit::core::RobotModelConstPtr& robot_model,
                                                                  const std::shared_ptr<tf2_ros::Buffer>& tf_buffer)
   : CurrentStateMonitor(robot_model, tf_buffer, ros::NodeHandle())
@@ -348,9 +354,11 @@ void planning_scene_monitor::CurrentStateMonitor::jointStateCallback(const senso
     // read the received values, and update their time stamps
     std::size_t n = joint_state->name.size();
     current_state_time_ = joint_state->header.stamp;
+    const moveit::core::VariableLayout& layout = getJointStateLayout(joint_state->name);
+    const std::vector<const moveit::core::JointModel*>& joints = layout.getJointModels();
     for (std::size_t i = 0; i < n; ++i)
     {
-      const moveit::core::JointModel* jm = robot_model_->getJointModel(joint_state->name[i]);
+      const moveit::core::JointModel* jm = joints[i];
       if (!jm)
         continue;
       // ignore fixed joints, multi-dof joints (they should not even be in the message)
@@ -411,6 +419,19 @@ void planning_scene_monitor::CurrentStateMonitor::jointStateCallback(const senso
   state_update_condition_.notify_all();
 }
 
+const moveit::core::VariableLayout&
+planning_scene_monitor::CurrentStateMonitor::getJointStateLayout(const std::vector<std::string>& names)
+{
+  for (const moveit::core::VariableLayout& layout : joint_state_layouts_)
+    if (layout.matches(names))
+      return layout;
+
+  if (joint_state_layouts_.size() >= MAX_JOINT_STATE_LAYOUTS)
+    joint_state_layouts_.clear();
+  joint_state_layouts_.emplace_back(*robot_model_, names);
+  return joint_state_layouts_.back();
+}
+
 void planning_scene_monitor::CurrentStateMonitor::tfCallback()
 {
   // read multi-dof joint states from TF, if needed
@@ -254,6 +254,9 @@ void PlanningSceneMonitor::initialize(const planning_scene::PlanningScenePtr& sc
                                             false);  // do not start the timer yet
 
   reconfigure_impl_ = new DynamicReconfigureImpl(this);
+
+  boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
+  updateSceneSnapshot(UPDATE_SCENE);
 }
 
 void PlanningSceneMonitor::monitorDiffs(bool flag)
@@ -468,6 +471,45 @@ void PlanningSceneMonitor::triggerSceneUpdateEvent(SceneUpdateType update_type)
   new_scene_update_condition_.notify_all();
 }
 
+void PlanningSceneMonitor::updateSceneSnapshot(SceneUpdateType update_type)
+{
+  if (update_type == UPDATE_NONE || !scene_)
+    return;
+
+  planning_scene::PlanningSceneConstPtr snapshot;
+  if (!scene_snapshot_base_ || (update_type & UPDATE_GEOMETRY))
+  {
+    planning_scene::PlanningScenePtr base = planning_scene::PlanningScene::clone(scene_);
+    collision_detection::World::ObjectConstPtr map = base->getWorld()->getObject(scene_->OCTOMAP_NS);
+    if (octomap_monitor_ && map && map->shapes_.size() == 1)
+    {
+      // the monitor keeps integrating sensor data into its octree, so the snapshot needs its own copy
+      const occupancy_map_monitor::OccMapTreePtr& tree = octomap_monitor_->getOcTreePtr();
+      const shapes::OcTree* o = static_cast<const shapes::OcTree*>(map->shapes_[0].get());
+      if (o->octree.get() == tree.get())
+      {
+        std::shared_ptr<const octomap::OcTree> copy;
+        {
+          occupancy_map_monitor::OccMapTree::ReadLock lock = tree->reading();
+          copy = std::make_shared<const octomap::OcTree>(*tree);
+        }
+        base->processOctomapPtr(copy, map->shape_poses_[0]);
+      }
+    }
+    scene_snapshot_base_ = base;
+    snapshot = base;
+  }
+  else
+  {
+    // the base is never modified after publishing it, so the diff is immutable as well
+    planning_scene::PlanningScenePtr diff = scene_snapshot_base_->diff();
+    diff->setCurrentState(scene_->getCurrentState());
+    diff->getTransformsNonConst().setAllTransforms(scene_->getTransforms().getAllTransforms());
+    snapshot = diff;
+  }
+  std::atomic_store(&scene_snapshot_, snapshot);
+}
+
 bool PlanningSceneMonitor::requestPlanningSceneState(const std::string& service_name)
 {
   if (get_scene_service_.getService() == service_name)
@@ -544,8 +586,10 @@ void PlanningSceneMonitor::clearOctomap()
     else
     {
       ROS_WARN_NAMED(LOGNAME, "Unable to clear octomap since no octomap monitor has been initialized");
-    }  // Lift the scoped lock before calling triggerSceneUpdateEvent to avoid deadlock
-  }
+    }
+    if (removed)
+      updateSceneSnapshot(UPDATE_GEOMETRY);
+  }  // Lift the scoped lock before calling triggerSceneUpdateEvent to avoid deadlock
 
   if (removed)
     triggerSceneUpdateEvent(UPDATE_GEOMETRY);
@@ -602,31 +646,33 @@ bool PlanningSceneMonitor::newPlanningSceneMessage(const moveit_msgs::PlanningSc
       excludeAttachedBodiesFromOctree();  // in case updates have happened to the attached bodies, put them in
       excludeWorldObjectsFromOctree();    // in case updates have happened to the attached bodies, put them in
     }
-  }
 
-  // if we have a diff, try to more accuratelly determine the update type
-  if (scene.is_diff)
-  {
-    bool no_other_scene_upd = (scene.name.empty() || scene.name == old_scene_name) &&
-                              scene.allowed_collision_matrix.entry_names.empty() && scene.link_padding.empty() &&
-                              scene.link_scale.empty();
-    if (no_other_scene_upd)
+    // if we have a diff, try to more accuratelly determine the update type
+    if (scene.is_diff)
     {
-      upd = UPDATE_NONE;
-      if (!moveit::core::isEmpty(scene.world))
-        upd = (SceneUpdateType)((int)upd | (int)UPDATE_GEOMETRY);
-
-      if (!scene.fixed_frame_transforms.empty())
-        upd = (SceneUpdateType)((int)upd | (int)UPDATE_TRANSFORMS);
-
-      if (!moveit::core::isEmpty(scene.robot_state))
+      bool no_other_scene_upd = (scene.name.empty() || scene.name == old_scene_name) &&
+                                scene.allowed_collision_matrix.entry_names.empty() && scene.link_padding.empty() &&
+                                scene.link_scale.empty();
+      if (no_other_scene_upd)
       {
-        upd = (SceneUpdateType)((int)upd | (int)UPDATE_STATE);
-        if (!scene.robot_state.attached_collision_objects.empty() || !static_cast<bool>(scene.robot_state.is_diff))
+        upd = UPDATE_NONE;
+        if (!moveit::core::isEmpty(scene.world))
           upd = (SceneUpdateType)((int)upd | (int)UPDATE_GEOMETRY);
+
+        if (!scene.fixed_frame_transforms.empty())
+          upd = (SceneUpdateType)((int)upd | (int)UPDATE_TRANSFORMS);
+
+        if (!moveit::core::isEmpty(scene.robot_state))
+        {
+          upd = (SceneUpdateType)((int)upd | (int)UPDATE_STATE);
+          if (!scene.robot_state.attached_collision_objects.empty() || !static_cast<bool>(scene.robot_state.is_diff))
+            upd = (SceneUpdateType)((int)upd | (int)UPDATE_GEOMETRY);
+        }
       }
     }
+    updateSceneSnapshot(upd);
   }
+
   triggerSceneUpdateEvent(upd);
   return result;
 }
@@ -650,6 +696,7 @@ void PlanningSceneMonitor::newPlanningSceneWorldCallback(const moveit_msgs::Plan
           octomap_monitor_->getOcTreePtr()->unlockWrite();
         }
       }
+      updateSceneSnapshot(UPDATE_SCENE);
     }
     triggerSceneUpdateEvent(UPDATE_SCENE);
   }
@@ -666,6 +713,7 @@ void PlanningSceneMonitor::collisionObjectCallback(const moveit_msgs::CollisionO
     last_update_time_ = ros::Time::now();
     if (!scene_->processCollisionObjectMsg(*obj))
       return;
+    updateSceneSnapshot(UPDATE_GEOMETRY);
   }
   triggerSceneUpdateEvent(UPDATE_GEOMETRY);
 }
@@ -679,6 +727,7 @@ void PlanningSceneMonitor::attachObjectCallback(const moveit_msgs::AttachedColli
       boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
       last_update_time_ = ros::Time::now();
       scene_->processAttachedCollisionObjectMsg(*obj);
+      updateSceneSnapshot(UPDATE_GEOMETRY);
     }
     triggerSceneUpdateEvent(UPDATE_GEOMETRY);
   }
@@ -980,6 +1029,8 @@ void PlanningSceneMonitor::unlockSceneWrite()
 {
   if (octomap_monitor_)
     octomap_monitor_->getOcTreePtr()->unlockWrite();
+  // the scene may have been modified in any way through LockedPlanningSceneRW
+  updateSceneSnapshot(UPDATE_SCENE);
   scene_update_mutex_.unlock();
 }
 
@@ -1240,6 +1291,7 @@ void PlanningSceneMonitor::octomapUpdateCallback()
       octomap_monitor_->getOcTreePtr()->unlockRead();  // unlock and rethrow
       throw;
     }
+    updateSceneSnapshot(UPDATE_GEOMETRY);
   }
   triggerSceneUpdateEvent(UPDATE_GEOMETRY);
 }
@@ -1288,6 +1340,7 @@ void PlanningSceneMonitor::updateSceneWithCurrentState()
       ROS_DEBUG_STREAM_NAMED(LOGNAME, "robot state update " << fmod(last_robot_motion_time_.toSec(), 10.));
       current_state_monitor_->setToCurrentState(scene_->getCurrentStateNonConst());
       scene_->getCurrentStateNonConst().update();  // compute all transforms
+      updateSceneSnapshot(UPDATE_STATE);
     }
     triggerSceneUpdateEvent(UPDATE_STATE);
   }
@@ -1357,6 +1410,7 @@ void PlanningSceneMonitor::updateFrameTransforms()
       boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
       scene_->getTransformsNonConst().setTransforms(transforms);
       last_update_time_ = ros::Time::now();
+      updateSceneSnapshot(UPDATE_TRANSFORMS);
     }
     triggerSceneUpdateEvent(UPDATE_TRANSFORMS);
   }
@@ -0,0 +1,135 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2020, PickNik LLC
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of PickNik LLC nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <ros/ros.h>
+#include <gtest/gtest.h>
+#include <moveit/planning_scene_monitor/planning_scene_monitor.h>
+#include <geometric_shapes/shapes.h>
+
+namespace planning_scene_monitor
+{
+class PlanningSceneSnapshotTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    psm_ = std::make_shared<PlanningSceneMonitor>("robot_description");
+    ASSERT_TRUE(static_cast<bool>(psm_->getPlanningScene()));
+    variable_ = psm_->getRobotModel()->getVariableNames()[0];
+  }
+
+  double getVariable(const planning_scene::PlanningSceneConstPtr& scene) const
+  {
+    return scene->getCurrentState().getVariablePosition(variable_);
+  }
+
+  PlanningSceneMonitorPtr psm_;
+  std::string variable_;
+};
+
+TEST_F(PlanningSceneSnapshotTest, SnapshotsAreImmutable)
+{
+  const planning_scene::PlanningSceneConstPtr initial = psm_->getPlanningSceneSnapshot();
+  ASSERT_TRUE(static_cast<bool>(initial));
+  // without updates, the same snapshot is returned
+  EXPECT_EQ(initial, psm_->getPlanningSceneSnapshot());
+  const double initial_value = getVariable(initial);
+
+  // a state-only update shows up in the next snapshot, but not in the one held
+  moveit_msgs::PlanningScene state_diff;
+  state_diff.is_diff = true;
+  state_diff.robot_state.is_diff = true;
+  state_diff.robot_state.joint_state.name.push_back(variable_);
+  state_diff.robot_state.joint_state.position.push_back(initial_value + 0.1);
+  ASSERT_TRUE(psm_->newPlanningSceneMessage(state_diff));
+  const planning_scene::PlanningSceneConstPtr moved = psm_->getPlanningSceneSnapshot();
+  ASSERT_TRUE(static_cast<bool>(moved));
+  EXPECT_NE(initial, moved);
+  EXPECT_DOUBLE_EQ(initial_value, getVariable(initial));
+  EXPECT_DOUBLE_EQ(initial_value + 0.1, getVariable(moved));
+
+  // a geometry update shows up in the next snapshot, but not in the ones held
+  moveit_msgs::PlanningScene world_diff;
+  world_diff.is_diff = true;
+  world_diff.robot_state.is_diff = true;
+  moveit_msgs::CollisionObject box;
+  box.id = "box";
+  box.header.frame_id = psm_->getRobotModel()->getModelFrame();
+  box.operation = moveit_msgs::CollisionObject::ADD;
+  box.primitives.resize(1);
+  box.primitives[0].type = shape_msgs::SolidPrimitive::BOX;
+  box.primitives[0].dimensions = { 0.1, 0.1, 0.1 };
+  box.primitive_poses.resize(1);
+  box.primitive_poses[0].orientation.w = 1.0;
+  world_diff.world.collision_objects.push_back(box);
+  ASSERT_TRUE(psm_->newPlanningSceneMessage(world_diff));
+  const planning_scene::PlanningSceneConstPtr with_box = psm_->getPlanningSceneSnapshot();
+  ASSERT_TRUE(static_cast<bool>(with_box));
+  EXPECT_FALSE(initial->getWorld()->hasObject("box"));
+  EXPECT_FALSE(moved->getWorld()->hasObject("box"));
+  EXPECT_TRUE(with_box->getWorld()->hasObject("box"));
+  EXPECT_DOUBLE_EQ(initial_value + 0.1, getVariable(with_box));
+  EXPECT_EQ(with_box, psm_->getPlanningSceneSnapshot());
+}
+
+TEST_F(PlanningSceneSnapshotTest, LockedPlanningSceneRW)
+{
+  const planning_scene::PlanningSceneConstPtr initial = psm_->getPlanningSceneSnapshot();
+  ASSERT_TRUE(static_cast<bool>(initial));
+  const double initial_value = getVariable(initial);
+  {
+    LockedPlanningSceneRW scene(psm_);
+    scene->getCurrentStateNonConst().setVariablePosition(variable_, initial_value + 0.2);
+    // taking a snapshot does not lock the scene, so it works while holding the write lock
+    EXPECT_EQ(initial, psm_->getPlanningSceneSnapshot());
+  }
+  // releasing the write lock publishes the change
+  const planning_scene::PlanningSceneConstPtr moved = psm_->getPlanningSceneSnapshot();
+  ASSERT_TRUE(static_cast<bool>(moved));
+  EXPECT_NE(initial, moved);
+  EXPECT_DOUBLE_EQ(initial_value, getVariable(initial));
+  EXPECT_DOUBLE_EQ(initial_value + 0.2, getVariable(moved));
+}
+}  // namespace planning_scene_monitor
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "planning_scene_monitor_test");
+
+  ros::AsyncSpinner spinner(1);
+  spinner.start();
+
+  return RUN_ALL_TESTS();
+}